@@ -43,6 +43,25 @@ utf8_t* dbg_analyze_syscall(int sysc, sid_t client)
 	dbg_registers_t l__regs = dbg_get_registers(client);
 	if (*tls_errno) return NULL;
 	
+	return dbg_analyze_syscall_regs(sysc, &l__regs);
+}
+
+/*
+ * dbg_analyze_syscall_regs(sysc, regs)
+ *
+ * Analyzes the system call softint "sysc" with the register
+ * contents "regs" (e.g. from a streamed system call).
+ * The output will be returned into a string.
+ *
+ * Return value:
+ *	!= NULL   Information string
+ *	== NULL	  Invalid interrupt or error
+ *
+ */ 
+utf8_t* dbg_analyze_syscall_regs(int sysc, const dbg_registers_t *regs)
+{
+	dbg_registers_t l__regs = *regs;
+	
 	utf8_t *l__buf = mem_alloc(1000);
 	int l__len = 0;
 	if (l__buf == NULL) return NULL;
@@ -135,6 +154,18 @@ utf8_t* dbg_analyze_syscall(int sysc, sid_t client)
 			if (l__regs.ecx == 0)
 			{
 				l__flagstr = "SCHED_REGULAR";
+			}
+			 else if (l__regs.ecx == 1)
+			{
+				l__flagstr = "SCHED_RR";
+			}
+			 else if (l__regs.ecx == 2)
+			{
+				l__flagstr = "SCHED_FIFO";
+			}
+			 else if (l__regs.ecx == 3)
+			{
+				l__flagstr = "SCHED_DEADLINE";
 			}
 			 else
 			{
@@ -589,7 +620,18 @@ utf8_t* dbg_analyze_syscall(int sysc, sid_t client)
 				l__pos += 18;
 			}			
 			
-			if (l__regs.ecx & (~(RECV_AWAKE_OTHER|RECV_TRACE_SYSCALL)))
+			if (l__regs.ecx & RECV_STREAM_SYSCALL)
+			{
+				if (l__pos != 0)
+				{
+					str_copy(&l__flagstr[l__pos], "|", 2);
+					l__pos += 1;
+				}
+				str_copy(&l__flagstr[l__pos], "RECV_STREAM_SYSCALL", 20);
+				l__pos += 19;
+			}			
+			
+			if (l__regs.ecx & (~(RECV_AWAKE_OTHER|RECV_TRACE_SYSCALL|RECV_STREAM_SYSCALL)))
 			{
 				if (l__pos != 0)
 				{
@@ -629,6 +671,16 @@ utf8_t* dbg_analyze_syscall(int sysc, sid_t client)
 			{
 				l__flagstr = "REGS_X86_EFLAGS";
 				l__retvalstr = "<eflags>->EBX";
+			}			
+ 			 else if (l__regs.ebx == REGS_X86_FRAME)
+			{
+				l__flagstr = "REGS_X86_FRAME";
+				l__retvalstr = "<frame>->[ECX]";
+			}			
+ 			 else if (l__regs.ebx == REGS_X86_FRAME_FPU)
+			{
+				l__flagstr = "REGS_X86_FRAME_FPU";
+				l__retvalstr = "<frame+fpu>->[ECX]";
 			}			
 			 else
 			{
@@ -680,6 +732,22 @@ utf8_t* dbg_analyze_syscall(int sysc, sid_t client)
 				l__reg2 = "<xxx>";
 				l__reg3 = "<xxx>";
 				l__reg4 = "<xxx>";				
+			}			
+ 			 else if (l__regs.ebx == REGS_X86_FRAME)
+			{
+				l__flagstr = "REGS_X86_FRAME";
+				l__reg1 = "<frame>";
+				l__reg2 = "<xxx>";
+				l__reg3 = "<xxx>";
+				l__reg4 = "<xxx>";				
+			}			
+ 			 else if (l__regs.ebx == REGS_X86_FRAME_FPU)
+			{
+				l__flagstr = "REGS_X86_FRAME_FPU";
+				l__reg1 = "<frame+fpu>";
+				l__reg2 = "<xxx>";
+				l__reg3 = "<xxx>";
+				l__reg4 = "<xxx>";				
 			}			
 			 else
 			{
@@ -708,6 +776,83 @@ utf8_t* dbg_analyze_syscall(int sysc, sid_t client)
 			break;
 		}	
 		
+		/* clone */
+		case (0xD7):
+		{
+			l__len = snprintf(l__buf, 1000, "D7: clone(sid=0x%X, adr=0x%X, pages=%i)", l__regs.eax, l__regs.ebx, l__regs.ecx);
+			break;
+		}	
+		
+		/* merge */
+		case (0xD8):
+		{
+			l__len = snprintf(l__buf, 1000, "D8: merge(sid=0x%X, adr=0x%X, pages=%i) => merged->EBX", l__regs.eax, l__regs.ebx, l__regs.ecx);
+			break;
+		}	
+		
+		/* recv_pagefaults */
+		case (0xD9):
+		{
+			l__len = snprintf(l__buf, 1000, "D9: recv_pagefaults(buf=0x%X, max=%i) => received->EBX", l__regs.eax, l__regs.ebx);
+			break;
+		}	
+		
+		/* resolve_pagefaults */
+		case (0xDA):
+		{
+			l__len = snprintf(l__buf, 1000, "DA: resolve_pagefaults(list=0x%X, num=%i) => awaked->EBX", l__regs.eax, l__regs.ebx);
+			break;
+		}	
+		
+		/* io_allow_range */
+		case (0xDB):
+		{
+			l__len = snprintf(l__buf, 1000, "DB: io_allow_range(sid = 0x%X, port = 0x%X, num = %i, op = %i)", l__regs.eax, l__regs.ebx, l__regs.ecx, l__regs.edx);
+			break;
+		}	
+		
+		/* irq_mode */
+		case (0xDC):
+		{
+			l__len = snprintf(l__buf, 1000, "DC: irq_mode(irq = %i, mode = 0x%X)", l__regs.eax, l__regs.ebx);
+			break;
+		}	
+		
+		/* set_deadline */
+		case (0xDD):
+		{
+			l__len = snprintf(l__buf, 1000, "DD: set_deadline(sid = 0x%X, runtime = %u, period = %u)", l__regs.eax, l__regs.ebx, l__regs.ecx);
+			break;
+		}	
+		
+		/* trace_ctl */
+		case (0xDE):
+		{
+			l__len = snprintf(l__buf, 1000, "DE: trace_ctl(mask = 0x%X)", l__regs.eax);
+			break;
+		}	
+		
+		/* profile_ctl */
+		case (0xDF):
+		{
+			l__len = snprintf(l__buf, 1000, "DF: profile_ctl(proc = 0x%X, depth = %u)", l__regs.eax, l__regs.ebx);
+			break;
+		}	
+		
+		/* trace_read */
+		case (0xE0):
+		{
+			l__len = snprintf(l__buf, 1000, "E0: trace_read(buf = 0x%X, first = %u, num = %u) => copied->EBX", l__regs.eax, l__regs.ebx, l__regs.ecx);
+			break;
+		}
+		
+		/* profile_read */
+		case (0xE1):
+		{
+			l__len = snprintf(l__buf, 1000, "E1: profile_read(buf = 0x%X, first = %u, num = %u) => copied->EBX", l__regs.eax, l__regs.ebx, l__regs.ecx);
+			break;
+		}	
+		
 		/* Invalid system call */
 		default:
 		{
@@ -906,7 +1051,7 @@ utf8_t* dbg_analyze_softint(int intr, sid_t client)
 		
 		return l__buf;
 	}
-	 else if ((intr < 0xC0) || (intr > 0xD6)) /* Empty-Ints */
+	 else if ((intr < 0xC0) || (intr > 0xE1)) /* Empty-Ints */
 	{
 		utf8_t *l__buf = mem_alloc(100);
 		if (l__buf == NULL) return NULL;
@@ -917,7 +1062,7 @@ utf8_t* dbg_analyze_softint(int intr, sid_t client)
 		
 		return l__buf;
 	}
-	 else if ((intr >= 0xC0) && (intr <= 0xD6)) /* Syscalls */
+	 else if ((intr >= 0xC0) && (intr <= 0xE1)) /* Syscalls */
 	{
 		return dbg_analyze_syscall(intr, client);
 	}
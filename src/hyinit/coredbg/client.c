@@ -19,6 +19,7 @@
 #include <hydrixos/mem.h>
 #include <hydrixos/stdfun.h>
 #include <hydrixos/system.h>
+#include <hydrixos/pmap.h>
 
 #include <coredbg/cdebug.h>
 
@@ -117,6 +118,12 @@ static int dbg_create_client_general(sid_t client, int term, int hook)
 	l__new->breakpoints = NULL;
 	l__new->breakpoints_n = 0;
 	
+	l__new->stream_pos = 0;
+	l__new->stream_tsc = 0;
+	l__new->stream_lost = 0;
+	
+	l__new->ring = NULL;
+	
 	l__new->hooked = hook;
 	
 	/* Add it to the clients list */
@@ -203,9 +210,21 @@ void dbg_destroy_client(sid_t client)
 	
 	lst_dellst(dbg_clients, l__client);
 	
+	/* Unmap its cached memory pages */
+	dbg_window_flush(client);
+	
 	/* Destroy the client structure */
 	dbg_free_breakpoint_list(l__client);
 	
+	if (l__client->ring != NULL)
+	{
+		/* Output the rest of the console ring */
+		dbg_drain_console(l__client);
+		
+		pmap_free(l__client->ring);
+		*tls_errno = 0;
+	}
+	
 	mem_free(l__client);
 		
 	/* Destroy the shell */
@@ -82,6 +82,60 @@ static void dbg_setup_cursor(void)
 	
 }
 
+/*
+ * dbg_term_line(term, line)
+ *
+ * Returns the buffer of the screen line "line" of the terminal "term".
+ * The buffer is a ring of 25 lines, starting at line "term->top".
+ *
+ */
+static inline char* dbg_term_line(dbg_terminals_t *term, int line)
+{
+	return &term->buffer[((term->top + line) % 25) * 160];
+}
+
+/*
+ * dbg_con_flush()
+ *
+ * Copies the changed lines of the current terminal
+ * to the screen. Subsequent lines will be copied
+ * at once.
+ *
+ */
+static void dbg_con_flush(void)
+{
+	dbg_terminals_t *l__term = dbg_current_term;
+	uint32_t l__dirty = l__term->dirty;
+	int l__line = 0;
+	
+	while (l__line < 25)
+	{
+		if (!(l__dirty & (1u << l__line)))
+		{
+			l__line ++;
+			continue;
+		}
+		
+		/* Find the end of the block (until the end of the ring) */
+		int l__first = l__line;
+		
+		do
+		{
+			l__line ++;
+		}while (    (l__line < 25)
+			 && (l__dirty & (1u << l__line))
+			 && (((l__term->top + l__line) % 25) != 0)
+		       );
+		
+		buf_copy((void*)&i__screen[l__first * 160], dbg_term_line(l__term, l__first), (l__line - l__first) * 160);
+	}
+	
+	l__term->dirty = 0;
+	
+	/* Update the cursor and the head line */
+	dbg_setup_cursor();
+}
+
 /*
  * dbg_init_driver
  *
@@ -95,6 +149,8 @@ int dbg_init_driver(void)
 	
 	dbg_terminals->keynum = 1;						/* F1-Terminal */
 	dbg_terminals->buffer = mem_alloc(25 * 80 * 2);
+	dbg_terminals->top = 0;
+	dbg_terminals->dirty = DBGTERM_ALL_LINES;
 	dbg_terminals->keybuf = 0;
 	
 	dbg_terminals->headline = mem_alloc(str_len("System Terminal", 25) + 1);
@@ -117,14 +173,15 @@ int dbg_init_driver(void)
 	dbg_terminals->output_color = DBGCOL_GREY;
 	
 	dbg_current_term = dbg_terminals;
-	dbg_setup_cursor();
 	
 	/* Clear the screen */
-	uint16_t *l__scr = (void*)i__screen;
+	uint16_t *l__scr = (void*)dbg_terminals->buffer;
 	int l__i = 80*25;
 	
 	while (l__i --) l__scr[l__i] = 0x0700;
 	
+	dbg_con_flush();
+	
 	/* Init the Keyb-IRQ-Handler */
 	dbg_keyboard_thread = blthr_create(dbg_keyb_driver, 4096);
 	hymk_set_priority(dbg_keyboard_thread->thread_sid, 40, 0);
@@ -137,14 +194,17 @@ int dbg_init_driver(void)
 }
 
 /*
- * dbg_internal_putc(c, t, b)
+ * dbg_internal_putc(c, t)
  *
  * Internal implementation of putc for different kinds of terminals.
- * Puts 'c' to the terminal 't' by using the buffer 'b'.
+ * Puts 'c' to the window buffer of the terminal 't' and marks the
+ * changed lines. The screen will be updated by dbg_con_flush.
  *
  */
-static void dbg_internal_putc(char c, dbg_terminals_t *term, char *buf)
+static void dbg_internal_putc(char c, dbg_terminals_t *term)
 {
+	char *buf;
+	
 	if (c == '\n')			/* CR */
 	{
 		term->column = 0;
@@ -190,8 +250,11 @@ static void dbg_internal_putc(char c, dbg_terminals_t *term, char *buf)
 			}
 		}
 		
-		buf[(term->column * 2) + (term->line * 160)] = ' ';
-		buf[(term->column * 2) + (term->line * 160) + 1] = term->output_color;
+		buf = dbg_term_line(term, term->line);
+		buf[term->column * 2] = ' ';
+		buf[(term->column * 2) + 1] = term->output_color;
+		
+		term->dirty |= (1u << term->line);
 	}
 	 else if (c == '\t')		/* Tabulator */
 	{
@@ -206,9 +269,12 @@ static void dbg_internal_putc(char c, dbg_terminals_t *term, char *buf)
 	}
 	 else				/* NORMAL CHAR */
 	{
-		buf[(term->column * 2) + (term->line * 160)] = c;
-		buf[(term->column * 2) + (term->line * 160) + 1] = term->output_color;
+		buf = dbg_term_line(term, term->line);
+		buf[term->column * 2] = c;
+		buf[(term->column * 2) + 1] = term->output_color;
 	
+		term->dirty |= (1u << term->line);
+		
 		term->column ++;
 		
 		if (term->column == 80) 
@@ -218,15 +284,19 @@ static void dbg_internal_putc(char c, dbg_terminals_t *term, char *buf)
 		}
 	}
 		
-	/* New screen line? */
+	/* New screen line? Just move the start of the ring. */
 	if (term->line == 25)
 	{
 		term->line --;
-		buf_copy((void*)buf, (void*)&buf[80 * 2], 80*24*2);
-		uint16_t *l__scr = (void*)&buf[80*24*2];
+		term->top = (term->top + 1) % 25;
+		
+		uint16_t *l__scr = (void*)dbg_term_line(term, 24);
 		int l__i = 80;
 		
 		while (l__i --) l__scr[l__i] = (term->output_color << 8) | 0x00;	
+		
+		/* All lines of the screen are moved */
+		term->dirty = DBGTERM_ALL_LINES;
 				
 		/* Scroll prompt line */
 		if (term->flags & DBGTERM_PROMPT_ON) 
@@ -245,8 +315,8 @@ static void dbg_internal_putc(char c, dbg_terminals_t *term, char *buf)
  */
 static void dbg_con_putc(char c)
 {
-	dbg_internal_putc(c, dbg_current_term, (char*)i__screen);
-	dbg_setup_cursor();
+	dbg_internal_putc(c, dbg_current_term);
+	dbg_con_flush();
 }
 
 /*
@@ -515,7 +585,9 @@ static char dbg_keyb_translate_key(unsigned c)
 		        )
 		   )
 		{ 
+			mtx_lock(&dbg_display_mutex, -1);
 			dbg_con_putc(l__c);
+			mtx_unlock(&dbg_display_mutex);
 		}
 	
 		/* Is there some thread reading from the current terminal? */
@@ -656,6 +728,9 @@ int dbg_create_window(const char* head)
 		return 0;
 	}
 	
+	l__newterm->top = 0;
+	l__newterm->dirty = 0;
+	
 	l__newterm->keybuf = 0;
 	
 	/* Setup the head line, if wanted */
@@ -721,20 +796,15 @@ void dbg_switch_window(int termid)
 	/* Did we found it? */
 	if (l__term == NULL) {mtx_unlock(&dbg_display_mutex); return;}
 	
-	/* Copy current the display content of the current terminal into its display buffer */
-	buf_copy(dbg_current_term->buffer, (void*)i__screen, 80 * 25 * 2);
-	
-	/* Copy the content of the selected terminal to the display buffer */
-	buf_copy((void*)i__screen, l__term->buffer, 80 * 25 * 2);
-	
 	/* Switch the current display structure */
 	dbg_current_term->is_current = FALSE;
 	l__term->is_current = TRUE;
 	
 	dbg_current_term = l__term;
 	
-	/* Update the cursor position */
-	dbg_setup_cursor();
+	/* Copy the content of the selected terminal to the screen */
+	l__term->dirty = DBGTERM_ALL_LINES;
+	dbg_con_flush();
 	
 	mtx_unlock(&dbg_display_mutex);
 	
@@ -913,6 +983,20 @@ static inline uint32_t dbg_extascii_to_utf8(char c)
 	return (uint32_t)c;
 }
 
+/*
+ * dbg_term_putc(term, c)
+ *
+ * Puts the UTF-8 charracter "c" to the window buffer of the
+ * terminal "term".
+ *
+ * This function expects dbg_display_mutex to be locked and leaves it locked!
+ *
+ */
+static inline void dbg_term_putc(dbg_terminals_t *term, uint32_t c)
+{
+	dbg_internal_putc(dbg_utf8_to_extascii(c), term);
+}
+
 /*
  * dbg_putc(t, c)
  *
@@ -937,18 +1021,10 @@ void dbg_putc(int termid, uint32_t c)
 	/* Did we found it? */
 	if (l__term == NULL) {mtx_unlock(&dbg_display_mutex); return;}
 	
-	/* Get its ASCII conversion */
-	char l__c = dbg_utf8_to_extascii(c);
+	dbg_term_putc(l__term, c);
 	
 	/* Is it the current terminal? */
-	if (l__term == dbg_current_term) 
-	{
-		dbg_con_putc(l__c);
-	}
-	 else
-	{
-		dbg_internal_putc(l__c, l__term, l__term->buffer);
-	}
+	if (l__term == dbg_current_term) dbg_con_flush();
 	
 	mtx_unlock(&dbg_display_mutex); 
 	
@@ -958,10 +1034,9 @@ void dbg_putc(int termid, uint32_t c)
 /*
  * dbg_puts(t, s)
  *
- * Puts a string on a termial. This function
- * don't prints the whole string at once, so
- * it is possible to switch the terminals during
- * the printout of the string.
+ * Puts a string on a termial. The string is written
+ * to the window buffer first. Afterwards the changed 
+ * lines will be copied to the screen at once.
  *
  * The printout string may have a length of 1000
  * charracters.
@@ -972,6 +1047,22 @@ void dbg_puts(int termid, const utf8_t* str)
 	size_t l__len = str_len(str, 1000);
 	size_t l__i;
 	
+	/* Search the terminal descriptor */
+	mtx_lock(&dbg_display_mutex, -1);
+	
+	dbg_terminals_t *l__term = dbg_terminals;
+	
+	while(l__term != NULL)
+	{
+		if (l__term->keynum == termid) 
+			break;
+		else
+			l__term = l__term->ls.n;
+	}
+	
+	/* Did we found it? */
+	if (l__term == NULL) {mtx_unlock(&dbg_display_mutex); return;}
+	
 	for (l__i = 0; l__i < l__len; l__i ++) 
 	{
 		if ((str[l__i] & 0xE0) == 0xC0)
@@ -980,12 +1071,12 @@ void dbg_puts(int termid, const utf8_t* str)
 			if ((l__i + 1) >= l__len)
 			{
 				/* Invalid UTF-8 charracter */
-				dbg_putc(termid, (uint32_t)'?');
+				dbg_term_putc(l__term, (uint32_t)'?');
 				break;
 			}
 			 else
 			{
-				dbg_putc(termid, ((unsigned char)str[l__i + 1] << 8) | ((unsigned char)str[l__i]));
+				dbg_term_putc(l__term, ((unsigned char)str[l__i + 1] << 8) | ((unsigned char)str[l__i]));
 				l__i ++;
 			}
 		}
@@ -995,21 +1086,26 @@ void dbg_puts(int termid, const utf8_t* str)
 			if ((l__i + 2) >= l__len)
 			{
 				/* Invalid UTF-8 charracter */
-				dbg_putc(termid, (uint32_t)'?');
+				dbg_term_putc(l__term, (uint32_t)'?');
 			 	break;
 			}
 				 else				
 			{
-				dbg_putc(termid, ((unsigned char)str[l__i + 2] << 16) | ((unsigned char)str[l__i + 1] << 8) | ((unsigned char)str[l__i]));
+				dbg_term_putc(l__term, ((unsigned char)str[l__i + 2] << 16) | ((unsigned char)str[l__i + 1] << 8) | ((unsigned char)str[l__i]));
 				l__i += 2;
 			}
 		} 
 		 else
 		{
 			/* No. Just ASCII / UTF-8 one octet*/
-			dbg_putc(termid, (uint32_t)str[l__i]);
+			dbg_term_putc(l__term, (uint32_t)str[l__i]);
 		}
 	}
+	
+	/* Update the screen */
+	if (l__term == dbg_current_term) dbg_con_flush();
+	
+	mtx_unlock(&dbg_display_mutex);
 
 	return;
 }
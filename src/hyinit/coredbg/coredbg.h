@@ -72,6 +72,8 @@ typedef struct
 	int		keynum;			/* F-Key for window selection (2 - 12) */
 	
 	char		*buffer;		/* Window buffer (25 lines) */
+	int		top;			/* Buffer line of the first screen line */
+	uint32_t	dirty;			/* Changed screen lines (bit n = line n) */
 	uint32_t	keybuf;			/* Keyboard buffer */
 	
 	char		*headline;		/* Headline of the terminal window */
@@ -93,6 +95,8 @@ typedef struct
 	list_t	ls;				/* Linked list of terminals */
 }dbg_terminals_t;
 
+#define DBGTERM_ALL_LINES		0x1FFFFFF	/* Dirty mask of all 25 lines */
+
 extern mtx_t dbg_display_mutex;
 extern thread_t* dbg_keyboard_thread;
 extern dbg_terminals_t *dbg_terminals;
@@ -266,6 +270,13 @@ typedef struct
 	
 	dbg_breaks_t	*breakpoints;		/* List of break points */
 	unsigned	breakpoints_n;		/* Count of break points */
+	
+	/* Streamed system calls (DBG_TRACE_SYSCALLS without DBG_HALT_SYSCALLS) */
+	uint32_t	stream_pos;		/* Next record of the trace ring */
+	uint32_t	stream_tsc;		/* Time stamp of the last system call */
+	uint32_t	stream_lost;		/* Records lost by an overflow */
+	
+	dc_ring_t	*ring;			/* Mapping of the console ring (or NULL) */
 
 	list_t		ls;			/* It is organized as a linked list */
 }dbg_client_t;
@@ -298,6 +309,7 @@ dbg_registers_t dbg_get_registers(sid_t client);			/* Get the registers of the c
 void dbg_set_registers(sid_t client, dbg_registers_t reg);		/* Change the registers of the current client */
 
 utf8_t* dbg_analyze_syscall(int sysc, sid_t client);			/* Displays a system call information of a client */
+utf8_t* dbg_analyze_syscall_regs(int sysc, const dbg_registers_t *regs);	/* Displays a system call information */
 utf8_t* dbg_analyze_exception(int intr, sid_t client);			/* Displays an exception information  of a client */
 utf8_t* dbg_analyze_softint(int intr, sid_t client);			/* Displays any software interrupt of a client */
 
@@ -310,6 +322,8 @@ void dbg_set_eflags(sid_t client, uint32_t flags);			/* Sets the current EFLAGS
 
 int dbg_read(sid_t client, uintptr_t adr, void* buf, size_t len);		/* Read datas from the client's memory */
 int dbg_write(sid_t client, uintptr_t adr, const void* buf, size_t len);	/* Write datas to the client's memory */
+void dbg_window_flush(sid_t client);					/* Unmaps the cached memory pages of a client */
+void* dbg_map_shared(sid_t client, uintptr_t adr, size_t len);		/* Maps the client's memory writeable */
 
 uint32_t dbg_read_stack(sid_t client, int level);			/* Reads a dword from the client's stack */
 
@@ -343,6 +357,7 @@ void dbg_disconnect_client(sid_t client);				/* Disconnects a client */
 
 int dbg_execute_client_command(dbg_client_t *client, dbg_registers_t *regs);	/* Executes a client command which was detected by dbg_handle_event */
 int dbg_handle_event(dbg_client_t *client, int nr);			/* Handle an interrupt event */
+void dbg_drain_console(dbg_client_t *client);				/* Outputs the console ring of a client */
 
 /* Logon operations */
 void dbg_logon_client(sid_t client);					/* Logs a client on to the debugger */
@@ -388,5 +403,10 @@ int dbg_sh_break(void);				/* Installs, Reads or deletes a breakpoint */
 int dbg_sh_sysinfo(void);			/* Outputs system informations */
 int dbg_sh_proc(void);				/* Outputs process informations */
 int dbg_sh_thrd(void);				/* Outputs process informations */
+int dbg_sh_irqlat(void);			/* Outputs the IRQ latency histogram */
+int dbg_sh_top(void);				/* Outputs the busiest threads */
+int dbg_sh_ktrace(void);			/* Controls and outputs the kernel trace ring */
+int dbg_sh_profile(void);			/* Samples the call chains of a process */
+void dbg_ktrace_stream(dbg_client_t *client);	/* Outputs the streamed system calls of a client */
 
 #endif
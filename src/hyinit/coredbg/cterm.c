@@ -21,6 +21,7 @@
 #include <hydrixos/system.h>
 
 #include <hydrixos/pmap.h>
+#include <hymk/trace.h>
 
 #include "../hyinit.h"
 #include "coredbg.h"
@@ -53,6 +54,30 @@ void dbg_execute_client(dbg_client_t *client)
 	dbg_shell_t *l__shell = *dbg_tls_shellptr;
 	int l__softint = -1;
 	int l__halt, l__trace;
+	unsigned l__recvflags;
+	
+	/* 
+	 * Traced but not halting system calls don't stop the client. 
+	 * They are streamed through the trace ring.
+	 *
+	 */
+	if (    (client->trace_flags & DBG_TRACE_SYSCALLS)
+	     && (!(client->halt_flags & DBG_HALT_SYSCALLS))
+	   )
+	{
+		l__recvflags = RECV_AWAKE_OTHER|RECV_TRACE_SYSCALL|RECV_STREAM_SYSCALL;
+		
+		client->stream_pos = 0;
+		client->stream_tsc = 0;
+		client->stream_lost = 0;
+		
+		if (hysys_info_read(MAININFO_TRACE_RECORDS) != 0)
+			client->stream_pos = hysys_info_read(MAININFO_TRACE_HEAD);
+	}
+	 else
+	{
+		l__recvflags = RECV_AWAKE_OTHER|RECV_TRACE_SYSCALL;
+	}
 		
 	while (1)
 	{
@@ -75,8 +100,24 @@ void dbg_execute_client(dbg_client_t *client)
 			dbg_set_eflags(client->client, l__eflags);
 		}
 
+		/* The client will change its memory */
+		dbg_window_flush(client->client);
+		
 		/* Receive and handle software interrupts */
-		l__softint = hymk_recv_softints(client->client, 0xFFFFFFFF, RECV_AWAKE_OTHER|RECV_TRACE_SYSCALL);
+		unsigned l__flags = l__recvflags;
+		
+		do
+		{
+			l__softint = hymk_recv_softints(client->client, 0xFFFFFFFF, l__flags);
+			
+			/* The client is still running after RECV_STREAM_DATA */
+			l__flags &= (~RECV_AWAKE_OTHER);
+		
+			/* Output the streamed system calls before the event */
+			if (l__recvflags & RECV_STREAM_SYSCALL)
+				dbg_ktrace_stream(client);
+				
+		}while ((unsigned)l__softint == RECV_STREAM_DATA);
 
 		int l__i = dbg_handle_event(client, l__softint);
 		
@@ -99,6 +140,16 @@ void dbg_execute_client(dbg_client_t *client)
 		}		
 	}
 		
+	/* Stop the streaming */
+	if (l__recvflags & RECV_STREAM_SYSCALL)
+	{
+		hymk_recv_softints(client->client, 0, 0);
+		*tls_errno = 0;
+		
+		if (client->stream_lost)
+			dbg_iprintf(l__shell->terminal, "%u trace records of 0x%X lost (trace ring overflow).\n", client->stream_lost, client->client);
+	}
+	
 	/* Delete trace flags */
 	uint32_t l__eflags = dbg_get_eflags(client->client);
 	l__eflags &= (~EFLAG_TRAP_FLAG);
@@ -122,6 +173,47 @@ void dbg_disconnect_client(sid_t client)
 }
 
 
+/*
+ * dbg_drain_console(client)
+ *
+ * Outputs the content of the console ring of the client "client"
+ * on the terminal of its shell.
+ *
+ */
+void dbg_drain_console(dbg_client_t *client)
+{
+	dbg_shell_t *l__shell = client->shell;
+	dc_ring_t *l__ring = client->ring;
+	utf8_t l__buf[257];
+	
+	if ((l__ring == NULL) || (l__shell == NULL)) return;
+	
+	uint32_t l__head = l__ring->out_head;
+	uint32_t l__tail = l__ring->out_tail;
+	
+	/* Invalid pointers, skip the content */
+	if ((l__head - l__tail) > DC_RING_OUT_SIZE)
+		l__tail = l__head;
+	
+	while (l__tail != l__head)
+	{
+		int l__n = 0;
+		
+		while ((l__tail != l__head) && (l__n < 256))
+		{
+			l__buf[l__n ++] = l__ring->out[l__tail & (DC_RING_OUT_SIZE - 1)];
+			l__tail ++;
+		}
+		
+		l__buf[l__n] = 0;
+		dbg_puts(l__shell->terminal, l__buf);
+	}
+	
+	l__ring->out_tail = l__tail;
+	
+	return;
+}
+
 /*
  * dbg_handle_event(client, nr)
  *
@@ -149,6 +241,9 @@ int dbg_handle_event(dbg_client_t *client, int nr)
 		return -1;
 	}
 	
+	/* Output the buffered console output before */
+	dbg_drain_console(client);
+	
 	/*
 	 * Get its halt and trace flags
 	 *
@@ -244,7 +339,7 @@ int dbg_handle_event(dbg_client_t *client, int nr)
 		}
 	}
 	/* IRQs + Emptyints */
-	 else if (((nr >= 0xA0) && (nr <= 0xAF)) || ((nr < 0xBF) || (nr > 0xD6)))
+	 else if (((nr >= 0xA0) && (nr <= 0xAF)) || ((nr < 0xBF) || (nr > 0xDF)))
 	{
 		if ((l__trace & DBG_TRACE_OTHER_SOFTINTS) || (l__halt & DBG_HALT_OTHER_SOFTINTS))
 		{
@@ -261,7 +356,7 @@ int dbg_handle_event(dbg_client_t *client, int nr)
 		}
 	}
 	/* Syscalls */
-	 else if ((nr >= 0xC0) && (nr <= 0xD6)) 
+	 else if ((nr >= 0xC0) && (nr <= 0xDF)) 
 	{
 		if ((l__trace & DBG_TRACE_SYSCALLS) || (l__halt & DBG_HALT_SYSCALLS))
 		{
@@ -491,6 +586,13 @@ int dbg_execute_client_command(dbg_client_t *client, dbg_registers_t *regs)
 		
 		case (DBG_COM_GETS):
 		{
+			/* Return it in the console ring */
+			if ((regs->ecx == 0) && (client->ring != NULL) && (regs->ebx <= DC_RING_IN_SIZE))
+			{
+				dbg_gets(l__shell->terminal, regs->ebx, client->ring->in);
+				break;
+			}
+			
 			utf8_t *l__buf = mem_alloc(regs->ebx);
 			if (l__buf == NULL)
 			{
@@ -510,6 +612,34 @@ int dbg_execute_client_command(dbg_client_t *client, dbg_registers_t *regs)
 			break;
 		}	
 			
+		case (DBG_COM_CONNECT_RING):
+		{
+			if (client->ring != NULL)
+			{
+				pmap_free(client->ring);
+				client->ring = NULL;
+			}
+			
+			/* The ring has to be page aligned */
+			if ((regs->ebx == 0) || (regs->ebx & 0xFFF))
+			{
+				*tls_errno = ERR_INVALID_ADDRESS;
+				regs->ebx = -1;
+				break;
+			}
+			
+			client->ring = dbg_map_shared(client->client, regs->ebx, sizeof(dc_ring_t));
+			
+			regs->ebx = (client->ring == NULL) ? -1 : 0;
+			break;
+		}
+		
+		case (DBG_COM_FLUSH):
+		{
+			/* Already done by dbg_handle_event */
+			break;
+		}
+		
 		case (DBG_COM_SET_TERMINAL):
 		{
 			regs->ebx = dbg_change_terminal(client, regs->ebx);
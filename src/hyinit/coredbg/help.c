@@ -270,7 +270,11 @@ int dbg_sh_help(void)
 		dbg_iprintf(l__shell->terminal, "\t[+I | -I]     \tSet (+I) or delete (-I) tracing of other software interrupts\n");
 		dbg_iprintf(l__shell->terminal, "\t[+D | -D]     \tSet (+D) or delete (-D) tracing of debugger calls\n");
 		dbg_iprintf(l__shell->terminal, "\t[+S | -S]     \tSet (+S) or delete (-S) tracing of system calls\n");
-		dbg_iprintf(l__shell->terminal, "\t[+M | -M]     \tSet (+M) or delete (-M) tracing of executed instructions\n");
+		dbg_iprintf(l__shell->terminal, "\t[+M | -M]     \tSet (+M) or delete (-M) tracing of executed instructions\n\n");
+		dbg_iprintf(l__shell->terminal, "\tTraced system calls don't stop the client, if the client\n");
+		dbg_iprintf(l__shell->terminal, "\tdoesn't halt on system calls. The kernel writes them to\n");
+		dbg_iprintf(l__shell->terminal, "\tthe trace ring. If the ring overflows, the number of lost\n");
+		dbg_iprintf(l__shell->terminal, "\trecords will be printed.\n");
 		dbg_iprintf(l__shell->terminal, "\n");
 	}
 	 else if (dbg_test_par(1, "halton") != -1)
@@ -331,7 +335,71 @@ int dbg_sh_help(void)
 		dbg_iprintf(l__shell->terminal, "\t-s            \tCreate a list of all valid names and numbers.\n");
 		dbg_iprintf(l__shell->terminal, "\n");
 	}
- 	 else if (dbg_test_par(1, "proc") != -1)
+ 	 else if (dbg_test_par(1, "irqlat") != -1)
+	{
+		dbg_iprintf(l__shell->terminal, "irqlat - Print the latency histogram of an IRQ\n\n");
+		dbg_iprintf(l__shell->terminal, "Usage:\n\tirqlat <irq>\n");
+		dbg_iprintf(l__shell->terminal, "\t<irq>         \tThe number of the IRQ (Dec).\n\n");
+		dbg_iprintf(l__shell->terminal, "\tPrints how often the handler thread of the IRQ got the CPU\n");
+		dbg_iprintf(l__shell->terminal, "\tafter less than a certain number of TSC cycles.\n");
+		dbg_iprintf(l__shell->terminal, "\n");
+	}
+ 	 else if (dbg_test_par(1, "top") != -1)
+	{
+		dbg_iprintf(l__shell->terminal, "top - Print the threads with the highest CPU usage\n\n");
+		dbg_iprintf(l__shell->terminal, "Usage:\n\ttop [-t <ms>] [-n <count>]\n");
+		dbg_iprintf(l__shell->terminal, "\t-t <ms>       \tLength of the sample in milliseconds (Dec).\n");
+		dbg_iprintf(l__shell->terminal, "\t              \tThe default is 1000.\n");
+		dbg_iprintf(l__shell->terminal, "\t-n <count>    \tNumber of threads to show (Dec). The default\n");
+		dbg_iprintf(l__shell->terminal, "\t              \tis 10.\n\n");
+		dbg_iprintf(l__shell->terminal, "\tShows the CPU share (in percent of the timer ticks), the\n");
+		dbg_iprintf(l__shell->terminal, "\tCPU time (in units of 1024 TSC cycles), the voluntary and\n");
+		dbg_iprintf(l__shell->terminal, "\tinvoluntary thread switches, the syncs, page faults and\n");
+		dbg_iprintf(l__shell->terminal, "\tIRQs of every thread during the sample.\n");
+		dbg_iprintf(l__shell->terminal, "\n");
+	}
+ 	 else if (dbg_test_par(1, "ktrace") != -1)
+	{
+		dbg_iprintf(l__shell->terminal, "ktrace - Control and print the kernel trace ring\n\n");
+		dbg_iprintf(l__shell->terminal, "Usage:\n\tktrace [-m <mask>] [-r] [-d <count>] [-s]\n");
+		dbg_iprintf(l__shell->terminal, "\t-m <mask>     \tSelect the recorded categories (Hex):\n");
+		dbg_iprintf(l__shell->terminal, "\t              \t1 Thread switches and wakeups\n");
+		dbg_iprintf(l__shell->terminal, "\t              \t2 System calls\n");
+		dbg_iprintf(l__shell->terminal, "\t              \t4 Page faults\n");
+		dbg_iprintf(l__shell->terminal, "\t              \t8 IRQs\n");
+		dbg_iprintf(l__shell->terminal, "\t              \t10 Time outs\n");
+		dbg_iprintf(l__shell->terminal, "\t-r            \tDiscard all records.\n");
+		dbg_iprintf(l__shell->terminal, "\t-d <count>    \tPrint the last <count> records (Dec).\n");
+		dbg_iprintf(l__shell->terminal, "\t-s            \tPrint the number of records of every type\n");
+		dbg_iprintf(l__shell->terminal, "\t              \tand the duration of the system calls.\n");
+		dbg_iprintf(l__shell->terminal, "\n");
+	}
+ 	 else if (dbg_test_par(1, "profile") != -1)
+	{
+		dbg_iprintf(l__shell->terminal, "profile - Sample the call chains of a process\n\n");
+		dbg_iprintf(l__shell->terminal, "Usage:\n\tprofile [-c <sid> | -a] [-g <depth>] [-t <ms>] [-n <count>]\n");
+		dbg_iprintf(l__shell->terminal, "\t-c <sid>      \tSample the process <sid> or the process of\n");
+		dbg_iprintf(l__shell->terminal, "\t              \tthe thread <sid> (Hex). Default is the\n");
+		dbg_iprintf(l__shell->terminal, "\t              \tcurrent client.\n");
+		dbg_iprintf(l__shell->terminal, "\t-a            \tSample all processes.\n");
+		dbg_iprintf(l__shell->terminal, "\t-g <depth>    \tNumber of recorded return addresses (Dec,\n");
+		dbg_iprintf(l__shell->terminal, "\t              \t0 - 3). Default is 3.\n");
+		dbg_iprintf(l__shell->terminal, "\t-t <ms>       \tLength of the sample in ms (Dec). Default\n");
+		dbg_iprintf(l__shell->terminal, "\t              \tis 1000.\n");
+		dbg_iprintf(l__shell->terminal, "\t-n <count>    \tNumber of lines to show (Dec). Default\n");
+		dbg_iprintf(l__shell->terminal, "\t              \tis 20.\n\n");
+		dbg_iprintf(l__shell->terminal, "\tEvery timer tick that interrupts the process in user\n");
+		dbg_iprintf(l__shell->terminal, "\tmode records the instruction pointer and the return\n");
+		dbg_iprintf(l__shell->terminal, "\taddresses of the EBP chain in a sample buffer of the\n");
+		dbg_iprintf(l__shell->terminal, "\tkernel, that only the debugger can read.\n");
+		dbg_iprintf(l__shell->terminal, "\tSELF counts the samples at an address, TOTAL also the\n");
+		dbg_iprintf(l__shell->terminal, "\tsamples below a call site. Call chains need code built\n");
+		dbg_iprintf(l__shell->terminal, "\twith -fno-omit-frame-pointer. Use the host script\n");
+		dbg_iprintf(l__shell->terminal, "\t'profsym' to resolve the addresses with a link map.\n");
+		dbg_iprintf(l__shell->terminal, "\tOther trace categories are off during the sample.\n");
+		dbg_iprintf(l__shell->terminal, "\n");
+	}
+	 else if (dbg_test_par(1, "proc") != -1)
 	{
 		dbg_iprintf(l__shell->terminal, "proc - Print informations about a certain process\n\n");
 		dbg_iprintf(l__shell->terminal, "Usage:\n\tproc {-n <name>|-a <num>} [-s] [-c <sid>]\n");
@@ -399,6 +467,10 @@ int dbg_sh_help(void)
 		dbg_iprintf(l__shell->terminal, "\tsysinfo\t- Print informations from the main information page.\n");
 		dbg_iprintf(l__shell->terminal, "\tproc   \t- Print informations about a certain process.\n");
 		dbg_iprintf(l__shell->terminal, "\tthrd   \t- Print informations about a certain thread.\n");
+		dbg_iprintf(l__shell->terminal, "\tirqlat \t- Print the latency histogram of an IRQ.\n");
+		dbg_iprintf(l__shell->terminal, "\ttop    \t- Print the threads with the highest CPU usage.\n");
+		dbg_iprintf(l__shell->terminal, "\tktrace \t- Control and print the kernel trace ring.\n");
+		dbg_iprintf(l__shell->terminal, "\tprofile\t- Sample the call chains of a process.\n");
 				
 		dbg_iprintf(l__shell->terminal, "\n\nEnter help <command> for more detailed informations about the selected command.\n\n");
 	}
@@ -38,7 +38,7 @@ typedef struct
 #define DBG_INFO_MKTHRD(___p)		DBG_INFO_MKNAME(___p, THRTAB_)
 
 /* Table of names for "sysinfo" */
-#define DBG_SYSINFOTAB_SIZE		20
+#define DBG_SYSINFOTAB_SIZE		36
 
 static const dbg_info_nametable_t   dbg_sysinfo_tab[DBG_SYSINFOTAB_SIZE] =
 {
@@ -54,6 +54,21 @@ static const dbg_info_nametable_t   dbg_sysinfo_tab[DBG_SYSINFOTAB_SIZE] =
 	DBG_INFO_MKMAIN(CPU_ID_CODE),
 	DBG_INFO_MKMAIN(PAGE_SIZE),	
 	DBG_INFO_MKMAIN(MAX_PAGE_OPERATION),
+	DBG_INFO_MKMAIN(RECLAIMED_PAGES),
+	DBG_INFO_MKMAIN(RECLAIM_PENDING),
+	DBG_INFO_MKMAIN(IRQ_LINES),
+	DBG_INFO_MKMAIN(DEADLINE_BANDWIDTH),
+	DBG_INFO_MKMAIN(CLOCK_SEQUENCE),
+	DBG_INFO_MKMAIN(CLOCK_TSC_LOW),
+	DBG_INFO_MKMAIN(CLOCK_TSC_HIGH),
+	DBG_INFO_MKMAIN(CLOCK_NS_LOW),
+	DBG_INFO_MKMAIN(CLOCK_NS_HIGH),
+	DBG_INFO_MKMAIN(CLOCK_MULT),
+	DBG_INFO_MKMAIN(CLOCK_TICK_NS),
+	DBG_INFO_MKMAIN(CLOCK_TSC_KHZ),
+	DBG_INFO_MKMAIN(TRACE_RECORDS),
+	DBG_INFO_MKMAIN(PROFILE_SAMPLES),
+	DBG_INFO_MKMAIN(PROFILE_DROPPED),
 
 	DBG_INFO_MKMAIN(X86_CPU_NAME_PART_1),	
 	DBG_INFO_MKMAIN(X86_CPU_NAME_PART_2),
@@ -62,11 +77,12 @@ static const dbg_info_nametable_t   dbg_sysinfo_tab[DBG_SYSINFOTAB_SIZE] =
 	DBG_INFO_MKMAIN(X86_CPU_FAMILY),		
 	DBG_INFO_MKMAIN(X86_CPU_MODEL),	
 	DBG_INFO_MKMAIN(X86_CPU_STEPPING),
-	DBG_INFO_MKMAIN(X86_RAM_SIZE)
+	DBG_INFO_MKMAIN(X86_RAM_SIZE),
+	DBG_INFO_MKMAIN(X86_APIC_ACTIVE)
 };
 
 /* Table of names for "proc" */
-#define DBG_PROCINFOTAB_SIZE		14
+#define DBG_PROCINFOTAB_SIZE		22
 
 static const dbg_info_nametable_t   dbg_procinfo_tab[DBG_PROCINFOTAB_SIZE] =
 {
@@ -83,12 +99,20 @@ static const dbg_info_nametable_t   dbg_procinfo_tab[DBG_PROCINFOTAB_SIZE] =
 	DBG_INFO_MKPROC(THREAD_COUNT),
 	DBG_INFO_MKPROC(THREAD_LIST_BEGIN),
 	DBG_INFO_MKPROC(UNIQUE_ID),
+	DBG_INFO_MKPROC(RECLAIM_NEXT),
+	DBG_INFO_MKPROC(RECLAIM_TABLE),
+	DBG_INFO_MKPROC(IO_BITMAP_LOW),
+	DBG_INFO_MKPROC(IO_BITMAP_HIGH),
+	DBG_INFO_MKPROC(IO_BITMAP_SIZE),
+	DBG_INFO_MKPROC(CPU_TIME_LOW),
+	DBG_INFO_MKPROC(CPU_TIME_HIGH),
+	DBG_INFO_MKPROC(CPU_TICKS),
 
 	DBG_INFO_MKPROC(X86_MMTABLE)
 };
 
 /* Table of names for "thrd" */
-#define DBG_THRDINFOTAB_SIZE		41
+#define DBG_THRDINFOTAB_SIZE		71
 
 static const dbg_info_nametable_t   dbg_thrdinfo_tab[DBG_THRDINFOTAB_SIZE] =
 {
@@ -129,11 +153,42 @@ static const dbg_info_nametable_t   dbg_thrdinfo_tab[DBG_THRDINFOTAB_SIZE] =
 
 	DBG_INFO_MKTHRD(UNIQUE_ID),
 
+	DBG_INFO_MKTHRD(DEADLINE_RUNTIME),
+	DBG_INFO_MKTHRD(DEADLINE_PERIOD),
+	DBG_INFO_MKTHRD(DEADLINE_BUDGET),
+	DBG_INFO_MKTHRD(DEADLINE_LOW),
+	DBG_INFO_MKTHRD(DEADLINE_HIGH),
+	DBG_INFO_MKTHRD(INHERITED_PRIORITY),
+	DBG_INFO_MKTHRD(INHERITED_CLASS),
+	DBG_INFO_MKTHRD(CPU_TIME_LOW),
+	DBG_INFO_MKTHRD(CPU_TIME_HIGH),
+	DBG_INFO_MKTHRD(CPU_TICKS),
+	DBG_INFO_MKTHRD(VOLUNTARY_SWITCHES),
+	DBG_INFO_MKTHRD(INVOLUNTARY_SWITCHES),
+	DBG_INFO_MKTHRD(WAIT_TIME_LOW),
+	DBG_INFO_MKTHRD(WAIT_TIME_HIGH),
+	DBG_INFO_MKTHRD(WAKEUPS),
+	DBG_INFO_MKTHRD(SYNC_COUNT),
+	DBG_INFO_MKTHRD(PAGEFAULT_COUNT),
+	DBG_INFO_MKTHRD(IRQ_COUNT),
+
 	DBG_INFO_MKTHRD(CUR_SYNC_QUEUE_PREV),
 	DBG_INFO_MKTHRD(CUR_SYNC_QUEUE_NEXT),
 	DBG_INFO_MKTHRD(OWN_SYNC_QUEUE_BEGIN),
 	DBG_INFO_MKTHRD(TIMEOUT_QUEUE_PREV),
 	DBG_INFO_MKTHRD(TIMEOUT_QUEUE_NEXT),
+	DBG_INFO_MKTHRD(PAGED_QUEUE_PREV),
+	DBG_INFO_MKTHRD(PAGED_QUEUE_NEXT),
+	DBG_INFO_MKTHRD(MEMOP_RESTART_OP),
+	DBG_INFO_MKTHRD(MEMOP_RESTART_ADR),
+	DBG_INFO_MKTHRD(MEMOP_RESTART_PAGES),
+	DBG_INFO_MKTHRD(MEMOP_RESTART_DONE),
+	DBG_INFO_MKTHRD(MEMOP_RESTART_RESULT),
+	DBG_INFO_MKTHRD(THROTTLE_NEXT),
+	DBG_INFO_MKTHRD(THROTTLE_COUNT),
+	DBG_INFO_MKTHRD(MEMOP_RESTART_SID),
+	DBG_INFO_MKTHRD(MEMOP_RESTART_FLAGS),
+	DBG_INFO_MKTHRD(MEMOP_RESTART_OFFSET),
 
 	DBG_INFO_MKTHRD(X86_KERNEL_POINTER),
 
@@ -406,3 +461,243 @@ int dbg_sh_thrd(void)
 	
 	return 0;
 }
+
+/*
+ * dbg_sh_irqlat
+ *
+ * Writes the latency histogram of an IRQ handler to the 
+ * terminal
+ *
+ * Usage:
+ *     irqlat <irq>
+ *
+ *		<irq>		The number of the IRQ (Dec).
+ *
+ */
+int dbg_sh_irqlat(void)
+{
+	dbg_shell_t *l__shell = *dbg_tls_shellptr;
+	uint32_t l__irq = 0;
+	int l__n;
+	
+	/* Get the IRQ number */
+	if (l__shell->n_pars < 2)
+	{
+		dbg_iprintf(l__shell->terminal, "Missing parameter. Try \"help irqlat\" for more information.\n");
+		return -1;
+	}
+	
+	if (    (dbglib_atoul(l__shell->pars[1], &l__irq, 10))
+	     || (l__irq >= hysys_info_read(MAININFO_IRQ_LINES))
+	   )
+	{
+		dbg_iprintf(l__shell->terminal, "Invalid IRQ number - %s.\n", l__shell->pars[1]);
+		return -1;
+	}
+	
+	/* Write the histogram */
+	for (l__n = 0; l__n < MAININFO_IRQ_LATENCY_BUCKETS; l__n ++)
+	{
+		if (l__n == (MAININFO_IRQ_LATENCY_BUCKETS - 1))
+		{
+			dbg_iprintf(l__shell->terminal, "IRQ %i >= 2^%i cycles: %i\n", l__irq, l__n + 7, hysys_info_read(MAININFO_IRQ_LATENCY(l__irq, l__n)));
+		}
+		 else
+		{
+			dbg_iprintf(l__shell->terminal, "IRQ %i <  2^%i cycles: %i\n", l__irq, l__n + 8, hysys_info_read(MAININFO_IRQ_LATENCY(l__irq, l__n)));
+		}
+	}
+	
+	return 0;
+}
+
+/*
+ * dbg_top_entry_t
+ *
+ * Counters of a thread at the begin of a "top" sample
+ *
+ */
+typedef struct
+{
+	sid_t		sid;		/* SID of the thread */
+	uint32_t	ticks;		/* THRTAB_CPU_TICKS */
+	uint64_t	cycles;		/* THRTAB_CPU_TIME_* */
+	uint32_t	voluntary;	/* THRTAB_VOLUNTARY_SWITCHES */
+	uint32_t	involuntary;	/* THRTAB_INVOLUNTARY_SWITCHES */
+	uint32_t	syncs;		/* THRTAB_SYNC_COUNT */
+	uint32_t	faults;		/* THRTAB_PAGEFAULT_COUNT */
+	uint32_t	irqs;		/* THRTAB_IRQ_COUNT */
+}dbg_top_entry_t;
+
+#define DBG_TOP_MAX_THREADS		256
+
+static dbg_top_entry_t dbg_top_tab[DBG_TOP_MAX_THREADS];
+
+/*
+ * dbg_top_read_cycles(sid)
+ *
+ * Reads the CPU time of a thread (in TSC cycles)
+ *
+ */
+static uint64_t dbg_top_read_cycles(sid_t sid)
+{
+	uint32_t l__high = 0;
+	uint32_t l__low = 0;
+	
+	/* Reread the low part, if the high part changed meanwhile */
+	do
+	{
+		l__high = hysys_thrtab_read(sid, THRTAB_CPU_TIME_HIGH);
+		l__low = hysys_thrtab_read(sid, THRTAB_CPU_TIME_LOW);
+	}while (l__high != hysys_thrtab_read(sid, THRTAB_CPU_TIME_HIGH));
+	
+	return (((uint64_t)l__high) << 32) | l__low;
+}
+
+/*
+ * dbg_sh_top
+ *
+ * Samples the CPU accounting counters of all threads for
+ * a while and writes the busiest threads to the terminal
+ *
+ * Usage:
+ *     top [-t <ms>] [-n <count>]
+ *
+ *		-t <ms>		Length of the sample (Dec, default 1000)
+ *		-n <count>	Number of threads to show (Dec, default 10)
+ *
+ */
+int dbg_sh_top(void)
+{
+	dbg_shell_t *l__shell = *dbg_tls_shellptr;
+	uint32_t l__time = 1000;
+	uint32_t l__count = 10;
+	uint32_t l__rtc = 0;
+	unsigned l__entries = 0;
+	unsigned l__n;
+	int l__par;
+	
+	/* Get the parameters */
+	l__par = dbg_test_par(1, "-t");
+	if (l__par != -1)
+	{
+		if (    (dbg_par_to_uint(l__par + 1, &l__time, 10))
+		     || (l__time == 0)
+		   )
+		{
+			dbg_iprintf(l__shell->terminal, "Invalid sample time. Try \"help top\" for more information.\n");
+			return -1;
+		}
+	}
+	
+	l__par = dbg_test_par(1, "-n");
+	if (l__par != -1)
+	{
+		if (dbg_par_to_uint(l__par + 1, &l__count, 10))
+		{
+			dbg_iprintf(l__shell->terminal, "Invalid thread count. Try \"help top\" for more information.\n");
+			return -1;
+		}
+	}
+	
+	/* Take the first sample of all used threads */
+	l__rtc = hysys_info_read(MAININFO_RTC_COUNTER_LOW);
+	
+	for (l__n = 0; 
+	     (l__n < ARCH_THREAD_TABLE_ENTRIES) && (l__entries < DBG_TOP_MAX_THREADS);
+	     l__n ++
+	    )
+	{
+		sid_t l__sid = SIDTYPE_THREAD | l__n;
+		dbg_top_entry_t *l__ent = &dbg_top_tab[l__entries];
+		
+		l__ent->ticks = hysys_thrtab_read(l__sid, THRTAB_CPU_TICKS);
+		if (*tls_errno) {*tls_errno = 0; continue;}
+		
+		l__ent->sid = l__sid;
+		l__ent->cycles = dbg_top_read_cycles(l__sid);
+		l__ent->voluntary = hysys_thrtab_read(l__sid, THRTAB_VOLUNTARY_SWITCHES);
+		l__ent->involuntary = hysys_thrtab_read(l__sid, THRTAB_INVOLUNTARY_SWITCHES);
+		l__ent->syncs = hysys_thrtab_read(l__sid, THRTAB_SYNC_COUNT);
+		l__ent->faults = hysys_thrtab_read(l__sid, THRTAB_PAGEFAULT_COUNT);
+		l__ent->irqs = hysys_thrtab_read(l__sid, THRTAB_IRQ_COUNT);
+		
+		l__entries ++;
+	}
+	
+	/* Wait (nobody syncs with our own process) */
+	hymk_sync(hysys_info_read(MAININFO_CURRENT_PROCESS), l__time, 0);
+	*tls_errno = 0;
+	
+	/* Calculate the differences */
+	l__rtc = hysys_info_read(MAININFO_RTC_COUNTER_LOW) - l__rtc;
+	if (l__rtc == 0) l__rtc = 1;
+	
+	for (l__n = 0; l__n < l__entries; l__n ++)
+	{
+		dbg_top_entry_t *l__ent = &dbg_top_tab[l__n];
+		uint32_t l__ticks = hysys_thrtab_read(l__ent->sid, THRTAB_CPU_TICKS);
+		
+		/* Thread terminated meanwhile */
+		if (*tls_errno)
+		{
+			*tls_errno = 0;
+			l__ent->sid = SID_INVALID;
+			continue;
+		}
+		
+		l__ent->ticks = l__ticks - l__ent->ticks;
+		l__ent->cycles = dbg_top_read_cycles(l__ent->sid) - l__ent->cycles;
+		l__ent->voluntary = hysys_thrtab_read(l__ent->sid, THRTAB_VOLUNTARY_SWITCHES) - l__ent->voluntary;
+		l__ent->involuntary = hysys_thrtab_read(l__ent->sid, THRTAB_INVOLUNTARY_SWITCHES) - l__ent->involuntary;
+		l__ent->syncs = hysys_thrtab_read(l__ent->sid, THRTAB_SYNC_COUNT) - l__ent->syncs;
+		l__ent->faults = hysys_thrtab_read(l__ent->sid, THRTAB_PAGEFAULT_COUNT) - l__ent->faults;
+		l__ent->irqs = hysys_thrtab_read(l__ent->sid, THRTAB_IRQ_COUNT) - l__ent->irqs;
+	}
+	
+	/* Write the busiest threads */
+	dbg_iprintf(l__shell->terminal, "Sample of %i ticks\n", l__rtc);
+	dbg_iprintf(l__shell->terminal, "THREAD     PROCESS    CPU   KCYCLES    VOL/INVOL   SYNCS  FAULTS IRQS\n");
+	
+	while (l__count --)
+	{
+		dbg_top_entry_t *l__best = NULL;
+		
+		/* Search the thread with the highest CPU time */
+		for (l__n = 0; l__n < l__entries; l__n ++)
+		{
+			dbg_top_entry_t *l__ent = &dbg_top_tab[l__n];
+			
+			if (l__ent->sid == SID_INVALID) continue;
+			
+			if (    (l__best == NULL)
+			     || (l__ent->ticks > l__best->ticks)
+			     || (    (l__ent->ticks == l__best->ticks)
+			          && (l__ent->cycles > l__best->cycles)
+			        )
+			   )
+			{
+				l__best = l__ent;
+			}
+		}
+		
+		if (l__best == NULL) break;
+		
+		dbg_iprintf(l__shell->terminal, "0x%X 0x%X %i  %i  %i/%i  %i  %i  %i\n",
+			    l__best->sid,
+			    hysys_thrtab_read(l__best->sid, THRTAB_PROCESS_SID),
+			    (l__best->ticks * 100) / l__rtc,
+			    (uint32_t)(l__best->cycles >> 10),
+			    l__best->voluntary,
+			    l__best->involuntary,
+			    l__best->syncs,
+			    l__best->faults,
+			    l__best->irqs
+			   );
+			   
+		*tls_errno = 0;
+		l__best->sid = SID_INVALID;
+	}
+	
+	return 0;
+}
@@ -0,0 +1,812 @@
+/*
+ *
+ * ktrace.c
+ *
+ * (C)2007 by Friedrich Grter
+ *
+ * This file is distributed under the terms of
+ * the GNU General Public License, Version 2. You
+ * should have received a copy of this license (e.g. in 
+ * the file 'copying').   
+ *
+ * Kernel trace ring commands
+ *
+ */
+#include <hydrixos/types.h>
+#include <hydrixos/tls.h>
+#include <hydrixos/errno.h>
+#include <hydrixos/blthr.h>
+#include <hydrixos/mem.h>
+#include <hydrixos/stdfun.h>
+#include <hydrixos/system.h>
+#include <hymk/trace.h>
+
+#include <coredbg/cdebug.h>
+
+#include "../hyinit.h"
+#include "coredbg.h"
+
+/* Names of the trace record types */
+static const utf8_t *dbg_ktrace_names[TRACE_TYPE_MAX + 1] =
+{
+	"?",
+	"switch",
+	"wakeup",
+	"sysenter",
+	"sysexit",
+	"pagefault",
+	"irq",
+	"timeout",
+	"sample",
+	"sysargs"
+};
+
+/* Records copied by the last trace_read (see dbg_ktrace_read) */
+#define DBG_KTRACE_CHUNK		64
+
+static trace_record_t dbg_ktrace_cache[DBG_KTRACE_CHUNK];
+static uint32_t dbg_ktrace_cache_first = 0;
+static unsigned dbg_ktrace_cache_num = 0;
+static mtx_t dbg_ktrace_cache_mtx = MTX_DEFINE();
+
+/* System calls of the summary (0xC0 - 0xFF) */
+#define DBG_KTRACE_SYSCALLS		64
+
+static struct
+{
+	uint32_t	count;		/* Number of calls */
+	uint64_t	cycles;		/* Sum of the durations */
+	uint32_t	max;		/* Longest call */
+}dbg_ktrace_sysc[DBG_KTRACE_SYSCALLS];
+
+/* Size of the profiler tables (power of 2) */
+#define DBG_PROFILE_ENTRIES		1024
+
+/* Sampled addresses */
+static struct
+{
+	uint32_t	adr;		/* Instruction address */
+	uint32_t	self;		/* Samples at this address */
+	uint32_t	total;		/* Samples at or below this call site */
+	int		printed;	/* Already written to the terminal */
+}dbg_profile_tab[DBG_PROFILE_ENTRIES];
+
+/* Sampled calls */
+static struct
+{
+	uint32_t	caller;		/* Return address of the call */
+	uint32_t	callee;		/* Address within the called function */
+	uint32_t	count;		/* Number of samples */
+	int		printed;	/* Already written to the terminal */
+}dbg_profile_calls[DBG_PROFILE_ENTRIES];
+
+/* Samples copied by the last profile_read */
+static trace_record_t dbg_profile_chunk[DBG_KTRACE_CHUNK];
+
+/*
+ * dbg_ktrace_read(num, rec)
+ *
+ * Copies the record 'num' of the trace ring to 'rec'. The
+ * ring is only readable by the trace_read system call, so
+ * DBG_KTRACE_CHUNK records are copied at once and kept for
+ * the following calls.
+ *
+ * Return value:
+ *	0	Successful
+ *	1	The record has been overwritten meanwhile
+ *
+ */
+static int dbg_ktrace_read(uint32_t num, trace_record_t *rec)
+{
+	int l__retval = 0;
+	
+	mtx_lock(&dbg_ktrace_cache_mtx, -1);
+	
+	if ((num - dbg_ktrace_cache_first) >= dbg_ktrace_cache_num)
+	{
+		dbg_ktrace_cache_first = num;
+		dbg_ktrace_cache_num = hymk_trace_read(dbg_ktrace_cache, num, DBG_KTRACE_CHUNK);
+		*tls_errno = 0;
+	}
+	
+	if ((num - dbg_ktrace_cache_first) < dbg_ktrace_cache_num)
+		*rec = dbg_ktrace_cache[num - dbg_ktrace_cache_first];
+	 else
+		l__retval = 1;
+	
+	mtx_unlock(&dbg_ktrace_cache_mtx);
+	
+	return l__retval;
+}
+
+/*
+ * dbg_ktrace_stream(client)
+ *
+ * Writes the system calls of the streamed client "client"
+ * (TRACE_SYSCALL_ENTER and TRACE_SYSCALL_ARGS records of the 
+ * client thread) since the last call to the terminal. Records
+ * that have been overwritten before reading are counted in
+ * client->stream_lost.
+ *
+ * This function expects dbg_client_mtx to be locked and leaves it locked!
+ *
+ */
+void dbg_ktrace_stream(dbg_client_t *client)
+{
+	dbg_shell_t *l__shell = *dbg_tls_shellptr;
+	uint32_t l__size = hysys_info_read(MAININFO_TRACE_RECORDS);
+	uint32_t l__head;
+	uint32_t l__lost = 0;
+	
+	if (l__size == 0) return;
+	
+	l__head = hysys_info_read(MAININFO_TRACE_HEAD);
+	
+	/* The ring has been reset meanwhile */
+	if ((int32_t)(l__head - client->stream_pos) < 0)
+		client->stream_pos = l__head;
+	
+	/* Overflow: Skip the overwritten records */
+	if ((l__head - client->stream_pos) > l__size)
+	{
+		l__lost = (l__head - client->stream_pos) - l__size;
+		client->stream_pos = l__head - l__size;
+	}
+	
+	while (client->stream_pos != l__head)
+	{
+		trace_record_t l__rec, l__args;
+		dbg_registers_t l__regs;
+		utf8_t *l__anl;
+		
+		if (dbg_ktrace_read(client->stream_pos ++, &l__rec)) 
+		{
+			l__lost ++;
+			continue;
+		}
+		
+		if (    (l__rec.type != TRACE_SYSCALL_ENTER) 
+		     || (l__rec.thread != client->client)
+		   )
+		{
+			continue;
+		}
+		
+		l__regs.eax = l__rec.arg[1];
+		l__regs.ebx = l__rec.arg[2];
+		l__regs.ecx = l__rec.arg[3];
+		l__regs.edx = 0;
+		l__regs.esi = 0;
+		l__regs.edi = 0;
+		l__regs.ebp = 0;
+		l__regs.esp = 0;
+		l__regs.eip = 0;
+		l__regs.eflags = 0;
+		
+		/* The kernel writes the other registers to the next record */
+		if (    (client->stream_pos != l__head)
+		     && (!dbg_ktrace_read(client->stream_pos, &l__args))
+		     && (l__args.type == TRACE_SYSCALL_ARGS)
+		     && (l__args.thread == client->client)
+		   )
+		{
+			l__regs.edx = l__args.arg[0];
+			l__regs.esi = l__args.arg[1];
+			l__regs.edi = l__args.arg[2];
+			l__regs.ebp = l__args.arg[3];
+			client->stream_pos ++;
+		}
+		
+		l__anl = dbg_analyze_syscall_regs(l__rec.arg[0], &l__regs);
+		
+		dbg_iprintf(l__shell->terminal, "[DBG 0x%X +%.1u] %s\n", 
+			    client->client,
+			    l__rec.tsc_low - client->stream_tsc,
+			    (l__anl != NULL) ? l__anl : "(invalid)"
+			   );
+			   
+		if (l__anl != NULL) mem_free(l__anl);
+		
+		client->stream_tsc = l__rec.tsc_low;
+	}
+	
+	if (l__lost)
+	{
+		client->stream_lost += l__lost;
+		
+		dbg_set_termcolor(l__shell->terminal, DBGCOL_YELLOW);
+		dbg_iprintf(l__shell->terminal, "[DBG 0x%X] %u trace records lost.\n", client->client, l__lost);
+		dbg_set_termcolor(l__shell->terminal, DBGCOL_GREY);
+	}
+	
+	return;
+}
+
+/*
+ * dbg_ktrace_dump(count)
+ *
+ * Writes the last 'count' records of the trace ring
+ * to the terminal. The time of a record is given in
+ * cycles since the first written record.
+ *
+ */
+static void dbg_ktrace_dump(uint32_t count)
+{
+	dbg_shell_t *l__shell = *dbg_tls_shellptr;
+	uint32_t l__head = hysys_info_read(MAININFO_TRACE_HEAD);
+	uint32_t l__first = 0;
+	uint32_t l__num;
+	int l__valid = 0;
+	
+	if (count > hysys_info_read(MAININFO_TRACE_RECORDS)) 
+		count = hysys_info_read(MAININFO_TRACE_RECORDS);
+	if (count > l__head) count = l__head;
+	
+	for (l__num = l__head - count; l__num != l__head; l__num ++)
+	{
+		trace_record_t l__rec;
+		
+		if (dbg_ktrace_read(l__num, &l__rec)) continue;
+		if (l__rec.type > TRACE_TYPE_MAX) l__rec.type = 0;
+		
+		if (!l__valid)
+		{
+			l__first = l__rec.tsc_low;
+			l__valid = 1;
+		}
+		
+		dbg_iprintf(l__shell->terminal, 
+			    "%i: +%u 0x%X %s 0x%X 0x%X 0x%X 0x%X\n",
+			    l__num,
+			    l__rec.tsc_low - l__first,
+			    l__rec.thread,
+			    dbg_ktrace_names[l__rec.type],
+			    l__rec.arg[0],
+			    l__rec.arg[1],
+			    l__rec.arg[2],
+			    l__rec.arg[3]
+			   );
+	}
+	
+	return;
+}
+
+/*
+ * dbg_ktrace_summary()
+ *
+ * Writes the number of records of every type and the
+ * duration of the traced system calls to the terminal.
+ *
+ */
+static void dbg_ktrace_summary(void)
+{
+	dbg_shell_t *l__shell = *dbg_tls_shellptr;
+	uint32_t l__types[TRACE_TYPE_MAX + 1];
+	uint32_t l__voluntary = 0;
+	uint32_t l__lost = 0;
+	uint32_t l__head = hysys_info_read(MAININFO_TRACE_HEAD);
+	uint32_t l__count = l__head;
+	uint32_t l__num;
+	unsigned l__n;
+	
+	if (l__count > hysys_info_read(MAININFO_TRACE_RECORDS)) 
+		l__count = hysys_info_read(MAININFO_TRACE_RECORDS);
+	
+	for (l__n = 0; l__n <= TRACE_TYPE_MAX; l__n ++)
+		l__types[l__n] = 0;
+		
+	for (l__n = 0; l__n < DBG_KTRACE_SYSCALLS; l__n ++)
+	{
+		dbg_ktrace_sysc[l__n].count = 0;
+		dbg_ktrace_sysc[l__n].cycles = 0;
+		dbg_ktrace_sysc[l__n].max = 0;
+	}
+	
+	/* Count the records */
+	for (l__num = l__head - l__count; l__num != l__head; l__num ++)
+	{
+		trace_record_t l__rec;
+		
+		if (dbg_ktrace_read(l__num, &l__rec)) 
+		{
+			l__lost ++;
+			continue;
+		}
+		
+		if (l__rec.type > TRACE_TYPE_MAX) l__rec.type = 0;
+		l__types[l__rec.type] ++;
+		
+		if ((l__rec.type == TRACE_SWITCH) && (l__rec.arg[1]))
+			l__voluntary ++;
+		
+		if (    (l__rec.type == TRACE_SYSCALL_EXIT)
+		     && (l__rec.arg[0] >= 0xC0)
+		     && (l__rec.arg[0] < (0xC0 + DBG_KTRACE_SYSCALLS))
+		   )
+		{
+			l__n = l__rec.arg[0] - 0xC0;
+			
+			dbg_ktrace_sysc[l__n].count ++;
+			dbg_ktrace_sysc[l__n].cycles += l__rec.arg[1];
+			
+			if (l__rec.arg[1] > dbg_ktrace_sysc[l__n].max)
+				dbg_ktrace_sysc[l__n].max = l__rec.arg[1];
+		}
+	}
+	
+	dbg_iprintf(l__shell->terminal, "Records: %i (%i written, %i overwritten while reading)\n", l__count - l__lost, l__head, l__lost);
+	
+	for (l__n = 1; l__n <= TRACE_TYPE_MAX; l__n ++)
+	{
+		dbg_iprintf(l__shell->terminal, "\t%s\t%i\n", dbg_ktrace_names[l__n], l__types[l__n]);
+	}
+	
+	dbg_iprintf(l__shell->terminal, "Voluntary switches: %i\n", l__voluntary);
+	dbg_iprintf(l__shell->terminal, "SYSCALL  CALLS  AVG. CYCLES  MAX. CYCLES\n");
+	
+	for (l__n = 0; l__n < DBG_KTRACE_SYSCALLS; l__n ++)
+	{
+		uint32_t l__avg;
+		
+		if (dbg_ktrace_sysc[l__n].count == 0) continue;
+		
+		/* Avoid a 64-bit division */
+		l__avg =   (uint32_t)(dbg_ktrace_sysc[l__n].cycles >> 8)
+			 / dbg_ktrace_sysc[l__n].count;
+		
+		dbg_iprintf(l__shell->terminal, "0x%X     %i  %i  %i\n", 
+			    l__n + 0xC0,
+			    dbg_ktrace_sysc[l__n].count,
+			    l__avg << 8,
+			    dbg_ktrace_sysc[l__n].max
+			   );
+	}
+	
+	return;
+}
+
+/*
+ * dbg_sh_ktrace
+ *
+ * Controls the kernel trace ring and writes its content
+ * to the terminal
+ *
+ * Usage:
+ *     ktrace [-m <mask>] [-r] [-d <count>] [-s]
+ *
+ *		-m <mask>	Select the recorded categories (Hex)
+ *		-r		Discard all records
+ *		-d <count>	Dump the last <count> records (Dec)
+ *		-s		Print a summary of the records
+ *
+ */
+int dbg_sh_ktrace(void)
+{
+	dbg_shell_t *l__shell = *dbg_tls_shellptr;
+	uint32_t l__mask = 0;
+	uint32_t l__count = 0;
+	int l__par;
+	
+	/* Change the mask */
+	l__par = dbg_test_par(1, "-m");
+	if (l__par != -1)
+	{
+		if (    (dbg_par_to_uint(l__par + 1, &l__mask, 16))
+		     || (l__mask & (~TRACE_CAT_ALL))
+		   )
+		{
+			dbg_iprintf(l__shell->terminal, "Invalid mask. Try \"help ktrace\" for more information.\n");
+			return -1;
+		}
+		
+		if (dbg_test_par(1, "-r") != -1) l__mask |= TRACE_RESET;
+		
+		hymk_trace_ctl(l__mask);
+		if (*tls_errno)
+		{
+			dbg_iprintf(l__shell->terminal, "Can't change the trace mask (error %i).\n", *tls_errno);
+			*tls_errno = 0;
+			return -1;
+		}
+	}
+	 else if (dbg_test_par(1, "-r") != -1)
+	{
+		if (hysys_info_read(MAININFO_TRACE_RECORDS) != 0)
+		{
+			hymk_trace_ctl(hysys_info_read(MAININFO_TRACE_MASK) | TRACE_RESET);
+			*tls_errno = 0;
+		}
+	}
+	
+	/* The ring isn't allocated before the first trace_ctl */
+	if (hysys_info_read(MAININFO_TRACE_RECORDS) == 0)
+	{
+		dbg_iprintf(l__shell->terminal, "Kernel tracing is not active.\n");
+		return 0;
+	}
+	
+	/* Dump */
+	l__par = dbg_test_par(1, "-d");
+	if (l__par != -1)
+	{
+		if (dbg_par_to_uint(l__par + 1, &l__count, 10))
+		{
+			dbg_iprintf(l__shell->terminal, "Invalid count. Try \"help ktrace\" for more information.\n");
+			return -1;
+		}
+		
+		dbg_ktrace_dump(l__count);
+	}
+	
+	/* Summary */
+	if (dbg_test_par(1, "-s") != -1)
+		dbg_ktrace_summary();
+	
+	dbg_iprintf(l__shell->terminal, "Active categories: 0x%X\n", hysys_info_read(MAININFO_TRACE_MASK));
+	
+	return 0;
+}
+
+/*
+ * dbg_profile_find(adr)
+ *
+ * Returns the entry of the address 'adr' in the profiler
+ * table. A new entry will be created, if the address isn't
+ * in the table, yet.
+ *
+ * Return value:
+ *	>= 0	Entry number
+ *	-1	The table is full
+ *
+ */
+static int dbg_profile_find(uint32_t adr)
+{
+	unsigned l__n = (adr >> 2) & (DBG_PROFILE_ENTRIES - 1);
+	unsigned l__tries;
+	
+	for (l__tries = 0; l__tries < DBG_PROFILE_ENTRIES; l__tries ++)
+	{
+		if (dbg_profile_tab[l__n].adr == adr) return l__n;
+		
+		if (dbg_profile_tab[l__n].adr == 0)
+		{
+			dbg_profile_tab[l__n].adr = adr;
+			return l__n;
+		}
+		
+		l__n = (l__n + 1) & (DBG_PROFILE_ENTRIES - 1);
+	}
+	
+	return -1;
+}
+
+/*
+ * dbg_profile_add_call(caller, callee)
+ *
+ * Counts a sample of the call from the return address
+ * 'caller' to the function at 'callee'.
+ *
+ * Return value:
+ *	0	Successful
+ *	-1	The table is full
+ *
+ */
+static int dbg_profile_add_call(uint32_t caller, uint32_t callee)
+{
+	unsigned l__n = ((caller >> 2) ^ (callee >> 4)) & (DBG_PROFILE_ENTRIES - 1);
+	unsigned l__tries;
+	
+	for (l__tries = 0; l__tries < DBG_PROFILE_ENTRIES; l__tries ++)
+	{
+		if (    (dbg_profile_calls[l__n].caller == caller)
+		     && (dbg_profile_calls[l__n].callee == callee)
+		   )
+		{
+			dbg_profile_calls[l__n].count ++;
+			return 0;
+		}
+		
+		if (dbg_profile_calls[l__n].count == 0)
+		{
+			dbg_profile_calls[l__n].caller = caller;
+			dbg_profile_calls[l__n].callee = callee;
+			dbg_profile_calls[l__n].count = 1;
+			return 0;
+		}
+		
+		l__n = (l__n + 1) & (DBG_PROFILE_ENTRIES - 1);
+	}
+	
+	return -1;
+}
+
+/*
+ * dbg_profile_collect(samples, dropped)
+ *
+ * Adds all samples of the profiler (read by profile_read)
+ * to the profiler tables.
+ *
+ * Parameters:
+ *	samples		Number of counted samples (out)
+ *	dropped		Number of samples that didn't fit into
+ *			the tables or the sample buffer (out)
+ *
+ */
+static void dbg_profile_collect(uint32_t *samples, uint32_t *dropped)
+{
+	uint32_t l__count = hysys_info_read(MAININFO_PROFILE_SAMPLES);
+	uint32_t l__num = 0;
+	uint32_t l__first = 0;
+	unsigned l__read = 0;
+	unsigned l__n;
+	
+	*samples = 0;
+	*dropped = hysys_info_read(MAININFO_PROFILE_DROPPED);
+	
+	for (l__n = 0; l__n < DBG_PROFILE_ENTRIES; l__n ++)
+	{
+		dbg_profile_tab[l__n].adr = 0;
+		dbg_profile_tab[l__n].self = 0;
+		dbg_profile_tab[l__n].total = 0;
+		dbg_profile_tab[l__n].printed = 0;
+		dbg_profile_calls[l__n].count = 0;
+		dbg_profile_calls[l__n].printed = 0;
+	}
+	
+	while (l__num < l__count)
+	{
+		trace_record_t l__rec;
+		uint32_t l__callee;
+		int l__ent;
+		
+		/* Copy the next chunk of samples */
+		if ((l__num - l__first) >= l__read)
+		{
+			l__first = l__num;
+			l__read = hymk_profile_read(dbg_profile_chunk, l__num, DBG_KTRACE_CHUNK);
+			if (l__read == 0) 
+			{
+				*tls_errno = 0;
+				(*dropped) += l__count - l__num;
+				break;
+			}
+		}
+		
+		l__rec = dbg_profile_chunk[l__num - l__first];
+		l__num ++;
+		
+		if (l__rec.type != TRACE_SAMPLE) continue;
+		
+		/* The sampled instruction */
+		l__ent = dbg_profile_find(l__rec.arg[0]);
+		if (l__ent == -1)
+		{
+			(*dropped) ++;
+			continue;
+		}
+		
+		dbg_profile_tab[l__ent].self ++;
+		dbg_profile_tab[l__ent].total ++;
+		(*samples) ++;
+		
+		/* The call sites (return addresses) */
+		l__callee = l__rec.arg[0];
+		
+		for (l__n = 1; l__n <= TRACE_SAMPLE_DEPTH; l__n ++)
+		{
+			if (l__rec.arg[l__n] == 0) break;
+			
+			l__ent = dbg_profile_find(l__rec.arg[l__n]);
+			if (l__ent != -1) dbg_profile_tab[l__ent].total ++;
+			
+			dbg_profile_add_call(l__rec.arg[l__n], l__callee);
+			l__callee = l__rec.arg[l__n];
+		}
+	}
+	
+	return;
+}
+
+/*
+ * dbg_profile_print(count)
+ *
+ * Writes the 'count' addresses with the most samples and 
+ * the 'count' most sampled calls to the terminal.
+ *
+ */
+static void dbg_profile_print(uint32_t count)
+{
+	dbg_shell_t *l__shell = *dbg_tls_shellptr;
+	uint32_t l__line;
+	unsigned l__n;
+	
+	dbg_iprintf(l__shell->terminal, "SELF\tTOTAL\tADDRESS\n");
+	
+	for (l__line = 0; l__line < count; l__line ++)
+	{
+		int l__best = -1;
+		
+		for (l__n = 0; l__n < DBG_PROFILE_ENTRIES; l__n ++)
+		{
+			if (    (dbg_profile_tab[l__n].adr == 0)
+			     || (dbg_profile_tab[l__n].printed)
+			   )
+			{
+				continue;
+			}
+			
+			if (    (l__best == -1) 
+			     || (dbg_profile_tab[l__n].self > dbg_profile_tab[l__best].self)
+			     || (    (dbg_profile_tab[l__n].self == dbg_profile_tab[l__best].self)
+			          && (dbg_profile_tab[l__n].total > dbg_profile_tab[l__best].total)
+			        )
+			   )
+			{
+				l__best = l__n;
+			}
+		}
+		
+		if (l__best == -1) break;
+		
+		dbg_profile_tab[l__best].printed = 1;
+		dbg_iprintf(l__shell->terminal, "%.1u\t%.1u\t0x%.8X\n",
+			    dbg_profile_tab[l__best].self,
+			    dbg_profile_tab[l__best].total,
+			    dbg_profile_tab[l__best].adr
+			   );
+	}
+	
+	dbg_iprintf(l__shell->terminal, "CALLS\tCALLER\t\tCALLEE\n");
+	
+	for (l__line = 0; l__line < count; l__line ++)
+	{
+		int l__best = -1;
+		
+		for (l__n = 0; l__n < DBG_PROFILE_ENTRIES; l__n ++)
+		{
+			if (    (dbg_profile_calls[l__n].count == 0)
+			     || (dbg_profile_calls[l__n].printed)
+			   )
+			{
+				continue;
+			}
+			
+			if (    (l__best == -1) 
+			     || (dbg_profile_calls[l__n].count > dbg_profile_calls[l__best].count)
+			   )
+			{
+				l__best = l__n;
+			}
+		}
+		
+		if (l__best == -1) break;
+		
+		dbg_profile_calls[l__best].printed = 1;
+		dbg_iprintf(l__shell->terminal, "%.1u\t0x%.8X -> 0x%.8X\n",
+			    dbg_profile_calls[l__best].count,
+			    dbg_profile_calls[l__best].caller,
+			    dbg_profile_calls[l__best].callee
+			   );
+	}
+	
+	return;
+}
+
+/*
+ * dbg_sh_profile
+ *
+ * Samples the user mode instruction pointer and the 
+ * call chain of a process with every timer tick for a 
+ * while and writes the most sampled addresses and calls
+ * to the terminal
+ *
+ * Usage:
+ *     profile [-c <sid> | -a] [-g <depth>] [-t <ms>] [-n <count>]
+ *
+ *		-c <sid>	Process (or a thread of it) to sample 
+ *				(Hex, default: current client)
+ *		-a		Sample all processes
+ *		-g <depth>	Number of recorded return addresses
+ *				(Dec, 0 - 3, default 3)
+ *		-t <ms>		Length of the sample (Dec, default 1000)
+ *		-n <count>	Number of lines to show (Dec, default 20)
+ *
+ */
+int dbg_sh_profile(void)
+{
+	dbg_shell_t *l__shell = *dbg_tls_shellptr;
+	uint32_t l__depth = TRACE_SAMPLE_DEPTH;
+	uint32_t l__time = 1000;
+	uint32_t l__count = 20;
+	uint32_t l__samples = 0;
+	uint32_t l__dropped = 0;
+	sid_t l__sid;
+	int l__par;
+	
+	/* Get the parameters */
+	if (dbg_test_par(1, "-a") != -1)
+	{
+		l__sid = SID_USER_EVERYBODY;
+	}
+	 else
+	{
+		l__sid = dbg_get_sidpar("profile", SIDTYPE_PROCESS);
+		if (l__sid == SID_INVALID)
+			return -1;
+			
+		/* Is it a thread SID? */
+		if (l__sid & SIDTYPE_THREAD)
+		{
+			l__sid = hysys_thrtab_read(l__sid, THRTAB_PROCESS_SID);
+			*tls_errno = 0;
+		}
+		
+		if ((l__sid & SID_TYPE_MASK) != SIDTYPE_PROCESS)
+		{
+			dbg_iprintf(l__shell->terminal, "Invalid process. Try \"help profile\" for more information.\n");
+			return -1;
+		}
+	}
+	
+	l__par = dbg_test_par(1, "-g");
+	if (l__par != -1)
+	{
+		if (    (dbg_par_to_uint(l__par + 1, &l__depth, 10))
+		     || (l__depth > TRACE_SAMPLE_DEPTH)
+		   )
+		{
+			dbg_iprintf(l__shell->terminal, "Invalid call chain depth. Try \"help profile\" for more information.\n");
+			return -1;
+		}
+	}
+	
+	l__par = dbg_test_par(1, "-t");
+	if (l__par != -1)
+	{
+		if (    (dbg_par_to_uint(l__par + 1, &l__time, 10))
+		     || (l__time == 0)
+		   )
+		{
+			dbg_iprintf(l__shell->terminal, "Invalid sample time. Try \"help profile\" for more information.\n");
+			return -1;
+		}
+	}
+	
+	l__par = dbg_test_par(1, "-n");
+	if (l__par != -1)
+	{
+		if (dbg_par_to_uint(l__par + 1, &l__count, 10))
+		{
+			dbg_iprintf(l__shell->terminal, "Invalid line count. Try \"help profile\" for more information.\n");
+			return -1;
+		}
+	}
+	
+	/* Start the profiler (allocates the sample buffer, if necessary) */
+	hymk_profile_ctl(l__sid, l__depth);
+	if (*tls_errno)
+	{
+		dbg_iprintf(l__shell->terminal, "Can't start the profiler (error %i).\n", *tls_errno);
+		*tls_errno = 0;
+		return -1;
+	}
+	
+	/* Wait (nobody syncs with our own process) */
+	hymk_sync(hysys_info_read(MAININFO_CURRENT_PROCESS), l__time, 0);
+	*tls_errno = 0;
+	
+	hymk_profile_ctl(SID_NULL, 0);
+	*tls_errno = 0;
+	
+	/* Evaluate the samples */
+	dbg_profile_collect(&l__samples, &l__dropped);
+	
+	dbg_iprintf(l__shell->terminal, "Samples: %u (%u dropped) in %u ms\n", l__samples, l__dropped, l__time);
+	
+	dbg_profile_print(l__count);
+	
+	if (hysys_info_read(MAININFO_PROFILE_DROPPED) != 0)
+		dbg_iprintf(l__shell->terminal, "The sample buffer has overflowed. Use a shorter sample time.\n");
+	
+	return 0;
+}
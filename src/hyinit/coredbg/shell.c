@@ -81,6 +81,10 @@ void dbg_init_shell(void)
 	dbg_register_command("sysinfo", dbg_sh_sysinfo);
 	dbg_register_command("proc", dbg_sh_proc);
 	dbg_register_command("thrd", dbg_sh_thrd);
+	dbg_register_command("irqlat", dbg_sh_irqlat);
+	dbg_register_command("top", dbg_sh_top);
+	dbg_register_command("ktrace", dbg_sh_ktrace);
+	dbg_register_command("profile", dbg_sh_profile);
 }
 
 /*
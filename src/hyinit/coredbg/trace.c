@@ -25,6 +25,33 @@
 #include "../hyinit.h"
 #include "coredbg.h"
 
+/*
+ * Memory window cache
+ *
+ * Pages of stopped processes, which were read once, stay 
+ * mapped read-only into the debugger until one of their threads
+ * runs again. Dumps and stack walks need one mapping per page 
+ * that way. Pages are only cached, if every thread of the
+ * process of the client is frozen, because the other threads
+ * could change the memory otherwise.
+ *
+ */
+#define DBG_WINDOW_PAGES		16
+
+typedef struct
+{
+	sid_t		client;		/* Thread that mapped the page (0 = unused) */
+	sid_t		process;	/* Owner of the page */
+	uintptr_t	adr;		/* Page address in the process */
+	uint8_t		*page;		/* Mapping in the debugger */
+	uint32_t	switches;	/* Context switches of the process at mapping time */
+	unsigned	used;		/* Time stamp of the last access (LRU) */
+}dbg_window_t;
+
+static dbg_window_t dbg_window[DBG_WINDOW_PAGES];
+static unsigned dbg_window_clock = 0;
+static mtx_t dbg_window_mtx = MTX_DEFINE();
+
 /*
  * dbg_get_registers
  *
@@ -36,32 +63,32 @@
  */
 dbg_registers_t dbg_get_registers(sid_t client)
 {
-	reg_t l__generic = hymk_read_regs(client, REGS_X86_GENERIC);
-	reg_t l__index = hymk_read_regs(client, REGS_X86_INDEX);
-	reg_t l__pointers = hymk_read_regs(client, REGS_X86_POINTERS);
-	reg_t l__eflags = hymk_read_regs(client, REGS_X86_EFLAGS);
+	reg_frame_t l__frame;
 	dbg_registers_t l__retval = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
 	
+	/* Read the whole frame with a single system call */
+	hymk_read_frame(client, REGS_X86_FRAME, &l__frame);
+	
 	/* Error */
 	if (*tls_errno)
 	{
 		dbg_shell_t *l__shell = *dbg_tls_shellptr;
 		
-		dbg_iprintf(l__shell->terminal, "Can't read registers from 0x%X, because of %i.\n", *tls_errno);
+		dbg_iprintf(l__shell->terminal, "Can't read registers from 0x%X, because of %i.\n", client, *tls_errno);
 		return l__retval;
 	}
 	
 	/* Store registers */
-	l__retval.eax = l__generic.regs[0];
-	l__retval.ebx = l__generic.regs[1];
-	l__retval.ecx = l__generic.regs[2];
-	l__retval.edx = l__generic.regs[3];
-	l__retval.esi = l__index.regs[0];
-	l__retval.edi = l__index.regs[1];
-	l__retval.ebp = l__index.regs[2];
-	l__retval.esp = l__pointers.regs[0];
-	l__retval.eip = l__pointers.regs[1];
-	l__retval.eflags = l__eflags.regs[0];
+	l__retval.eax = l__frame.eax;
+	l__retval.ebx = l__frame.ebx;
+	l__retval.ecx = l__frame.ecx;
+	l__retval.edx = l__frame.edx;
+	l__retval.esi = l__frame.esi;
+	l__retval.edi = l__frame.edi;
+	l__retval.ebp = l__frame.ebp;
+	l__retval.esp = l__frame.esp;
+	l__retval.eip = l__frame.eip;
+	l__retval.eflags = l__frame.eflags;
 	
 	return l__retval;
 }
@@ -77,35 +104,29 @@ dbg_registers_t dbg_get_registers(sid_t client)
  */
 void dbg_set_registers(sid_t client, dbg_registers_t reg)
 {
-	reg_t l__generic;
-	reg_t l__index;
-	reg_t l__pointers;
-	reg_t l__eflags;
-	
-	/* Load registers */
-	l__generic.regs[0] = reg.eax;
-	l__generic.regs[1] = reg.ebx;
-	l__generic.regs[2] = reg.ecx;
-	l__generic.regs[3] = reg.edx;
-	l__index.regs[0] = reg.esi;
-	l__index.regs[1] = reg.edi;
-	l__index.regs[2] = reg.ebp;
-	l__pointers.regs[0] = reg.esp;
-	l__pointers.regs[1] = reg.eip;
-	l__eflags.regs[0] = reg.eflags;
-	
-	/* Store them */
-	hymk_write_regs(client, REGS_X86_GENERIC, l__generic);
-	hymk_write_regs(client, REGS_X86_INDEX, l__index);
-	hymk_write_regs(client, REGS_X86_POINTERS, l__pointers);
-	hymk_write_regs(client, REGS_X86_EFLAGS, l__eflags);
+	reg_frame_t l__frame;
+	
+	/* Load registers (the segment registers are read-only) */
+	l__frame.eax = reg.eax;
+	l__frame.ebx = reg.ebx;
+	l__frame.ecx = reg.ecx;
+	l__frame.edx = reg.edx;
+	l__frame.esi = reg.esi;
+	l__frame.edi = reg.edi;
+	l__frame.ebp = reg.ebp;
+	l__frame.esp = reg.esp;
+	l__frame.eip = reg.eip;
+	l__frame.eflags = reg.eflags;
+	
+	/* Store them with a single system call */
+	hymk_write_frame(client, REGS_X86_FRAME, &l__frame);
 	
 	/* Error */
 	if (*tls_errno)
 	{
 		dbg_shell_t *l__shell = *dbg_tls_shellptr;
 		
-		dbg_iprintf(l__shell->terminal, "Can't change registers of 0x%X, because of %i.\n", *tls_errno);
+		dbg_iprintf(l__shell->terminal, "Can't change registers of 0x%X, because of %i.\n", client, *tls_errno);
 		return;
 	}
 	
@@ -331,6 +352,9 @@ static void* dbg_prep_access(sid_t client, uintptr_t adr, size_t len, unsigned o
 				*tls_errno = 0;
 			}
 			
+			hymk_awake_subject(client);
+			*tls_errno = 0;
+			
 			pmap_free(l__tmp);
 			return NULL;
 		}
@@ -344,11 +368,251 @@ static void* dbg_prep_access(sid_t client, uintptr_t adr, size_t len, unsigned o
 	return l__tmp;
 }
 
+/*
+ * dbg_window_frozen(proc, switches)
+ *
+ * Tests if every thread of the process "proc" is frozen and 
+ * returns the count of context switches of all its threads in 
+ * "switches". The count changes, if one of the threads was
+ * running in the meantime. The search stops after all threads
+ * of the process (see PRCTAB_THREAD_COUNT) were found.
+ *
+ * Return value:
+ *	1	All threads are frozen
+ *	0	At least one thread may run
+ *
+ */
+static int dbg_window_frozen(sid_t proc, uint32_t *switches)
+{
+	unsigned l__n;
+	uint32_t l__threads = hysys_prctab_read(proc, PRCTAB_THREAD_COUNT);
+	
+	*switches = 0;
+	
+	if (*tls_errno)
+	{
+		*tls_errno = 0;
+		return 0;
+	}
+	
+	for (l__n = 0; (l__n < ARCH_THREAD_TABLE_ENTRIES) && (l__threads > 0); l__n ++)
+	{
+		sid_t l__sid = SIDTYPE_THREAD | l__n;
+		
+		if (hysys_thrtab_read(l__sid, THRTAB_PROCESS_SID) != proc)
+		{
+			*tls_errno = 0;
+			continue;
+		}
+		
+		if (hysys_thrtab_read(l__sid, THRTAB_FREEZE_COUNTER) == 0)
+		{
+			*tls_errno = 0;
+			return 0;
+		}
+		
+		*switches +=   hysys_thrtab_read(l__sid, THRTAB_VOLUNTARY_SWITCHES)
+			     + hysys_thrtab_read(l__sid, THRTAB_INVOLUNTARY_SWITCHES);
+			     
+		l__threads --;
+	}
+	
+	*tls_errno = 0;
+	
+	return 1;
+}
+
+/*
+ * dbg_window_flush(client)
+ *
+ * Unmaps all cached pages of the process of the client "client" 
+ * from the memory window cache. If "client" is 0, the whole cache
+ * will be flushed.
+ *
+ * The function has to be called before a client continues
+ * its execution or its memory is changed.
+ *
+ */
+void dbg_window_flush(sid_t client)
+{
+	sid_t l__proc = 0;
+	int l__i;
+	
+	if (client != 0)
+	{
+		l__proc = hysys_thrtab_read(client, THRTAB_PROCESS_SID);
+		*tls_errno = 0;
+	}
+	
+	mtx_lock(&dbg_window_mtx, -1);
+	
+	for (l__i = 0; l__i < DBG_WINDOW_PAGES; l__i ++)
+	{
+		if (dbg_window[l__i].client == 0) continue;
+		
+		if (    (client != 0)
+		     && (dbg_window[l__i].client != client)
+		     && ((l__proc == 0) || (dbg_window[l__i].process != l__proc))
+		   )
+		{
+			continue;
+		}
+		
+		pmap_free(dbg_window[l__i].page);
+		*tls_errno = 0;
+		
+		dbg_window[l__i].client = 0;
+		dbg_window[l__i].page = NULL;
+	}
+	
+	mtx_unlock(&dbg_window_mtx);
+	
+	return;
+}
+
+/*
+ * dbg_window_get(client, proc, switches, adr)
+ *
+ * Returns the mapping of the page at "adr" of the process "proc"
+ * of the client "client" from the memory window cache. If the 
+ * page isn't cached, it will be mapped and replace the least 
+ * recently used entry. "switches" is the current count of
+ * context switches of the process (see dbg_window_frozen).
+ *
+ * All threads of the process have to be stopped. The function 
+ * expects dbg_window_mtx to be locked and leaves it locked!
+ *
+ * Return value:
+ *	!= NULL		Read-only mapping of the page
+ *	== NULL		Error
+ *
+ */
+static uint8_t* dbg_window_get(sid_t client, sid_t proc, uint32_t switches, uintptr_t adr)
+{
+	int l__i;
+	int l__lru = 0;
+	
+	adr &= (~0xfff);
+	
+	for (l__i = 0; l__i < DBG_WINDOW_PAGES; l__i ++)
+	{
+		dbg_window_t *l__win = &dbg_window[l__i];
+		
+		if (    (l__win->client != 0) 
+		     && (l__win->process == proc) 
+		     && (l__win->adr == adr)
+		   )
+		{
+			/* Still valid, if no thread of the process did run */
+			if (l__win->switches == switches)
+			{
+				l__win->used = ++ dbg_window_clock;
+				return l__win->page;
+			}
+			
+			/* Outdated */
+			pmap_free(l__win->page);
+			*tls_errno = 0;
+			
+			l__win->client = 0;
+			l__win->page = NULL;
+		}
+		
+		/* Search the victim (unused entries first) */
+		if (dbg_window[l__lru].client == 0) continue;
+		
+		if (    (l__win->client == 0)
+		     || (l__win->used < dbg_window[l__lru].used)
+		   )
+		{
+			l__lru = l__i;
+		}
+	}
+	
+	/* Map the page */
+	uint8_t *l__page = dbg_prep_access(client, adr, 4096, PGA_READ);
+	if (l__page == NULL) return NULL;
+	
+	hymk_awake_subject(client);
+	*tls_errno = 0;
+	
+	/* Replace the least recently used page */
+	dbg_window_t *l__win = &dbg_window[l__lru];
+	
+	if (l__win->client != 0)
+	{
+		pmap_free(l__win->page);
+		*tls_errno = 0;
+	}
+	
+	l__win->client = client;
+	l__win->process = proc;
+	l__win->adr = adr;
+	l__win->page = l__page;
+	l__win->switches = switches;
+	l__win->used = ++ dbg_window_clock;
+	
+	return l__page;
+}
+
+/*
+ * dbg_read_cached(client, proc, switches, adr, buf, len)
+ *
+ * Reads "len" bytes of the memory of the stopped process "proc" 
+ * of the client "client" at its address "adr" to "buf" using the 
+ * memory window cache (see dbg_window_get).
+ *
+ * Return value:
+ *	0	Successful
+ *	1	Error
+ *
+ */
+static int dbg_read_cached(sid_t client, sid_t proc, uint32_t switches, uintptr_t adr, void* buf, size_t len)
+{
+	uint8_t *l__buf = buf;
+	
+	mtx_lock(&dbg_window_mtx, -1);
+	
+	while (len > 0)
+	{
+		uintptr_t l__offset = adr & 0xfff;
+		size_t l__part = 4096 - l__offset;
+		
+		if (l__part > len) l__part = len;
+		
+		uint8_t *l__page = dbg_window_get(client, proc, switches, adr);
+		if (l__page == NULL)
+		{
+			mtx_unlock(&dbg_window_mtx);
+			return 1;
+		}
+		
+		buf_copy(l__buf, &l__page[l__offset], l__part);
+		if (*tls_errno)
+		{
+			dbg_isprintf("Can't copy data in dbg_read, because of %i.\n", *tls_errno);
+			*tls_errno = 0;
+			
+			mtx_unlock(&dbg_window_mtx);
+			return 1;
+		}
+		
+		l__buf += l__part;
+		adr += l__part;
+		len -= l__part;
+	}
+	
+	mtx_unlock(&dbg_window_mtx);
+	
+	return 0;
+}
+
 /*
  * dbg_read(client, adr, buf, len)
  *
  * Reads "len" bytes of the memory of client "client" at its address "adr"
- * to "buf". 
+ * to "buf". The memory of stopped processes will be read via the
+ * memory window cache.
  *
  * Return value:
  *	0	Successful
@@ -357,6 +621,18 @@ static void* dbg_prep_access(sid_t client, uintptr_t adr, size_t len, unsigned o
  */
 int dbg_read(sid_t client, uintptr_t adr, void* buf, size_t len)
 {	
+	sid_t l__proc = hysys_thrtab_read(client, THRTAB_PROCESS_SID);
+	uint32_t l__switches;
+	
+	/* Stopped processes can't change their memory, use the cache */
+	if (    (*tls_errno == 0)
+	     && (dbg_window_frozen(l__proc, &l__switches))
+	   )
+	{
+		return dbg_read_cached(client, l__proc, l__switches, adr, buf, len);
+	}
+	*tls_errno = 0;
+	
 	uintptr_t l__offset = adr & 0xfff;
 	uint8_t* l__tmp = dbg_prep_access(client, adr, len, PGA_READ);
 		
@@ -394,6 +670,9 @@ int dbg_read(sid_t client, uintptr_t adr, void* buf, size_t len)
  */
 int dbg_write(sid_t client, uintptr_t adr, const void* buf, size_t len)
 {	
+	/* The cached pages would be outdated */
+	dbg_window_flush(client);
+	
 	uintptr_t l__offset = adr & 0xfff;
 	uint8_t* l__tmp = dbg_prep_access(client, adr, len, PGA_WRITE);
 		
@@ -419,6 +698,32 @@ int dbg_write(sid_t client, uintptr_t adr, const void* buf, size_t len)
 	return 0;
 }
 
+/*
+ * dbg_map_shared(client, adr, len)
+ *
+ * Maps "len" bytes of the memory of client "client" at its address "adr"
+ * writeable into the debugger. The mapping is shared with the client
+ * and has to be released with pmap_free.
+ *
+ * Return value:
+ *	!= NULL		Mapping of "adr"
+ *	== NULL		Error
+ *
+ */
+void* dbg_map_shared(sid_t client, uintptr_t adr, size_t len)
+{
+	uint8_t* l__tmp = dbg_prep_access(client, adr, len, PGA_WRITE);
+	
+	if (l__tmp == NULL)
+		return NULL;
+		
+	/* Awake the client */
+	hymk_awake_subject(client);
+	*tls_errno = 0;
+	
+	return &l__tmp[adr & 0xfff];
+}
+
 /*
  * dbg_read_stack(client, level)
  *
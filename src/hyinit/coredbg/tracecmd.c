@@ -186,6 +186,8 @@ int dbg_sh_exit(void)
 {
 	dbg_shell_t *l__shell = *dbg_tls_shellptr;
 	
+	dbg_window_flush(l__shell->client);
+	
 	/* Kill the client */
 	if (dbg_test_par(0, "kill") > -1)
 	{
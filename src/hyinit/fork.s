@@ -21,8 +21,11 @@
 .extern initfork_stack_buf
 .extern initfork_thread_buf
 .extern initfork_libinit
+.extern initpaged_stack_buf
+.extern init_paged_client
 
 .global initfork_entry
+.global initpaged_entry
 
 .code32
 .text
@@ -55,5 +58,16 @@ tmpa:	movl $0, %eax
 	int  $0xC8			# yield_thread
 	
 	jmp tmpa
+
+#
+# The entry code of a client of the demo PageD
+#
+initpaged_entry:
+	movl initpaged_stack_buf, %eax		# Load our stack pointer
+	movl %eax, %esp
+	
+	call init_paged_client			# Never returns
+	
+	jmp tmp_exit
 		
 	
\ No newline at end of file
@@ -39,9 +39,60 @@ enum {
 };
 
 sid_t init_fork(int pnum);
+uint64_t init_fork_benchmark(unsigned heap_pages, uint64_t *map_cycles);
+uint64_t init_share_benchmark(unsigned procs, uint64_t *teardown_cycles);
+uint64_t init_cow_benchmark(unsigned pages);
+uint64_t init_xml_benchmark(unsigned kib, uint32_t *bytes, uint32_t *events);
+unsigned init_xml_test(void);
+int init_path_benchmark(unsigned lookups, uint32_t *times);
+#define INIT_PATH_GROUPS	128	/* Elements below the root of init_path_benchmark */
+#define INIT_PATH_KEYS		64	/* Children of these elements */
+#define INIT_PATH_COUNT		32	/* Different paths resolved by init_path_benchmark */
+#define INIT_PATH_ROUND		1000	/* Lookups per measured round */
+#define INIT_PATH_METHODS	3	/* Compared methods of the path resolution */
+uint64_t init_latency_benchmark(unsigned pages, uint64_t *max_cycles);
+#define INIT_LATENCY_PERIODS	256	/* Periods of 1 ms measured by init_latency_benchmark */
+uint64_t init_jitter_benchmark(unsigned cls, unsigned load, uint64_t *min_cycles, uint64_t *max_cycles);
+#define INIT_JITTER_LOAD_MAX	8	/* Max. count of load threads of init_jitter_benchmark */
+unsigned init_throttle_benchmark(unsigned load, uint32_t *throttles);
+#define INIT_THROTTLE_TICKS	400	/* Timer ticks measured by init_throttle_benchmark */
 void init_kill(void);
+
+/*
+ * Page merging daemon
+ *
+ */
+#define INIT_MERGE_STEP		2048	/* Max. pages per merge call */
+#define INIT_MERGE_INTERVAL	5000	/* Interval of the merge passes in ms */
+
+extern volatile unsigned init_merge_saved;
+extern volatile unsigned init_merge_passes;
+
+unsigned init_merge_pass(void);
+void init_merge_start(void);
 void initfork_libinit(void);
 
+/*
+ * Demo paging daemon
+ *
+ */
+#define INIT_PAGED_WORKERS	2		/* Worker threads of the demo PageD */
+#define INIT_PAGED_BATCH	32		/* Max. faults received at once */
+#define INIT_PAGED_PROCS	8		/* Max. clients of init_paged_benchmark */
+#define INIT_PAGED_TIMEOUT	5000		/* Timeout of the clients in ms */
+#define INIT_PAGED_MAGIC	0x50414745u	/* Content of the resolved pages */
+
+extern volatile uintptr_t init_paged_area;
+extern volatile unsigned init_paged_pages;
+extern volatile sid_t init_paged_parent;
+extern uintptr_t initpaged_stack_buf;
+extern volatile unsigned init_paged_faults;
+extern volatile unsigned init_paged_batches;
+
+int init_paged_start(void);
+void init_paged_client(void);
+int init_paged_benchmark(unsigned pages, unsigned procs, uint64_t *cycles);
+
 /*
  * Process entry points
  *
@@ -22,6 +22,9 @@
 #include <hydrixos/system.h>
 #include <hydrixos/mem.h>
 #include <hydrixos/pmap.h>
+#include <hydrixos/spxml.h>
+
+#include <coredbg/cdebug.h>
 
 #include "hyinit.h"
 
@@ -29,6 +32,7 @@ volatile int init_process_number = INITPROC_MAIN;
 extern region_t *pmap_region;
 
 extern void initfork_entry(void);
+extern void initpaged_entry(void);
 
 uintptr_t initfork_stack_buf;
 thread_t* initfork_thread_buf;
@@ -77,26 +81,11 @@ sid_t init_fork(int pnum)
 	initfork_stack_buf = ((uintptr_t)(*tls_my_thread)->stack) + (*tls_my_thread)->stack_sz;
 	initfork_thread_buf = (*tls_my_thread);
 	
-	/* Fill its address space */
-	hysys_map(l__new_thr, 
-		  code_region->start,
-		  code_region->pages,
-		  MAP_READ|MAP_WRITE|MAP_EXECUTABLE|MAP_COPYONWRITE,
-		  (uintptr_t)code_region->start
-		 );
-	hysys_map(l__new_thr, 
-		  heap_region->start,
-		  heap_region->pages,
-		  MAP_READ|MAP_WRITE|MAP_EXECUTABLE|MAP_COPYONWRITE,
-		  (uintptr_t)heap_region->start
-		 );	
-	hysys_map(l__new_thr, 
-		  pmap_region->start,
-		  pmap_region->pages,
-		  MAP_READ|MAP_WRITE|MAP_EXECUTABLE|MAP_COPYONWRITE,
-		  (uintptr_t)pmap_region->start
-		 );		 
-	if (*tls_errno) {iprintf("MAP ERROR: %i\n", *tls_errno); while(1);}
+	/* Fill its address space (copy-on-write) */
+	hymk_clone(l__new_thr, code_region->start, code_region->pages);
+	hymk_clone(l__new_thr, heap_region->start, heap_region->pages);
+	hymk_clone(l__new_thr, pmap_region->start, pmap_region->pages);
+	if (*tls_errno) {iprintf("CLONE ERROR: %i\n", *tls_errno); while(1);}
 	
 	/* Synchronize memory and re-set init process number */
 	HYSYS_MSYNC();	
@@ -110,6 +99,954 @@ sid_t init_fork(int pnum)
 	return l__new_proc;
 }
 
+/*
+ * init_rdtsc
+ *
+ * Reads the time stamp counter of the CPU.
+ *
+ */
+static inline uint64_t init_rdtsc(void)
+{
+	uint64_t l__tsc;
+	
+	__asm__ __volatile__("rdtsc\n" : "=A" (l__tsc));
+	
+	return l__tsc;
+}
+
+/*
+ * init_fork_benchmark(heap_pages, map_cycles)
+ *
+ * Measures the costs of duplicating the address space of the
+ * current process, after its heap was grown by "heap_pages" 
+ * pages. The address space will be duplicated once by the 
+ * clone system call and once by mapping an area of the size
+ * of the used heap using MAP_COPYONWRITE. The area is separate
+ * from the heap, so the heap isn't left selected for 
+ * copy-on-write afterwards. The duplicates are never started.
+ *
+ * Return value:
+ *	Costs of the clone operation (in CPU cycles)
+ *
+ * The costs of the mapping operation are returned by
+ * "map_cycles".
+ *
+ */
+uint64_t init_fork_benchmark(unsigned heap_pages, uint64_t *map_cycles)
+{
+	uint64_t l__clone = 0;
+	uint64_t l__start;
+	void *l__mem = NULL;
+	int l__i;
+	
+	/* Grow the heap */
+	if (heap_pages > 0)
+	{
+		l__mem = mem_alloc(heap_pages * ARCH_PAGE_SIZE);
+		if (l__mem == NULL) return 0;
+	}
+	
+	for (l__i = 0; l__i < 2; l__i ++)
+	{
+		void *l__area = NULL;
+		unsigned l__pages = heap_region->usable_pages;
+		
+		/* Area of the size of the used heap for the mapping */
+		if (l__i == 1)
+		{
+			l__area = pmap_mapalloc(l__pages * ARCH_PAGE_SIZE);
+			if (l__area == NULL) break;
+		}
+		
+		sid_t l__proc = hymk_create_process(&initfork_entry, NULL);
+		if (*tls_errno) 
+		{
+			if (l__area != NULL) pmap_free(l__area);
+			break;
+		}
+		sid_t l__thr = hysys_prctab_read(l__proc, PRCTAB_CONTROLLER_THREAD_SID);
+		
+		l__start = init_rdtsc();
+		
+		if (l__i == 0)
+		{
+			hymk_clone(l__thr, heap_region->start, heap_region->pages);
+			l__clone = init_rdtsc() - l__start;
+		}
+		 else
+		{
+			hysys_map(l__thr,
+				  l__area,
+				  l__pages,
+				  MAP_READ|MAP_WRITE|MAP_EXECUTABLE|MAP_COPYONWRITE,
+				  (uintptr_t)l__area
+				 );
+			*map_cycles = init_rdtsc() - l__start;
+		}
+		
+		/* Destroy the duplicate */
+		hymk_destroy_subject(l__proc);
+		hymk_destroy_subject(l__thr);
+		*tls_errno = 0;
+		
+		if (l__area != NULL) pmap_free(l__area);
+	}
+	
+	if (l__mem != NULL) mem_free(l__mem);
+	
+	return l__clone;
+}
+
+/*
+ * init_share_benchmark(procs, teardown_cycles)
+ *
+ * Measures the costs of sharing the init image with "procs"
+ * processes (max. 64). The code region of the current process 
+ * will be cloned into each new process, afterwards all of the
+ * processes will be destroyed again. So every page frame of the
+ * image gets "procs" further users. The processes are never 
+ * started.
+ *
+ * Return value:
+ *	Costs of sharing the image (in CPU cycles)
+ *
+ * The costs of destroying the processes are returned by
+ * "teardown_cycles".
+ *
+ */
+uint64_t init_share_benchmark(unsigned procs, uint64_t *teardown_cycles)
+{
+	sid_t l__procs[64];
+	sid_t l__thrs[64];
+	uint64_t l__share = 0;
+	uint64_t l__start;
+	unsigned l__n = 0;
+	unsigned l__i;
+	
+	if (procs > 64) procs = 64;
+	
+	/* Create the processes and share the image */
+	while (l__n < procs)
+	{
+		l__procs[l__n] = hymk_create_process(&initfork_entry, NULL);
+		if (*tls_errno) break;
+		l__thrs[l__n] = hysys_prctab_read(l__procs[l__n], PRCTAB_CONTROLLER_THREAD_SID);
+		
+		l__start = init_rdtsc();
+		hymk_clone(l__thrs[l__n], code_region->start, code_region->pages);
+		l__share += init_rdtsc() - l__start;
+		
+		l__n ++;
+		if (*tls_errno) break;
+	}
+	
+	/* Destroy them */
+	l__start = init_rdtsc();
+	
+	for (l__i = 0; l__i < l__n; l__i ++)
+	{
+		hymk_destroy_subject(l__procs[l__i]);
+		hymk_destroy_subject(l__thrs[l__i]);
+	}
+	
+	*teardown_cycles = init_rdtsc() - l__start;
+	*tls_errno = 0;
+	
+	return l__share;
+}
+
+/*
+ * init_cow_benchmark(pages)
+ *
+ * Measures the costs of writing sequentially to "pages" pages
+ * of the heap, after the heap was shared with a new process 
+ * using the clone system call. So every written page causes a 
+ * copy-on-write operation. The new process is never started.
+ *
+ * Return value:
+ *	Costs of the write operation (in CPU cycles)
+ *
+ */
+uint64_t init_cow_benchmark(unsigned pages)
+{
+	uint64_t l__cycles = 0;
+	uint32_t *l__mem;
+	unsigned l__i;
+	
+	l__mem = mem_alloc(pages * ARCH_PAGE_SIZE);
+	if (l__mem == NULL) return 0;
+	
+	/* Make the pages present */
+	for (l__i = 0; l__i < (pages * ARCH_PAGE_SIZE) / 4; l__i ++)
+		l__mem[l__i] = 0;
+	
+	sid_t l__proc = hymk_create_process(&initfork_entry, NULL);
+	if (!*tls_errno)
+	{
+		sid_t l__thr = hysys_prctab_read(l__proc, PRCTAB_CONTROLLER_THREAD_SID);
+		uint64_t l__start;
+		
+		hymk_clone(l__thr, heap_region->start, heap_region->pages);
+		
+		/* Write the memory sequentially */
+		l__start = init_rdtsc();
+		
+		for (l__i = 0; l__i < (pages * ARCH_PAGE_SIZE) / 4; l__i ++)
+			l__mem[l__i] = l__i;
+		
+		l__cycles = init_rdtsc() - l__start;
+		
+		hymk_destroy_subject(l__proc);
+		hymk_destroy_subject(l__thr);
+	}
+	
+	*tls_errno = 0;
+	mem_free(l__mem);
+	
+	return l__cycles;
+}
+
+/*
+ * init_paged_benchmark(pages, procs, cycles)
+ *
+ * Measures the page fault handling of the demo PageD. Up to
+ * 8 client processes are started at once, each of them reads
+ * "pages" pages of an area that is only reserved by the current
+ * process. So every read page causes a page fault that has to 
+ * be resolved by the worker threads of the PageD (see paged.c).
+ * The time until all clients are done is returned by "cycles".
+ *
+ * Return value:
+ *	0	Successful
+ *	1	Error
+ *
+ */
+int init_paged_benchmark(unsigned pages, unsigned procs, uint64_t *cycles)
+{
+	sid_t l__procs[INIT_PAGED_PROCS];
+	sid_t l__thrs[INIT_PAGED_PROCS];
+	void *l__area;
+	void *l__stack;
+	uint64_t l__start;
+	unsigned l__n = 0;
+	unsigned l__i;
+	int l__retval = 0;
+	
+	if (procs > INIT_PAGED_PROCS) procs = INIT_PAGED_PROCS;
+	
+	if (init_paged_start()) return 1;
+	
+	/* Reserve the area (it won't be mapped) */
+	l__area = pmap_alloc(pages * ARCH_PAGE_SIZE);
+	if (l__area == NULL) return 1;
+	
+	l__stack = pmap_mapalloc(8192);
+	if (l__stack == NULL)
+	{
+		pmap_free(l__area);
+		return 1;
+	}
+	
+	init_paged_area = (uintptr_t)l__area;
+	init_paged_pages = pages;
+	init_paged_parent = hysys_info_read(MAININFO_CURRENT_PROCESS);
+	initpaged_stack_buf = (uintptr_t)l__stack + 8192;
+	HYSYS_MSYNC();
+	
+	/* Create the clients */
+	while (l__n < procs)
+	{
+		l__procs[l__n] = hymk_create_process(&initpaged_entry, NULL);
+		if (*tls_errno) break;
+		l__thrs[l__n] = hysys_prctab_read(l__procs[l__n], PRCTAB_CONTROLLER_THREAD_SID);
+		
+		hymk_clone(l__thrs[l__n], code_region->start, code_region->pages);
+		hymk_clone(l__thrs[l__n], pmap_region->start, pmap_region->pages);
+		
+		l__n ++;
+		if (*tls_errno) break;
+	}
+	
+	if (*tls_errno) l__retval = 1;
+	
+	/* Start them and wait until they are done */
+	l__start = init_rdtsc();
+	
+	for (l__i = 0; l__i < l__n; l__i ++)
+		hymk_awake_subject(l__thrs[l__i]);
+	
+	for (l__i = 0; l__i < l__n; l__i ++)
+	{
+		*tls_errno = 0;
+		
+		if (    (hymk_sync(l__thrs[l__i], INIT_PAGED_TIMEOUT, 0) != l__thrs[l__i])
+		     || (*tls_errno)
+		   )
+		{
+			l__retval = 1;
+		}
+	}
+	
+	*cycles = init_rdtsc() - l__start;
+	
+	/* Destroy them */
+	for (l__i = 0; l__i < l__n; l__i ++)
+	{
+		hymk_destroy_subject(l__procs[l__i]);
+		hymk_destroy_subject(l__thrs[l__i]);
+	}
+	
+	*tls_errno = 0;
+	pmap_free(l__stack);
+	pmap_free(l__area);
+	
+	return l__retval;
+}
+
+/*
+ * init_xml_benchmark(kib, bytes, events)
+ *
+ * Measures the time to read all events of an SPXML document
+ * of about "kib" KiB with the streaming reader. The document
+ * consists of repeated entries. Its real size is returned in
+ * "bytes" and the number of read events in "events".
+ *
+ * Return value:
+ *	Duration of the scan (in ns)
+ *
+ */
+uint64_t init_xml_benchmark(unsigned kib, uint32_t *bytes, uint32_t *events)
+{
+	static const utf8_t l__entry[] = 
+		"\t<entry id=\"42\" type=\"text\">\n"
+		"\t\t<name>Name of the entry</name>\n"
+		"\t\t<!-- Comment within the entry -->\n"
+		"\t\t<value>Some longer text of the entry &amp; more</value>\n"
+		"\t\t<flag/>\n"
+		"\t</entry>\n";
+	size_t l__elen = sizeof(l__entry) - 1;
+	spxml_reader_t l__reader;
+	spxml_event_t l__evt;
+	uint64_t l__start;
+	uint64_t l__ns;
+	utf8_t *l__xml;
+	size_t l__len;
+	
+	l__xml = mem_alloc(kib * 1024 + 16);
+	if (l__xml == NULL) return 0;
+	
+	/* Build the document */
+	l__len = buf_copy(l__xml, "<list>\n", 7);
+	
+	while ((l__len + l__elen) <= (kib * 1024))
+		l__len += buf_copy(l__xml + l__len, l__entry, l__elen);
+		
+	l__len += buf_copy(l__xml + l__len, "</list>\n", 8);
+	
+	/* Read it */
+	spxml_reader_init(&l__reader, NULL, 0);
+	spxml_reader_feed(&l__reader, l__xml, l__len);
+	
+	*events = 0;
+	l__start = hysys_time_ns();
+	
+	while (spxml_reader_next(&l__reader, &l__evt) < SPXMLEVENT_EOF)
+		(*events) ++;
+	
+	l__ns = hysys_time_ns() - l__start;
+	
+	*bytes = l__len;
+	mem_free(l__xml);
+	
+	return l__ns;
+}
+
+/*
+ * init_xml_test()
+ *
+ * Parses nested SPXML documents, which are copied to buffers
+ * of exactly their length (including the 0 character), so
+ * the tokenizer must not read behind their end. Afterwards
+ * some paths are resolved by spxml_resolve_path and by a path
+ * index, which both have to return the same nodes.
+ *
+ * Return value:
+ *	Number of failed tests
+ *
+ */
+unsigned init_xml_test(void)
+{
+	static const utf8_t *l__docs[] = 
+	{
+		"<a><b>x</b></a>",
+		"<a>\n <b>some longer text of b</b>\n <c><d/></c>\n</a>",
+		"<?xml version=\"1.0\"?><a><!-- comment --><b>x</b><c>y</c></a>"
+	};
+	static const utf8_t *l__paths[] =
+	{
+		"/a", "/a/b", "/a/", "/a/b/", "/a//b", "/", "//a", "/a/c"
+	};
+	unsigned l__failed = 0;
+	unsigned l__i, l__j;
+	
+	for (l__i = 0; l__i < (sizeof(l__docs) / sizeof(l__docs[0])); l__i ++)
+	{
+		size_t l__len = str_len(l__docs[l__i], 1000) + 1;
+		utf8_t *l__xml = mem_alloc(l__len);
+		spxml_node_t l__root;
+		
+		if (l__xml == NULL) return l__failed + 1;
+		
+		buf_copy(l__xml, l__docs[l__i], l__len);
+		l__root.children = NULL;
+		l__root.arena = NULL;
+		
+		if (    (spxml_create_tree(l__xml, l__len, &l__root) == NULL)
+		     || (spxml_resolve_path("/a/b", &l__root) == NULL)
+		   )
+		{
+			dc_printf("XML test %i: parsing failed.\n", l__i);
+			l__failed ++;
+			*tls_errno = 0;
+		}
+		 else
+		{
+			spxml_index_t *l__index = spxml_create_index(&l__root);
+			
+			for (l__j = 0; l__j < (sizeof(l__paths) / sizeof(l__paths[0])); l__j ++)
+			{
+				if (    (l__index == NULL)
+				     || (    spxml_index_resolve(l__index, l__paths[l__j]) 
+				          != spxml_resolve_path(l__paths[l__j], &l__root)
+					)
+				   )
+				{
+					dc_printf("XML test %i: index differs for %s.\n", l__i, l__paths[l__j]);
+					l__failed ++;
+				}
+				
+				*tls_errno = 0;
+			}
+			
+			if (l__index != NULL) spxml_destroy_index(l__index);
+		}
+		
+		spxml_destroy_tree(&l__root);
+		*tls_errno = 0;
+		mem_free(l__xml);
+	}
+	
+	return l__failed;
+}
+
+/*
+ * init_path_name(buf, prefix, num)
+ *
+ * Writes the tag name "prefix" followed by the three
+ * digits of "num" to "buf".
+ *
+ * Return value:
+ *	Size of the name (4 bytes)
+ *
+ */
+static size_t init_path_name(utf8_t *buf, utf8_t prefix, unsigned num)
+{
+	buf[0] = prefix;
+	buf[1] = '0' + (num / 100) % 10;
+	buf[2] = '0' + (num / 10) % 10;
+	buf[3] = '0' + num % 10;
+	
+	return 4;
+}
+
+/*
+ * init_path_benchmark(lookups, times)
+ *
+ * Measures "lookups" path resolutions (a multiple of 
+ * INIT_PATH_ROUND) within a tree of INIT_PATH_GROUPS elements
+ * with INIT_PATH_KEYS children each. The durations (in us)
+ * are returned in "times" (INIT_PATH_METHODS entries):
+ *
+ *	0	spxml_resolve_path
+ *	1	Compiled paths with an index of the tree
+ *	2	Path strings with the path cache of the index
+ *
+ * Return value:
+ *	0	Successful
+ *	1	Error or the results differ
+ *
+ */
+int init_path_benchmark(unsigned lookups, uint32_t *times)
+{
+	static utf8_t l__paths[INIT_PATH_COUNT][24];
+	spxml_path_t *l__compiled[INIT_PATH_COUNT];
+	spxml_node_t *l__found[INIT_PATH_COUNT];
+	spxml_index_t *l__index;
+	spxml_node_t l__root;
+	uint64_t l__start;
+	utf8_t *l__xml;
+	size_t l__len = 0;
+	unsigned l__i, l__j, l__m;
+	int l__ok = 1;
+	
+	l__xml = mem_alloc(INIT_PATH_GROUPS * (INIT_PATH_KEYS + 2) * 16 + 32);
+	if (l__xml == NULL) return 1;
+	
+	/* Build the document <config><g000><k000>0</k000>...</g000>...</config> */
+	l__len += buf_copy(l__xml + l__len, "<config>", 8);
+	
+	for (l__i = 0; l__i < INIT_PATH_GROUPS; l__i ++)
+	{
+		l__xml[l__len ++] = '<';
+		l__len += init_path_name(l__xml + l__len, 'g', l__i);
+		l__xml[l__len ++] = '>';
+		
+		for (l__j = 0; l__j < INIT_PATH_KEYS; l__j ++)
+		{
+			l__xml[l__len ++] = '<';
+			l__len += init_path_name(l__xml + l__len, 'k', l__j);
+			l__len += buf_copy(l__xml + l__len, ">0</", 4);
+			l__len += init_path_name(l__xml + l__len, 'k', l__j);
+			l__xml[l__len ++] = '>';
+		}
+		
+		l__len += buf_copy(l__xml + l__len, "</", 2);
+		l__len += init_path_name(l__xml + l__len, 'g', l__i);
+		l__xml[l__len ++] = '>';
+	}
+	
+	l__len += buf_copy(l__xml + l__len, "</config>", 9);
+	l__xml[l__len ++] = 0;
+	
+	if (spxml_create_tree(l__xml, l__len, &l__root) == NULL)
+	{
+		mem_free(l__xml);
+		return 1;
+	}
+	
+	l__index = spxml_create_index(&l__root);
+	if (l__index == NULL)
+	{
+		spxml_destroy_tree(&l__root);
+		mem_free(l__xml);
+		return 1;
+	}
+	
+	/* Paths spread over the document: /config/gNNN/kNNN */
+	for (l__i = 0; l__i < INIT_PATH_COUNT; l__i ++)
+	{
+		l__len = buf_copy(l__paths[l__i], "/config/", 8);
+		l__len += init_path_name(&l__paths[l__i][l__len], 'g', (l__i * 37 + 100) % INIT_PATH_GROUPS);
+		l__paths[l__i][l__len ++] = '/';
+		l__len += init_path_name(&l__paths[l__i][l__len], 'k', (l__i * 23 + 40) % INIT_PATH_KEYS);
+		l__paths[l__i][l__len] = 0;
+		
+		l__compiled[l__i] = spxml_compile_path(l__paths[l__i]);
+		l__found[l__i] = spxml_resolve_path(l__paths[l__i], &l__root);
+		
+		if (    (l__found[l__i] == NULL)
+		     || (l__compiled[l__i] == NULL)
+		     || (spxml_index_lookup(l__index, l__compiled[l__i]) != l__found[l__i])
+		     || (spxml_index_resolve(l__index, l__paths[l__i]) != l__found[l__i])
+		   )
+		{
+			l__ok = 0;
+		}
+	}
+	
+	/* 
+	 * Measure rounds of INIT_PATH_ROUND lookups, so the 
+	 * duration of a round fits into 32 bits
+	 *
+	 */
+	for (l__m = 0; (l__m < INIT_PATH_METHODS) && l__ok; l__m ++)
+	{
+		times[l__m] = 0;
+		
+		for (l__i = 0; l__i < lookups; l__i += INIT_PATH_ROUND)
+		{
+			l__start = hysys_time_ns();
+			
+			for (l__j = l__i; l__j < (l__i + INIT_PATH_ROUND); l__j ++)
+			{
+				switch (l__m)
+				{
+					case (0):
+						spxml_resolve_path(l__paths[l__j % INIT_PATH_COUNT], &l__root);
+						break;
+					case (1):
+						spxml_index_lookup(l__index, l__compiled[l__j % INIT_PATH_COUNT]);
+						break;
+					default:
+						spxml_index_resolve(l__index, l__paths[l__j % INIT_PATH_COUNT]);
+				}
+			}
+			
+			times[l__m] += (uint32_t)(hysys_time_ns() - l__start) / 1000;
+		}
+	}
+	
+	for (l__i = 0; l__i < INIT_PATH_COUNT; l__i ++)
+	{
+		if (l__compiled[l__i] != NULL) spxml_destroy_path(l__compiled[l__i]);
+	}
+	
+	spxml_destroy_index(l__index);
+	spxml_destroy_tree(&l__root);
+	mem_free(l__xml);
+	
+	*tls_errno = 0;
+	
+	return !l__ok;
+}
+
+/* Memory area of the map / unmap storm of init_latency_benchmark */
+static void *init_latency_mem = NULL;
+static unsigned init_latency_pages = 0;
+static volatile int init_latency_storm = 0;
+
+/*
+ * init_latency_storm_thread(thr)
+ *
+ * Maps the memory area "init_latency_mem" into a new process
+ * and unmaps it again, until "init_latency_storm" is reset
+ * to 0. The process is never started.
+ *
+ */
+static void init_latency_storm_thread(thread_t *thr)
+{
+	sid_t l__proc;
+	
+	hymk_set_priority(thr->thread_sid, THRPRIOR_NORMAL, THRSCHED_CLASS_NORMAL);
+	
+	l__proc = hymk_create_process(&initfork_entry, NULL);
+	
+	if (!*tls_errno)
+	{
+		sid_t l__thr = hysys_prctab_read(l__proc, PRCTAB_CONTROLLER_THREAD_SID);
+		
+		while (init_latency_storm == 1)
+		{
+			hysys_map(l__thr,
+				  init_latency_mem,
+				  init_latency_pages,
+				  MAP_READ|MAP_WRITE|MAP_COPYONWRITE,
+				  (uintptr_t)init_latency_mem
+				 );
+			hymk_unmap(l__thr, 
+				   init_latency_mem, 
+				   init_latency_pages, 
+				   UNMAP_COMPLETE
+				  );
+			*tls_errno = 0;
+		}
+		
+		hymk_destroy_subject(l__proc);
+		hymk_destroy_subject(l__thr);
+	}
+	
+	*tls_errno = 0;
+	init_latency_storm = 0;
+	
+	return;
+}
+
+/*
+ * init_latency_benchmark(pages, max_cycles)
+ *
+ * Measures the wakeup latency of a high priority thread, that
+ * sleeps INIT_LATENCY_PERIODS times for 1 ms. If "pages" is 
+ * not null, another thread will map and unmap "pages" pages
+ * in the meantime (max. MAININFO_MAX_PAGE_OPERATION pages).
+ *
+ * Return value:
+ *	Sum of all periods (in CPU cycles)
+ *
+ * The longest period is returned by "max_cycles".
+ *
+ */
+uint64_t init_latency_benchmark(unsigned pages, uint64_t *max_cycles)
+{
+	sid_t l__self = hysys_info_read(MAININFO_CURRENT_THREAD);
+	sid_t l__proc = hysys_info_read(MAININFO_CURRENT_PROCESS);
+	unsigned l__prior = hysys_thrtab_read(l__self, THRTAB_STATIC_PRIORITY);
+	thread_t *l__storm = NULL;
+	uint64_t l__sum = 0;
+	unsigned l__i;
+	
+	*max_cycles = 0;
+	
+	/* Start the storm */
+	if (pages > 0)
+	{
+		uint32_t *l__mem;
+		
+		l__mem = mem_alloc(pages * ARCH_PAGE_SIZE);
+		if (l__mem == NULL) return 0;
+		
+		/* Make the pages present */
+		for (l__i = 0; l__i < pages; l__i ++)
+			l__mem[l__i * (ARCH_PAGE_SIZE / 4)] = l__i;
+		
+		init_latency_mem = l__mem;
+		init_latency_pages = pages;
+		init_latency_storm = 1;
+		
+		l__storm = blthr_create(&init_latency_storm_thread, 8192);
+		if (l__storm == NULL)
+		{
+			mem_free(l__mem);
+			return 0;
+		}
+		
+		blthr_awake(l__storm);
+	}
+	
+	/* Measure the periods */
+	hymk_set_priority(l__self, THRPRIOR_VERY_HIGH, THRSCHED_CLASS_NORMAL);
+	
+	for (l__i = 0; l__i < INIT_LATENCY_PERIODS; l__i ++)
+	{
+		uint64_t l__start = init_rdtsc();
+		
+		/* Just wait (nobody will sync with our process) */
+		hymk_sync(l__proc, 1, 0);
+		*tls_errno = 0;
+		
+		uint64_t l__period = init_rdtsc() - l__start;
+		
+		l__sum += l__period;
+		if (l__period > *max_cycles) *max_cycles = l__period;
+	}
+	
+	hymk_set_priority(l__self, l__prior, THRSCHED_CLASS_NORMAL);
+	
+	/* Stop the storm */
+	if (l__storm != NULL)
+	{
+		init_latency_storm = 2;
+		
+		while (init_latency_storm != 0)
+		{
+			hymk_sync(l__proc, 1, 0);
+			*tls_errno = 0;
+		}
+		
+		mem_free(init_latency_mem);
+	}
+	
+	return l__sum;
+}
+
+/* Load threads of init_jitter_benchmark */
+static volatile int init_jitter_load = 0;
+static volatile int init_jitter_done[INIT_JITTER_LOAD_MAX];
+static volatile unsigned init_jitter_started = 0;
+
+/*
+ * init_jitter_load_thread(thr)
+ *
+ * Wastes CPU time with a high priority of the normal
+ * scheduling class, until "init_jitter_load" is reset 
+ * to 0.
+ *
+ */
+static void init_jitter_load_thread(thread_t *thr)
+{
+	unsigned l__num = init_jitter_started ++;
+	
+	hymk_set_priority(thr->thread_sid, THRPRIOR_VERY_HIGH, THRSCHED_CLASS_NORMAL);
+	*tls_errno = 0;
+	
+	while (init_jitter_load == 1);
+	
+	init_jitter_done[l__num] = 1;
+	
+	return;
+}
+
+/*
+ * init_jitter_start_load(load)
+ *
+ * Starts "load" load threads (max. INIT_JITTER_LOAD_MAX).
+ *
+ * Return value:
+ *	Number of started load threads
+ *
+ */
+static unsigned init_jitter_start_load(unsigned load)
+{
+	unsigned l__i;
+	
+	if (load > INIT_JITTER_LOAD_MAX) load = INIT_JITTER_LOAD_MAX;
+	
+	init_jitter_load = 1;
+	init_jitter_started = 0;
+	
+	for (l__i = 0; l__i < load; l__i ++)
+	{
+		thread_t *l__thr = blthr_create(&init_jitter_load_thread, 8192);
+		
+		init_jitter_done[l__i] = 1;
+		
+		if (l__thr == NULL) continue;
+		
+		init_jitter_done[l__i] = 0;
+		blthr_awake(l__thr);
+	}
+	
+	return load;
+}
+
+/*
+ * init_jitter_stop_load(load)
+ *
+ * Stops the "load" load threads started by 
+ * init_jitter_start_load.
+ *
+ */
+static void init_jitter_stop_load(unsigned load)
+{
+	sid_t l__proc = hysys_info_read(MAININFO_CURRENT_PROCESS);
+	unsigned l__i;
+	
+	init_jitter_load = 0;
+	
+	for (l__i = 0; l__i < load; l__i ++)
+	{
+		while (init_jitter_done[l__i] == 0)
+		{
+			hymk_sync(l__proc, 1, 0);
+			*tls_errno = 0;
+		}
+	}
+}
+
+/*
+ * init_jitter_benchmark(cls, load, min_cycles, max_cycles)
+ *
+ * Measures the jitter of a thread of the scheduling class
+ * "cls", that sleeps INIT_LATENCY_PERIODS times for 1 ms,
+ * while "load" threads (max. INIT_JITTER_LOAD_MAX) of the
+ * normal scheduling class waste CPU time. A thread of the
+ * deadline class reserves 1 ms every 4 ms.
+ *
+ * Return value:
+ *	Sum of all periods (in CPU cycles)
+ *
+ * The shortest and the longest period are returned by
+ * "min_cycles" and "max_cycles".
+ *
+ */
+uint64_t init_jitter_benchmark(unsigned cls, unsigned load, uint64_t *min_cycles, uint64_t *max_cycles)
+{
+	sid_t l__self = hysys_info_read(MAININFO_CURRENT_THREAD);
+	sid_t l__proc = hysys_info_read(MAININFO_CURRENT_PROCESS);
+	unsigned l__prior = hysys_thrtab_read(l__self, THRTAB_STATIC_PRIORITY);
+	uint64_t l__sum = 0;
+	unsigned l__i;
+	
+	*min_cycles = 0;
+	*max_cycles = 0;
+	
+	/* Start the load */
+	load = init_jitter_start_load(load);
+	
+	/* Select the scheduling class */
+	if (cls == THRSCHED_CLASS_DEADLINE)
+	{
+		hymk_set_deadline(l__self, 1, 4);
+	}
+	 else
+	{
+		hymk_set_priority(l__self, THRPRIOR_VERY_HIGH, cls);
+	}
+	
+	/* Measure the periods */
+	if (!*tls_errno)
+	{
+		*min_cycles = 0xFFFFFFFFFFFFFFFFull;
+		
+		for (l__i = 0; l__i < INIT_LATENCY_PERIODS; l__i ++)
+		{
+			uint64_t l__start = init_rdtsc();
+			
+			/* Just wait (nobody will sync with our process) */
+			hymk_sync(l__proc, 1, 0);
+			*tls_errno = 0;
+			
+			uint64_t l__period = init_rdtsc() - l__start;
+			
+			l__sum += l__period;
+			if (l__period > *max_cycles) *max_cycles = l__period;
+			if (l__period < *min_cycles) *min_cycles = l__period;
+		}
+	}
+	
+	*tls_errno = 0;
+	
+	hymk_set_deadline(l__self, 0, 0);
+	hymk_set_priority(l__self, l__prior, THRSCHED_CLASS_NORMAL);
+	*tls_errno = 0;
+	
+	/* Stop the load */
+	init_jitter_stop_load(load);
+	
+	return l__sum;
+}
+
+/*
+ * init_throttle_benchmark(load, throttles)
+ *
+ * Measures the CPU time of a deadline thread that reserves 
+ * 1 ms every 4 ms but wastes CPU time for INIT_THROTTLE_TICKS
+ * timer ticks, while "load" threads of the normal scheduling
+ * class waste CPU time as well. The thread should be throttled
+ * after its runtime in every period, so it gets about a 
+ * quarter of the CPU time. The number of throttles is 
+ * returned by "throttles".
+ *
+ * Return value:
+ *	Share of the CPU time of the thread (in 1/1000)
+ *
+ */
+unsigned init_throttle_benchmark(unsigned load, uint32_t *throttles)
+{
+	sid_t l__self = hysys_info_read(MAININFO_CURRENT_THREAD);
+	unsigned l__prior = hysys_thrtab_read(l__self, THRTAB_STATIC_PRIORITY);
+	uint32_t l__ticks = hysys_thrtab_read(l__self, THRTAB_CPU_TICKS);
+	uint32_t l__count = hysys_thrtab_read(l__self, THRTAB_THROTTLE_COUNT);
+	uint32_t l__start;
+	unsigned l__retval = 0;
+	
+	*throttles = 0;
+	
+	load = init_jitter_start_load(load);
+	
+	hymk_set_deadline(l__self, 1, 4);
+	
+	if (!*tls_errno)
+	{
+		l__start = hysys_info_read(MAININFO_RTC_COUNTER_LOW);
+		
+		while ((hysys_info_read(MAININFO_RTC_COUNTER_LOW) - l__start) < INIT_THROTTLE_TICKS);
+		
+		l__ticks = hysys_thrtab_read(l__self, THRTAB_CPU_TICKS) - l__ticks;
+		l__retval = (l__ticks * 1000) / INIT_THROTTLE_TICKS;
+		*throttles = hysys_thrtab_read(l__self, THRTAB_THROTTLE_COUNT) - l__count;
+	}
+	
+	*tls_errno = 0;
+	
+	hymk_set_deadline(l__self, 0, 0);
+	hymk_set_priority(l__self, l__prior, THRSCHED_CLASS_NORMAL);
+	*tls_errno = 0;
+	
+	init_jitter_stop_load(load);
+	
+	return l__retval;
+}
+
 /*
  * init_kill
  *
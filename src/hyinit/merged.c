@@ -0,0 +1,147 @@
+/*
+ *
+ * merged.c
+ *
+ * (C)2007 by Friedrich Gr�ter
+ *
+ * This file is distributed under the terms of
+ * the GNU General Public License, Version 2. You
+ * should have received a copy of this license (e.g. in 
+ * the file 'copying'). 
+ *
+ * Page merging daemon of hyInit
+ *
+ */
+#include <hydrixos/types.h> 
+#include <hydrixos/errno.h> 
+#include <hydrixos/hymk.h> 
+#include <hydrixos/tls.h>
+#include <hydrixos/stdfun.h>
+#include <hydrixos/blthr.h>
+
+#include <hydrixos/system.h>
+#include <hydrixos/mem.h>
+
+#include "hyinit.h"
+
+extern region_t *pmap_region;
+
+volatile unsigned init_merge_saved = 0;		/* Pages saved by the merge daemon */
+volatile unsigned init_merge_passes = 0;	/* Passes of the merge daemon */
+static thread_t *init_merge_thread = NULL;	/* Thread of the merge daemon */
+
+/*
+ * init_merge_region(proc, reg)
+ *
+ * Merges the pages of the region "reg" of the process
+ * "proc" with identical pages of other processes.
+ *
+ * Return value:
+ *	Number of merged pages
+ *
+ */
+static unsigned init_merge_region(sid_t proc, region_t *reg)
+{
+	uintptr_t l__adr;
+	unsigned l__pages;
+	unsigned l__retval = 0;
+	
+	if (reg == NULL) return 0;
+	
+	l__adr = (uintptr_t)reg->start;
+	l__pages = reg->pages;
+	
+	/* The kernel restricts the number of pages per call */
+	while (l__pages > 0)
+	{
+		unsigned l__num = l__pages;
+		
+		if (l__num > INIT_MERGE_STEP) l__num = INIT_MERGE_STEP;
+		
+		l__retval += hymk_merge(proc, (void*)l__adr, l__num);
+		if (*tls_errno) break;
+		
+		l__adr += l__num * ARCH_PAGE_SIZE;
+		l__pages -= l__num;
+	}
+	
+	return l__retval;
+}
+
+/*
+ * init_merge_pass()
+ *
+ * Merges identical pages of the main init process and
+ * of the debugger process. Because all init processes 
+ * are forked from the main process, they use the same
+ * regions.
+ *
+ * Return value:
+ *	Number of merged pages
+ *
+ */
+unsigned init_merge_pass(void)
+{
+	sid_t l__procs[2];
+	unsigned l__retval = 0;
+	int l__i;
+	
+	l__procs[0] = hysys_info_read(MAININFO_CURRENT_PROCESS);
+	l__procs[1] = initproc_debugger_sid;
+	
+	for (l__i = 0; l__i < 2; l__i ++)
+	{
+		if (l__procs[l__i] == 0) continue;
+		
+		l__retval += init_merge_region(l__procs[l__i], code_region);
+		l__retval += init_merge_region(l__procs[l__i], data_region);
+		l__retval += init_merge_region(l__procs[l__i], heap_region);
+		l__retval += init_merge_region(l__procs[l__i], pmap_region);
+	}
+	
+	*tls_errno = 0;
+	
+	return l__retval;
+}
+
+/*
+ * init_merge_daemon(thr)
+ *
+ * Main function of the merge daemon. It executes
+ * a merge pass every INIT_MERGE_INTERVAL ms.
+ *
+ */
+static void init_merge_daemon(thread_t *thr)
+{
+	sid_t l__proc = hysys_info_read(MAININFO_CURRENT_PROCESS);
+	
+	/* Merging is background work */
+	hymk_set_priority(thr->thread_sid, THRPRIOR_LOW, THRSCHED_CLASS_NORMAL);
+	*tls_errno = 0;
+	
+	while (1)
+	{
+		init_merge_saved += init_merge_pass();
+		init_merge_passes ++;
+		
+		/* Just wait (nobody will sync with our process) */
+		hymk_sync(l__proc, INIT_MERGE_INTERVAL, 0);
+		*tls_errno = 0;
+	}
+}
+
+/*
+ * init_merge_start()
+ *
+ * Starts the merge daemon, if it is not running yet.
+ *
+ */
+void init_merge_start(void)
+{
+	if (init_merge_thread != NULL) return;
+	
+	init_merge_thread = blthr_create(&init_merge_daemon, 8192);
+	if (init_merge_thread != NULL) blthr_awake(init_merge_thread);
+	
+	return;
+}
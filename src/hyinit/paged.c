@@ -0,0 +1,165 @@
+/*
+ *
+ * paged.c
+ *
+ * (C)2007 by Friedrich Grter
+ *
+ * This file is distributed under the terms of
+ * the GNU General Public License, Version 2. You
+ * should have received a copy of this license (e.g. in
+ * the file 'copying').
+ *
+ * Demo paging daemon of hyInit
+ *
+ */
+#include <hydrixos/types.h>
+#include <hydrixos/errno.h>
+#include <hydrixos/hymk.h>
+#include <hydrixos/tls.h>
+#include <hydrixos/stdfun.h>
+#include <hydrixos/blthr.h>
+#include <hydrixos/pmap.h>
+
+#include <hydrixos/system.h>
+#include <hydrixos/mem.h>
+
+#include "hyinit.h"
+
+volatile uintptr_t init_paged_area = 0;		/* Area resolved by the demo PageD */
+volatile unsigned init_paged_pages = 0;		/* Size of this area in pages */
+volatile sid_t init_paged_parent = 0;		/* Process that waits for the clients */
+uintptr_t initpaged_stack_buf;			/* Stack pointer of the clients */
+
+volatile unsigned init_paged_faults = 0;	/* Page faults resolved by the workers */
+volatile unsigned init_paged_batches = 0;	/* Batches received by the workers */
+static uint32_t *init_paged_src = NULL;		/* Page mapped to every fault address */
+static int init_paged_running = 0;		/* Is the demo PageD installed? */
+
+/*
+ * init_paged_worker(thr)
+ *
+ * Worker thread of the demo PageD. It receives batches
+ * of page faults and maps the source page read-only to
+ * every fault address within the area of the running
+ * benchmark. Other faults can't be resolved by the demo,
+ * so their threads will stay frozen.
+ *
+ */
+static void init_paged_worker(thread_t *thr)
+{
+	paged_fault_t l__faults[INIT_PAGED_BATCH];
+	paged_resolve_t l__list[INIT_PAGED_BATCH];
+
+	while (1)
+	{
+		unsigned l__num = hymk_recv_pagefaults(l__faults, INIT_PAGED_BATCH);
+		unsigned l__res = 0;
+		unsigned l__i;
+
+		/* Awaked as idle worker, just retry */
+		if (l__num == 0)
+		{
+			*tls_errno = 0;
+			continue;
+		}
+
+		for (l__i = 0; l__i < l__num; l__i ++)
+		{
+			uintptr_t l__adr = l__faults[l__i].adr;
+
+			if (    (l__adr < init_paged_area)
+			     || (l__adr >= init_paged_area + init_paged_pages * ARCH_PAGE_SIZE)
+			   )
+			{
+				iprintf("PageD demo (0x%X): Can't resolve fault of 0x%X at 0x%X.\n",
+					thr->thread_sid,
+					l__faults[l__i].thread,
+					l__adr
+				       );
+				continue;
+			}
+
+			l__list[l__res].thread = l__faults[l__i].thread;
+			l__list[l__res].src_adr = (uintptr_t)init_paged_src;
+			l__list[l__res].flags = 0;
+			l__res ++;
+		}
+
+		init_paged_faults += hymk_resolve_pagefaults(l__list, l__res);
+		init_paged_batches ++;
+		*tls_errno = 0;
+	}
+}
+
+/*
+ * init_paged_start()
+ *
+ * Installs the current process as demo PageD and starts
+ * its worker threads, if it is not running yet. The
+ * PageD can't be removed again.
+ *
+ * Return value:
+ *	0	Successful
+ *	1	Error
+ *
+ */
+int init_paged_start(void)
+{
+	unsigned l__i;
+
+	if (init_paged_running) return 0;
+
+	hymk_set_paged();
+	if (*tls_errno) return 1;
+
+	/* The source page of every resolved fault */
+	init_paged_src = pmap_mapalloc(ARCH_PAGE_SIZE);
+	if (init_paged_src == NULL) return 1;
+
+	for (l__i = 0; l__i < ARCH_PAGE_SIZE / 4; l__i ++)
+		init_paged_src[l__i] = INIT_PAGED_MAGIC;
+
+	/* Start the workers */
+	for (l__i = 0; l__i < INIT_PAGED_WORKERS; l__i ++)
+	{
+		thread_t *l__thr = blthr_create(&init_paged_worker, 8192);
+
+		if (l__thr == NULL) return 1;
+
+		blthr_awake(l__thr);
+	}
+
+	init_paged_running = 1;
+
+	return 0;
+}
+
+/*
+ * init_paged_client()
+ *
+ * Entry of the client processes of init_paged_benchmark
+ * (see initpaged_entry). It reads every page of the area
+ * resolved by the demo PageD and synchronizes with the
+ * waiting process, if all pages contain the source page.
+ *
+ */
+void init_paged_client(void)
+{
+	volatile uint32_t *l__mem = (void*)init_paged_area;
+	unsigned l__ok = 1;
+	unsigned l__i;
+
+	for (l__i = 0; l__i < init_paged_pages; l__i ++)
+	{
+		if (l__mem[l__i * (ARCH_PAGE_SIZE / 4)] != INIT_PAGED_MAGIC)
+			l__ok = 0;
+	}
+
+	if (l__ok) hymk_sync(init_paged_parent, INIT_PAGED_TIMEOUT, 0);
+
+	/* Wait until we are destroyed */
+	while (1)
+	{
+		hymk_sync(hysys_info_read(MAININFO_CURRENT_PROCESS), 0xFFFFFFFF, 0);
+	}
+}
@@ -107,6 +107,282 @@ static int testparser()
 	return 0;
 }
 
+/*
+ * forkbench()
+ *
+ * Compares the costs of duplicating the address space using the
+ * clone system call and using MAP_COPYONWRITE for different sizes
+ * of the heap.
+ *
+ */
+static void forkbench(void)
+{
+	static const unsigned l__sizes[] = {0, 256, 1024, 4096};
+	unsigned l__i;
+	
+	dc_printf("Heap growth\tclone (cycles)\tmap (cycles)\n");
+	
+	for (l__i = 0; l__i < (sizeof(l__sizes) / sizeof(l__sizes[0])); l__i ++)
+	{
+		uint64_t l__map = 0;
+		uint64_t l__clone = init_fork_benchmark(l__sizes[l__i], &l__map);
+		
+		dc_printf("%i KiB\t\t%i\t\t%i\n", 
+			  l__sizes[l__i] * (ARCH_PAGE_SIZE / 1024), 
+			  (uint32_t)l__clone, 
+			  (uint32_t)l__map
+			 );
+	}
+}
+
+/*
+ * sharebench()
+ *
+ * Measures the costs of sharing the init image with
+ * a growing number of processes and of destroying them.
+ *
+ */
+static void sharebench(void)
+{
+	static const unsigned l__procs[] = {1, 4, 16, 64};
+	unsigned l__i;
+	
+	dc_printf("Processes\tshare (cycles)\tdestroy (cycles)\n");
+	
+	for (l__i = 0; l__i < (sizeof(l__procs) / sizeof(l__procs[0])); l__i ++)
+	{
+		uint64_t l__destroy = 0;
+		uint64_t l__share = init_share_benchmark(l__procs[l__i], &l__destroy);
+		
+		dc_printf("%i\t\t%i\t\t%i\n", 
+			  l__procs[l__i], 
+			  (uint32_t)l__share, 
+			  (uint32_t)l__destroy
+			 );
+	}
+}
+
+/*
+ * latbench()
+ *
+ * Measures the wakeup latency of a high priority thread
+ * while another thread maps and unmaps growing memory areas.
+ *
+ */
+static void latbench(void)
+{
+	static const unsigned l__pages[] = {0, 256, 1024, 2048};
+	unsigned l__i;
+	
+	dc_printf("Storm\t\tperiod (cycles)\tmax. (cycles)\n");
+	
+	for (l__i = 0; l__i < (sizeof(l__pages) / sizeof(l__pages[0])); l__i ++)
+	{
+		uint64_t l__max = 0;
+		uint32_t l__sum = (uint32_t)init_latency_benchmark(l__pages[l__i], &l__max);
+		
+		dc_printf("%i KiB\t\t%i\t\t%i\n", 
+			  l__pages[l__i] * (ARCH_PAGE_SIZE / 1024), 
+			  l__sum / INIT_LATENCY_PERIODS,
+			  (uint32_t)l__max
+			 );
+	}
+}
+
+/*
+ * jitterbench()
+ *
+ * Measures the jitter of a periodic thread of each 
+ * scheduling class with and without background load.
+ *
+ */
+static void jitterbench(void)
+{
+	static const unsigned l__classes[] = {
+						THRSCHED_CLASS_NORMAL, 
+						THRSCHED_CLASS_RR, 
+						THRSCHED_CLASS_FIFO, 
+						THRSCHED_CLASS_DEADLINE
+					     };
+	static const utf8_t *l__names[] = {"normal", "rr", "fifo", "deadline"};
+	static const unsigned l__loads[] = {0, 4};
+	unsigned l__i, l__j;
+	
+	dc_printf("Class\t\tLoad\tperiod (cycles)\tjitter (cycles)\n");
+	
+	for (l__i = 0; l__i < (sizeof(l__classes) / sizeof(l__classes[0])); l__i ++)
+	{
+		for (l__j = 0; l__j < (sizeof(l__loads) / sizeof(l__loads[0])); l__j ++)
+		{
+			uint64_t l__min = 0;
+			uint64_t l__max = 0;
+			uint32_t l__sum = (uint32_t)init_jitter_benchmark(l__classes[l__i], 
+									 l__loads[l__j], 
+									 &l__min, 
+									 &l__max
+									);
+			
+			dc_printf("%s\t\t%i\t%i\t\t%i\n", 
+				  l__names[l__i],
+				  l__loads[l__j],
+				  l__sum / INIT_LATENCY_PERIODS,
+				  (uint32_t)(l__max - l__min)
+				 );
+		}
+	}
+	
+	/* A deadline thread that exceeds its runtime of 1 ms every 4 ms */
+	dc_printf("\nOverrun\t\tLoad\tCPU (1/1000)\tthrottles\n");
+	
+	for (l__j = 0; l__j < (sizeof(l__loads) / sizeof(l__loads[0])); l__j ++)
+	{
+		uint32_t l__throttles = 0;
+		unsigned l__share = init_throttle_benchmark(l__loads[l__j], &l__throttles);
+		
+		dc_printf("deadline\t%i\t%i\t\t%i\n", 
+			  l__loads[l__j],
+			  l__share,
+			  l__throttles
+			 );
+	}
+}
+
+/*
+ * cowbench()
+ *
+ * Measures the throughput of sequential writes to 
+ * memory that has been shared by copy-on-write.
+ *
+ */
+static void cowbench(void)
+{
+	static const unsigned l__pages[] = {16, 256, 1024};
+	unsigned l__i;
+	
+	dc_printf("Size\t\twrite (cycles)\tper page (cycles)\n");
+	
+	for (l__i = 0; l__i < (sizeof(l__pages) / sizeof(l__pages[0])); l__i ++)
+	{
+		uint32_t l__write = (uint32_t)init_cow_benchmark(l__pages[l__i]);
+		
+		dc_printf("%i KiB\t\t%i\t\t%i\n", 
+			  l__pages[l__i] * (ARCH_PAGE_SIZE / 1024), 
+			  l__write, 
+			  l__write / l__pages[l__i]
+			 );
+	}
+}
+
+/*
+ * xmlbench()
+ *
+ * Measures the throughput of the SPXML tokenizer for
+ * documents of different sizes.
+ *
+ */
+static void xmlbench(void)
+{
+	static const unsigned l__sizes[] = {64, 256, 1024};
+	unsigned l__i;
+	
+	dc_printf("Size		events		time (us)	MB/s\n");
+	
+	for (l__i = 0; l__i < (sizeof(l__sizes) / sizeof(l__sizes[0])); l__i ++)
+	{
+		uint32_t l__bytes = 0;
+		uint32_t l__events = 0;
+		uint32_t l__us = (uint32_t)init_xml_benchmark(l__sizes[l__i], &l__bytes, &l__events) / 1000;
+		
+		dc_printf("%i KiB		%i		%i		%i\n", 
+			  l__sizes[l__i], 
+			  l__events, 
+			  l__us,
+			  l__us ? (l__bytes / l__us) : 0
+			 );
+	}
+}
+
+/*
+ * pagedbench()
+ *
+ * Measures the page fault handling of the demo PageD
+ * with a growing number of faulting processes.
+ *
+ */
+static void pagedbench(void)
+{
+	static const unsigned l__procs[] = {1, 4, 8};
+	unsigned l__i;
+	
+	dc_printf("Processes	faults		batches		per fault (cycles)\n");
+	
+	for (l__i = 0; l__i < (sizeof(l__procs) / sizeof(l__procs[0])); l__i ++)
+	{
+		unsigned l__faults = init_paged_faults;
+		unsigned l__batches = init_paged_batches;
+		uint64_t l__cycles = 0;
+		
+		if (init_paged_benchmark(256, l__procs[l__i], &l__cycles))
+		{
+			dc_printf("Page fault handling failed.\n");
+			return;
+		}
+		
+		l__faults = init_paged_faults - l__faults;
+		l__batches = init_paged_batches - l__batches;
+		
+		dc_printf("%i\t\t%i\t\t%i\t\t%i\n", 
+			  l__procs[l__i], 
+			  l__faults,
+			  l__batches,
+			  l__faults ? ((uint32_t)l__cycles / l__faults) : 0
+			 );
+	}
+}
+
+/*
+ * xmltest()
+ *
+ * Tests the SPXML parser with documents, that end at
+ * the end of their buffers.
+ *
+ */
+static void xmltest(void)
+{
+	unsigned l__failed = init_xml_test();
+	
+	if (l__failed)
+		dc_printf("%i XML tests failed.\n", l__failed);
+	 else
+		dc_printf("All XML tests passed.\n");
+}
+
+/*
+ * pathbench()
+ *
+ * Compares the path resolution of a SPXML tree with
+ * and without an index.
+ *
+ */
+static void pathbench(void)
+{
+	static const utf8_t *l__names[INIT_PATH_METHODS] = {"linear", "index", "cache"};
+	uint32_t l__times[INIT_PATH_METHODS];
+	unsigned l__i;
+	
+	if (init_path_benchmark(1000000, l__times))
+	{
+		dc_printf("Path resolution failed.\n");
+		return;
+	}
+	
+	dc_printf("1000000 lookups, %i x %i elements\n", INIT_PATH_GROUPS, INIT_PATH_KEYS);
+	dc_printf("Method\t\ttime (ms)\n");
+	
+	for (l__i = 0; l__i < INIT_PATH_METHODS; l__i ++)
+		dc_printf("%s\t\t%i\n", l__names[l__i], l__times[l__i] / 1000);
+}
+
 void sub_thread(thread_t *thr);
 int x = 0;
 void sub_thread(thread_t *thr)
@@ -121,6 +397,16 @@ void sub_thread(thread_t *thr)
 	dc_printf("\t* xml\tTo parse a simple XML-File\n");
 	dc_printf("\t* blink\tJust a stupid multi-tasking demo\n");
 	dc_printf("\t* fblink\tJust a stupid performance demo\n");
+	dc_printf("\t* forkbench\tMeasures the costs of forking\n");
+	dc_printf("\t* sharebench\tMeasures the costs of sharing pages\n");
+	dc_printf("\t* cowbench\tMeasures the costs of copy-on-write\n");
+	dc_printf("\t* merge\tMerges identical pages of the init processes\n");
+	dc_printf("\t* latbench\tMeasures the wakeup latency during map storms\n");
+	dc_printf("\t* jitterbench\tMeasures the jitter of the scheduling classes\n");
+	dc_printf("\t* xmlbench\tMeasures the throughput of the XML tokenizer\n");
+	dc_printf("\t* xmltest\tTests the XML parser\n");
+	dc_printf("\t* pathbench\tMeasures the XML path resolution with an index\n");
+	dc_printf("\t* pagedbench\tMeasures the page fault handling of a demo PageD\n");
 
 	while(1) 
 	{
@@ -141,6 +427,58 @@ void sub_thread(thread_t *thr)
 		{
 			long l__c = 0;
 			while(1) {dc_printf("%i\n", l__c++); blthr_yield(0);}
+		}
+		 else if (!str_compare(l__buf, "forkbench", 10))
+		{
+			forkbench();
+		}
+		 else if (!str_compare(l__buf, "sharebench", 11))
+		{
+			sharebench();
+		}
+		 else if (!str_compare(l__buf, "cowbench", 9))
+		{
+			cowbench();
+		}
+		 else if (!str_compare(l__buf, "latbench", 9))
+		{
+			latbench();
+		}
+		 else if (!str_compare(l__buf, "jitterbench", 12))
+		{
+			jitterbench();
+		}
+		 else if (!str_compare(l__buf, "xmlbench", 9))
+		{
+			xmlbench();
+		}
+		 else if (!str_compare(l__buf, "xmltest", 8))
+		{
+			xmltest();
+		}
+		 else if (!str_compare(l__buf, "pathbench", 10))
+		{
+			pathbench();
+		}
+		 else if (!str_compare(l__buf, "pagedbench", 11))
+		{
+			pagedbench();
+		}
+		 else if (!str_compare(l__buf, "merge", 6))
+		{
+			unsigned l__merged = init_merge_pass();
+			
+			dc_printf("Merged %i pages (%i KiB saved).\n", 
+				  l__merged, 
+				  l__merged * (ARCH_PAGE_SIZE / 1024)
+				 );
+				 
+			init_merge_start();
+			
+			dc_printf("Merge daemon: %i pages saved in %i passes.\n", 
+				  init_merge_saved, 
+				  init_merge_passes
+				 );
 		}
 		 else if (!str_compare(l__buf, "fblink", 7))
 		{
@@ -39,7 +39,6 @@ extern uint32_t *current_p;		/* current process descr */
 extern uint32_t *current_t;		/* current thread descr */
 extern uint32_t *kinfo_eff_prior;	/* buffer of the currnt effctv priority*/
 extern uint64_t *kinfo_rtc_ctr;		/* buffer of the current RTC ctr */
-extern uint32_t *kinfo_io_map;		/* current I/O permission map */
 
 /* Initialization of the info page area */
 int kinfo_init_x86_cpu(void);
@@ -54,6 +53,13 @@ int kinfo_init(void);
  *
  */
 extern long i386_do_pge;
+extern long i386_do_tsc;
+
+/* Reads the time stamp counter (only if i386_do_tsc != 0) */
+#define RDTSC(___tsc)	 __asm__ __volatile__(\
+					      "rdtsc\n"\
+					      :"=A" (___tsc)\
+					     );
 
 /*
  * Descriptor managment
@@ -125,5 +131,62 @@ static inline int kinfo_isthrd(sid_t sid)
 	return 1;
 }
 
+/*
+ * kinfo_add64(tab, low, val)
+ *
+ * Adds 'val' to the 64-bit counter of a process or thread
+ * table 'tab', that is stored in the entries 'low' (lower
+ * 32 bits) and 'low + 1' (higher 32 bits).
+ *
+ */
+static inline void kinfo_add64(uint32_t *tab, unsigned low, uint64_t val)
+{
+	uint64_t l__v =   ((((uint64_t)tab[low + 1]) << 32) | tab[low])
+			+ val;
+	
+	tab[low] = (uint32_t)l__v;
+	tab[low + 1] = (uint32_t)(l__v >> 32);
+}
+
+/*
+ * kinfo_div64(a, b)
+ *
+ * Divides the 64-bit value 'a' by 'b'. The quotient has to
+ * fit into 32 bits ((a >> 32) < b), otherwise the CPU will
+ * raise a divide error.
+ *
+ */
+static inline uint32_t kinfo_div64(uint64_t a, uint32_t b)
+{
+	uint32_t l__quot;
+	uint32_t l__rem;
+	
+	__asm__ __volatile__("divl %4\n"
+			     :"=a" (l__quot), "=d" (l__rem)
+			     :"a" ((uint32_t)a), "d" ((uint32_t)(a >> 32)), "rm" (b)
+			    );
+	
+	return l__quot;
+}
+
+/*
+ * kinfo_clock_write_begin() / kinfo_clock_write_end()
+ *
+ * Enclose every change of the clock entries of the
+ * main info page (see MAININFO_CLOCK_SEQUENCE).
+ *
+ */
+static inline void kinfo_clock_write_begin(void)
+{
+	main_info[MAININFO_CLOCK_SEQUENCE] ++;
+	__asm__ __volatile__("":::"memory");
+}
+
+static inline void kinfo_clock_write_end(void)
+{
+	__asm__ __volatile__("":::"memory");
+	main_info[MAININFO_CLOCK_SEQUENCE] ++;
+}
+
 #endif
 
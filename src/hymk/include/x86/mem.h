@@ -118,7 +118,8 @@ int kmod_init(void);
 /* 
  * PFLAG_AVAILABLE_0:  Page is selected for Copy-on-write.
  * PFLAG_AVAILABLE_1:  Page is protected by the PageD.
- * PFLAG_AVAILABLE_2:  Currently unused (reserved for later versions).
+ * PFLAG_AVAILABLE_2:  Page table is shared by copy-on-write
+ *		       (only used within page directory entries).
  *
  */
 #define PFLAG_AVAILABLE_0	512	
@@ -127,6 +128,7 @@ int kmod_init(void);
 
 #define PFLAG_COPYONWRITE	PFLAG_AVAILABLE_0
 #define PFLAG_PAGED_PROTECTED	PFLAG_AVAILABLE_1
+#define PFLAG_SHARED_TABLE	PFLAG_AVAILABLE_2
 
 /* generalized paging flags */
 #define GENFLAG_PRESENT		PFLAG_PRESENT
@@ -138,6 +140,7 @@ int kmod_init(void);
 #define GENFLAG_GLOBAL		PFLAG_GLOBAL
 #define GENFLAG_DO_COPYONWRITE	PFLAG_AVAILABLE_0
 #define GENFLAG_PAGED_PROTECTED	PFLAG_AVAILABLE_1
+#define GENFLAG_SHARED_TABLE	PFLAG_AVAILABLE_2
 
 #define GENFLAG_DONT_OVERWRITE_SETTINGS		0x1000
 			 		      		      
@@ -193,19 +196,42 @@ typedef struct {
 	uintptr_t		u_adr;	/* Adress of page */
 }page_user_t;
 
-typedef struct sidlist_st{
-	page_user_t		user;	/* Users of this shared page (sid-null = unused )*/
-	struct sidlist_st	*nxt;	/* Next list entry */
-}sidlist_t;
+/*
+ * Reverse map (RMAP) of shared page frames
+ *
+ * The first RMAP_INLINE_USERS users of a shared page frame are
+ * stored within a small per-frame array. Further users are stored
+ * as overflow entries within a hash table (key: page frame, process
+ * and address), which are also linked to a per-frame list. Both
+ * object types are allocated from a pool of kernel page frames
+ * which grows on demand.
+ *
+ */
+#define RMAP_INLINE_USERS	3
+
+typedef struct rmap_entry_st {
+	uintptr_t		page;		/* Physical address of the page frame */
+	page_user_t		user;		/* User of the page frame */
+	struct rmap_entry_st	*hash_nxt;	/* Next entry of the hash bucket */
+	struct rmap_entry_st	*prv;		/* Previous overflow entry of the frame */
+	struct rmap_entry_st	*nxt;		/* Next overflow entry of the frame */
+	uint32_t		reserved[2];	/* (Size of a pool object) */
+}rmap_entry_t;
+
+typedef struct {
+	page_user_t		users[RMAP_INLINE_USERS];	/* Inline users */
+	uint32_t		inline_count;	/* Count of inline users */
+	rmap_entry_t		*overflow;	/* Overflow entries of the frame */
+}rmap_t;
 	
 typedef union {
 	page_user_t	single;		/* Single use: Process-SID */
-	sidlist_t	*multi;		/* Multiple use: SID-List */
+	rmap_t		*multi;		/* Multiple use: Reverse map */
 }page_usr_u;
 
 typedef struct {
 	uint16_t	usage;		/* Usage counter of a page frame */
-	page_usr_u	owner;		/* Owner SID / SID-List of a page frame */
+	page_usr_u	owner;		/* Owner SID / Reverse map of a page frame */
 }pbtab_t;
 
 /* Page buffer table */
@@ -216,11 +242,26 @@ extern pbtab_t* page_buf_table;		/* Pointer to the PBT */
 /* Access to the page buffer table */
 #define PAGE_BUF_TAB(___padr)		(page_buf_table[(___padr - (1024*1024)) / 4096])
 
-/* Page share table */
-extern uintptr_t page_share_table_start;	/* Start address of the PST */
-extern long page_share_table_count;		/* Count of entries in the PST */
-extern size_t page_share_table_sz;		/* Size of the PST */
-extern sidlist_t *page_share_table_free;	/* Pointer to the PST (free entries list) */
+/* Is the page frame 'padr' described by the PBT? */
+#define KMEM_IS_USER_FRAME(___padr) \
+	(    ((___padr) > 1024*1024) \
+	  && ((___padr) < (page_buffer_start + page_buffer_sz)) \
+	)
+
+/* Reverse map */
+extern uintptr_t rmap_hash_start;		/* Start address of the RMAP hash table */
+extern unsigned long rmap_hash_count;		/* Count of buckets (power of two) */
+extern size_t rmap_hash_sz;			/* Size of the RMAP hash table */
+extern rmap_entry_t **rmap_hash;		/* Pointer to the RMAP hash table */
+extern unsigned long rmap_pool_pages;		/* Page frames used by the RMAP pool */
+extern unsigned long rmap_pool_free_count;	/* Free objects within the RMAP pool */
+
+int kmem_rmap_reserve(unsigned long num);
+int kmem_rmap_add(uintptr_t page, sid_t pid, uintptr_t u_adr);
+int kmem_rmap_remove(uintptr_t page, sid_t pid, uintptr_t u_adr);
+void kmem_rmap_release(uintptr_t page);
+int kmem_rmap_rename(uintptr_t page, sid_t old_pid, sid_t new_pid, uintptr_t u_adr);
+sid_t kmem_rmap_first(uintptr_t page);
 
 /* Page buffer */
 extern uintptr_t page_buffer_start;	/* Start address of the Pagebuffer */
@@ -235,6 +276,7 @@ void* kmem_alloc_kernel_pageframe(void);	/* Normal-zone only */
 
 void kmem_free_kernel_pageframe(void* page);
 void kmem_free_user_pageframe(uintptr_t page, sid_t pid, uintptr_t u_adr);
+int kmem_share_user_pageframe(uintptr_t page, sid_t pid, uintptr_t u_adr);
 
 /*
  * ===================================
@@ -247,6 +289,16 @@ void kmem_free_user_pageframe(uintptr_t page, sid_t pid, uintptr_t u_adr);
 uint32_t* kmem_create_space(void);
 void kmem_destroy_space(uint32_t* pagedir);
 
+/*
+ * Copy-on-write sharing of page tables
+ *
+ */
+int kmem_share_table(uint32_t *pdir_s, sid_t sid_s, uint32_t *pdir_d, sid_t sid_d, unsigned long n);
+uint32_t* kmem_unshare_table(uint32_t *pdir, sid_t sid, uintptr_t adr);
+uint32_t* kmem_get_private_table(uint32_t *pdir, sid_t sid, uintptr_t adr, bool doalloc);
+void kmem_release_table(uint32_t *pdir, sid_t sid, unsigned long n);
+unsigned long kmem_reclaim_table(uint32_t *pdir, sid_t sid, unsigned long n);
+
 /*
  * TLB managment
  *
@@ -283,8 +335,12 @@ void kmem_destroy_space(uint32_t* pagedir);
 #define VAS_MAIN_INFO_PAGE		0xF8000000
 #define VAS_PROC_TABLE_START		0xF8001000
 #define VAS_THREAD_TABLE_START		0xFB001000
+#define VAS_TRACE_RING			0xFE002000
+#define VAS_PROFILE_BUFFER		0xFE044000
 #define VAS_INFO_END			0xFFFDFFFF
 #define VAS_USER_MODE_ACCESS_AREA	0xFFFE0000
+#define VAS_LAPIC_PAGE			0xFFFFD000
+#define VAS_IOAPIC_PAGE			0xFFFFE000
 #define VAS_LAST_PAGE			0xFFFFF000	
 
 /*
@@ -298,8 +354,31 @@ void kmem_destroy_space(uint32_t* pagedir);
  *
  */
 extern sid_t paged_thr_sid;
+extern sid_t paged_proc_sid;
+extern unsigned paged_queue_num;
 int kpaged_handle_exception(uint32_t number, uint32_t code, uintptr_t ip);
 int kpaged_send_pagefault(uint32_t number, uint32_t code, uint32_t ip, uint32_t adr);
+void kpaged_remove_fault(uint32_t *thr);
+void* kpaged_get_user_buffer(uintptr_t adr, size_t sz, bool write);
+
+/*
+ * Preemption of long running memory operations
+ *
+ */
+#define KMEM_OP_ALLOC			1
+#define KMEM_OP_MAP			2
+#define KMEM_OP_UNMAP			3
+#define KMEM_OP_MERGE			4
+#define KMEM_OP_MOVE			5
+
+unsigned long kmem_op_resume(unsigned op, 
+			     sid_t sid, 
+			     uintptr_t adr, 
+			     unsigned long pages,
+			     unsigned flags,
+			     uintptr_t offset
+			    );
+int kmem_op_preempt(unsigned op, unsigned long done);
 
 /*
  * Copy-on-write implementation
@@ -307,6 +386,7 @@ int kpaged_send_pagefault(uint32_t number, uint32_t code, uint32_t ip, uint32_t
  */
 int kmem_do_copy_on_write(uint32_t* pdir, sid_t sid, uintptr_t usradr);		/* Execution of COW */
 int kmem_copy_on_write(void); 							/* Exception handler for COW exceptions */
+int kmem_merge_page(uint32_t *pdir, sid_t sid, uintptr_t usradr);		/* Merging of identical pages */
 			  
 /*
  * TSS initialization
@@ -62,6 +62,24 @@ extern struct i386_tss_ps {
 	uint16_t	t, io_base;
 }*i386_tss_struct;
 
+/*
+ * Layout of the TSS area (TSS + I/O permission bitmaps)
+ *
+ * The TSS is followed by two bitmaps. The first one allows
+ * the access to every port (for IO_ALLOW_PORTS), the second
+ * one contains a copy of the port bitmap of the current
+ * process. If "io_base" is beyond the TSS limit every
+ * port access of user mode code will be denied.
+ *
+ */
+#define I386_IOMAP_SIZE		8192	/* 65536 Ports */
+#define I386_IOMAP_ALLOW_ALL	0x0080	/* Offset of the "allow all" map */
+#define I386_IOMAP_PROCESS	0x2100	/* Offset of the process map */
+#define I386_IOMAP_NONE		0xFFFF	/* No map, deny all */
+
+#define I386_TSS_LIMIT		(I386_IOMAP_PROCESS + I386_IOMAP_SIZE)
+#define I386_TSS_AREA_SIZE	(5 * 4096)
+
 typedef struct {
 	unsigned int	offs_l 		:16,
 			sel 		:16,
@@ -102,16 +120,50 @@ extern struct ksched_irqt_ps {
 		sid_t		pid;		/* SID of receiving process */
 		sid_t		tid;		/* SID of receiving thread */
 		long		used;		/* used = 1; unused = 0; unuseable = -1 */
-}ksched_irqt_s[16];
+		unsigned	gsi;		/* I/O APIC pin */
+		unsigned	mode;		/* IRQMODE_* flags */
+}ksched_irqt_s[IRQ_MAX_LINES];
+
+/* Number of usable IRQ lines (16 if the PIC is used) */
+extern unsigned ksched_irq_lines;
+
+/* Calculate the IDT entry of an IRQ */
+#define	IRQ(irqnr)			(0xA0 + irqnr)
+
+/* IDT entry of the spurious interrupt of the local APIC */
+#define APIC_SPURIOUS_VECTOR		0xBF
 
 int ksched_init_ints(void);
 
+/* TSC value at the entry of the last IRQ (0 if no TSC) */
+extern uint64_t ksched_irq_entry_tsc;
+
+/* Updates the IRQ latency histogram of a handler thread */
+void kio_irq_dispatched(uint32_t *thr);
+
 /* 
- * These functions controls the PIC
+ * These functions controls the PIC or the I/O APIC
  *
  */
 void ksched_enable_irq(irq_t irqnr);
 void ksched_disable_irq(irq_t irqnr);
+int ksched_irq_pending(void);
+int ksched_irq_needs_mask(irq_t irqnr);
+int ksched_set_irq_mode(irq_t irqnr, unsigned mode);
+
+/*
+ * Local APIC and I/O APIC (apic.c)
+ *
+ */
+extern bool ksched_apic_active;
+extern volatile uint32_t *ksched_lapic_eoi;
+
+int ksched_init_apic(void);
+void ksched_apic_set_mask(irq_t irq, bool masked);
+int ksched_apic_irq_pending(void);
+
+/* Restarts the current system call */
+void ksched_restart_syscall(void);
 
 /*
  * This assembler function will handle the interrupts:
@@ -133,6 +185,15 @@ void i386_irqhandleasm_12(void);
 void i386_irqhandleasm_13(void);
 void i386_irqhandleasm_14(void);
 void i386_irqhandleasm_15(void);
+void i386_irqhandleasm_16(void);
+void i386_irqhandleasm_17(void);
+void i386_irqhandleasm_18(void);
+void i386_irqhandleasm_19(void);
+void i386_irqhandleasm_20(void);
+void i386_irqhandleasm_21(void);
+void i386_irqhandleasm_22(void);
+void i386_irqhandleasm_23(void);
+void i386_spurious_handler(void);
 
 void i386_exhandleasm_0(void);
 void i386_exhandleasm_1(void);
@@ -182,6 +243,8 @@ void ksched_start_irq_handler(irq_t irqn);
 void ksched_do_panic(void);
 
 void kio_reenable_irq(irq_t irq);
+void kio_load_iomap(void);
+void kio_free_iomap(uint32_t *proc);
 
 /* Informations about the current exception */
 extern uint32_t i386_saved_error_code;
@@ -201,13 +264,42 @@ extern uint32_t *i386_old_stack_pointer;
  */
 #define SCHED_REGULAR			0
 
+/* 
+ * Is it a thread of a real-time class (RR, FIFO or deadline) or
+ * did it inherit a real-time class from a waiting thread?
+ *
+ */
+#define KSCHED_IS_RT(___thr)	\
+		(    ((___thr)[THRTAB_SCHEDULING_CLASS] != THRSCHED_CLASS_NORMAL) \
+		  || ((___thr)[THRTAB_INHERITED_CLASS] != THRSCHED_CLASS_NORMAL) \
+		)
+
+/* Static priority of a thread, including the inherited priority */
+#define KSCHED_PRIORITY(___thr)	\
+		(  ((___thr)[THRTAB_INHERITED_PRIORITY] > (___thr)[THRTAB_STATIC_PRIORITY]) \
+		 ? (___thr)[THRTAB_INHERITED_PRIORITY] \
+		 : (___thr)[THRTAB_STATIC_PRIORITY] \
+		)
+		
+/* Bandwidth currently reserved by deadline threads (in 1/65536) */
+extern uint32_t ksched_deadline_bandwidth;
+
+/* Deadline threads waiting for their next period */
+extern uint32_t *ksched_throttled;
+
 /* Count of threads that are ready for execution*/
 extern long ksched_active_threads;
 extern long ksched_change_thread;	
+extern long ksched_yielded;
 extern uint32_t *ksched_idle_thread;
 
 int ksched_start_thread(uint32_t *thrd);
+int ksched_start_thread_direct(uint32_t *thrd);
 int ksched_stop_thread(uint32_t *thrd);
+void ksched_requeue_thread(uint32_t *thrd);
+void ksched_rt_tick(void);
+void ksched_rt_replenish(void);
+int ksched_release_deadline(uint32_t *thrd);
 
 int ksysc_create_idle(void);
 void ksched_idle_loop(void);
@@ -240,6 +332,8 @@ int kremote_received(uint32_t intr);
  *
  */
 void ksync_interrupt_other(uint32_t *other);
+void ksync_update_inheritance(uint32_t *thr);
+void ksync_priority_changed(uint32_t *thr);
 void ksync_removefrom_waitqueue_error(uint32_t *other, uint32_t *me);
 
 #endif
@@ -56,7 +56,27 @@
 
 #define MEM_MAX_PAGE_OP_NUM		((8 * 1024 * 1024) / 4096)
 
-#define PST_PERCENT			20
+/* Count of pages copied in advance by a copy-on-write exception */
+#define MEM_COW_FAULT_AROUND		8
+
+/* Count of candidates of the page merging (power of two) */
+#define MEM_MERGE_CANDIDATES		512
+
+/* Count of pages between two preemption points of memory operations */
+#define MEM_PREEMPT_PAGES		64
+
+/* Count of page tables reclaimed in one step after killing a process */
+#define MEM_RECLAIM_CHUNK		4
+
+/* Max. count of PageD worker threads */
+#define PAGED_MAX_WORKERS		8
+
+/* Max. count of page faults received / resolved with one system call */
+#define PAGED_MAX_BATCH			256
+
+/* Count of RMAP hash buckets per 100 page frames */
+#define RMAP_HASH_PERCENT		25
+
 /*
  * Size of a Kernel stack
  *
@@ -70,9 +90,15 @@
  */
 #define SCHED_PRIORITY_MAX		40
 #define SCHED_PRIORITY_MIN		0
-#define SCHED_CLASS_MAX			0
+#define SCHED_CLASS_MAX			3
 #define SCHED_CLASS_MIN			0
 
+/* Max. CPU bandwidth of all deadline threads (in 1/65536, 90 %) */
+#define SCHED_DEADLINE_MAX_BANDWIDTH	58982
+
+/* Max. period of a deadline thread (in ticks) */
+#define SCHED_DEADLINE_MAX_PERIOD	0xFFFF
+
 /*
  * Frequency of the timer in Hz 
  *
@@ -81,7 +107,16 @@
  */
 #define TIMER_FREQUENCY				1000
 
+/* PIT cycles (1.193182 MHz) of the TSC calibration (about 50 ms) */
+#define KSCHED_TSC_CALIBRATION_COUNT		59659
+
+/* Max. length of a chain of threads inheriting their priorities */
+#define SYNC_INHERIT_DEPTH			16
+
 /* IRQ THREAD PRIORITY */
 #define IRQ_THREAD_PRIORITY			1000
 
+/* Max. count of IRQ lines (I/O APIC pins, vectors 0xA0 - 0xB7) */
+#define IRQ_MAX_LINES				24
+
 #endif
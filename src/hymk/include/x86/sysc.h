@@ -19,7 +19,7 @@
 #include <sched.h>
 
 #define KFIRST_SYSCALL			0xC0u
-#define KLAST_SYSCALL			0xD5u
+#define KLAST_SYSCALL			0xDFu
 
 extern errno_t syscall_error;
 
@@ -32,6 +32,9 @@ sid_t sysc_create_process(uintptr_t eip, uintptr_t esp);
 
 int ksysc_create_init(void);
 
+extern unsigned long ksubj_reclaim_pending;
+int ksubj_reclaim(unsigned long tables);
+
 void sysc_set_controller(sid_t sid);
 
 void sysc_destroy_subject(sid_t sid);
@@ -48,6 +51,13 @@ void sysc_awake_subject(sid_t subj);
 
 void sysc_yield_thread(sid_t dest);
 void sysc_set_priority(sid_t thrd, unsigned priority, unsigned policy);
+void sysc_set_deadline(sid_t thrd, unsigned runtime, unsigned period);
+
+/* Tracing */
+uint32_t sysc_trace_ctl(uint32_t mask);
+void sysc_profile_ctl(sid_t proc, unsigned depth);
+unsigned sysc_trace_read(uintptr_t buf, uint32_t first, unsigned num);
+unsigned sysc_profile_read(uintptr_t buf, uint32_t first, unsigned num);
 
 /* Memory sharing */
 void sysc_allow(sid_t dest_sid, 
@@ -91,6 +101,16 @@ void sysc_move(sid_t dest_sid,
 	       uintptr_t dest_offset
 	      );
 
+void sysc_clone(sid_t dest_sid,
+		uintptr_t src_adr,
+		unsigned long pages
+	       );
+
+unsigned sysc_merge(sid_t sid,
+		    uintptr_t adr,
+		    unsigned long pages
+		   );
+
 /* Synchronization */
 sid_t sysc_sync(sid_t other, unsigned timeout, unsigned resyncs);
 
@@ -105,6 +125,14 @@ void sysc_io_allow(sid_t dest, unsigned flags);
 #define IO_ALLOW_IRQ		1u
 #define IO_ALLOW_PORTS		2u
 
+void sysc_io_allow_range(sid_t dest, 
+			 unsigned port, 
+			 unsigned num, 
+			 unsigned op
+			);
+#define IORANGE_DENY		0u
+#define IORANGE_ALLOW		1u
+
 void sysc_io_alloc(uintptr_t src, 
 		  uintptr_t dest, 
 		  unsigned long pages, 
@@ -118,17 +146,25 @@ void sysc_io_alloc(uintptr_t src,
 void sysc_recv_irq(irq_t irq);
 #define RECV_IRQ_NONE		0xFFFFFFFFu		 
 
+void sysc_irq_mode(irq_t irq, unsigned mode);
+#define IRQMODE_EDGE		0u
+#define IRQMODE_LEVEL		1u
+#define IRQMODE_ACTIVE_LOW	2u
+
 /* Remote control of threads */
 uint32_t sysc_recv_softints(sid_t sid, unsigned timeout, int flags);
 #define RECV_AWAKE_OTHER	1u
 #define RECV_TRACE_SYSCALL	2u
+#define RECV_STREAM_SYSCALL	4u
+
+#define RECV_STREAM_DATA	0xFFFFFFFEu
 
 /*
  * These functions will directly manipulate the registers
  * of the calling thread to pass their return values.
  *
  */
-void sysc_read_regs(sid_t sid, unsigned regtype);
+void sysc_read_regs(sid_t sid, unsigned regtype, uintptr_t frame);
 void sysc_write_regs(sid_t sid, 
 		     unsigned regtype, 
 		     uint32_t reg_a,
@@ -142,6 +178,29 @@ void sysc_write_regs(sid_t sid,
 #define REGS_X86_EFLAGS		3u
 #define REGS_X86_BREAKPOINTS	4u
 #define REGS_X86_DEBUG_SETUP	5u
+#define REGS_X86_FRAME		6u
+#define REGS_X86_FRAME_FPU	7u
+
+/* x86: Complete register frame (REGS_X86_FRAME, REGS_X86_FRAME_FPU) */
+typedef struct
+{
+	uint32_t	eax, ebx, ecx, edx;
+	uint32_t	esi, edi, ebp, esp;
+	uint32_t	eip, eflags;
+	uint32_t	cs, ss, ds, es, fs, gs;	/* Read-only */
+	
+	/* Only used by REGS_X86_FRAME_FPU */
+	uint32_t	fpu_format;		/* REG_FPU_* */
+	uint32_t	reserved[3];
+	uint8_t		fpu[512];		/* FSAVE or FXSAVE image */
+}reg_frame_t;
+
+/* Size of the register frame without the FPU state */
+#define REG_FRAME_SIZE		(16 * 4)
+
+#define REG_FPU_NONE		0u
+#define REG_FPU_FSAVE		1u
+#define REG_FPU_FXSAVE		2u
 
 /* Paging Daemon */
 void sysc_set_paged(void);
@@ -151,6 +210,25 @@ unsigned sysc_test_page(uintptr_t adr, sid_t sid);
 #define PGA_WRITE		2u
 #define PGA_EXECUTE		4u
 
+/* Batched page fault handling */
+typedef struct
+{
+	sid_t		thread;		/* Faulting thread */
+	uint32_t	number;		/* Platform exception number */
+	uintptr_t	adr;		/* Fault address (or IP of other exceptions) */
+	uint32_t	descr;		/* Page table entry of the fault address */
+}paged_fault_t;
+
+typedef struct
+{
+	sid_t		thread;		/* Thread to awake */
+	uintptr_t	src_adr;	/* Page to map to the fault address (or null) */
+	unsigned	flags;		/* MAP_WRITE, MAP_EXECUTABLE, MAP_PAGED */
+}paged_resolve_t;
+
+unsigned sysc_recv_pagefaults(uintptr_t buf, unsigned max);
+unsigned sysc_resolve_pagefaults(uintptr_t list, unsigned num);
+
 /*
  * Low-Level implementations of the system calls
  *
@@ -188,6 +266,18 @@ void i386_sysc_write_regs(void);
 void i386_sysc_set_paged(void);
 void i386_sysc_test_page(void);
 
+void i386_sysc_clone(void);
+void i386_sysc_merge(void);
+void i386_sysc_recv_pagefaults(void);
+void i386_sysc_resolve_pagefaults(void);
+void i386_sysc_io_allow_range(void);
+void i386_sysc_irq_mode(void);
+void i386_sysc_set_deadline(void);
+void i386_sysc_trace_ctl(void);
+void i386_sysc_profile_ctl(void);
+void i386_sysc_trace_read(void);
+void i386_sysc_profile_read(void);
+
 
 #endif
 
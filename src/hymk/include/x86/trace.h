@@ -0,0 +1,96 @@
+/*
+ *
+ * trace.h
+ *
+ * (C)2007 by Friedrich Grter
+ *
+ * This file is distributed under the terms of
+ * the GNU General Public License, Version 2. You
+ * should have received a copy of this license (e.g. in 
+ * the file 'copying'). 
+ *
+ * Kernel trace ring
+ *
+ */
+#ifndef _KTRACE_H
+#define _KTRACE_H
+
+#include <hydrixos/types.h>
+#include <hymk/trace.h>
+#include <info.h>
+
+/* Pages of trace records (+ 1 header page) */
+#define KTRACE_RING_PAGES		64
+#define KTRACE_RING_SIZE		((KTRACE_RING_PAGES * 4096) / sizeof(trace_record_t))
+
+/* Max. number of records copied by trace_read and profile_read */
+#define KTRACE_READ_MAX			256
+
+/* Pages of the profiler sample buffer */
+#define KPROF_BUFFER_PAGES		16
+#define KPROF_BUFFER_SIZE		((KPROF_BUFFER_PAGES * 4096) / sizeof(trace_record_t))
+
+extern uint32_t ktrace_mask;
+extern trace_header_t *ktrace_header;
+extern trace_record_t *ktrace_ring;
+
+/* Sampled process (SID_NULL if the profiler is off) */
+extern sid_t kprof_process;
+
+int ktrace_alloc_ring(void);
+void ktrace_syscall_enter(uint32_t nr, uint32_t eax, uint32_t ebx, uint32_t ecx);
+void ktrace_syscall_exit(uint32_t nr);
+void ktrace_sample(void);
+
+/*
+ * ktrace_write(type, a0, a1, a2, a3)
+ *
+ * Writes a record to the trace ring. Only call this
+ * function if the category of 'type' is active.
+ *
+ */
+static inline void ktrace_write(unsigned type, 
+				uint32_t a0, 
+				uint32_t a1, 
+				uint32_t a2, 
+				uint32_t a3
+			       )
+{
+	uint32_t l__head = ktrace_header->head;
+	trace_record_t *l__rec = &ktrace_ring[l__head & (KTRACE_RING_SIZE - 1)];
+	
+	/* Without TSC the timer ticks are used */
+	if (i386_do_tsc)
+	{
+		__asm__ __volatile__("rdtsc\n"
+				     :"=a" (l__rec->tsc_low), "=d" (l__rec->tsc_high)
+				    );
+	}
+	 else
+	{
+		l__rec->tsc_low = main_info[MAININFO_RTC_COUNTER_LOW];
+		l__rec->tsc_high = main_info[MAININFO_RTC_COUNTER_HIGH];
+	}
+	
+	l__rec->type = type;
+	l__rec->cpu = 0;
+	l__rec->thread = current_t[THRTAB_SID];
+	l__rec->arg[0] = a0;
+	l__rec->arg[1] = a1;
+	l__rec->arg[2] = a2;
+	l__rec->arg[3] = a3;
+	
+	/* Publish the record */
+	__asm__ __volatile__("":::"memory");
+	ktrace_header->head = l__head + 1;
+	main_info[MAININFO_TRACE_HEAD] = l__head + 1;
+}
+
+/* Writes a trace record, if the category '___cat' is active */
+#define KTRACE(___cat, ___type, ___a0, ___a1, ___a2, ___a3) \
+	{\
+		if (ktrace_mask & (___cat)) \
+			ktrace_write((___type), (___a0), (___a1), (___a2), (___a3));\
+	}
+
+#endif
@@ -47,6 +47,32 @@
 			     );\
 }
 
+/*
+ * kmem_reclaim_frames()
+ *
+ * Reclaims the page frames of all defunct processes at once,
+ * if the page buffer ran out of frames. Allocations done
+ * during the reclamation (e.g. by the release of a shared
+ * page table) won't start another one.
+ *
+ * Return value:
+ *	1	Defunct processes reclaimed, retry the allocation
+ *	0	Nothing to reclaim
+ *
+ */
+static int kmem_reclaim_frames(void)
+{
+	static bool l__active = false;
+	
+	if ((!ksubj_reclaim_pending) || (l__active)) return 0;
+	
+	l__active = true;
+	ksubj_reclaim(0xFFFFFFFF);
+	l__active = false;
+	
+	return 1;
+}
+
 /*
  * kmem_alloc_kernel_pageframe()
  *
@@ -83,7 +109,10 @@ void* kmem_alloc_kernel_pageframe(void)
 		return l__retval;
 	}	
 	
-	/* Out of memory */
+	/* Out of memory. Reclaim the memory of defunct processes first */
+	if (kmem_reclaim_frames())
+		return kmem_alloc_kernel_pageframe();
+	
 	return NULL;	
 }
 
@@ -149,7 +178,10 @@ void* kmem_alloc_user_pageframe(sid_t pid, uintptr_t u_adr)
 		return l__retval;
 	}	
 	
-	/* Out of memory */
+	/* Out of memory. Reclaim the memory of defunct processes first */
+	if (kmem_reclaim_frames())
+		return kmem_alloc_user_pageframe(pid, u_adr);
+	
 	return NULL;	
 }
 
@@ -163,7 +195,7 @@ void* kmem_alloc_user_pageframe(sid_t pid, uintptr_t u_adr)
  * kmem_free_user_pageframe.
  *
  * The function will reset the page frame status information
- * of the PBT without removing PST-entries.
+ * of the PBT and release its reverse map.
  *
  */
 void kmem_free_kernel_pageframe(void* page)
@@ -179,6 +211,8 @@ void kmem_free_kernel_pageframe(void* page)
 		return;
 	}
 	
+	kmem_rmap_release(l__page);
+	
 	PAGE_BUF_TAB(l__page).usage = 0;	
 	PAGE_BUF_TAB((uintptr_t)l__page).owner.single.pid = 0;
 	PAGE_BUF_TAB((uintptr_t)l__page).owner.single.u_adr = 0;
@@ -206,7 +240,7 @@ void kmem_free_kernel_pageframe(void* page)
  * Removes the useage information of a page frame at physical
  * address 'page' for the process 'pid' at address 'u_adr'.
  * If the page frame will be only used by a single process by now, 
- * the function removes the useage-list. If the page frame will 
+ * the function removes the reverse map. If the page frame will 
  * be unused, the function frees the page using 
  * 'kmem_free_kernel_pageframe'.
  * 
@@ -216,9 +250,6 @@ void kmem_free_kernel_pageframe(void* page)
  */
 void kmem_free_user_pageframe(uintptr_t page, sid_t pid, uintptr_t u_adr)
 {
-	long l__n;
-	sidlist_t *l__slist_last;
-	sidlist_t *l__slist_cur;
 	page &= (~0xFFF);
 
 	/* Is it a valid middle-zone page frame */
@@ -244,69 +275,41 @@ void kmem_free_user_pageframe(uintptr_t page, sid_t pid, uintptr_t u_adr)
 		return;
 	}
 
-	/* The page is used by multiple owners, search it */
-	l__n = PAGE_BUF_TAB(page).usage;
-	l__slist_last = NULL;
-	l__slist_cur = PAGE_BUF_TAB(page).owner.multi;
+	/* The page is used by multiple owners, remove it from the RMAP */
+	kmem_rmap_remove(page, pid, u_adr);
+	
+	return;
+}
 
-	while (l__n --)
+/*
+ * kmem_share_user_pageframe(page, pid, u_adr)
+ *
+ * Adds the process 'pid' as a further user of the page frame
+ * at physical address 'page', which is mapped to its address
+ * space at address 'u_adr'. If the page frame has been used 
+ * by a single owner until now, the function will create a new
+ * reverse map for it (see kmem_rmap_add). The usage counter of
+ * the page frame will be incremented.
+ *
+ * Page frames that are not described by the PBT (e.g. I/O
+ * memory) will be ignored.
+ *
+ * Return value:
+ *	0	Successful
+ *	1	Not enough memory for the reverse map
+ *
+ */
+int kmem_share_user_pageframe(uintptr_t page, sid_t pid, uintptr_t u_adr)
+{
+	page &= (~0xFFF);
+	
+	/* Is it a page frame described by the PBT? */
+	if (!KMEM_IS_USER_FRAME(page))
 	{
-		/* Is this the searched owner entry? */
-		if (    (l__slist_cur->user.pid == pid)
-		     && (l__slist_cur->user.u_adr == u_adr)
-		   )
-		{
-			/* Okay, just remove the entry from the list*/
-			if (l__slist_last != NULL ) 
-			{
-				/* Entry is somewhere in the list */
-				l__slist_last->nxt = l__slist_cur->nxt;
-			}
-			 else
-			{
-				/* Entry is at the beginnig of the list */
-				PAGE_BUF_TAB(page).owner.multi = l__slist_cur->nxt;
-			}
-			
-			/* At the entry to the free entries list of the PST */
-			l__slist_cur->nxt = page_share_table_free->nxt;
-
-			if (page_share_table_free != NULL)
-				page_share_table_free->nxt = l__slist_cur;
-			else
-				page_share_table_free = l__slist_cur;
-
-			/* Decrement usage status */
-			PAGE_BUF_TAB(page).usage --;
-			
-			/* Do we need still a list? */
-			if (PAGE_BUF_TAB(page).usage == 1)
-			{
-				/* No? Switch to single-owner mode */
-				l__slist_cur = PAGE_BUF_TAB(page).owner.multi;
-				
-				PAGE_BUF_TAB(page).owner.single.pid = l__slist_cur->user.pid;
-				PAGE_BUF_TAB(page).owner.single.u_adr = l__slist_cur->user.u_adr;
-				
-				/* Free the remaining list entry */
-				l__slist_cur->nxt = page_share_table_free->nxt;
-				page_share_table_free->nxt = l__slist_cur;
-			}
-			
-			return;
-		}
-		 else
-		{
-			/* Next turn, save the pointer to last entry */
-			l__slist_last = l__slist_cur;
-			l__slist_cur = l__slist_cur->nxt;
-		
-			if (l__slist_cur->nxt == NULL) break;
-		}
+		return 0;
 	}
 	
-	/* Page not included in list */
-	return;
+	return kmem_rmap_add(page, pid, u_adr);
 }
 
 /*
@@ -324,6 +327,8 @@ void kmem_free_user_pageframe(uintptr_t page, sid_t pid, uintptr_t u_adr)
  * The destination area may not contain the kernel memory,
  * the zero page or the thread local storage.
  *
+ * The operation has preemption points (see kmem_op_preempt).
+ *
  * Parameters:
  *	start	Destination address 		
  *	pages	Number of page frames
@@ -332,6 +337,11 @@ void kmem_free_user_pageframe(uintptr_t page, sid_t pid, uintptr_t u_adr)
 void sysc_alloc_pages(uintptr_t start, unsigned long pages)
 {
 	void* l__memory;
+	unsigned long l__op_pages = pages;
+	unsigned l__preempt = MEM_PREEMPT_PAGES;
+	
+	/* Continue an interrupted operation */
+	unsigned long l__done = kmem_op_resume(KMEM_OP_ALLOC, 0, start, pages, 0, 0);
 	
 	/* Align start address to the start of the page */
 	start &= (~0xfff);
@@ -355,9 +365,23 @@ void sysc_alloc_pages(uintptr_t start, unsigned long pages)
 		return;
 	}
 		   
+	pages -= l__done;
+	start += l__done * 4096;
+		   
 	/* Allocate the new memory area */
 	while(pages --)
 	{
+		/* Preemption point */
+		if ((-- l__preempt) == 0)
+		{
+			l__preempt = MEM_PREEMPT_PAGES;
+			
+			if (kmem_op_preempt(KMEM_OP_ALLOC, l__op_pages - (pages + 1)))
+			{
+				return;
+			}
+		}
+		
 		l__memory = kmem_alloc_user_pageframe(current_p[PRCTAB_SID], 
 						      start 
 						     );
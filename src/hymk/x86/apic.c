@@ -0,0 +1,424 @@
+/*
+ *
+ * apic.c
+ *
+ * (C)2007 by Friedrich Grter
+ *
+ * This file is distributed under the terms of
+ * the GNU General Public License, Version 2. You
+ * should have received a copy of this license (e.g.
+ * in the file 'copying').
+ *
+ * Local APIC and I/O APIC interrupt routing
+ *
+ * If the ACPI MADT describes an I/O APIC, the kernel
+ * routes all IRQs through the I/O APIC and the local 
+ * APIC instead of the 8259 PICs. The IRQ numbers 0-15 
+ * are still the ISA IRQ numbers (translated by the
+ * interrupt source overrides of the MADT), the numbers
+ * above 15 are the global system interrupts of the
+ * I/O APIC. Every IRQ uses the vector IRQ(n).
+ *
+ */
+#include <hydrixos/types.h>
+#include <stdio.h>
+#include <setup.h>
+#include <mem.h>
+#include <page.h>
+#include <sched.h>
+#include <sysc.h>
+#include <hymk/x86-io.h>
+
+/* Is the APIC used instead of the PIC? */
+bool ksched_apic_active = false;
+
+/* EOI register of the local APIC (used by irq.s, NULL if PIC) */
+volatile uint32_t *ksched_lapic_eoi = NULL;
+
+/* Kernel addresses of the register windows */
+static volatile uint32_t *ksched_lapic = NULL;
+static volatile uint32_t *ksched_ioapic = NULL;
+
+/* Destination of the IRQs (APIC ID of the boot processor) */
+static uint32_t ksched_apic_dest = 0;
+
+/* Local APIC registers (index of 32 bit words) */
+#define LAPIC_ID		(0x20 / 4)
+#define LAPIC_TPR		(0x80 / 4)
+#define LAPIC_EOI		(0xB0 / 4)
+#define LAPIC_SVR		(0xF0 / 4)
+#define LAPIC_IRR(___n)		((0x200 + ((___n) * 0x10)) / 4)
+
+/* I/O APIC registers */
+#define IOAPIC_REGSEL		0
+#define IOAPIC_WINDOW		(0x10 / 4)
+#define IOAPIC_VERSION		1
+#define IOAPIC_REDIR_LOW(___p)	(0x10 + ((___p) * 2))
+#define IOAPIC_REDIR_HIGH(___p)	(0x11 + ((___p) * 2))
+
+/* Redirection entry flags */
+#define IOAPIC_ACTIVE_LOW	(1u << 13)
+#define IOAPIC_LEVEL		(1u << 15)
+#define IOAPIC_MASKED		(1u << 16)
+
+/*
+ * ksched_ioapic_read(reg)
+ *
+ * Reads the register 'reg' of the I/O APIC.
+ *
+ */
+static inline uint32_t ksched_ioapic_read(uint32_t reg)
+{
+	ksched_ioapic[IOAPIC_REGSEL] = reg;
+	
+	return ksched_ioapic[IOAPIC_WINDOW];
+}
+
+/*
+ * ksched_ioapic_write(reg, val)
+ *
+ * Writes 'val' to the register 'reg' of the I/O APIC.
+ *
+ */
+static inline void ksched_ioapic_write(uint32_t reg, uint32_t val)
+{
+	ksched_ioapic[IOAPIC_REGSEL] = reg;
+	ksched_ioapic[IOAPIC_WINDOW] = val;
+	
+	return;
+}
+
+/*
+ * ksched_apic_map(vadr, padr)
+ *
+ * Maps the register page at the physical address 'padr'
+ * uncached to the kernel page 'vadr'.
+ *
+ * Return value:
+ *	Kernel address of the registers
+ *
+ */
+static volatile uint32_t* ksched_apic_map(uintptr_t vadr, uintptr_t padr)
+{
+	uint32_t *l__ktab = ikp_start + 1024;
+	
+	l__ktab[(vadr / 4096) - 0xC0000] =   (padr & (~0xFFFU))
+					   | PFLAG_PRESENT
+					   | PFLAG_READWRITE
+					   | PFLAG_CACHE_DISABLED
+					   | PFLAG_GLOBAL;
+	INVLPG(vadr);
+	
+	return (void*)(uintptr_t)((vadr - VAS_KERNEL_START) + (padr & 0xFFF));
+}
+
+/*
+ * ksched_acpi_checksum(adr, len)
+ *
+ * Tests the checksum of an ACPI structure.
+ *
+ * Return value:
+ *	true	Valid checksum
+ *	false	Invalid checksum
+ *
+ */
+static bool ksched_acpi_checksum(const uint8_t *adr, uint32_t len)
+{
+	uint8_t l__sum = 0;
+	
+	while (len --) l__sum += *(adr ++);
+	
+	return (l__sum == 0);
+}
+
+/*
+ * ksched_acpi_find_rsdp(start, end)
+ *
+ * Searches the ACPI RSDP between the physical addresses
+ * 'start' and 'end'.
+ *
+ * Return value:
+ *	Address of the RSDP
+ *	NULL, if not found
+ *
+ */
+static const uint8_t* ksched_acpi_find_rsdp(uintptr_t start, uintptr_t end)
+{
+	const uint8_t *l__adr = (void*)start;
+	
+	while ((uintptr_t)l__adr < end)
+	{
+		if (    (l__adr[0] == 'R') && (l__adr[1] == 'S')
+		     && (l__adr[2] == 'D') && (l__adr[3] == ' ')
+		     && (l__adr[4] == 'P') && (l__adr[5] == 'T')
+		     && (l__adr[6] == 'R') && (l__adr[7] == ' ')
+		     && (ksched_acpi_checksum(l__adr, 20))
+		   )
+		{
+			return l__adr;
+		}
+		
+		l__adr += 16;
+	}
+	
+	return NULL;
+}
+
+/*
+ * ksched_acpi_find_madt()
+ *
+ * Searches the ACPI MADT ("APIC" table) by using the RSDT.
+ * Only tables within the normal zone can be read.
+ *
+ * Return value:
+ *	Address of the MADT
+ *	NULL, if not found
+ *
+ */
+static const uint8_t* ksched_acpi_find_madt(void)
+{
+	const uint8_t *l__rsdp;
+	const uint8_t *l__rsdt;
+	uint32_t l__len, l__i;
+	uintptr_t l__ebda;
+	
+	/* Read the segment of the EBDA from the BIOS data area */
+	__asm__ __volatile__("movzwl 0x40E, %0" : "=r" (l__ebda));
+	l__ebda <<= 4;
+	
+	/* Search the EBDA and the BIOS area */
+	l__rsdp = ksched_acpi_find_rsdp(l__ebda, l__ebda + 1024);
+	if (l__rsdp == NULL) 
+		l__rsdp = ksched_acpi_find_rsdp(0xE0000, 0x100000);
+	if (l__rsdp == NULL) return NULL;
+	
+	/* Read the RSDT */
+	l__rsdt = (void*)(uintptr_t)*((uint32_t*)&l__rsdp[16]);
+	if (((uintptr_t)l__rsdt + 36) >= NORMAL_ZONE_END) return NULL;
+	
+	l__len = *((uint32_t*)&l__rsdt[4]);
+	if (    (((uintptr_t)l__rsdt + l__len) >= NORMAL_ZONE_END)
+	     || (!ksched_acpi_checksum(l__rsdt, l__len))
+	   )
+	{
+		return NULL;
+	}
+	
+	/* Search the MADT */
+	for (l__i = 36; (l__i + 4) <= l__len; l__i += 4)
+	{
+		const uint8_t *l__tab = (void*)(uintptr_t)
+					*((uint32_t*)&l__rsdt[l__i]);
+		
+		if (((uintptr_t)l__tab + 36) >= NORMAL_ZONE_END) continue;
+		
+		if (    (l__tab[0] == 'A') && (l__tab[1] == 'P')
+		     && (l__tab[2] == 'I') && (l__tab[3] == 'C')
+		     && (((uintptr_t)l__tab + *((uint32_t*)&l__tab[4])) < NORMAL_ZONE_END)
+		   )
+		{
+			return l__tab;
+		}
+	}
+	
+	return NULL;
+}
+
+/*
+ * ksched_apic_set_mask(irq, masked)
+ *
+ * Masks or unmasks the I/O APIC pin of the IRQ 'irq'.
+ *
+ * Parameters:
+ *	irq	Number of the IRQ
+ *	masked	true  = mask the pin
+ *		false = unmask the pin
+ *
+ */
+void ksched_apic_set_mask(irq_t irq, bool masked)
+{
+	uint32_t l__reg = IOAPIC_REDIR_LOW(ksched_irqt_s[irq].gsi);
+	uint32_t l__val = IRQ(irq);
+	
+	if (ksched_irqt_s[irq].mode & IRQMODE_LEVEL) l__val |= IOAPIC_LEVEL;
+	if (ksched_irqt_s[irq].mode & IRQMODE_ACTIVE_LOW) l__val |= IOAPIC_ACTIVE_LOW;
+	if (masked) l__val |= IOAPIC_MASKED;
+	
+	ksched_ioapic_write(l__reg, l__val);
+	
+	return;
+}
+
+/*
+ * ksched_apic_irq_pending()
+ *
+ * Tests if an IRQ is waiting in the interrupt request
+ * register of the local APIC (see ksched_irq_pending).
+ *
+ * Return value:
+ *	!= 0	IRQ pending
+ *	0	No IRQ pending
+ *
+ */
+int ksched_apic_irq_pending(void)
+{
+	/* The vectors 0xA0 - 0xBF are part of the 6th IRR */
+	return (ksched_lapic[LAPIC_IRR(IRQ(0) / 32)] 
+		& ~(1u << (APIC_SPURIOUS_VECTOR % 32))) != 0;
+}
+
+/*
+ * ksched_init_apic()
+ *
+ * Initializes the local APIC and the I/O APIC, if they 
+ * are described by the ACPI MADT. The PIC will be 
+ * disabled afterwards. All I/O APIC pins are masked.
+ *
+ * Return value:
+ *	0	APIC is used
+ *	1	APIC not available, the PIC is still used
+ *
+ */
+int ksched_init_apic(void)
+{
+	const uint8_t *l__madt;
+	uint32_t l__cpuid_eax = 0, l__cpuid_edx = 0;
+	uint32_t l__msr_low = 0, l__msr_high = 0;
+	uintptr_t l__ioapic = 0;
+	uint32_t l__len, l__i;
+	irq_t l__irq;
+	unsigned l__pins;
+	
+	/* Is there a local APIC? (CPUID.1:EDX bit 9) */
+	__asm__ __volatile__("cpuid" 
+			     : "=a" (l__cpuid_eax), "=d" (l__cpuid_edx) 
+			     : "a" (1) 
+			     : "ebx", "ecx"
+			    );
+	if (!(l__cpuid_edx & (1u << 9))) return 1;
+	
+	/* Search the MADT */
+	l__madt = ksched_acpi_find_madt();
+	if (l__madt == NULL) return 1;
+	
+	l__len = *((uint32_t*)&l__madt[4]);
+	
+	/*
+	 * Find the I/O APIC and the ISA IRQ routing. The ISA
+	 * IRQs keep the trigger mode of the ELCR, if there is
+	 * no override. The other pins are used by PCI devices
+	 * (level triggered, active low).
+	 *
+	 */
+	for (l__irq = 16; l__irq < IRQ_MAX_LINES; l__irq ++)
+	{
+		ksched_irqt_s[l__irq].mode = IRQMODE_LEVEL | IRQMODE_ACTIVE_LOW;
+	}
+	
+	for (l__i = 44; (l__i + 2) <= l__len; l__i += l__madt[l__i + 1])
+	{
+		const uint8_t *l__ent = &l__madt[l__i];
+		
+		if (l__ent[1] < 2) break;
+		
+		/* I/O APIC (only the one handling GSI 0 is used) */
+		if (    (l__ent[0] == 1)
+		     && (*((uint32_t*)&l__ent[8]) == 0)
+		   )
+		{
+			l__ioapic = *((uint32_t*)&l__ent[4]);
+		}
+		
+		/* Interrupt source override of an ISA IRQ */
+		if (    (l__ent[0] == 2)
+		     && (l__ent[2] == 0)
+		     && (l__ent[3] < 16)
+		     && (*((uint32_t*)&l__ent[4]) < IRQ_MAX_LINES)
+		   )
+		{
+			uint16_t l__flags = *((uint16_t*)&l__ent[8]);
+			irq_t l__src = l__ent[3];
+			
+			ksched_irqt_s[l__src].gsi = *((uint32_t*)&l__ent[4]);
+			
+			/* Polarity (01 = high, 11 = low) */
+			if ((l__flags & 3) == 1) 
+				ksched_irqt_s[l__src].mode &= ~IRQMODE_ACTIVE_LOW;
+			if ((l__flags & 3) == 3) 
+				ksched_irqt_s[l__src].mode |= IRQMODE_ACTIVE_LOW;
+				
+			/* Trigger mode (01 = edge, 11 = level) */
+			if (((l__flags >> 2) & 3) == 1)
+				ksched_irqt_s[l__src].mode &= ~IRQMODE_LEVEL;
+			if (((l__flags >> 2) & 3) == 3)
+				ksched_irqt_s[l__src].mode |= IRQMODE_LEVEL;
+		}
+	}
+	
+	if (l__ioapic == 0) return 1;
+	
+	/*
+	 * Map and enable the local APIC 
+	 *
+	 */
+	__asm__ __volatile__("rdmsr" 
+			     : "=a" (l__msr_low), "=d" (l__msr_high) 
+			     : "c" (0x1B)
+			    );
+	l__msr_low |= (1u << 11);	/* Global enable */
+	__asm__ __volatile__("wrmsr" 
+			     :: "a" (l__msr_low), "d" (l__msr_high), "c" (0x1B)
+			    );
+	
+	ksched_lapic = ksched_apic_map(VAS_LAPIC_PAGE, l__msr_low & (~0xFFFU));
+	ksched_ioapic = ksched_apic_map(VAS_IOAPIC_PAGE, l__ioapic);
+	
+	ksched_lapic[LAPIC_TPR] = 0;
+	ksched_lapic[LAPIC_SVR] = 0x100 | APIC_SPURIOUS_VECTOR;
+	ksched_apic_dest = ksched_lapic[LAPIC_ID] >> 24;
+	
+	/*
+	 * Find out the number of usable IRQ lines. An ISA IRQ
+	 * that was moved to another pin makes the IRQ with the
+	 * number of this pin unusable (e.g. IRQ 2, if IRQ 0
+	 * is routed to pin 2).
+	 *
+	 */
+	l__pins = ((ksched_ioapic_read(IOAPIC_VERSION) >> 16) & 0xFF) + 1;
+	if (l__pins > IRQ_MAX_LINES) l__pins = IRQ_MAX_LINES;
+	if (l__pins < 16) return 1;
+	
+	for (l__irq = 0; l__irq < l__pins; l__irq ++)
+	{
+		irq_t l__src;
+		
+		if (ksched_irqt_s[l__irq].gsi != l__irq) continue;
+		
+		for (l__src = 0; l__src < 16; l__src ++)
+		{
+			if (    (l__src != l__irq)
+			     && (ksched_irqt_s[l__src].gsi == l__irq)
+			   )
+			{
+				ksched_irqt_s[l__irq].used = -1;
+			}
+		}
+	}
+	
+	/* Mask every pin */
+	for (l__i = 0; l__i < l__pins; l__i ++)
+	{
+		ksched_ioapic_write(IOAPIC_REDIR_HIGH(l__i), ksched_apic_dest << 24);
+		ksched_ioapic_write(IOAPIC_REDIR_LOW(l__i), IOAPIC_MASKED);
+	}
+	
+	/* Disable the PIC */
+	outb(0x21, 0xFF);
+	outb(0xA1, 0xFF);
+	
+	ksched_irq_lines = l__pins;
+	ksched_lapic_eoi = &ksched_lapic[LAPIC_EOI];
+	ksched_apic_active = true;
+	
+	return 0;
+}
@@ -15,8 +15,10 @@
 #include <hydrixos/types.h>
 #include <mem.h>
 #include <info.h>
+#include <setup.h>
 #include <sched.h>
 #include <current.h>
+#include <trace.h>
 #include <page.h>
 #include <stdio.h>
 
@@ -85,6 +87,76 @@ static inline void ksched_set_local_storage(void)
 	return;
 }
 
+/*
+ * ksched_account_switch(prev, next)
+ *
+ * Counts the switch from the thread 'prev' to the thread
+ * 'next'. If the CPU has a TSC, the run time of 'prev' and
+ * the time 'next' waited in the run queue are charged, too.
+ *
+ */
+static inline void ksched_account_switch(uint32_t *prev, uint32_t *next)
+{
+	uint64_t l__now = 0;
+	uint64_t l__last = 0;
+	
+	/* Blocked or yielding threads switch voluntarily */
+	if (prev != next)
+	{
+		if (    (ksched_yielded)
+		     || (    (prev[THRTAB_RUNQUEUE_PREV] == (uintptr_t)NULL)
+		          && (prev[THRTAB_RUNQUEUE_NEXT] == (uintptr_t)NULL)
+		          && (prev != ksched_idle_thread)
+		        )
+		   )
+		{
+			prev[THRTAB_VOLUNTARY_SWITCHES] ++;
+			KTRACE(TRACE_CAT_SCHED, TRACE_SWITCH, next[THRTAB_SID], 1, 0, 0);
+		}
+		 else
+		{
+			prev[THRTAB_INVOLUNTARY_SWITCHES] ++;
+			KTRACE(TRACE_CAT_SCHED, TRACE_SWITCH, next[THRTAB_SID], 0, 0, 0);
+		}
+	}
+	
+	ksched_yielded = 0;
+	
+	if (!i386_do_tsc) return;
+	
+	RDTSC(l__now);
+	
+	/* Run time of 'prev' */
+	l__last =   (((uint64_t)prev[THRTAB_X86_ACCOUNT_TSC_HIGH]) << 32)
+		  | prev[THRTAB_X86_ACCOUNT_TSC_LOW];
+	
+	if (l__last != 0)
+	{
+		kinfo_add64(prev, THRTAB_CPU_TIME_LOW, l__now - l__last);
+		kinfo_add64(&PROCESS(prev[THRTAB_PROCESS_SID], 0),
+			    PRCTAB_CPU_TIME_LOW,
+			    l__now - l__last
+			   );
+	}
+	
+	prev[THRTAB_X86_ACCOUNT_TSC_LOW] = (uint32_t)l__now;
+	prev[THRTAB_X86_ACCOUNT_TSC_HIGH] = (uint32_t)(l__now >> 32);
+	
+	if (prev == next) return;
+	
+	/* Wait time of 'next' */
+	l__last =   (((uint64_t)next[THRTAB_X86_ACCOUNT_TSC_HIGH]) << 32)
+		  | next[THRTAB_X86_ACCOUNT_TSC_LOW];
+	
+	if (l__last != 0)
+		kinfo_add64(next, THRTAB_WAIT_TIME_LOW, l__now - l__last);
+	
+	next[THRTAB_X86_ACCOUNT_TSC_LOW] = (uint32_t)l__now;
+	next[THRTAB_X86_ACCOUNT_TSC_HIGH] = (uint32_t)(l__now >> 32);
+	
+	return;
+}
+
 /* 
  * ksched_next_thread()
  *
@@ -99,38 +171,53 @@ void ksched_next_thread(void)
 	/* Is there a need of a thread switch? */
 	if (!ksched_change_thread) return;	/* If not, return */
 
-	/* Are we at the end of the run queue? */	
-	if (current_t[THRTAB_RUNQUEUE_NEXT] == NULL)
+	/* Real-time threads are always executed first */
+	l__next = (void*)(uintptr_t)ksched_idle_thread[THRTAB_RUNQUEUE_NEXT];
+	
+	if ((l__next == NULL) || (!KSCHED_IS_RT(l__next)))
 	{
-		if (ksched_active_threads == 1)
+		/* Are we at the end of the run queue? */	
+		if (current_t[THRTAB_RUNQUEUE_NEXT] == NULL)
 		{
-			/*
-		 	 * If no (=one) thread is active, the idle thread will
-		 	 * be executed.
-		 	 *
-			 */
-			l__next = (void*)(uintptr_t)
-					ksched_idle_thread;
-		}
+			if (ksched_active_threads == 1)
+			{
+				/*
+			 	 * If no (=one) thread is active, the idle thread will
+			 	 * be executed.
+			 	 *
+				 */
+				l__next = (void*)(uintptr_t)
+						ksched_idle_thread;
+			}
+			 else
+			{
+				/*
+				 * Else we go to the begin of the runqueue again...
+				 *
+				 */
+				l__next = (void*)(uintptr_t)
+						ksched_idle_thread[THRTAB_RUNQUEUE_NEXT];
+			}	
+		}	
 		 else
 		{
-			/*
-			 * Else we go to the begin of the runqueue again...
-			 *
+			/* 
+			 * Execute the next thread if we are somewhere within the
+			 * runqueue
 			 */
 			l__next = (void*)(uintptr_t)
-					ksched_idle_thread[THRTAB_RUNQUEUE_NEXT];
-		}	
-	}	
-	 else
+					current_t[THRTAB_RUNQUEUE_NEXT];
+		}
+	}
+	
+	/* Measure the IRQ latency, if it is an IRQ handler */
+	if (l__next[THRTAB_THRSTAT_FLAGS] & THRSTAT_IRQ_HANDLING)
 	{
-		/* 
-		 * Execute the next thread if we are somewhere within the
-		 * runqueue
-		 */
-		l__next = (void*)(uintptr_t)
-				current_t[THRTAB_RUNQUEUE_NEXT];
+		kio_irq_dispatched(l__next);
 	}
+	
+	/* CPU time and switch accounting */
+	ksched_account_switch(current_t, l__next);
 
 	i386_new_stack_pointer =
 		&l__next[THRTAB_X86_KERNEL_POINTER];
@@ -143,6 +230,9 @@ void ksched_next_thread(void)
 		ksched_switch_space(l__next[THRTAB_PROCESS_SID]);
 		current_p = &PROCESS(l__next[THRTAB_PROCESS_SID], 0);
 		main_info[MAININFO_CURRENT_PROCESS] = l__next[THRTAB_PROCESS_SID];
+		
+		/* Select the I/O permission bitmap of the process */
+		kio_load_iomap();
 	}
 
 	/* Save the FPU stack */
@@ -169,12 +259,9 @@ void ksched_next_thread(void)
 	/* Pointer to the effective priority buffer */
 	kinfo_eff_prior = &current_t[THRTAB_EFFECTIVE_PRIORITY];
 	
-	/* Pointer to the buffer with I/O permissions */
-	kinfo_io_map = &current_p[PRCTAB_IO_ACCESS_RIGHTS];
-
 	/* Refresh the thread's effective priority if needed */
 	if (*kinfo_eff_prior == 0)
-		*kinfo_eff_prior = (current_t[THRTAB_STATIC_PRIORITY] * 2);
+		*kinfo_eff_prior = (KSCHED_PRIORITY(current_t) * 2);
 //kprintf(" %i\n", *kinfo_eff_prior);
 	return;
 }
@@ -31,7 +31,6 @@ uint32_t *current_p = NULL;
 uint32_t *current_t = NULL;
 uint32_t *kinfo_eff_prior = NULL;
 uint64_t *kinfo_rtc_ctr = NULL;
-uint32_t *kinfo_io_map = NULL;
 
 sid_t	paged_pid = SID_PLACEHOLDER_NULL;
 
@@ -52,6 +51,7 @@ static struct {
 }i386_cpuid_s;
 long i387_fsave = 0;
 long i386_do_pge = 0;
+long i386_do_tsc = 0;
 
 /*
  * kinfo_init_x86_cpu()
@@ -136,6 +136,9 @@ int kinfo_init_x86_cpu(void)
 		#endif
 	}	
 	
+	/* Is the time stamp counter available? */
+	i386_do_tsc = ((i386_cpuid_s.features & 16) != 0);
+	
 	return 0;
 }
 
@@ -248,6 +251,29 @@ int kinfo_init(void)
 	main_info[MAININFO_CPU_ID_CODE] = HYMK_VERSION_CPUID;
 	main_info[MAININFO_PAGE_SIZE] = 4096;
 	main_info[MAININFO_MAX_PAGE_OPERATION] = MEM_MAX_PAGE_OP_NUM;
+	main_info[MAININFO_RECLAIMED_PAGES] = 0;
+	main_info[MAININFO_RECLAIM_PENDING] = 0;
+	main_info[MAININFO_IRQ_LINES] = 16;
+	main_info[MAININFO_DEADLINE_BANDWIDTH] = 0;
+	main_info[MAININFO_TRACE_RECORDS] = 0;
+	main_info[MAININFO_TRACE_HEAD] = 0;
+	main_info[MAININFO_TRACE_MASK] = 0;
+	main_info[MAININFO_PROFILE_SAMPLES] = 0;
+	main_info[MAININFO_PROFILE_DROPPED] = 0;
+	
+	/* The high resolution clock is set up by ksched_init_ints */
+	for (l__n = MAININFO_CLOCK_SEQUENCE; l__n <= MAININFO_CLOCK_TSC_KHZ; l__n ++)
+	{
+		main_info[l__n] = 0;
+	}
+	
+	for (l__n = MAININFO_IRQ_LATENCY(0, 0); 
+	     l__n < MAININFO_IRQ_LATENCY(IRQ_MAX_LINES, 0); 
+	     l__n ++
+	    )
+	{
+		main_info[l__n] = 0;
+	}
 		
 	main_info[MAININFO_X86_CPU_NAME_PART_1] = i386_cpuid_s.name[0];
 	main_info[MAININFO_X86_CPU_NAME_PART_2] = i386_cpuid_s.name[1];
@@ -258,6 +284,7 @@ int kinfo_init(void)
 	main_info[MAININFO_X86_CPU_MODEL] = i386_cpuid_s.model;
 	main_info[MAININFO_X86_CPU_STEPPING] = i386_cpuid_s.stepping_id;
 	main_info[MAININFO_X86_RAM_SIZE] = total_mem_size - (1024*1024);
+	main_info[MAININFO_X86_APIC_ACTIVE] = 0;
 	
 	#ifdef DEBUG_MODE
 		long l__cpustr[4];
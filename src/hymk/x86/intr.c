@@ -23,12 +23,16 @@
 #include <sysc.h>
 #include <error.h>
 #include <page.h>
+#include <trace.h>
 
-/* PIC IRQ mask */
+/* PIC IRQ mask (or mask of the I/O APIC pins) */
 static uint32_t	ksched_irqmask;		
 
-/* Calculate the IDT entry of an IRQ */
-#define	IRQ(irqnr)			(0xA0 + irqnr)
+/* Number of usable IRQ lines */
+unsigned ksched_irq_lines = 16;
+
+/* TSC value at the entry of the last IRQ */
+uint64_t ksched_irq_entry_tsc = 0;
 
 #define _MASTER_SLAVE 			2
 #define _SLAVE_IRQ 			8
@@ -43,7 +47,7 @@ int kremote_received(uint32_t intr);
  * Kernel interrupt table
  *
  */
-struct ksched_irqt_ps ksched_irqt_s[16];
+struct ksched_irqt_ps ksched_irqt_s[IRQ_MAX_LINES];
 
 /*
  * ksched_set_irq(irn, offs)
@@ -127,11 +131,23 @@ static void ksched_set_exc_usr(unsigned irn, uintptr_t offs)
 /*
  * ksched_disable_irq(irqnr)
  *
- * Disables the IRQ 'irqnr' on the PIC.
+ * Disables the IRQ 'irqnr' on the PIC (or on the I/O APIC).
  *
  */
 void ksched_disable_irq(irq_t irqnr)
 {
+	/* Mask the I/O APIC pin, if not already masked */
+	if (ksched_apic_active)
+	{
+		if (!(ksched_irqmask & (1u << irqnr)))
+		{
+			ksched_irqmask |= (1u << irqnr);
+			ksched_apic_set_mask(irqnr, true);
+		}
+		
+		return;
+	}
+	
 	ksched_irqmask |= (1 << irqnr);
 
 	if ((ksched_irqmask & 0xff00) == 0xff00) 
@@ -146,11 +162,23 @@ void ksched_disable_irq(irq_t irqnr)
 /*
  * ksched_enable_irq(irqnr)
  *
- * Enables the IRQ 'irqnr' on the PIC.
+ * Enables the IRQ 'irqnr' on the PIC (or on the I/O APIC).
  *
  */
 void ksched_enable_irq(irq_t irqnr)
 {
+	/* Unmask the I/O APIC pin, if not already unmasked */
+	if (ksched_apic_active)
+	{
+		if (ksched_irqmask & (1u << irqnr))
+		{
+			ksched_irqmask &= ~(1u << irqnr);
+			ksched_apic_set_mask(irqnr, false);
+		}
+		
+		return;
+	}
+	
 	ksched_irqmask &= ~(1 << irqnr);
 
 	if(irqnr >= _SLAVE_IRQ) 
@@ -162,6 +190,150 @@ void ksched_enable_irq(irq_t irqnr)
 	return;
 }
 
+/*
+ * ksched_irq_pending()
+ *
+ * Tests if an enabled IRQ is waiting in the interrupt request
+ * register of the PIC. Because the kernel is executed with
+ * disabled interrupts, long running kernel operations can use
+ * this function to detect that they are delaying an IRQ.
+ *
+ * Return value:
+ *	!= 0	IRQ pending
+ *	0	No IRQ pending
+ *
+ */
+int ksched_irq_pending(void)
+{
+	uint32_t l__irr;
+	
+	if (ksched_apic_active) return ksched_apic_irq_pending();
+	
+	/* Select the IRR for reading */
+	outb(0x20, 0x0A);
+	outb(0xA0, 0x0A);
+	
+	l__irr = inb(0x20) | (inb(0xA0) << 8);
+	
+	return (l__irr & (~ksched_irqmask) & (~(1u << _MASTER_SLAVE))) != 0;
+}
+
+/*
+ * ksched_irq_needs_mask(irqnr)
+ *
+ * Tests if the IRQ 'irqnr' has to be masked while its
+ * handler thread is running. The timer IRQ is never
+ * masked. Edge triggered I/O APIC pins also stay unmasked,
+ * because a masked I/O APIC pin drops incoming edges.
+ * Edges occuring during the handling of an IRQ are
+ * remembered by the IRQ handler table instead (see 
+ * ksched_start_irq_handler).
+ *
+ * Return value:
+ *	!= 0	Mask the IRQ during handling
+ *	0	Don't mask it
+ *
+ */
+int ksched_irq_needs_mask(irq_t irqnr)
+{
+	if (irqnr == 0) return 0;
+	
+	if (    (ksched_apic_active)
+	     && (!(ksched_irqt_s[irqnr].mode & IRQMODE_LEVEL))
+	   )
+	{
+		return 0;
+	}
+	
+	return 1;
+}
+
+/*
+ * ksched_set_irq_mode(irqnr, mode)
+ *
+ * Sets the trigger mode and the polarity of the IRQ 'irqnr'.
+ * If the PIC is used, only edge triggered (active high) and
+ * level triggered (active low) IRQs are possible. They are
+ * selected by using the ELCR of the chipset.
+ *
+ * Return value:
+ *	0	Mode changed
+ *	-1	Invalid IRQ or mode
+ *
+ */
+int ksched_set_irq_mode(irq_t irqnr, unsigned mode)
+{
+	uint32_t l__elcr;
+	
+	/* The timer IRQ and unusable lines won't be changed */
+	if (    (irqnr == 0)
+	     || (irqnr >= ksched_irq_lines)
+	     || (ksched_irqt_s[irqnr].used == -1)
+	     || (mode & (~(IRQMODE_LEVEL | IRQMODE_ACTIVE_LOW)))
+	   )
+	{
+		return -1;
+	}
+	
+	/* Reprogram the I/O APIC pin */
+	if (ksched_apic_active)
+	{
+		ksched_irqt_s[irqnr].mode = mode;
+		ksched_apic_set_mask(irqnr, (ksched_irqmask >> irqnr) & 1);
+		
+		return 0;
+	}
+	
+	/* Change the ELCR (not for the cascade IRQ) */
+	if (irqnr == _MASTER_SLAVE) return -1;
+	
+	l__elcr = inb(0x4D0) | (inb(0x4D1) << 8);
+	
+	if (mode == IRQMODE_EDGE)
+		l__elcr &= ~(1u << irqnr);
+	else if (mode == (IRQMODE_LEVEL | IRQMODE_ACTIVE_LOW))
+		l__elcr |= (1u << irqnr);
+	else
+		return -1;
+		
+	outb(0x4D0, l__elcr & 0xFF);
+	outb(0x4D1, (l__elcr >> 8) & 0xFF);
+	
+	ksched_irqt_s[irqnr].mode = mode;
+	
+	return 0;
+}
+
+/*
+ * ksched_restart_syscall()
+ *
+ * Lets the current thread execute its current system call
+ * again, after it returned to user mode. This is done by
+ * moving back the instruction pointer of the thread to 
+ * the "int $0xNN" instruction (2 bytes). 
+ *
+ * The system call entry code will write the error code 
+ * to EAX, so the error code will be set to the original
+ * value of EAX to keep the parameters of the system call.
+ * Thus the interrupted system call has to return without
+ * setting an error code afterwards.
+ *
+ */
+void ksched_restart_syscall(void)
+{
+	uint32_t *l__frame = (void*)(uintptr_t)
+				(
+				    current_t[THRTAB_KERNEL_STACK_ADDRESS]
+				  + KERNEL_STACK_SIZE
+				  - (17 * 4)
+				);
+				
+	l__frame[12] -= 2;		/* eip */
+	sysc_error = l__frame[7];	/* eax */
+	
+	return;
+}
+
 /*
  * ksched_init_timer
  *
@@ -178,14 +350,89 @@ static void ksched_init_timer(void)
         outb(0x43, 0x34); 
         outb(0x40, (uint8_t) (l__tmp & 0xFF));
         outb(0x40, (uint8_t) ((l__tmp & 0xFF00) >> 8));
+        
+	/* Real length of a timer tick */
+	main_info[MAININFO_CLOCK_TICK_NS] = 
+		kinfo_div64((uint64_t)l__tmp * 1000000000u, 1193182);
         		
 	return;
 }
 
+/*
+ * ksched_calibrate_tsc
+ *
+ * Measures the frequency of the time stamp counter with
+ * channel 2 of the PIT and publishes the high resolution
+ * clock in the main info page.
+ *
+ */
+static void ksched_calibrate_tsc(void)
+{
+	uint64_t l__start = 0;
+	uint64_t l__end = 0;
+	uint64_t l__scaled;
+	uint64_t l__base;
+	uint32_t l__ns;
+	uint32_t l__cycles;
+	uint8_t l__port61;
+	
+	if (!i386_do_tsc) return;
+	
+	/* Period of the measurement */
+	l__ns = kinfo_div64(  (uint64_t)KSCHED_TSC_CALIBRATION_COUNT 
+			    * 1000000000u, 
+			    1193182
+			   );
+	
+	/* Gate on, speaker off */
+	l__port61 = inb(0x61);
+	outb(0x61, (uint8_t)((l__port61 & (~0x02)) | 0x01));
+	
+	/* Channel 2, mode 0 (OUT2 goes high at the end of the count) */
+	outb(0x43, 0xB0);
+	outb(0x42, (uint8_t)(KSCHED_TSC_CALIBRATION_COUNT & 0xFF));
+	outb(0x42, (uint8_t)((KSCHED_TSC_CALIBRATION_COUNT & 0xFF00) >> 8));
+	
+	RDTSC(l__start);
+	while (!(inb(0x61) & 0x20));
+	RDTSC(l__end);
+	
+	outb(0x61, l__port61);
+	
+	/* The quotients of kinfo_div64 have to fit into 32 bits */
+	if ((l__end - l__start) >> 32) return;
+	
+	l__cycles = (uint32_t)(l__end - l__start);
+	l__scaled = ((uint64_t)l__ns) << MAININFO_CLOCK_SHIFT;
+	
+	if ((l__scaled >> 32) >= l__cycles) return;
+	
+	/* Publish the clock (continuing the tick based time) */
+	l__base = (*kinfo_rtc_ctr) * main_info[MAININFO_CLOCK_TICK_NS];
+	
+	kinfo_clock_write_begin();
+	
+	main_info[MAININFO_CLOCK_TSC_LOW] = (uint32_t)l__end;
+	main_info[MAININFO_CLOCK_TSC_HIGH] = (uint32_t)(l__end >> 32);
+	main_info[MAININFO_CLOCK_NS_LOW] = (uint32_t)l__base;
+	main_info[MAININFO_CLOCK_NS_HIGH] = (uint32_t)(l__base >> 32);
+	main_info[MAININFO_CLOCK_MULT] = kinfo_div64(l__scaled, l__cycles);
+	main_info[MAININFO_CLOCK_TSC_KHZ] = 
+		kinfo_div64((uint64_t)l__cycles * 1000000u, l__ns);
+	
+	kinfo_clock_write_end();
+	
+	#ifdef DEBUG_MODE
+		kprintf("TSC frequency: %i kHz\n", main_info[MAININFO_CLOCK_TSC_KHZ]);
+	#endif
+	
+	return;
+}
+
 /*
  * ksched_init_ints
  *
- * Initializes the PIC and the IDT.
+ * Initializes the PIC (or the APIC) and the IDT.
  *
  *
  */
@@ -193,6 +440,7 @@ int ksched_init_ints(void)
 {
 	irq_t	l__irqn = 16;
 	unsigned l__i = 256;
+	uint32_t l__elcr = 0;
 	
 	#ifdef DEBUG_MODE
 		kprintf("Initializing the IDT...");
@@ -237,6 +485,18 @@ int ksched_init_ints(void)
 
 	ksched_set_sysc(0xD5, (uintptr_t)&i386_sysc_set_paged);	 
 	ksched_set_sysc(0xD6, (uintptr_t)&i386_sysc_test_page);	 
+
+	ksched_set_sysc(0xD7, (uintptr_t)&i386_sysc_clone);
+	ksched_set_sysc(0xD8, (uintptr_t)&i386_sysc_merge);
+	ksched_set_sysc(0xD9, (uintptr_t)&i386_sysc_recv_pagefaults);
+	ksched_set_sysc(0xDA, (uintptr_t)&i386_sysc_resolve_pagefaults);
+	ksched_set_sysc(0xDB, (uintptr_t)&i386_sysc_io_allow_range);
+	ksched_set_sysc(0xDC, (uintptr_t)&i386_sysc_irq_mode);
+	ksched_set_sysc(0xDD, (uintptr_t)&i386_sysc_set_deadline);
+	ksched_set_sysc(0xDE, (uintptr_t)&i386_sysc_trace_ctl);
+	ksched_set_sysc(0xDF, (uintptr_t)&i386_sysc_profile_ctl);
+	ksched_set_sysc(0xE0, (uintptr_t)&i386_sysc_trace_read);
+	ksched_set_sysc(0xE1, (uintptr_t)&i386_sysc_profile_read);
 	
 	/* IRQs */
 	ksched_set_irq(IRQ(0x0), (uintptr_t)&i386_irqhandleasm_0);
@@ -255,6 +515,15 @@ int ksched_init_ints(void)
 	ksched_set_irq(IRQ(0xD), (uintptr_t)&i386_irqhandleasm_13);
 	ksched_set_irq(IRQ(0xE), (uintptr_t)&i386_irqhandleasm_14);
 	ksched_set_irq(IRQ(0xF), (uintptr_t)&i386_irqhandleasm_15);
+	ksched_set_irq(IRQ(0x10), (uintptr_t)&i386_irqhandleasm_16);
+	ksched_set_irq(IRQ(0x11), (uintptr_t)&i386_irqhandleasm_17);
+	ksched_set_irq(IRQ(0x12), (uintptr_t)&i386_irqhandleasm_18);
+	ksched_set_irq(IRQ(0x13), (uintptr_t)&i386_irqhandleasm_19);
+	ksched_set_irq(IRQ(0x14), (uintptr_t)&i386_irqhandleasm_20);
+	ksched_set_irq(IRQ(0x15), (uintptr_t)&i386_irqhandleasm_21);
+	ksched_set_irq(IRQ(0x16), (uintptr_t)&i386_irqhandleasm_22);
+	ksched_set_irq(IRQ(0x17), (uintptr_t)&i386_irqhandleasm_23);
+	ksched_set_irq(APIC_SPURIOUS_VECTOR, (uintptr_t)&i386_spurious_handler);
 	
 	/* Exceptions */
 	ksched_set_exc(0x0, (uintptr_t)&i386_exhandleasm_0);
@@ -319,28 +588,56 @@ int ksched_init_ints(void)
 	 * Disable every IRQ and init the kernel IRQ table
 	 *
 	 */
-	l__irqn = 16;
+	l__irqn = IRQ_MAX_LINES;
+	l__elcr = inb(0x4D0) | (inb(0x4D1) << 8);
 
 	while (l__irqn--)
 	{
-		ksched_disable_irq(l__irqn);
+		if (l__irqn < 16) ksched_disable_irq(l__irqn);
 		ksched_irqt_s[l__irqn].pid = 0;
 		ksched_irqt_s[l__irqn].tid = 0;
 		ksched_irqt_s[l__irqn].used = 0;
+		ksched_irqt_s[l__irqn].gsi = l__irqn;
+		ksched_irqt_s[l__irqn].mode =
+				(l__elcr & (1u << l__irqn))
+			      ? (IRQMODE_LEVEL | IRQMODE_ACTIVE_LOW)
+			      : IRQMODE_EDGE;
 	}
 
 	/* Ensure the IRQs are masked by the CPU */
 	__asm__ __volatile__("cli");
 	
+	#ifdef DEBUG_MODE
+		kprintf("( DONE )\n");
+		kprintf("Initializing the APIC...");
+	#endif
+	
+	/* Use the APIC instead of the PIC, if possible */
+	if (ksched_init_apic() == 0)
+	{
+		ksched_irqmask = 0xFFFFFFFF;
+		main_info[MAININFO_IRQ_LINES] = ksched_irq_lines;
+		main_info[MAININFO_X86_APIC_ACTIVE] = 1;
+		
+		#ifdef DEBUG_MODE
+			kprintf("( %i IRQ LINES )\n", ksched_irq_lines);
+		#endif
+	}
+	 else
+	{
+		#ifdef DEBUG_MODE
+			kprintf("( NOT AVAILABLE )\n");
+		#endif
+	}
+	
 	/* Initialize the PIT */
 	ksched_init_timer();
 	
+	/* Calibrate the TSC */
+	ksched_calibrate_tsc();
+	
 	/* Enable the RTC IRQ */
 	ksched_enable_irq(0);
-
-	#ifdef DEBUG_MODE
-		kprintf("( DONE )\n");
-	#endif	
 		
 	return 0;
 }
@@ -384,10 +681,22 @@ void i386_handle_emptyint(unsigned intno)
  */
 void ksched_handle_irq(irq_t irqn)
 {
+	/* Remember the entry time for the latency histogram */
+	if (i386_do_tsc) {RDTSC(ksched_irq_entry_tsc);}
+	
 	/* Internal handler for IRQ0 */
 	if (irqn == 0)
 	{
+		kinfo_clock_write_begin();
 		(*kinfo_rtc_ctr) ++;
+		kinfo_clock_write_end();
+		
+		/* Charge the timer tick to the current thread */
+		current_t[THRTAB_CPU_TICKS] ++;
+		current_p[PRCTAB_CPU_TICKS] ++;
+		
+		/* Sampling profiler */
+		if (kprof_process != SID_NULL) ktrace_sample();
 		
 		/* Overflow of the system clock? */
 		if (*kinfo_rtc_ctr == 0)
@@ -403,14 +712,23 @@ void ksched_handle_irq(irq_t irqn)
 			if (timeout_next <= *kinfo_rtc_ctr)
 			{
 				/* Start the pending thread */
+				KTRACE(TRACE_CAT_TIMEOUT, TRACE_TIMEOUT, timeout_queue[THRTAB_SID], 0, 0, 0);
 				ksched_start_thread(timeout_queue);
 				timeout_queue[THRTAB_THRSTAT_FLAGS] &= (~THRSTAT_TIMEOUT);
+				ksync_priority_changed(timeout_queue);
 				ksched_del_timeout(timeout_queue);
 			}
 		}
 		
-		/* Reducing thread priority */
-		if (*kinfo_eff_prior == 0)
+		/* Replenishing throttled deadline threads */
+		if (ksched_throttled != NULL) ksched_rt_replenish();
+		
+		/* Reducing thread priority (not for real-time threads) */
+		if (KSCHED_IS_RT(current_t))
+		{
+			ksched_rt_tick();
+		}
+		 else if (*kinfo_eff_prior == 0)
 		{
 			ksched_change_thread = true;
 		}		
@@ -681,6 +999,24 @@ void ksched_handle_except(void)
 	}
 	 else
 	{
+		if (i386_saved_error_num == EXC_X86_PAGE_FAULT)
+		{
+			current_t[THRTAB_PAGEFAULT_COUNT] ++;
+			
+			if (ktrace_mask & TRACE_CAT_FAULT)
+			{
+				uintptr_t l__adr = 0;
+				
+				__asm__ __volatile__ ("movl %%cr2, %%eax\n": "=a" (l__adr));
+				ktrace_write(TRACE_PAGEFAULT, 
+					     l__adr, 
+					     i386_saved_error_code, 
+					     i386_saved_error_eip, 
+					     0
+					    );
+			}
+		}
+		
 		/* 
 		 * Test if exception was produced by the COW-flag
 		 *
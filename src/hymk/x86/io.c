@@ -14,6 +14,7 @@
  */
 #include <hydrixos/types.h>
 #include <stdio.h>
+#include <string.h>
 #include <mem.h>
 #include <info.h>
 #include <error.h>
@@ -22,37 +23,32 @@
 #include <current.h>
 #include <page.h>
 #include <sysc.h>
+#include <trace.h>
 
 int kio_current_io = 0xFFFFFFFF;
 uint32_t *kio_last_thread = NULL;
 
+/* Unique ID of the process whose port map is loaded to the TSS */
+static uint32_t kio_iomap_owner = 0xFFFFFFFF;
+/* Number of bytes of the TSS process map that may differ from 0xFF */
+static unsigned long kio_iomap_size = 0;
+
 /*
  * IRQ Handlers structure
  *
+ * 'is_pending' is set, if an IRQ occurs during the handling
+ * of the same IRQ without masking it (see ksched_irq_needs_mask).
+ *
+ * 'start_tsc' is the TSC value at the arrival of the IRQ that
+ * is currently passed to the handler thread (0 if none).
+ *
  */
 struct {
-	sid_t	tid;
-	int	is_handling;
-}irq_handlers_s[16] 
-= 
-	{
-		{0, 0},
-		{0, 0},
-		{0, 0},
-		{0, 0},
-		{0, 0},
-		{0, 0},
-		{0, 0},
-		{0, 0},
-		{0, 0},
-		{0, 0},
-		{0, 0},
-		{0, 0},
-		{0, 0},
-		{0, 0},
-		{0, 0},
-		{0, 0}
-	};
+	sid_t		tid;
+	int		is_handling;
+	int		is_pending;
+	uint64_t	start_tsc;
+}irq_handlers_s[IRQ_MAX_LINES];
 
 /*
  * sysc_io_allow(dest, flags)
@@ -94,6 +90,9 @@ void sysc_io_allow(sid_t dest, unsigned flags)
 		/* Add the flags */
 		PROCESS(dest, PRCTAB_IO_ACCESS_RIGHTS) |= flags;
 		
+		if (&PROCESS(dest, 0) == current_p)
+			kio_load_iomap();
+		
 		return;
 	}
 	
@@ -102,6 +101,239 @@ void sysc_io_allow(sid_t dest, unsigned flags)
 	return;
 }
 
+/*
+ * kio_load_iomap()
+ *
+ * Selects the I/O permission bitmap of the current process
+ * in the TSS. Processes with IO_ALLOW_PORTS use the "allow
+ * all" map, processes without a port map use no map at all.
+ * Both cases just change the "io_base" field of the TSS.
+ *
+ * The port map of a process will be copied to the TSS only
+ * if it is not already loaded. Only the used part of the
+ * map will be copied (or reset to 0xFF, if the previously
+ * loaded map was bigger).
+ *
+ */
+void kio_load_iomap(void)
+{
+	unsigned long l__size = current_p[PRCTAB_IO_BITMAP_SIZE];
+	uint8_t *l__dest = (uint8_t*)i386_tss_struct + I386_IOMAP_PROCESS;
+	unsigned long l__i;
+	
+	/* Access on all ports */
+	if (current_p[PRCTAB_IO_ACCESS_RIGHTS] & IO_ALLOW_PORTS)
+	{
+		i386_tss_struct->io_base = I386_IOMAP_ALLOW_ALL;
+		return;
+	}
+	
+	/* No port map */
+	if (l__size == 0)
+	{
+		i386_tss_struct->io_base = I386_IOMAP_NONE;
+		return;
+	}
+	
+	/*
+	 * Copy the port map, if it isn't already loaded
+	 *
+	 */
+	if (kio_iomap_owner != current_p[PRCTAB_UNIQUE_ID])
+	{
+		for (l__i = 0; l__i < l__size; l__i += 4096)
+		{
+			uint8_t *l__src = (void*)(uintptr_t)
+			   current_p[   (l__i < 4096) 
+			   	      ? PRCTAB_IO_BITMAP_LOW 
+				      : PRCTAB_IO_BITMAP_HIGH
+				    ];
+			unsigned long l__len = l__size - l__i;
+		
+			if (l__len > 4096) l__len = 4096;
+			
+			if (l__src != NULL)
+			{
+				memcpy(&l__dest[l__i], l__src, l__len);
+			}
+			 else
+			{
+				unsigned long l__j;
+				
+				for (l__j = 0; l__j < l__len; l__j ++)
+					l__dest[l__i + l__j] = 0xFF;
+			}
+		}
+		
+		/* Deny the rest of the previously loaded map */
+		for (l__i = l__size; l__i < kio_iomap_size; l__i ++)
+			l__dest[l__i] = 0xFF;
+		
+		kio_iomap_size = l__size;
+		kio_iomap_owner = current_p[PRCTAB_UNIQUE_ID];
+	}
+	
+	i386_tss_struct->io_base = I386_IOMAP_PROCESS;
+	return;
+}
+
+/*
+ * kio_free_iomap(proc)
+ *
+ * Frees the port map of the process 'proc'.
+ *
+ * Parameters:
+ *	proc	Descriptor of the process
+ *
+ */
+void kio_free_iomap(uint32_t *proc)
+{
+	if (proc[PRCTAB_IO_BITMAP_LOW] != (uintptr_t)NULL)
+		kmem_free_kernel_pageframe((void*)(uintptr_t)
+					   proc[PRCTAB_IO_BITMAP_LOW]
+					  );
+	if (proc[PRCTAB_IO_BITMAP_HIGH] != (uintptr_t)NULL)
+		kmem_free_kernel_pageframe((void*)(uintptr_t)
+					   proc[PRCTAB_IO_BITMAP_HIGH]
+					  );
+		
+	proc[PRCTAB_IO_BITMAP_LOW] = (uintptr_t)NULL;
+	proc[PRCTAB_IO_BITMAP_HIGH] = (uintptr_t)NULL;
+	proc[PRCTAB_IO_BITMAP_SIZE] = 0;
+	
+	if (kio_iomap_owner == proc[PRCTAB_UNIQUE_ID])
+		kio_iomap_owner = 0xFFFFFFFF;
+	
+	return;
+}
+
+/*
+ * sysc_io_allow_range(dest, port, num, op)
+ *
+ * (Implementation of the "io_allow_range" system call)
+ *
+ * Allows or denies a process the access on a range of
+ * I/O ports. The port map of the process will be created
+ * on the first grant. It is only used, if the process 
+ * has no IO_ALLOW_PORTS right. This system call may be 
+ * only called by root processes.
+ *
+ * Parameters:
+ *	dest	SID of the affected process
+ *	port	Number of the first port
+ *	num	Number of ports
+ *	op	The wanted operation:
+ *			IORANGE_DENY	0	Deny the access
+ *			IORANGE_ALLOW	1	Allow the access
+ *
+ */
+void sysc_io_allow_range(sid_t dest, 
+			 unsigned port, 
+			 unsigned num, 
+			 unsigned op
+			)
+{
+	uint32_t *l__proc;
+	unsigned l__i;
+	
+	/* Is the current process a root process? */
+	if (!current_p[PRCTAB_IS_ROOT])
+	{
+		SET_ERROR(ERR_NOT_ROOT);
+		return;
+	}
+	
+	/* Does the destination SID define a valid process? */
+	if (!kinfo_isproc(dest))
+	{
+		SET_ERROR(ERR_INVALID_SID);
+		return;
+	}
+	
+	/* Valid range and operation? */
+	if (    (num == 0)
+	     || (port > 0xFFFF)
+	     || (num > (0x10000 - port))
+	     || ((op != IORANGE_ALLOW) && (op != IORANGE_DENY))
+	   )
+	{
+		SET_ERROR(ERR_INVALID_ARGUMENT);
+		return;
+	}
+	
+	l__proc = &PROCESS(dest, 0);
+	
+	/*
+	 * Allocate the needed parts of the port map
+	 *
+	 */
+	if (op == IORANGE_ALLOW)
+	{
+		unsigned long l__size = ((port + num - 1) / 8) + 1;
+		
+		for (l__i = PRCTAB_IO_BITMAP_LOW; 
+		     l__i <= PRCTAB_IO_BITMAP_HIGH; 
+		     l__i ++
+		    )
+		{
+			unsigned l__first = (l__i - PRCTAB_IO_BITMAP_LOW) * 32768;
+			uint8_t *l__page;
+			unsigned l__j;
+			
+			/* Is this part affected? */
+			if (    (l__proc[l__i] != (uintptr_t)NULL)
+			     || (port >= (l__first + 32768))
+			     || ((port + num) <= l__first)
+			   )
+			{
+				continue;
+			}
+			
+			l__page = kmem_alloc_kernel_pageframe();
+			if (l__page == NULL)
+			{
+				SET_ERROR(ERR_NOT_ENOUGH_MEMORY);
+				return;
+			}
+			
+			for (l__j = 0; l__j < 4096; l__j ++)
+				l__page[l__j] = 0xFF;
+				
+			l__proc[l__i] = (uintptr_t)l__page;
+		}
+		
+		if (l__size > l__proc[PRCTAB_IO_BITMAP_SIZE])
+			l__proc[PRCTAB_IO_BITMAP_SIZE] = l__size;
+	}
+	
+	/*
+	 * Change the port map
+	 *
+	 */
+	for (l__i = port; l__i < (port + num); l__i ++)
+	{
+		uint8_t *l__page = (void*)(uintptr_t)
+			l__proc[PRCTAB_IO_BITMAP_LOW + (l__i / 32768)];
+		
+		/* Nothing to deny, if there is no map */
+		if (l__page == NULL) continue;
+		
+		if (op == IORANGE_ALLOW)
+			l__page[(l__i % 32768) / 8] &= ~(1u << (l__i % 8));
+		else
+			l__page[(l__i % 32768) / 8] |= (1u << (l__i % 8));
+	}
+	
+	/* Reload the map, if it is loaded to the TSS */
+	if (kio_iomap_owner == l__proc[PRCTAB_UNIQUE_ID])
+		kio_iomap_owner = 0xFFFFFFFF;
+		
+	if (l__proc == current_p)
+		kio_load_iomap();
+	
+	return;
+}
+
 /*
  * sysc_io_alloc(src, dest, pages, flags)
  *
@@ -186,19 +418,23 @@ void sysc_io_alloc(uintptr_t src,
  */
 void kio_reenable_irq(irq_t irq)
 {
+	/* Exit IRQ handling by releasing the IRQ */	
+	current_t[THRTAB_IRQ_RECV_NUMBER] = 0xFFFFFFFF;
+	
+	if (irq >= ksched_irq_lines) return;
+	
 	/*
 	 * Disable all IRQs after handling
 	 *
 	 * (However we don't want to disable
-	 *  the RTC IRQ, because we need it)
+	 *  the RTC IRQ, because we need it. 
+	 *  Edge triggered I/O APIC pins also
+	 *  stay enabled.)
 	 *
 	 */
-	if (irq != 0) 
+	if (ksched_irq_needs_mask(irq)) 
 		ksched_disable_irq(irq);
 		
-	/* Exit IRQ handling by releasing the IRQ */	
-	current_t[THRTAB_IRQ_RECV_NUMBER] = 0xFFFFFFFF;
-		
 	irq_handlers_s[irq].tid = 0;
 	irq_handlers_s[irq].is_handling = 0;
 		
@@ -222,6 +458,8 @@ void kio_reenable_irq(irq_t irq)
  */
 void sysc_recv_irq(irq_t irq)
 {
+	irq_t l__irq;
+	
 	if (!(current_p[PRCTAB_IO_ACCESS_RIGHTS] & IO_ALLOW_IRQ))
 	{
 		SET_ERROR(ERR_ACCESS_DENIED);
@@ -236,7 +474,15 @@ void sysc_recv_irq(irq_t irq)
 			return;
 
 		/* Re-enable IRQ */
-		kio_reenable_irq(current_t[THRTAB_IRQ_RECV_NUMBER]);
+		l__irq = current_t[THRTAB_IRQ_RECV_NUMBER];
+		kio_reenable_irq(l__irq);
+		
+		/* Also disable edge triggered I/O APIC pins */
+		if ((l__irq != 0) && (l__irq < ksched_irq_lines))
+		{
+			ksched_disable_irq(l__irq);
+			irq_handlers_s[l__irq].is_pending = 0;
+		}
 		
 		/* Sleep a moment */
 		current_t[THRTAB_EFFECTIVE_PRIORITY] = 0;
@@ -247,7 +493,9 @@ void sysc_recv_irq(irq_t irq)
 	}
 
 	/* Don't handle invalid IRQs */
-	if (irq > 15)
+	if (    (irq >= ksched_irq_lines)
+	     || (ksched_irqt_s[irq].used == -1)
+	   )
 	{
 		SET_ERROR(ERR_INVALID_ARGUMENT);
 		return;
@@ -279,11 +527,27 @@ void sysc_recv_irq(irq_t irq)
 	current_t[THRTAB_IRQ_RECV_NUMBER] = irq;
 	current_t[THRTAB_EFFECTIVE_PRIORITY] = IRQ_THREAD_PRIORITY;
 	
-	ksched_stop_thread(current_t);
-	current_t[THRTAB_THRSTAT_FLAGS] |= THRSTAT_IRQ;
-	
 	/* Enable the IRQ */
 	ksched_enable_irq(irq);
+	
+	/* 
+	 * Handle an IRQ that occured during the last handling
+	 * directly, without leaving and reentering the run queue
+	 *
+	 */
+	if (irq_handlers_s[irq].is_pending)
+	{
+		irq_handlers_s[irq].is_pending = 0;
+		irq_handlers_s[irq].is_handling = 1;
+		
+		if (ksched_irq_needs_mask(irq)) ksched_disable_irq(irq);
+		
+		current_t[THRTAB_THRSTAT_FLAGS] |= THRSTAT_IRQ_HANDLING;
+		return;
+	}
+	
+	ksched_stop_thread(current_t);
+	current_t[THRTAB_THRSTAT_FLAGS] |= THRSTAT_IRQ;
 		
 	/* Switch the current thread */
 	ksched_change_thread = true;
@@ -292,6 +556,51 @@ void sysc_recv_irq(irq_t irq)
 	return;	
 }
 
+/*
+ * sysc_irq_mode(irq, mode)
+ *
+ * (Implementation of the "irq_mode" system call)
+ *
+ * Sets the trigger mode and the polarity of an IRQ line.
+ * If the PIC is used, only IRQMODE_EDGE and 
+ * IRQMODE_LEVEL | IRQMODE_ACTIVE_LOW are possible. The
+ * mode of the timer IRQ (IRQ 0) can't be changed.
+ *
+ * Parameters:
+ *	irq	Number of the IRQ
+ *	mode	The wanted mode:
+ *			IRQMODE_EDGE		Edge triggered, active high
+ *			IRQMODE_LEVEL		Level triggered
+ *			IRQMODE_ACTIVE_LOW	Active low
+ *
+ */
+void sysc_irq_mode(irq_t irq, unsigned mode)
+{
+	if (!(current_p[PRCTAB_IO_ACCESS_RIGHTS] & IO_ALLOW_IRQ))
+	{
+		SET_ERROR(ERR_ACCESS_DENIED);
+		return;
+	}
+	
+	/* Is the IRQ handled by another thread? */
+	if (    (irq < ksched_irq_lines)
+	     && (irq_handlers_s[irq].tid != 0) 
+	     && (irq_handlers_s[irq].tid != current_t[THRTAB_SID])
+	   )
+	{
+		SET_ERROR(ERR_RESOURCE_BUSY);
+		return;
+	}
+	
+	if (ksched_set_irq_mode(irq, mode) != 0)
+	{
+		SET_ERROR(ERR_INVALID_ARGUMENT);
+		return;
+	}
+	
+	return;
+}
+
 /*
  * ksched_start_irq_handler(irqn)
  *
@@ -304,23 +613,70 @@ void ksched_start_irq_handler(irq_t irqn)
 	/* Is the IRQ in use? */
 	if (irq_handlers_s[irqn].tid == 0) return;
 	
-	/* Is it allready handled? */
+	THREAD(irq_handlers_s[irqn].tid, THRTAB_IRQ_COUNT) ++;
+	KTRACE(TRACE_CAT_IRQ, TRACE_IRQ, irqn, irq_handlers_s[irqn].tid, 0, 0);
+	
+	/* Is it allready handled? Remember it (but not the RTC-IRQ). */
 	if (irq_handlers_s[irqn].is_handling == 1)
+	{
+		if (irqn != 0) irq_handlers_s[irqn].is_pending = 1;
 		return;
+	}
 	
 	/* Handle it */
 	irq_handlers_s[irqn].is_handling = 1;
 	
-	/* Disable the IRQ (staying enabled if RTC-IRQ) */
-	if (irqn != 0) ksched_disable_irq(irqn);
+	/* Disable the IRQ (staying enabled if RTC-IRQ or edge triggered) */
+	if (ksched_irq_needs_mask(irqn)) ksched_disable_irq(irqn);
 	
 	/* Handle the IRQ */
 	THREAD(irq_handlers_s[irqn].tid, THRTAB_THRSTAT_FLAGS) &= (~THRSTAT_IRQ);
 	THREAD(irq_handlers_s[irqn].tid, THRTAB_THRSTAT_FLAGS) |= THRSTAT_IRQ_HANDLING;
 	
-	ksched_start_thread(&THREAD(irq_handlers_s[irqn].tid, 0));
+	irq_handlers_s[irqn].start_tsc = ksched_irq_entry_tsc;
+	
+	/* Switch directly to the handler (see ksched_start_thread_direct) */
+	ksched_start_thread_direct(&THREAD(irq_handlers_s[irqn].tid, 0));
+	
+	return;
+}
+
+/*
+ * kio_irq_dispatched(thr)
+ *
+ * Is called by ksched_next_thread, if the IRQ handling thread
+ * 'thr' gets the CPU. Adds the time between the arrival of the
+ * IRQ and this thread switch to the latency histogram of the
+ * IRQ on the main info page.
+ *
+ * Parameters:
+ *	thr	The thread that gets the CPU
+ *
+ */
+void kio_irq_dispatched(uint32_t *thr)
+{
+	irq_t l__irq = thr[THRTAB_IRQ_RECV_NUMBER];
+	uint64_t l__now = 0;
+	uint64_t l__delta = 0;
+	unsigned l__bucket = 0;
+	
+	if (l__irq >= ksched_irq_lines) return;
+	if (irq_handlers_s[l__irq].start_tsc == 0) return;
+	
+	RDTSC(l__now);
+	l__delta = (l__now - irq_handlers_s[l__irq].start_tsc) >> 8;
+	irq_handlers_s[l__irq].start_tsc = 0;
+	
+	/* Bucket n: less than 2^(n + 8) cycles */
+	while (    (l__delta != 0)
+		&& (l__bucket < (MAININFO_IRQ_LATENCY_BUCKETS - 1))
+	      )
+	{
+		l__delta >>= 1;
+		l__bucket ++;
+	}
+	
+	main_info[MAININFO_IRQ_LATENCY(l__irq, l__bucket)] ++;
 	
-	/* Thread change */
-	ksched_change_thread = true;
 	return;
 }
@@ -23,8 +23,6 @@
 .extern i386_esp0_ret
 .extern ksched_debug_stack
 
-.extern kinfo_io_map
-
 .global i386_do_context_switch
 .global i386_yield_kernel_thread
 
@@ -32,6 +30,7 @@
 # Informations for IRQ handling
 #
 .extern ksched_handle_irq
+.extern ksched_lapic_eoi
 .extern kinfo_eff_prior
 .extern kinfo_rtc_ctr
 
@@ -153,33 +152,11 @@ i386_do_context_switch_ret:
 	movl	%eax, (%ebx)
 		
 	#
-	# Restore the I/O-Permission map
+	# (The I/O permissions are controlled by the
+	#  I/O permission bitmap of the TSS, see 
+	#  kio_load_iomap)
 	#
-	movl	kinfo_io_map, %eax		# Get the I/O permission map
-	movl	(%eax), %ebx
-	
-	# If port access is allowed
-	andl	$2, %ebx
-	jz	i386_do_context_switch_noio
-	
-	# Set IOPL = 3
-	movl	%esp, %ebx
-	movl	56(%ebx), %eax
-	orl	$0x3000, %eax
-	movl	%eax, 56(%ebx)
-
-	jmp	i386_do_context_switch_lastret
-
-	#
-	# Set IOPL = 0
-	#
-i386_do_context_switch_noio:
-	movl	%esp, %ebx
-	movl	56(%ebx), %eax
-	andl	$0xFFFFCFFF, %eax
-	movl	%eax, 56(%ebx)
-	
-i386_do_context_switch_lastret:		
+		
 	#
 	# Restore the registers of the interrupted thread
 	#
@@ -252,7 +229,8 @@ i386_yield_kernel_thread:
 # The macro parameter 'M_exnum' will define the prefix of the function
 # that is created by the macro. The number 'M_pnum' defines whether
 # a master (0x20) or a slave (0xa0) IRQ should be handled by the function
-# builded out of this macro.
+# builded out of this macro. If the APIC is used, the EOI will be sent
+# to the local APIC instead.
 #
 ###########################################################################
 .macro MIRQ M_irqnum, M_pnum
@@ -300,8 +278,16 @@ i386_irqhandleasm_\M_irqnum:
 	#
 	# Set IRQ = Handled
 	#
-	movb	$0x20, %al
+	movl	ksched_lapic_eoi, %eax
+	cmpl	$0, %eax
+	je	1f
+	
+	movl	$0, (%eax)			# Local APIC EOI
+	jmp	2f
+1:
+	movb	$0x20, %al			# PIC EOI
         outb	%al, $\M_pnum
+2:
 	
 	#
         # Return to the current thread
@@ -410,6 +396,18 @@ i386_exhandleasm_\M_exnum:
 	jmp i386_do_context_switch
 .endm
 
+###########################################################################
+#
+# i386_spurious_handler
+#
+# Handles a spurious interrupt of the local APIC (no EOI needed)
+#
+###########################################################################
+.global i386_spurious_handler
+
+i386_spurious_handler:
+	iretl
+
 ###########################################################################
 #
 # i386_emptyint_handler
@@ -494,6 +492,14 @@ MIRQ 12, 0xA0
 MIRQ 13, 0xA0
 MIRQ 14, 0xA0
 MIRQ 15, 0xA0
+MIRQ 16, 0xA0
+MIRQ 17, 0xA0
+MIRQ 18, 0xA0
+MIRQ 19, 0xA0
+MIRQ 20, 0xA0
+MIRQ 21, 0xA0
+MIRQ 22, 0xA0
+MIRQ 23, 0xA0
 
 #
 # Exception handler symbols "created" by calling the MEX macro
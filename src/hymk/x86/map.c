@@ -23,6 +23,109 @@
 #include <sysc.h>
 #include <page.h>
 
+/* Cleared during operations that can't be restarted */
+static bool kmem_op_restartable = true;
+
+/* Phase of a running move operation (1 = map, 2 = unmap, see sysc_move) */
+static unsigned kmem_op_move_phase = 0;
+/* Pages of the current phase to skip */
+static unsigned long kmem_op_move_done = 0;
+
+/*
+ * kmem_op_resume(op, sid, adr, pages, flags, offset)
+ *
+ * Returns the number of pages already processed by the memory
+ * operation 'op' of the current thread, if it was interrupted
+ * by a preemption point (see kmem_op_preempt) and restarted 
+ * with the same arguments (SID 'sid', start address 'adr', 
+ * number of pages 'pages', flags 'flags' and offset 'offset').
+ * The arguments will be saved as the key of the operation for 
+ * a later kmem_op_preempt. Any saved progress will be reset, 
+ * so the function has to be called before the arguments are 
+ * tested.
+ *
+ * The map and unmap phase of a move operation use the key
+ * and the progress of the move operation.
+ *
+ * Return value:
+ *	Number of pages to skip
+ *
+ */
+unsigned long kmem_op_resume(unsigned op, 
+			     sid_t sid, 
+			     uintptr_t adr, 
+			     unsigned long pages,
+			     unsigned flags,
+			     uintptr_t offset
+			    )
+{
+	unsigned long l__done = 0;
+	
+	/* Phase of a move operation */
+	if (kmem_op_move_phase != 0)
+	{
+		l__done = kmem_op_move_done;
+		kmem_op_move_done = 0;
+		
+		return l__done;
+	}
+	
+	if (    (current_t[THRTAB_MEMOP_RESTART_OP] == op)
+	     && (current_t[THRTAB_MEMOP_RESTART_SID] == sid)
+	     && (current_t[THRTAB_MEMOP_RESTART_ADR] == adr)
+	     && (current_t[THRTAB_MEMOP_RESTART_PAGES] == pages)
+	     && (current_t[THRTAB_MEMOP_RESTART_FLAGS] == flags)
+	     && (current_t[THRTAB_MEMOP_RESTART_OFFSET] == offset)
+	   )
+	{
+		l__done = current_t[THRTAB_MEMOP_RESTART_DONE];
+	}
+	
+	current_t[THRTAB_MEMOP_RESTART_OP] = 0;
+	current_t[THRTAB_MEMOP_RESTART_SID] = sid;
+	current_t[THRTAB_MEMOP_RESTART_ADR] = adr;
+	current_t[THRTAB_MEMOP_RESTART_PAGES] = pages;
+	current_t[THRTAB_MEMOP_RESTART_FLAGS] = flags;
+	current_t[THRTAB_MEMOP_RESTART_OFFSET] = offset;
+	
+	return l__done;
+}
+
+/*
+ * kmem_op_preempt(op, done)
+ *
+ * Preemption point of the memory operation 'op' of the current
+ * thread (the key was saved by kmem_op_resume). If an IRQ is
+ * pending, the progress 'done' will be saved to the thread 
+ * descriptor and the system call will be restarted after the
+ * IRQ was handled (see ksched_restart_syscall). The caller has
+ * to return immediately in this case.
+ *
+ * Return value:
+ *	1	Operation interrupted
+ *	0	Continue
+ *
+ */
+int kmem_op_preempt(unsigned op, unsigned long done)
+{
+	if ((!kmem_op_restartable) || (!ksched_irq_pending())) return 0;
+	
+	/* Save the progress of the whole move operation */
+	if (kmem_op_move_phase != 0)
+	{
+		op = KMEM_OP_MOVE;
+		if (kmem_op_move_phase == 2) 
+			done += current_t[THRTAB_MEMOP_RESTART_PAGES];
+	}
+	
+	current_t[THRTAB_MEMOP_RESTART_OP] = op;
+	current_t[THRTAB_MEMOP_RESTART_DONE] = done;
+	
+	ksched_restart_syscall();
+	
+	return 1;
+}
+
 /*
  * sysc_allow(dest_sid, src_sid, dest_adr, pages, flags)
  *
@@ -122,6 +225,11 @@ void sysc_allow(sid_t dest_sid,
  * into an enabled memory area of the virtual address space 
  * of another thread.
  *
+ * Every MEM_PREEMPT_PAGES pages the operation will be 
+ * interrupted, if an IRQ is pending, and continued after
+ * the IRQ was handled (see kmem_op_preempt). The same is
+ * done by unmap and alloc_pages.
+ *
  * Parameters:
  *	dest_sid	SID of the affected thread
  *	src_adr		The start address of the memory area
@@ -150,6 +258,17 @@ void sysc_map(sid_t dest_sid,
 	uint16_t l__flags = 0;		/* Calculated flags */
 	sid_t l__src_psid = current_t[THRTAB_PROCESS_SID];	/* Process of the source address space */
 	sid_t l__dest_psid;					/* Process of the dest. address space */
+	unsigned long l__op_pages = pages;
+	unsigned l__preempt = MEM_PREEMPT_PAGES;
+	
+	/* Continue an interrupted operation */
+	unsigned long l__done = kmem_op_resume(KMEM_OP_MAP, 
+					       dest_sid, 
+					       src_adr, 
+					       pages, 
+					       flags, 
+					       dest_offset
+					      );
 		
 	dest_offset &= (~0xfff);	/* Rounding offset address to pages */
 		
@@ -197,7 +316,7 @@ void sysc_map(sid_t dest_sid,
 	}
 	
 	l__dest = &THREAD(dest_sid, 0);
-	l__dest_psid = current_t[THRTAB_PROCESS_SID];
+	l__dest_psid = l__dest[THRTAB_PROCESS_SID];
 	
 	/* Are we allowed to map into this address space? */
 	if (    (l__dest[THRTAB_MEMORY_OP_SID] != current_t[THRTAB_SID])
@@ -278,6 +397,10 @@ void sysc_map(sid_t dest_sid,
 		
 	}	
 	
+	pages -= l__done;
+	src_adr += l__done * 4096;
+	l__dest_adr += l__done * 4096;
+	
 	/*
 	 * Page mapping operation
 	 *
@@ -291,6 +414,17 @@ void sysc_map(sid_t dest_sid,
 
 	while (pages --)
 	{
+		/* Preemption point */
+		if ((-- l__preempt) == 0)
+		{
+			l__preempt = MEM_PREEMPT_PAGES;
+			
+			if (kmem_op_preempt(KMEM_OP_MAP, l__op_pages - (pages + 1)))
+			{
+				return;
+			}
+		}
+		
 		/* 
 		 * Reload PDIR offsets, Page table ptrs etc. 
 		 *
@@ -303,6 +437,22 @@ void sysc_map(sid_t dest_sid,
 			l__ptab_s = (void*)(uintptr_t)
 				(l__pdir_s[l__pd_offs_s] & (~0xFFFu));
 			
+			/* COW changes the source table, so it has to be private */
+			if (    (flags & MAP_COPYONWRITE)
+			     && (l__pdir_s[l__pd_offs_s] & GENFLAG_SHARED_TABLE)
+			   )
+			{
+				l__ptab_s = kmem_unshare_table(l__pdir_s, 
+							       l__src_psid, 
+							       src_adr
+							      );
+				if (l__ptab_s == NULL)
+				{
+					SET_ERROR(ERR_NOT_ENOUGH_MEMORY);
+					return;
+				}
+			}
+			
 			/* Empty page table, override 1024 pages */
 			if (l__ptab_s == NULL)
 			{
@@ -327,10 +477,16 @@ void sysc_map(sid_t dest_sid,
 		{
 			l__pd_offs_d = (l__dest_adr / (4096 * 1024));
 			
-			l__ptab_d = kmem_get_table(l__pdir_d, 
-				    		   l__dest_adr,
-				       		   1
-				      	    	  );
+			l__ptab_d = kmem_get_private_table(l__pdir_d, 
+							   l__dest_psid,
+				    		   	   l__dest_adr,
+				       		   	   1
+				      	    	  	  );
+			if (l__ptab_d == NULL)
+			{
+				SET_ERROR(ERR_NOT_ENOUGH_MEMORY);
+				return;
+			}
 		}
 	
 
@@ -362,8 +518,9 @@ void sysc_map(sid_t dest_sid,
 					return;
 				}
 				
-				/* Refresh l__entry now */
+				/* Refresh l__entry now (the table may have been duplicated) */
 				MSYNC();
+				l__ptab_s = kmem_get_table(l__pdir_s, src_adr, false);
 				l__entry = l__ptab_s[l__ptb_offs_s];
 			}
 				
@@ -388,47 +545,12 @@ void sysc_map(sid_t dest_sid,
 			   )
 			{
 
-				/* Get a new PST entry */
-				sidlist_t *l__pst = page_share_table_free;
-				if (l__pst == NULL)
+				/* Add the new user as page frame owner */
+				if (kmem_share_user_pageframe(l__padr, l__dest_psid, l__dest_adr))
 				{
 					SET_ERROR(ERR_NOT_ENOUGH_MEMORY);
 					return;
 				}
-				page_share_table_free = page_share_table_free->nxt;
-				
-				/* Add the new user as page frame owner */
-				if (PAGE_BUF_TAB(l__padr).usage == 1)
-				{
-					/* Create a new list, so we need 
-					 * another free PST entry first
-					 */
-					sidlist_t *l__sndpst = page_share_table_free;
-					if (l__sndpst == NULL)
-					{
-						page_share_table_free = l__pst;
-						SET_ERROR(ERR_NOT_ENOUGH_MEMORY);
-						return;
-					}
-					page_share_table_free = page_share_table_free->nxt;
-					
-					/* Copy datas from the single-entry */
-					l__sndpst->user.pid = PAGE_BUF_TAB(l__padr).owner.single.pid;
-					l__sndpst->user.u_adr = PAGE_BUF_TAB(l__padr).owner.single.u_adr;
-					l__sndpst->nxt = l__pst;
-					
-					/* Setup the list */
-					PAGE_BUF_TAB(l__padr).owner.multi = l__sndpst;
-				}
-				
-				/* Just create the new element */
-				l__pst->user.pid = l__dest_psid;
-				l__pst->user.u_adr = l__dest_adr;
-				l__pst->nxt = PAGE_BUF_TAB(l__padr).owner.multi;
-				PAGE_BUF_TAB(l__padr).owner.multi = l__pst;		
-						
-				/* Change the usage counter */
-				PAGE_BUF_TAB(l__padr).usage ++;
 			}
 
 			/*
@@ -496,6 +618,17 @@ void sysc_unmap(sid_t dest_sid,
 	       )
 {
 	uint32_t *l__dest = NULL;	/* Dest Thread */
+	unsigned long l__op_pages = pages;
+	unsigned l__preempt = MEM_PREEMPT_PAGES;
+	
+	/* Continue an interrupted operation */
+	unsigned long l__done = kmem_op_resume(KMEM_OP_UNMAP, 
+					       dest_sid, 
+					       dest_adr, 
+					       pages, 
+					       flags, 
+					       0
+					      );
 		
 	/*
 	 * Testing
@@ -639,8 +772,28 @@ void sysc_unmap(sid_t dest_sid,
 
 	uint32_t *l__ptab_d = NULL;
 	
+	uint32_t *l__self = current_t;
+	
+	pages -= l__done;
+	dest_adr += l__done * 4096;
+	
 	while (pages --)
 	{
+		/* 
+		 * Preemption point (not possible, if the thread
+		 * has been stopped to wait for the PageD)
+		 *
+		 */
+		if (((-- l__preempt) == 0) && (current_t == l__self))
+		{
+			l__preempt = MEM_PREEMPT_PAGES;
+			
+			if (kmem_op_preempt(KMEM_OP_UNMAP, l__op_pages - (pages + 1)))
+			{
+				return;
+			}
+		}
+		
 		/* 
 		 * Reload PDIR offsets, Page table ptrs etc. 
 		 *
@@ -651,10 +804,19 @@ void sysc_unmap(sid_t dest_sid,
 		{
 			l__pd_offs_d = (dest_adr / (4096 * 1024));
 			
-			l__ptab_d = kmem_get_table(l__pdir_d, 
-				    		   dest_adr,
-				       		   0
-				      	    	  );
+			l__ptab_d = kmem_get_private_table(l__pdir_d, 
+							   l__dest[THRTAB_PROCESS_SID],
+				    		   	   dest_adr,
+				       		   	   0
+				      	    	  	  );
+			
+			if (    (l__ptab_d == NULL)
+			     && (l__pdir_d[l__pd_offs_d] & GENFLAG_PRESENT)
+			   )
+			{
+				SET_ERROR(ERR_NOT_ENOUGH_MEMORY);
+				return;
+			}
 			
 			if (l__ptab_d == NULL)
 			{
@@ -742,6 +904,9 @@ void sysc_unmap(sid_t dest_sid,
  * Maps an area into another enabled virtual address space and
  * removes it from the current virtual address space.
  *
+ * An interrupted move will be continued in the phase (map or 
+ * unmap) it was interrupted in (see kmem_op_preempt).
+ *
  * Parameters:
  *	dest_sid	SID of the affected thread
  *	src_adr		The start address of the memory area
@@ -760,6 +925,15 @@ void sysc_move(sid_t dest_sid,
 	       uintptr_t dest_offset
 	      )
 {
+	/* Continue an interrupted operation */
+	unsigned long l__done = kmem_op_resume(KMEM_OP_MOVE, 
+					       dest_sid, 
+					       src_adr, 
+					       pages, 
+					       flags, 
+					       dest_offset
+					      );
+	
 	/* Test the execution restriction */
 	if (pages > MEM_MAX_PAGE_OP_NUM)	
 	{
@@ -767,11 +941,300 @@ void sysc_move(sid_t dest_sid,
 		return;
 	}	
 	
-	sysc_map(dest_sid, src_adr, pages, flags, dest_offset);
+	/* Map phase (skipped, if interrupted in the unmap phase) */
+	if (l__done < pages)
+	{
+		kmem_op_move_phase = 1;
+		kmem_op_move_done = l__done;
+		
+		sysc_map(dest_sid, src_adr, pages, flags, dest_offset);
+		
+		kmem_op_move_phase = 0;
 
-	if (sysc_error) return;
+		/* Failed or interrupted by a preemption point? */
+		if ((sysc_error) || (current_t[THRTAB_MEMOP_RESTART_OP] != 0)) return;
+		
+		l__done = pages;
+	}
+	
+	/* Unmap phase */
+	kmem_op_move_phase = 2;
+	kmem_op_move_done = l__done - pages;
 		
 	sysc_unmap(current_t[THRTAB_SID], src_adr, pages, UNMAP_COMPLETE);
 	
+	kmem_op_move_phase = 0;
+	
 	return;
 }
+
+/*
+ * sysc_clone(dest_sid, src_adr, pages)
+ *
+ * (Implementation of the "clone" system call)
+ *
+ * Copies a memory area of the current virtual address space
+ * to the same addresses of the virtual address space of another
+ * process. The copy is done by copy-on-write: Page tables that 
+ * are completely covered by the area will be shared read-only
+ * between both address spaces and duplicated on the first
+ * write access. Thus the costs of the operation depend on the
+ * count of page tables instead of the count of pages. Parts of 
+ * the area that do not cover a complete page table will be 
+ * mapped using MAP_COPYONWRITE.
+ *
+ * The destination thread has to allow the map operation for
+ * the selected area. Because of its low costs the operation 
+ * is not restricted to MEM_MAX_PAGE_OP_NUM pages.
+ *
+ * Parameters:
+ *	dest_sid	SID of a thread of the destination process
+ *	src_adr		The start address of the memory area
+ *	pages		Number of pages that should be cloned
+ *
+ */
+void sysc_clone(sid_t dest_sid,
+		uintptr_t src_adr,
+		unsigned long pages
+	       )
+{
+	uint32_t *l__dest = NULL;	/* Dest Thread */
+	uint32_t *l__pdir_s = NULL;	/* Source PDIR */
+	uint32_t *l__pdir_d = NULL;	/* Dest PDIR */
+	uint32_t *l__pstat_s = NULL;	/* Source PSTAT */	
+	uint32_t *l__pstat_d = NULL;	/* Dest PSTAT */	
+	sid_t l__src_psid = current_t[THRTAB_PROCESS_SID];
+	sid_t l__dest_psid;
+	
+	/*
+	 * Testing & preparing
+	 *
+	 */
+	/* Round up the source address */
+	src_adr &= (~0xFFFu);
+	
+	/* Is the used source address valid? */
+	if (	((src_adr + (pages * 4096)) <= src_adr)
+	     || ((src_adr + (pages * 4096)) > VAS_THREAD_LOCAL_STORAGE)
+	     || ((pages * 4096) / 4096 != pages)
+	   )
+	{
+		SET_ERROR(ERR_INVALID_ADDRESS);
+		return;
+	}
+	
+	/* Is the destination SID valid? */
+	if (!kinfo_isthrd(dest_sid))
+	{
+		SET_ERROR(ERR_INVALID_SID);
+		return;
+	}
+	
+	l__dest = &THREAD(dest_sid, 0);
+	l__dest_psid = l__dest[THRTAB_PROCESS_SID];
+	
+	/* Cloning into the own address space makes no sense */
+	if (l__dest_psid == l__src_psid)
+	{
+		SET_ERROR(ERR_INVALID_ARGUMENT);
+		return;
+	}
+	
+	/* Are we allowed to map into this address space? */
+	if (    (l__dest[THRTAB_MEMORY_OP_SID] != current_t[THRTAB_SID])
+	     && (l__dest[THRTAB_MEMORY_OP_SID] != current_p[PRCTAB_SID])
+	     && (l__dest[THRTAB_MEMORY_OP_SID] != SID_USER_EVERYBODY)
+	     && (    (l__dest[THRTAB_MEMORY_OP_SID] != SID_USER_ROOT)
+	          || (current_p[PRCTAB_IS_ROOT] == 0)
+		)
+	    )
+	{
+		SET_ERROR(ERR_ACCESS_DENIED);
+		return;
+	}
+	
+	if (!(l__dest[THRTAB_MEMORY_OP_ALLOWED] & ALLOW_MAP))
+	{
+		SET_ERROR(ERR_ACCESS_DENIED);
+		return;
+	}
+	
+	/* Is the area part of the enabled destination area? */
+	if (    (src_adr < l__dest[THRTAB_MEMORY_OP_DESTADR])
+	     || (   (((src_adr - l__dest[THRTAB_MEMORY_OP_DESTADR]) / 4096) + pages)
+	          > l__dest[THRTAB_MEMORY_OP_MAXSIZE]
+	        )
+	   )
+	{
+		SET_ERROR(ERR_ACCESS_DENIED);
+		return;
+	}
+	
+	l__pdir_s = (void*)(uintptr_t)current_p[PRCTAB_PAGEDIR_PHYSICAL_ADDR];
+	l__pdir_d = (void*)(uintptr_t)PROCESS(l__dest_psid, PRCTAB_PAGEDIR_PHYSICAL_ADDR);
+	l__pstat_s = &current_p[PRCTAB_X86_MMTABLE];
+	l__pstat_d = &PROCESS(l__dest_psid, PRCTAB_X86_MMTABLE);
+	
+	/*
+	 * Cloning operation (a restart would unshare the tables
+	 * shared so far, so the mapping of single pages can't
+	 * be preempted)
+	 *
+	 */
+	kmem_op_restartable = false;
+	
+	while (pages > 0)
+	{
+		unsigned long l__n = src_adr / (4096 * 1024);
+		unsigned long l__num = 1024 - ((src_adr / 4096) & 0x3FF);
+		
+		if (l__num > pages) l__num = pages;
+		
+		if (l__pdir_s[l__n] & GENFLAG_PRESENT)
+		{
+			/* Share complete page tables */
+			if (    (l__num != 1024)
+			     || (kmem_share_table(l__pdir_s, 
+						  l__src_psid, 
+						  l__pdir_d,
+						  l__dest_psid,
+						  l__n
+						 ) != 0
+				)
+			   )
+			{
+				/* Otherwise just map the pages */
+				sysc_map(dest_sid, 
+					 src_adr,
+					 l__num,
+					   MAP_READ 
+					 | MAP_WRITE 
+					 | MAP_EXECUTABLE 
+					 | MAP_COPYONWRITE,
+					 src_adr - l__dest[THRTAB_MEMORY_OP_DESTADR]
+					);
+					
+				if (sysc_error) break;
+			}
+			 else
+			{
+				l__pstat_d[l__n] = l__pstat_s[l__n];
+			}
+		}
+		
+		src_adr += l__num * 4096;
+		pages -= l__num;
+	}
+	
+	kmem_op_restartable = true;
+	
+	/* The source tables are read-only now */
+	INV_TLB_COMPLETE();
+	
+	return;
+}
+
+/*
+ * sysc_merge(sid, adr, pages)
+ *
+ * (Implementation of the "merge" system call)
+ *
+ * Merges the pages of a memory area of the address space
+ * of the process 'sid' with identical pages of the same or
+ * other address spaces. Merged pages are shared by 
+ * copy-on-write (see kmem_merge_page). Each page is compared
+ * with the last tested page of the same content hash, so the
+ * memory areas of all processes should be passed periodically.
+ * This system call may be only called by root processes.
+ *
+ * Parameters:
+ *	sid	SID of the affected process (or of one of its threads)
+ *	adr	The start address of the memory area
+ *	pages	Number of pages that should be tested
+ *
+ * Return value:
+ *	Number of merged pages
+ *
+ */
+unsigned sysc_merge(sid_t sid, uintptr_t adr, unsigned long pages)
+{
+	uint32_t *l__pdir;
+	unsigned l__retval = 0;
+	unsigned long l__op_pages = pages;
+	unsigned l__preempt = MEM_PREEMPT_PAGES;
+	
+	/* Continue an interrupted operation */
+	unsigned long l__done = kmem_op_resume(KMEM_OP_MERGE, sid, adr, pages, 0, 0);
+	
+	/* Is the current process a root process? */
+	if (!current_p[PRCTAB_IS_ROOT])
+	{
+		SET_ERROR(ERR_NOT_ROOT);
+		return 0;
+	}
+	
+	/* Test the execution restriction */
+	if (pages > MEM_MAX_PAGE_OP_NUM)	
+	{
+		SET_ERROR(ERR_SYSCALL_RESTRICTED);
+		return 0;
+	}	
+	
+	/* Is the area valid? */
+	adr &= (~0xFFFu);
+	
+	if (	((adr + (pages * 4096)) < adr)
+	     || ((adr + (pages * 4096)) > VAS_THREAD_LOCAL_STORAGE)
+	   )
+	{
+		SET_ERROR(ERR_INVALID_ADDRESS);
+		return 0;
+	}
+	
+	/* Is it a thread subject? */
+	if (sid & SIDTYPE_THREAD)
+	{
+		if (!kinfo_isthrd(sid))
+		{
+			SET_ERROR(ERR_INVALID_SID);
+			return 0;
+		}
+		
+		sid = THREAD(sid, THRTAB_PROCESS_SID);
+	}
+	
+	/* Is it a valid address space? */
+	if (!kinfo_isproc(sid))
+	{
+		SET_ERROR(ERR_INVALID_SID);
+		return 0;
+	}
+	
+	l__pdir = (void*)(uintptr_t)PROCESS(sid, PRCTAB_PAGEDIR_PHYSICAL_ADDR);
+	
+	if (l__done > 0) l__retval = current_t[THRTAB_MEMOP_RESTART_RESULT];
+	
+	pages -= l__done;
+	adr += l__done * 4096;
+	
+	/* Merge the pages */
+	while (pages --)
+	{
+		/* Preemption point (keeps the number of merged pages) */
+		if ((-- l__preempt) == 0)
+		{
+			l__preempt = MEM_PREEMPT_PAGES;
+			current_t[THRTAB_MEMOP_RESTART_RESULT] = l__retval;
+			
+			if (kmem_op_preempt(KMEM_OP_MERGE, l__op_pages - (pages + 1)))
+			{
+				return 0;
+			}
+		}
+		
+		l__retval += kmem_merge_page(l__pdir, sid, adr);
+		adr += 4096;
+	}
+	
+	return l__retval;
+}
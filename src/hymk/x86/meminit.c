@@ -36,11 +36,11 @@ uintptr_t page_buf_table_start = 0;	/* Start address of the PBT */
 size_t page_buf_table_sz = 0;		/* Size of the PBT */
 pbtab_t* page_buf_table = NULL;		/* Pointer to the PBT */
 
-/* Page share table */
-uintptr_t page_share_table_start = 0;		/* Start address of the PST */
-long page_share_table_count = 0;		/* Count of entries in the PST */
-size_t page_share_table_sz = 0;			/* Size of the PST */
-sidlist_t *page_share_table_free = NULL;	/* Pointer to the PST (free entries list) */
+/* Reverse map */
+uintptr_t rmap_hash_start = 0;		/* Start address of the RMAP hash table */
+unsigned long rmap_hash_count = 0;	/* Count of buckets (power of two) */
+size_t rmap_hash_sz = 0;		/* Size of the RMAP hash table */
+rmap_entry_t **rmap_hash = NULL;	/* Pointer to the RMAP hash table */
 
 /* Page buffer */
 uintptr_t page_buffer_start = 0;	/* Start address of the page buffer */
@@ -64,10 +64,10 @@ static void kmem_dump_tables(void)
 		page_buf_table_start, 
 		page_buf_table_sz / 1024
 	       );
-	kprintf("PST Start: 0x%X - PST Size %i KiB (%i Entries)\n", 
-		page_share_table_start, 
-		page_share_table_sz / 1024,
-		page_share_table_count
+	kprintf("RMAP Start: 0x%X - RMAP Size %i KiB (%i Buckets)\n", 
+		rmap_hash_start, 
+		rmap_hash_sz / 1024,
+		rmap_hash_count
 	       );
 	kprintf("NZS Start: 0x%X - NZS Size %i KiB\n", 
 		normal_zone.frame_stack_start, 
@@ -107,17 +107,23 @@ int kmem_init_tables(void)
 	page_buf_table_sz =   ((total_mem_size - (1024 * 1024)) / 4096) 
 			       * sizeof(pbtab_t);
 			       
-	page_share_table_start = (page_buf_table_start + page_buf_table_sz);
-	page_share_table_free = (void*)page_share_table_start;
-	page_share_table_count = (((total_mem_size - (1024 * 1024)) / 4096) * PST_PERCENT) / 100;
-	page_share_table_sz = page_share_table_count * sizeof(sidlist_t);
+	rmap_hash_start = (page_buf_table_start + page_buf_table_sz);
+	rmap_hash = (void*)rmap_hash_start;
+	rmap_hash_count = 1;
+	while (   (rmap_hash_count * 2)
+	       <= ((((total_mem_size - (1024 * 1024)) / 4096) * RMAP_HASH_PERCENT) / 100)
+	      )
+	{
+		rmap_hash_count *= 2;
+	}
+	rmap_hash_sz = rmap_hash_count * sizeof(rmap_entry_t*);
 			      
 			      	
 		
 	/* Normal zone stack */
 	
-	normal_zone.frame_stack_start =  page_share_table_start 
-				       + page_share_table_sz;
+	normal_zone.frame_stack_start =  rmap_hash_start 
+				       + rmap_hash_sz;
 	normal_zone.frame_stack_count =   normal_mem_free / 4096;
 	normal_zone.frame_stack_sz = normal_zone.frame_stack_count * sizeof(uint32_t);
 	normal_zone.frame_stack_ptr = (void*)(  normal_zone.frame_stack_start 
@@ -137,7 +143,7 @@ int kmem_init_tables(void)
 	normal_mem_free -=   normal_zone.frame_stack_sz 
 		          + high_zone.frame_stack_sz
 		          + page_buf_table_sz
-			  + page_share_table_sz
+			  + rmap_hash_sz
 		          ;
 	normal_mem_free &= (~0xFFFU);
 	normal_mem_free -= 4096;
@@ -156,7 +162,7 @@ int kmem_init_tables(void)
 	page_buffer_sz = normal_mem_free + high_mem_free;
 
 	/*
-	 * Initialize the PBT and PST
+	 * Initialize the PBT and the RMAP hash table
 	 *
 	 */
 	
@@ -169,17 +175,12 @@ int kmem_init_tables(void)
 		page_buf_table[l__n].owner.single.u_adr = 0;
 	}
 	
-	/* Initialize the PST */
-	for (l__n = 0;
-	     l__n < (page_share_table_count - 1);
-	     l__n ++
-	    )
+	/* Initialize the RMAP hash table */
+	l__n = rmap_hash_count;
+	while(l__n --)
 	{
-		page_share_table_free[l__n].user.pid = 0;
-		page_share_table_free[l__n].user.u_adr = 0;
-		page_share_table_free[l__n].nxt = &page_share_table_free[l__n + 1];
+		rmap_hash[l__n] = NULL;
 	}
-	page_share_table_free[l__n -1].nxt = NULL;
 	
 	/*
 	 * Initialize the Normal / High Zone page frame stacks
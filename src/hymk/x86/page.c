@@ -18,6 +18,7 @@
 #include <stdio.h>
 #include <page.h>
 #include <current.h>
+#include <info.h>
 
 uint32_t *i386_current_pdir = 0;
 
@@ -192,6 +193,27 @@ long kmem_map_page_frame_cur(uintptr_t p_adr,
 			     unsigned flags
 			    )
 {
+	unsigned long l__n = v_adr / (4096 * 1024);
+	unsigned long l__last = (v_adr + (pages * 4096) - 1) / (4096 * 1024);
+	
+	/* Shared page tables have to be duplicated first */
+	while ((pages > 0) && (l__n <= l__last) && (l__n < (VAS_KERNEL_START / (4096 * 1024))))
+	{
+		if (i386_current_pdir[l__n] & GENFLAG_SHARED_TABLE)
+		{
+			if (kmem_unshare_table(i386_current_pdir,
+					       current_p[PRCTAB_SID],
+					       l__n * 4096 * 1024
+					      ) == NULL
+			   )
+			{
+				return -1;
+			}
+		}
+		
+		l__n ++;
+	}
+	
 	/* Map the pages */
 	long l__retval =
 		kmem_map_page_frame(i386_current_pdir, 
@@ -492,14 +514,382 @@ void kmem_destroy_space(uint32_t* pagedir)
 	return;
 }
 
+/*
+ * kmem_share_table(pdir_s, sid_s, pdir_d, sid_d, n)
+ *
+ * Shares the page table 'n' of the address space 'pdir_s' of
+ * the process 'sid_s' with the address space 'pdir_d' of the
+ * process 'sid_d'. Both page directory entries will be marked
+ * read-only and GENFLAG_SHARED_TABLE, so the first write access 
+ * of one of the processes will duplicate the table 
+ * (see kmem_unshare_table).
+ *
+ * The usage counter of the page table frame is used to count
+ * the address spaces that are sharing the table. The page frames
+ * referenced by a shared table remain registered for its oldest 
+ * user only, so their usage counters won't be changed. 
+ *
+ * The TLB of the source address space has to be invalidated
+ * by the caller.
+ *
+ * Return value:
+ *	0	Successful
+ *	1	Destination table already existing or
+ *		source table not existing
+ *	2	Not enough memory for the reverse map
+ *
+ */
+int kmem_share_table(uint32_t *pdir_s, 
+		     sid_t sid_s, 
+		     uint32_t *pdir_d, 
+		     sid_t sid_d, 
+		     unsigned long n
+		    )
+{
+	uintptr_t l__tab = pdir_s[n] & (~0xFFFu);
+	uintptr_t l__base = n * 4096 * 1024;
+	
+	if (    (!(pdir_s[n] & GENFLAG_PRESENT))
+	     || (pdir_d[n] & GENFLAG_PRESENT)
+	   )
+	{
+		return 1;
+	}
+	
+	/* Is the table shared for the first time? */
+	if (!(pdir_s[n] & GENFLAG_SHARED_TABLE))
+	{
+		PAGE_BUF_TAB(l__tab).owner.single.pid = sid_s;
+		PAGE_BUF_TAB(l__tab).owner.single.u_adr = l__base;
+		
+		pdir_s[n] &= (~PFLAG_READWRITE);
+		pdir_s[n] |= GENFLAG_SHARED_TABLE;
+	}
+	
+	/* Add the new user of the table */
+	if (kmem_share_user_pageframe(l__tab, sid_d, l__base))
+	{
+		return 2;
+	}
+	
+	pdir_d[n] = pdir_s[n];
+	
+	return 0;
+}
+
+/*
+ * kmem_unshare_table(pdir, sid, adr)
+ *
+ * Gives the process 'sid' a private copy of the shared page
+ * table which describes the address 'adr' within its address 
+ * space 'pdir'. All writable pages of the table will be
+ * selected for copy-on-write in the old and the new table. The
+ * page frames of the table are registered for the new user as
+ * well, so the page-level copy-on-write can be done by
+ * kmem_do_copy_on_write.
+ *
+ * If 'sid' is the last user of the table, the table will
+ * just be made writable again.
+ *
+ * Return value:
+ *	!= NULL		Pointer to the private page table
+ *	NULL		Table not existing or not enough memory
+ *
+ */
+uint32_t* kmem_unshare_table(uint32_t *pdir, sid_t sid, uintptr_t adr)
+{
+	unsigned long l__n = adr / (4096 * 1024);
+	uintptr_t l__base = l__n * 4096 * 1024;
+	uintptr_t l__tab = pdir[l__n] & (~0xFFFu);
+	uint32_t *l__old = (void*)l__tab;
+	uint32_t *l__new = NULL;
+	unsigned long l__frames = 0;
+	sid_t l__receiver = sid;
+	unsigned l__i;
+	
+	if (!(pdir[l__n] & GENFLAG_PRESENT)) return NULL;
+	if (!(pdir[l__n] & GENFLAG_SHARED_TABLE)) return l__old;
+	
+	/* The last user of the table just takes it back */
+	if (PAGE_BUF_TAB(l__tab).usage == 1)
+	{
+		PAGE_BUF_TAB(l__tab).owner.single.pid = SID_PLACEHOLDER_KERNEL;
+		PAGE_BUF_TAB(l__tab).owner.single.u_adr = l__tab + VAS_KERNEL_START;
+		
+		pdir[l__n] &= (~GENFLAG_SHARED_TABLE);
+		pdir[l__n] |= PFLAG_READWRITE;
+		
+		if (pdir == i386_current_pdir) INV_TLB_COMPLETE();
+		
+		return l__old;
+	}
+	
+	/* 
+	 * Reserve the RMAP objects. (Each page frame may need 
+	 * up to two new objects)
+	 */
+	for (l__i = 0; l__i < 1024; l__i ++)
+	{
+		uintptr_t l__padr = l__old[l__i] & (~0xFFFu);
+		
+		if (    (l__old[l__i] & GENFLAG_PRESENT)
+		     && (KMEM_IS_USER_FRAME(l__padr))
+		   )
+		{
+			l__frames ++;
+		}
+	}
+	
+	if (kmem_rmap_reserve(l__frames * 2)) return NULL;
+	
+	l__new = kmem_alloc_kernel_pageframe();
+	if (l__new == NULL) return NULL;
+	
+	/* 
+	 * Leave the table. If we have been its oldest user, the
+	 * next oldest user will inherit the page frame entries.
+	 */
+	if (kmem_rmap_first(l__tab) == sid)
+	{
+		kmem_free_user_pageframe(l__tab, sid, l__base);
+		l__receiver = kmem_rmap_first(l__tab);
+	}
+	 else
+	{
+		kmem_free_user_pageframe(l__tab, sid, l__base);
+	}
+	
+	/* Copy the table and select its pages for COW */
+	for (l__i = 0; l__i < 1024; l__i ++)
+	{
+		uint32_t l__entry = l__old[l__i];
+		uintptr_t l__padr = l__entry & (~0xFFFu);
+		
+		if (    (l__entry & GENFLAG_PRESENT)
+		     && (KMEM_IS_USER_FRAME(l__padr))
+		   )
+		{
+			if (l__entry & GENFLAG_WRITABLE)
+			{
+				l__entry &= (~GENFLAG_WRITABLE);
+				l__entry |= GENFLAG_DO_COPYONWRITE;
+				l__old[l__i] = l__entry;
+			}
+			
+			kmem_share_user_pageframe(l__padr, 
+						  l__receiver, 
+						  l__base + (l__i * 4096)
+						 );
+		}
+		
+		l__new[l__i] = l__entry;
+	}
+	
+	pdir[l__n] =   ((uintptr_t)l__new)
+		     | PFLAG_PRESENT
+		     | PFLAG_READWRITE
+		     | PFLAG_USER
+		    ;
+		
+	if (pdir == i386_current_pdir) INV_TLB_COMPLETE();
+	
+	return l__new;
+}
+
+/*
+ * kmem_get_private_table(pdir, sid, adr, doalloc)
+ *
+ * Works like kmem_get_table, but a page table that is 
+ * shared by copy-on-write will be duplicated first. Use
+ * this function, if you want to change the page table 
+ * of the process 'sid'.
+ *
+ * Return value:
+ *  != NULL	The address of the table
+ *  NULL	Table not existing or not enough memory
+ *
+ */
+uint32_t* kmem_get_private_table(uint32_t *pdir, 
+				 sid_t sid, 
+				 uintptr_t adr, 
+				 bool doalloc
+				)
+{
+	if (pdir[adr / (4096 * 1024)] & GENFLAG_SHARED_TABLE)
+	{
+		return kmem_unshare_table(pdir, sid, adr);
+	}
+	
+	return kmem_get_table(pdir, adr, doalloc);
+}
+
+/*
+ * kmem_release_table(pdir, sid, n)
+ *
+ * Removes the page table 'n' from the address space 'pdir'
+ * of the process 'sid'. A private page table will be freed.
+ * If the table is shared with other processes, the process
+ * will only leave it and pass the ownership of the referenced
+ * page frames to the next oldest user of the table.
+ *
+ */
+void kmem_release_table(uint32_t *pdir, sid_t sid, unsigned long n)
+{
+	uintptr_t l__tab = pdir[n] & (~0xFFFu);
+	uintptr_t l__base = n * 4096 * 1024;
+	uint32_t *l__ptab = (void*)l__tab;
+	
+	if (!(pdir[n] & GENFLAG_PRESENT)) return;
+	
+	/* Private table */
+	if (    (!(pdir[n] & GENFLAG_SHARED_TABLE))
+	     || (PAGE_BUF_TAB(l__tab).usage == 1)
+	   )
+	{
+		kmem_free_kernel_pageframe(l__ptab);
+		pdir[n] = 0;
+		return;
+	}
+	
+	/* Shared table */
+	if (kmem_rmap_first(l__tab) == sid)
+	{
+		unsigned l__i;
+		sid_t l__holder;
+		
+		kmem_free_user_pageframe(l__tab, sid, l__base);
+		l__holder = kmem_rmap_first(l__tab);
+		
+		for (l__i = 0; l__i < 1024; l__i ++)
+		{
+			uintptr_t l__padr = l__ptab[l__i] & (~0xFFFu);
+			
+			if (    (l__ptab[l__i] & GENFLAG_PRESENT)
+			     && (KMEM_IS_USER_FRAME(l__padr))
+			   )
+			{
+				kmem_rmap_rename(l__padr, 
+						 sid, 
+						 l__holder, 
+						 l__base + (l__i * 4096)
+						);
+			}
+		}
+	}
+	 else
+	{
+		kmem_free_user_pageframe(l__tab, sid, l__base);
+	}
+	
+	pdir[n] = 0;
+	
+	return;
+}
+
+/*
+ * kmem_reclaim_table(pdir, sid, n)
+ *
+ * Frees all user page frames referenced by the page table
+ * 'n' of the address space 'pdir' of the defunct process
+ * 'sid' and releases the table afterwards. The page frames
+ * of a shared table are passed to its next user instead
+ * (see kmem_release_table).
+ *
+ * Return value:
+ *	Number of freed page frames (frames that are still
+ *	used by other processes are not counted)
+ *
+ */
+unsigned long kmem_reclaim_table(uint32_t *pdir, sid_t sid, unsigned long n)
+{
+	uint32_t *l__ptab = (void*)(uintptr_t)(pdir[n] & (~0xFFFu));
+	uintptr_t l__base = n * 4096 * 1024;
+	unsigned long l__freed = 0;
+	unsigned l__i;
+	
+	if (!(pdir[n] & GENFLAG_PRESENT)) return 0;
+	
+	/* Private table */
+	if (    (!(pdir[n] & GENFLAG_SHARED_TABLE))
+	     || (PAGE_BUF_TAB((uintptr_t)l__ptab).usage == 1)
+	   )
+	{
+		for (l__i = 0; l__i < 1024; l__i ++)
+		{
+			uintptr_t l__padr = l__ptab[l__i] & (~0xFFFu);
+			
+			if (    (l__ptab[l__i] & GENFLAG_PRESENT)
+			     && (KMEM_IS_USER_FRAME(l__padr))
+			   )
+			{
+				kmem_free_user_pageframe(l__padr, 
+							 sid, 
+							 l__base + (l__i * 4096)
+							);
+				
+				if (PAGE_BUF_TAB(l__padr).usage == 0) l__freed ++;
+			}
+		}
+	}
+	
+	kmem_release_table(pdir, sid, n);
+	
+	return l__freed;
+}
+
+/*
+ * kmem_copy_page(dst, src)
+ *
+ * Copies the content of the page 'src' (void*) to 
+ * the page 'dst' (void*).
+ *
+ * Use this macro carefully: It would change the
+ * string direction flag and write to the ES segment.
+ *
+ */
+#define kmem_copy_page(___dst, ___src) \
+{\
+	uint32_t d1, d2, d3;\
+	\
+	__asm__ __volatile__ (\
+			      "cld\n"\
+			      "rep movsl\n"\
+			      : "=&c" (d1), "=&D" (d2), "=&S" (d3)\
+			      : "0" (1024), "1" ((___dst)), "2" ((___src))\
+			      : "memory"\
+			     );\
+}
+
+/*
+ * kmem_set_copy_window(slot, entry)
+ *
+ * Sets the UMCA page 'slot' of the copy window to the
+ * page table entry 'entry'. The copy window is never
+ * unmapped, so the TLB entry has only to be invalidated
+ * if the mapping changes.
+ *
+ */
+static inline void kmem_set_copy_window(uintptr_t slot, uint32_t entry)
+{
+	uint32_t *l__ktab = ikp_start + 1024;
+	
+	if (l__ktab[(slot >> 12) - 0xC0000] != entry)
+	{
+		l__ktab[(slot >> 12) - 0xC0000] = entry;
+		INVLPG(slot);
+	}
+	
+	return;
+}
+
 /* 
  * kmem_do_copy_on_write(pdir, sid, usradr)
  *
  * Execute the copy-on-write operation to the user address "usradr".
  * The operation will be done for the address space "pdir" and
  * the process "sid".
- * This function will temporaly map two user mode page frames
- * into the kernel address space to make them accessable.
+ * This function will map two user mode page frames into the
+ * copy window of the kernel address space to make them accessable.
  *
  * Return value:
  *	>0	Not successful
@@ -513,7 +903,6 @@ int kmem_do_copy_on_write(uint32_t* pdir, sid_t sid, uintptr_t usradr)
 	uintptr_t l__newphy = 0;
 	uint32_t *l__entry = NULL;
 	uint32_t *l__newframe = NULL;
-	uint32_t *l__ktab = ikp_start + 1024;
 	uint32_t *l__newptr = (void*)(uintptr_t)(0xFFFE1000 - 0xC0000000);
 	uint32_t *l__oldptr = (void*)(uintptr_t)(0xFFFE0000 - 0xC0000000);
 
@@ -528,6 +917,20 @@ int kmem_do_copy_on_write(uint32_t* pdir, sid_t sid, uintptr_t usradr)
 	l__entry = &l__ptab[(usradr >> 12) & (0x3ffu)];
 	l__phyadr = *l__entry & (~0xfffu);
 	
+	/* Page table shared by the clone operation? Duplicate it first */
+	if (    (pdir[usradr / (4096 * 1024)] & GENFLAG_SHARED_TABLE)
+	     && (*l__entry & GENFLAG_PRESENT)
+	   )
+	{
+		l__ptab = kmem_unshare_table(pdir, sid, usradr);
+		if (l__ptab == NULL) return 3;
+		
+		l__entry = &l__ptab[(usradr >> 12) & (0x3ffu)];
+		
+		/* The page itself was writable */
+		if (!(*l__entry & GENFLAG_DO_COPYONWRITE)) return 0;
+	}
+	
 	/* Not selected for copy on write, other exception */
 	if (!(*l__entry & GENFLAG_DO_COPYONWRITE)) return 2;
 	
@@ -546,37 +949,17 @@ int kmem_do_copy_on_write(uint32_t* pdir, sid_t sid, uintptr_t usradr)
 	if (l__newframe == NULL) return 3;
 	l__newphy = (uintptr_t)l__newframe;
 	
-	/* Decrement usage counter */
-	PAGE_BUF_TAB(l__phyadr).usage --;
+	/* Map the old and the new page frame into the copy window */
+	kmem_set_copy_window(0xFFFE0000, l__phyadr | GENFLAG_PRESENT | GENFLAG_READABLE);
+	kmem_set_copy_window(0xFFFE1000, l__newphy | GENFLAG_PRESENT | GENFLAG_WRITABLE);
 	
-	/* Map the old page frame into the UMCA */
-	l__ktab[0xFFFE0 - 0xC0000] =  l__phyadr | GENFLAG_PRESENT | GENFLAG_READABLE;
-	
-	/* Map the new page frame into the UMCA */
-	l__ktab[0xFFFE1 - 0xC0000] = l__newphy | GENFLAG_PRESENT | GENFLAG_WRITABLE;
-	
-	/* Invalidate TLB */
-	INVLPG(0xFFFE0000);
-	INVLPG(0xFFFE1000);
-
 	/* Copy datas */
-	int l__n = 1024;
-	while(l__n --)
-	{
-		l__newptr[l__n] = l__oldptr[l__n];
-	}
-	
-	l__ktab[0xFFFE0 - 0xC0000] = 0;
-	l__ktab[0xFFFE1 - 0xC0000] = 0;
-	
-	/* Invalidate TLB again */
-	INVLPG(0xFFFE0000);
-	INVLPG(0xFFFE1000);	
+	kmem_copy_page(l__newptr, l__oldptr);
 	
 	/* 
 	 * Remove the process from the old page frame's 
-	 * owners list (PST) and actualize its page table
-	 * entry.
+	 * reverse map and actualize its page table
+	 * entry. This will also decrement the usage counter.
 	 */
 	 kmem_free_user_pageframe(l__phyadr, sid, usradr);
 	 
@@ -593,10 +976,62 @@ int kmem_do_copy_on_write(uint32_t* pdir, sid_t sid, uintptr_t usradr)
 	return 0;
 }
 
+/*
+ * kmem_cow_fault_around(pdir, sid, usradr)
+ *
+ * Resolves the copy-on-write of up to MEM_COW_FAULT_AROUND pages 
+ * following the address 'usradr' after a copy-on-write exception.
+ * This will only be done if the page in front of 'usradr' is 
+ * already private and writable, so the process seems to write
+ * its memory sequentially. The operation ends at the first page
+ * that is not selected for copy-on-write and at the end of the
+ * page table.
+ *
+ */
+static void kmem_cow_fault_around(uint32_t *pdir, sid_t sid, uintptr_t usradr)
+{
+	uint32_t *l__ptab;
+	unsigned l__i = (usradr >> 12) & 0x3FFu;
+	unsigned l__n = MEM_COW_FAULT_AROUND;
+	
+	if (l__i == 0) return;
+	
+	l__ptab = kmem_get_table(pdir, usradr, false);
+	if (l__ptab == NULL) return;
+	
+	/* Sequential access? */
+	if (    (!(l__ptab[l__i - 1] & GENFLAG_PRESENT))
+	     || (!(l__ptab[l__i - 1] & GENFLAG_WRITABLE))
+	   )
+	{
+		return;
+	}
+	
+	usradr &= (~0xFFFu);
+	
+	while ((l__n --) && (++ l__i < 1024))
+	{
+		usradr += 4096;
+		
+		if (    (!(l__ptab[l__i] & GENFLAG_PRESENT))
+		     || (!(l__ptab[l__i] & GENFLAG_DO_COPYONWRITE))
+		   )
+		{
+			return;
+		}
+		
+		if (kmem_do_copy_on_write(pdir, sid, usradr)) return;
+	}
+	
+	return;
+}
+
 /*
  * kmem_copy_on_write()
  *
  * Tries to handle the copy-on-write exception, if possible.
+ * If the process seems to write its memory sequentially, the
+ * following pages will be copied too (see kmem_cow_fault_around).
  *
  * Return value:
  *	>0	Not successful
@@ -605,6 +1040,7 @@ int kmem_do_copy_on_write(uint32_t* pdir, sid_t sid, uintptr_t usradr)
 int kmem_copy_on_write(void)
 {
 	uintptr_t l__usradr = 0;
+	int l__retval;
 
 	/* Get the user mode address of the access violation */
 	__asm__ __volatile__ (
@@ -613,5 +1049,216 @@ int kmem_copy_on_write(void)
 			     );
 
 	/* Try to copy it */
-	return kmem_do_copy_on_write(i386_current_pdir, current_p[PRCTAB_SID], l__usradr);
+	l__retval = kmem_do_copy_on_write(i386_current_pdir, current_p[PRCTAB_SID], l__usradr);
+	if (l__retval) return l__retval;
+	
+	kmem_cow_fault_around(i386_current_pdir, current_p[PRCTAB_SID], l__usradr);
+	
+	return 0;
+}
+
+/*
+ * Candidates of the page merging
+ *
+ * Every page tested by kmem_merge_page is stored within
+ * this table, indexed by the hash of its content. The 
+ * entries are never removed, so they have to be verified
+ * before they are used.
+ *
+ */
+typedef struct {
+	uint32_t	hash;		/* Hash of the page content */
+	sid_t		pid;		/* Process using the page */
+	uintptr_t	u_adr;		/* Address of the page */
+	uintptr_t	page;		/* Page frame */
+}merge_cand_t;
+
+static merge_cand_t merge_candidates[MEM_MERGE_CANDIDATES];
+
+/*
+ * kmem_get_merge_entry(pdir, adr)
+ *
+ * Returns the page table entry of the page 'adr' within the
+ * address space 'pdir', if the page may be merged. This is
+ * a present user page frame of the PBT that is not part of a
+ * shared page table and not protected by the PageD.
+ *
+ * Return value:
+ *	!= NULL		Pointer to the page table entry
+ *	NULL		The page may not be merged
+ *
+ */
+static uint32_t* kmem_get_merge_entry(uint32_t *pdir, uintptr_t adr)
+{
+	uint32_t *l__ptab;
+	uint32_t *l__entry;
+	
+	if (pdir[adr / (4096 * 1024)] & GENFLAG_SHARED_TABLE) return NULL;
+	
+	l__ptab = kmem_get_table(pdir, adr, false);
+	if (l__ptab == NULL) return NULL;
+	
+	l__entry = &l__ptab[(adr >> 12) & 0x3FFu];
+	
+	if (    (!(*l__entry & GENFLAG_PRESENT))
+	     || (!(*l__entry & GENFLAG_USER_MODE))
+	     || (*l__entry & GENFLAG_PAGED_PROTECTED)
+	     || (!KMEM_IS_USER_FRAME(*l__entry & (~0xFFFu)))
+	   )
+	{
+		return NULL;
+	}
+	
+	return l__entry;
+}
+
+/*
+ * kmem_merge_get_candidate(hash, padr)
+ *
+ * Returns the page table entry of the merge candidate for
+ * the hash value 'hash', if its page frame is still mapped,
+ * still used by a single process only (a frame shared writable
+ * in the meantime must not be selected for copy-on-write by
+ * only one of its users) and has the same content as the
+ * page frame 'padr'. The 
+ * page frame 'padr' has to be mapped to the first page of
+ * the copy window.
+ *
+ * Return value:
+ *	!= NULL		Pointer to the page table entry
+ *	NULL		No identical candidate
+ *
+ */
+static uint32_t* kmem_merge_get_candidate(uint32_t hash, uintptr_t padr)
+{
+	uint32_t *l__ptr = (void*)(uintptr_t)(0xFFFE0000 - 0xC0000000);
+	uint32_t *l__cptr = (void*)(uintptr_t)(0xFFFE1000 - 0xC0000000);
+	merge_cand_t *l__cand = &merge_candidates[hash & (MEM_MERGE_CANDIDATES - 1)];
+	uint32_t *l__centry;
+	unsigned l__n;
+	
+	if (    (l__cand->hash != hash)
+	     || (l__cand->page == padr)
+	     || (!kinfo_isproc(l__cand->pid))
+	   )
+	{
+		return NULL;
+	}
+	
+	/* Is the candidate still mapped? */
+	l__centry = kmem_get_merge_entry((void*)(uintptr_t)PROCESS(l__cand->pid, 
+								   PRCTAB_PAGEDIR_PHYSICAL_ADDR
+								  ),
+					 l__cand->u_adr
+					);
+					 
+	if (    (l__centry == NULL)
+	     || ((*l__centry & (~0xFFFu)) != l__cand->page)
+	     || (PAGE_BUF_TAB(l__cand->page).usage != 1)
+	   )
+	{
+		return NULL;
+	}
+	
+	/* Compare both pages */
+	kmem_set_copy_window(0xFFFE1000, l__cand->page | GENFLAG_PRESENT | GENFLAG_READABLE);
+	
+	for (l__n = 0; l__n < 1024; l__n ++)
+	{
+		if (l__ptr[l__n] != l__cptr[l__n]) return NULL;
+	}
+	
+	return l__centry;
+}
+
+/*
+ * kmem_merge_page(pdir, sid, usradr)
+ *
+ * Tries to merge the page at the address 'usradr' of the
+ * process 'sid' (address space 'pdir') with another page
+ * of the same content. Only pages that are used by a single
+ * process will be merged. The page will be compared with the
+ * last tested page of the same hash (see merge_candidates). 
+ * If both pages are identical, the page frame of the other
+ * page will be shared by copy-on-write and the page frame of
+ * 'usradr' will be freed. Otherwise the page will become the 
+ * new candidate for its hash value.
+ *
+ * This function uses the copy window of the copy-on-write
+ * operation.
+ *
+ * Return value:
+ *	1	The page has been merged
+ *	0	The page has not been merged
+ *
+ */
+int kmem_merge_page(uint32_t *pdir, sid_t sid, uintptr_t usradr)
+{
+	uint32_t *l__ptr = (void*)(uintptr_t)(0xFFFE0000 - 0xC0000000);
+	uint32_t *l__entry;
+	uint32_t *l__centry;
+	uintptr_t l__padr;
+	merge_cand_t *l__cand;
+	uint32_t l__hash = 5381;
+	uint32_t l__flags;
+	unsigned l__n;
+	
+	usradr &= (~0xFFFu);
+	
+	l__entry = kmem_get_merge_entry(pdir, usradr);
+	if (l__entry == NULL) return 0;
+	
+	l__padr = *l__entry & (~0xFFFu);
+	if (PAGE_BUF_TAB(l__padr).usage != 1) return 0;
+	
+	/* Hash the page content */
+	kmem_set_copy_window(0xFFFE0000, l__padr | GENFLAG_PRESENT | GENFLAG_READABLE);
+	
+	for (l__n = 0; l__n < 1024; l__n ++)
+		l__hash = ((l__hash << 5) + l__hash) ^ l__ptr[l__n];
+		
+	l__cand = &merge_candidates[l__hash & (MEM_MERGE_CANDIDATES - 1)];
+	l__centry = kmem_merge_get_candidate(l__hash, l__padr);
+	
+	/* No identical page, use it as new candidate */
+	if (    (l__centry == NULL)
+	     || (kmem_share_user_pageframe(l__cand->page, sid, usradr))
+	   )
+	{
+		l__cand->hash = l__hash;
+		l__cand->pid = sid;
+		l__cand->u_adr = usradr;
+		l__cand->page = l__padr;
+		
+		return 0;
+	}
+	
+	/* Select the candidate for copy-on-write */
+	if (*l__centry & GENFLAG_WRITABLE)
+	{
+		*l__centry &= (~GENFLAG_WRITABLE);
+		*l__centry |= GENFLAG_DO_COPYONWRITE;
+		
+		if (    PROCESS(l__cand->pid, PRCTAB_PAGEDIR_PHYSICAL_ADDR)
+		     == (uintptr_t)i386_current_pdir
+		   )
+		{
+			INVLPG(l__cand->u_adr);
+		}
+	}
+	
+	/* Replace our page frame */
+	l__flags = *l__entry & 0xFFFu;
+	if (l__flags & GENFLAG_WRITABLE)
+	{
+		l__flags &= (~GENFLAG_WRITABLE);
+		l__flags |= GENFLAG_DO_COPYONWRITE;
+	}
+	
+	*l__entry = l__cand->page | l__flags;
+	kmem_free_user_pageframe(l__padr, sid, usradr);
+	
+	if (pdir == i386_current_pdir) INVLPG(usradr);
+	
+	return 1;
 }
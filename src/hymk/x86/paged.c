@@ -26,13 +26,26 @@
 #include <sysc.h>
 
 sid_t paged_thr_sid = 0;
+sid_t paged_proc_sid = 0;
+
+/* Queue of the threads waiting for the PageD */
+static uint32_t *paged_queue_begin = NULL;
+static uint32_t *paged_queue_end = NULL;
+unsigned paged_queue_num = 0;
+
+/* PageD worker threads waiting for page faults */
+static sid_t paged_idle_workers[PAGED_MAX_WORKERS];
+static unsigned paged_idle_num = 0;
 
 /*
  * sysc_set_paged()
  *
  * (Implementation of the "set_paged" system call)
  *
- * Installs the current thread as PageD.
+ * Installs the current thread as PageD. Every thread of
+ * the PageD process may receive and resolve page faults
+ * afterwards, so calling it again from the PageD process
+ * has no effect.
  *
  */
 void sysc_set_paged(void)
@@ -45,12 +58,15 @@ void sysc_set_paged(void)
 	
 	if (paged_thr_sid)
 	{
-		SET_ERROR(ERR_PAGING_DAEMON);
+		if (paged_proc_sid != current_p[PRCTAB_SID])
+			SET_ERROR(ERR_PAGING_DAEMON);
+			
 		return;
 	}
 		   
 	/* Set paged */
 	paged_thr_sid = current_t[THRTAB_SID];
+	paged_proc_sid = current_p[PRCTAB_SID];
 	current_p[PRCTAB_IS_PAGED] = 1;
 	
 	#ifdef DEBUG_MODE
@@ -63,15 +79,83 @@ void sysc_set_paged(void)
 	return;
 }
 
+/*
+ * kpaged_unlink_fault(thr)
+ *
+ * Removes the thread 'thr' from the fault queue, if it
+ * is still part of it.
+ *
+ */
+static void kpaged_unlink_fault(uint32_t *thr)
+{
+	uint32_t *l__prev = (void*)(uintptr_t)thr[THRTAB_PAGED_QUEUE_PREV];
+	uint32_t *l__next = (void*)(uintptr_t)thr[THRTAB_PAGED_QUEUE_NEXT];
+	
+	/* Not queued (anymore)? */
+	if ((l__prev == NULL) && (paged_queue_begin != thr)) return;
+	
+	if (l__prev != NULL) 
+		l__prev[THRTAB_PAGED_QUEUE_NEXT] = (uintptr_t)l__next;
+	else
+		paged_queue_begin = l__next;
+		
+	if (l__next != NULL)
+		l__next[THRTAB_PAGED_QUEUE_PREV] = (uintptr_t)l__prev;
+	else
+		paged_queue_end = l__prev;
+		
+	thr[THRTAB_PAGED_QUEUE_PREV] = (uintptr_t)NULL;
+	thr[THRTAB_PAGED_QUEUE_NEXT] = (uintptr_t)NULL;
+	paged_queue_num --;
+	
+	return;
+}
+
+/*
+ * kpaged_remove_fault(thr)
+ *
+ * Removes a thread that will be destroyed from the fault
+ * queue resp. from the list of idle PageD workers.
+ *
+ */
+void kpaged_remove_fault(uint32_t *thr)
+{
+	unsigned l__i;
+	
+	if (thr[THRTAB_THRSTAT_FLAGS] & THRSTAT_WAIT_HYPAGED)
+	{
+		kpaged_unlink_fault(thr);
+		thr[THRTAB_THRSTAT_FLAGS] &= (~THRSTAT_WAIT_HYPAGED);
+	}
+	
+	if (thr[THRTAB_THRSTAT_FLAGS] & THRSTAT_RECV_PAGEFAULTS)
+	{
+		for (l__i = 0; l__i < paged_idle_num; l__i ++)
+		{
+			if (paged_idle_workers[l__i] == thr[THRTAB_SID])
+			{
+				paged_idle_workers[l__i] = 
+					paged_idle_workers[-- paged_idle_num];
+				break;
+			}
+		}
+		
+		thr[THRTAB_THRSTAT_FLAGS] &= (~THRSTAT_RECV_PAGEFAULTS);
+	}
+	
+	return;
+}
+
 /*
  * kpaged_message_send()
  *
- * Synchronizes the current thread to the PageD and
- * and freezes it.
+ * Appends the current thread to the fault queue of the 
+ * PageD, awakes an idle PageD worker thread (if there
+ * is one) and freezes the current thread until its
+ * page fault has been resolved.
  *
  * Return:
  *	2	No PageD installed
- *	1	Can't sync to installed PageD (Error-Code)
  *	0	Success
  *
  */
@@ -79,14 +163,43 @@ static int kpaged_message_send(void)
 {
 	if (paged_thr_sid == 0) return 2;
 	
-	/* Synchronize with PageD */
-	if (!sysc_sync(paged_thr_sid, 0, 0))
+	/* Append to the fault queue */
+	current_t[THRTAB_PAGED_QUEUE_PREV] = (uintptr_t)paged_queue_end;
+	current_t[THRTAB_PAGED_QUEUE_NEXT] = (uintptr_t)NULL;
+	
+	if (paged_queue_end != NULL)
+		paged_queue_end[THRTAB_PAGED_QUEUE_NEXT] = (uintptr_t)current_t;
+	else
+		paged_queue_begin = current_t;
+		
+	paged_queue_end = current_t;
+	paged_queue_num ++;
+	
+	/* Leave the run queue */
+	current_t[THRTAB_THRSTAT_FLAGS] |= THRSTAT_WAIT_HYPAGED;
+	ksched_stop_thread(current_t);
+	
+	/* Awake a PageD worker */
+	if (paged_idle_num > 0)
 	{
-		return 1;
+		sid_t l__worker = paged_idle_workers[-- paged_idle_num];
+		
+		if (kinfo_isthrd(l__worker))
+		{
+			THREAD(l__worker, THRTAB_THRSTAT_FLAGS) &= (~THRSTAT_RECV_PAGEFAULTS);
+			
+			if (    (THREAD(l__worker, THRTAB_FREEZE_COUNTER) == 0)
+			     && (!(THREAD(l__worker, THRTAB_THRSTAT_FLAGS) & THRSTAT_OTHER_FREEZE))
+			   )
+			{
+				ksched_start_thread(&THREAD(l__worker, 0));
+			}
+		}
 	}
 	
 	/* And sleep */
-	sysc_freeze_subject(current_t[THRTAB_SID]);
+	ksched_change_thread = true;
+	ksched_next_thread();
 	
 	return 0;
 }
@@ -319,7 +432,7 @@ int kpaged_handle_exception(uint32_t number, uint32_t code, uintptr_t ip)
 	if ((current_t == NULL) || (current_p == NULL)) return 1;
 	
 	/* Exception of the paging daemon */
-	if (current_t[THRTAB_SID] == paged_thr_sid) return 1;
+	if (current_p[PRCTAB_IS_PAGED]) return 1;
 	
 	/* Make a difference between exception and page fault */
 	if (number != EXC_X86_PAGE_FAULT)
@@ -442,3 +555,370 @@ unsigned sysc_test_page(uintptr_t adr, sid_t sid)
 	
 	return l__retval;
 }
+
+/*
+ * kpaged_get_user_buffer(adr, sz, write)
+ *
+ * Tests if the buffer 'adr' of 'sz' bytes within the current
+ * address space is accessable by the current thread and returns
+ * a pointer to it, which is valid within the kernel address
+ * space. If 'write' is set, pages marked for copy-on-write
+ * will be copied first.
+ *
+ * Return value:
+ *	!= NULL		Kernel pointer to the buffer
+ *	NULL		Buffer not accessable
+ *
+ */
+void* kpaged_get_user_buffer(uintptr_t adr, size_t sz, bool write)
+{
+	uint32_t *l__pdir = (void*)(uintptr_t)current_p[PRCTAB_PAGEDIR_PHYSICAL_ADDR];
+	uintptr_t l__page = adr & (~0xFFFu);
+	uint32_t *l__ptab;
+	uint32_t l__entry;
+	
+	if (    (sz == 0)
+	     || ((adr + sz) <= adr) 
+	     || ((adr + sz) > VAS_USER_END)
+	   )
+	{
+		return NULL;
+	}
+	
+	while (l__page < (adr + sz))
+	{
+		l__ptab = kmem_get_table(l__pdir, l__page, false);
+		if (l__ptab == NULL) return NULL;
+		
+		l__entry = l__ptab[(l__page / 4096) & 0x3FF];
+		
+		if (    (!(l__entry & GENFLAG_PRESENT))
+		     || (!(l__entry & GENFLAG_USER_MODE))
+		     || (l__entry & GENFLAG_PAGED_PROTECTED)
+		   )
+		{
+			return NULL;
+		}
+		
+		/* The kernel ignores the write protection of user pages */
+		if (write)
+		{
+			if (    (l__entry & GENFLAG_DO_COPYONWRITE)
+			     || (l__pdir[l__page / (4096 * 1024)] & GENFLAG_SHARED_TABLE)
+			   )
+			{
+				if (kmem_do_copy_on_write(l__pdir, 
+							  current_p[PRCTAB_SID], 
+							  l__page
+							 ) == 3
+				   )
+				{
+					return NULL;
+				}
+				
+				l__ptab = kmem_get_table(l__pdir, l__page, false);
+				l__entry = l__ptab[(l__page / 4096) & 0x3FF];
+			}
+			
+			if (!(l__entry & GENFLAG_WRITABLE)) return NULL;
+		}
+		
+		l__page += 4096;
+	}
+	
+	return (void*)(adr - VAS_KERNEL_START);
+}
+
+/*
+ * sysc_recv_pagefaults(buf, max)
+ *
+ * (Implementation of the "recv_pagefaults" system call)
+ *
+ * Moves up to 'max' entries of the fault queue to the
+ * buffer 'buf' of the calling PageD thread. If the queue
+ * is empty, the calling thread will sleep until the next
+ * page fault occurs and the system call returns 0 (so the
+ * caller has to retry).
+ *
+ * Parameters:
+ *	buf	Buffer for 'max' paged_fault_t entries
+ *	max	Max. number of received faults
+ *
+ * Return value:
+ *	Number of received faults
+ *
+ */
+unsigned sysc_recv_pagefaults(uintptr_t buf, unsigned max)
+{
+	paged_fault_t *l__buf;
+	unsigned l__num = 0;
+	
+	if (!current_p[PRCTAB_IS_PAGED])
+	{
+		SET_ERROR(ERR_PAGING_DAEMON);
+		return 0;
+	}
+	
+	if (max > PAGED_MAX_BATCH)
+	{
+		SET_ERROR(ERR_SYSCALL_RESTRICTED);
+		return 0;
+	}
+	
+	if (max == 0)
+	{
+		SET_ERROR(ERR_INVALID_ARGUMENT);
+		return 0;
+	}
+	
+	/* Nothing to do, wait for the next fault */
+	if (paged_queue_begin == NULL)
+	{
+		if (paged_idle_num >= PAGED_MAX_WORKERS)
+		{
+			SET_ERROR(ERR_RESOURCE_BUSY);
+			return 0;
+		}
+		
+		paged_idle_workers[paged_idle_num ++] = current_t[THRTAB_SID];
+		current_t[THRTAB_THRSTAT_FLAGS] |= THRSTAT_RECV_PAGEFAULTS;
+		ksched_stop_thread(current_t);
+		
+		ksched_change_thread = true;
+		ksched_next_thread();
+		
+		return 0;
+	}
+	
+	if (max > paged_queue_num) max = paged_queue_num;
+	
+	l__buf = kpaged_get_user_buffer(buf, max * sizeof(paged_fault_t), true);
+	if (l__buf == NULL)
+	{
+		SET_ERROR(ERR_INVALID_ADDRESS);
+		return 0;
+	}
+	
+	/* Drain the queue */
+	while ((l__num < max) && (paged_queue_begin != NULL))
+	{
+		uint32_t *l__thr = paged_queue_begin;
+		
+		kpaged_unlink_fault(l__thr);
+		
+		l__buf[l__num].thread = l__thr[THRTAB_SID];
+		l__buf[l__num].number = l__thr[THRTAB_LAST_EXCPT_NR_PLATTFORM];
+		
+		if (l__thr[THRTAB_LAST_EXCPT_NUMBER] == EXC_INVALID_PAGE)
+		{
+			l__buf[l__num].adr = l__thr[THRTAB_PAGEFAULT_LINEAR_ADDRESS];
+			l__buf[l__num].descr = l__thr[THRTAB_PAGEFAULT_DESCRIPTOR];
+		}
+		 else
+		{
+			l__buf[l__num].adr = l__thr[THRTAB_LAST_EXCPT_ADDRESS];
+			l__buf[l__num].descr = 0;
+		}
+		
+		l__num ++;
+	}
+	
+	return l__num;
+}
+
+/*
+ * kpaged_map_page(thr, src_adr, flags)
+ *
+ * Maps the page 'src_adr' of the PageD address space to
+ * the address of the last page fault of the thread 'thr'.
+ * A page frame that was mapped to this address before will
+ * be released.
+ *
+ * Return value:
+ *	0	Successful
+ *	1	Invalid source page
+ *	2	Not enough memory
+ *
+ */
+static int kpaged_map_page(uint32_t *thr, uintptr_t src_adr, unsigned flags)
+{
+	sid_t l__psid = thr[THRTAB_PROCESS_SID];
+	uint32_t *l__pdir_s = (void*)(uintptr_t)current_p[PRCTAB_PAGEDIR_PHYSICAL_ADDR];
+	uint32_t *l__pdir_d = (void*)(uintptr_t)PROCESS(l__psid, PRCTAB_PAGEDIR_PHYSICAL_ADDR);
+	uintptr_t l__dest_adr = thr[THRTAB_PAGEFAULT_LINEAR_ADDRESS] & (~0xFFFu);
+	uint32_t *l__ptab_s;
+	uint32_t *l__ptab_d;
+	uint32_t l__entry;
+	uint32_t l__old;
+	
+	src_adr &= (~0xFFFu);
+	
+	if ((src_adr >= VAS_KERNEL_START) || (l__dest_adr >= VAS_KERNEL_START))
+		return 1;
+	
+	/* Load the source page */
+	l__ptab_s = kmem_get_table(l__pdir_s, src_adr, false);
+	if (l__ptab_s == NULL) return 1;
+	
+	l__entry = l__ptab_s[(src_adr / 4096) & 0x3FF];
+	
+	if (    (!(l__entry & GENFLAG_PRESENT))
+	     || (!KMEM_IS_USER_FRAME(l__entry & (~0xFFFu)))
+	   )
+	{
+		return 1;
+	}
+	
+	/* A copy-on-write page can't be shared directly */
+	if (l__entry & GENFLAG_DO_COPYONWRITE)
+	{
+		if (kmem_do_copy_on_write(l__pdir_s, current_p[PRCTAB_SID], src_adr))
+			return 2;
+			
+		l__ptab_s = kmem_get_table(l__pdir_s, src_adr, false);
+		l__entry = l__ptab_s[(src_adr / 4096) & 0x3FF];
+	}
+	
+	/* Load the destination page */
+	l__ptab_d = kmem_get_private_table(l__pdir_d, l__psid, l__dest_adr, 1);
+	if (l__ptab_d == NULL) return 2;
+	
+	if (kmem_share_user_pageframe(l__entry & (~0xFFFu), l__psid, l__dest_adr))
+		return 2;
+	
+	/* Release the old page frame */
+	l__old = l__ptab_d[(l__dest_adr / 4096) & 0x3FF];
+	
+	if (l__old & GENFLAG_PRESENT)
+	{
+		kmem_free_user_pageframe(l__old, l__psid, l__dest_adr);
+	}
+	 else
+	{
+		PROCESS(l__psid, PRCTAB_X86_MMTABLE + (l__dest_adr / (4096 * 1024))) ++;
+	}
+	
+	/* Map the new one */
+	l__entry =   (l__entry & (~0xFFFu))
+		   | GENFLAG_PRESENT 
+		   | GENFLAG_USER_MODE
+		   | GENFLAG_READABLE;
+		   
+	if (flags & MAP_WRITE) l__entry |= GENFLAG_WRITABLE;
+	if (flags & MAP_EXECUTABLE) l__entry |= GENFLAG_EXECUTABLE;
+	if (flags & MAP_PAGED) l__entry |= GENFLAG_PAGED_PROTECTED;
+	
+	l__ptab_d[(l__dest_adr / 4096) & 0x3FF] = l__entry;
+	
+	if (l__pdir_d == i386_current_pdir) INVLPG(l__dest_adr);
+	
+	return 0;
+}
+
+/*
+ * sysc_resolve_pagefaults(list, num)
+ *
+ * (Implementation of the "resolve_pagefaults" system call)
+ *
+ * Resolves 'num' page faults received by recv_pagefaults.
+ * If the source address of an entry of 'list' is not null,
+ * the page at this address will be mapped to the fault address
+ * of the thread first. Afterwards all threads are awaked together.
+ *
+ * Parameters:
+ *	list	List of 'num' paged_resolve_t entries
+ *	num	Number of entries
+ *
+ * Return value:
+ *	Number of awaked threads
+ *
+ */
+unsigned sysc_resolve_pagefaults(uintptr_t list, unsigned num)
+{
+	paged_resolve_t *l__list;
+	unsigned l__i;
+	unsigned l__num = 0;
+	
+	if (!current_p[PRCTAB_IS_PAGED])
+	{
+		SET_ERROR(ERR_PAGING_DAEMON);
+		return 0;
+	}
+	
+	if (num > PAGED_MAX_BATCH)
+	{
+		SET_ERROR(ERR_SYSCALL_RESTRICTED);
+		return 0;
+	}
+	
+	if (num == 0) return 0;
+	
+	l__list = kpaged_get_user_buffer(list, num * sizeof(paged_resolve_t), false);
+	if (l__list == NULL)
+	{
+		SET_ERROR(ERR_INVALID_ADDRESS);
+		return 0;
+	}
+	
+	for (l__i = 0; l__i < num; l__i ++)
+	{
+		sid_t l__sid = l__list[l__i].thread;
+		uint32_t *l__thr;
+		
+		/* Is it waiting for the PageD? */
+		if (    (!kinfo_isthrd(l__sid))
+		     || (!(THREAD(l__sid, THRTAB_THRSTAT_FLAGS) & THRSTAT_WAIT_HYPAGED))
+		   )
+		{
+			SET_ERROR(ERR_INVALID_SID);
+			continue;
+		}
+		
+		l__thr = &THREAD(l__sid, 0);
+		
+		/* Map the page */
+		if (l__list[l__i].src_adr != 0)
+		{
+			int l__ret;
+			
+			if (l__thr[THRTAB_LAST_EXCPT_NUMBER] != EXC_INVALID_PAGE)
+			{
+				SET_ERROR(ERR_INVALID_ARGUMENT);
+				continue;
+			}
+			
+			l__ret = kpaged_map_page(l__thr, 
+						 l__list[l__i].src_adr, 
+						 l__list[l__i].flags
+						);
+			if (l__ret == 1)
+			{
+				SET_ERROR(ERR_INVALID_ADDRESS);
+				continue;
+			}
+			 else if (l__ret == 2)
+			{
+				SET_ERROR(ERR_NOT_ENOUGH_MEMORY);
+				continue;
+			}
+		}
+		
+		/* Awake it */
+		kpaged_unlink_fault(l__thr);
+		l__thr[THRTAB_THRSTAT_FLAGS] &= (~THRSTAT_WAIT_HYPAGED);
+		
+		if (    (l__thr[THRTAB_FREEZE_COUNTER] == 0)
+		     && (!(l__thr[THRTAB_THRSTAT_FLAGS] & THRSTAT_OTHER_FREEZE))
+		   )
+		{
+			ksched_start_thread(l__thr);
+		}
+		
+		l__num ++;
+	}
+	
+	/* If needed, yield the current thread */
+	KSCHED_TRY_RESCHED();
+	
+	return l__num;
+}
@@ -20,10 +20,165 @@
 #include <setup.h>
 #include <sched.h>
 #include <current.h>
+#include <string.h>
 #include <sysc.h>
+#include <trace.h>
+
+/* EFLAGS bits writeable by write_regs (CF, PF, AF, ZF, SF, TF, DF, OF) */
+#define KREMOTE_EFLAGS_USER		0x00000DD5u
+
+extern long i387_fsave;
 
 /*
- * sysc_read_regs(sid, regtype)
+ * kremote_read_frame(sid, stack, regtype, buf)
+ *
+ * Copies the complete register frame 'stack' of the thread 
+ * 'sid' (and its FPU state, if 'regtype' is REGS_X86_FRAME_FPU)
+ * to the reg_frame_t buffer 'buf' of the current thread.
+ *
+ */
+static void kremote_read_frame(sid_t sid, 
+			       uint32_t *stack, 
+			       unsigned regtype, 
+			       uintptr_t buf
+			      )
+{
+	reg_frame_t *l__frame;
+	
+	/* The FPU state of the current thread is still in the FPU */
+	if ((regtype == REGS_X86_FRAME_FPU) && (sid == current_t[THRTAB_SID]))
+	{
+		SET_ERROR(ERR_INVALID_SID);
+		return;
+	}
+	
+	l__frame = kpaged_get_user_buffer(buf, 
+					  (regtype == REGS_X86_FRAME_FPU) ? 
+					  	  sizeof(reg_frame_t) 
+					  	: REG_FRAME_SIZE,
+					  true
+					 );
+	if (l__frame == NULL)
+	{
+		SET_ERROR(ERR_INVALID_ADDRESS);
+		return;
+	}
+	
+	l__frame->eax = stack[7];
+	l__frame->ebx = stack[4];
+	l__frame->ecx = stack[6];
+	l__frame->edx = stack[5];
+	l__frame->esi = stack[1];
+	l__frame->edi = stack[0];
+	l__frame->ebp = stack[2];
+	l__frame->esp = stack[15];
+	l__frame->eip = stack[12];
+	l__frame->eflags = stack[14];
+	l__frame->cs = stack[13];
+	l__frame->ss = stack[16];
+	l__frame->ds = stack[11];
+	l__frame->es = stack[10];
+	l__frame->fs = stack[9];
+	l__frame->gs = stack[8];
+	
+	if (regtype == REGS_X86_FRAME_FPU)
+	{
+		l__frame->fpu_format = i387_fsave;
+		l__frame->reserved[0] = 0;
+		l__frame->reserved[1] = 0;
+		l__frame->reserved[2] = 0;
+		
+		memcpy(l__frame->fpu, &THREAD(sid, THRTAB_X86_FPU_STACK), sizeof(l__frame->fpu));
+	}
+	
+	return;
+}
+
+/*
+ * kremote_write_frame(sid, stack, regtype, buf)
+ *
+ * Changes the register frame 'stack' of the thread 'sid' 
+ * (and its FPU state, if 'regtype' is REGS_X86_FRAME_FPU)
+ * to the content of the reg_frame_t buffer 'buf' of the 
+ * current thread. The segment registers and the system
+ * flags of EFLAGS won't be changed.
+ *
+ */
+static void kremote_write_frame(sid_t sid, 
+				uint32_t *stack, 
+				unsigned regtype, 
+				uintptr_t buf
+			       )
+{
+	reg_frame_t *l__frame;
+	
+	l__frame = kpaged_get_user_buffer(buf, 
+					  (regtype == REGS_X86_FRAME_FPU) ? 
+					  	  sizeof(reg_frame_t) 
+					  	: REG_FRAME_SIZE,
+					  false
+					 );
+	if (l__frame == NULL)
+	{
+		SET_ERROR(ERR_INVALID_ADDRESS);
+		return;
+	}
+	
+	if (regtype == REGS_X86_FRAME_FPU)
+	{
+		uint8_t *l__fpu = (void*)&THREAD(sid, THRTAB_X86_FPU_STACK);
+		
+		/* The FPU state of the current thread is still in the FPU */
+		if (sid == current_t[THRTAB_SID])
+		{
+			SET_ERROR(ERR_INVALID_SID);
+			return;
+		}
+		
+		if (    (l__frame->fpu_format != (uint32_t)i387_fsave)
+		     || (i387_fsave == REG_FPU_NONE)
+		   )
+		{
+			SET_ERROR(ERR_INVALID_ARGUMENT);
+			return;
+		}
+		
+		/* FXRSTOR faults on reserved MXCSR bits (MXCSR at 24, MXCSR_MASK at 28) */
+		if (i387_fsave == REG_FPU_FXSAVE)
+		{
+			uint32_t l__mask = *(uint32_t*)&l__fpu[28];
+			uint32_t l__mxcsr = *(const uint32_t*)&l__frame->fpu[24];
+			
+			if (l__mask == 0) l__mask = 0xFFBF;
+			
+			memcpy(l__fpu, l__frame->fpu, sizeof(l__frame->fpu));
+			
+			*(uint32_t*)&l__fpu[24] = l__mxcsr & l__mask;
+			*(uint32_t*)&l__fpu[28] = l__mask;
+		}
+		 else
+		{
+			memcpy(l__fpu, l__frame->fpu, sizeof(l__frame->fpu));
+		}
+	}
+	
+	stack[7] = l__frame->eax;
+	stack[4] = l__frame->ebx;
+	stack[6] = l__frame->ecx;
+	stack[5] = l__frame->edx;
+	stack[1] = l__frame->esi;
+	stack[0] = l__frame->edi;
+	stack[2] = l__frame->ebp;
+	stack[15] = l__frame->esp;
+	stack[12] = l__frame->eip;
+	stack[14] =   (stack[14] & (~KREMOTE_EFLAGS_USER)) 
+		    | (l__frame->eflags & KREMOTE_EFLAGS_USER);
+	
+	return;
+}
+
+/*
+ * sysc_read_regs(sid, regtype, frame)
  *
  * (Implementation of the "read_regs" system call)
  *
@@ -32,6 +187,11 @@
  * to the registers EBX (1), ECX (2), EDX (3), ESI (4) of the
  * calling thread.
  *
+ * The types REGS_X86_FRAME and REGS_X86_FRAME_FPU copy all
+ * registers (and the FPU state of a thread, that isn't the 
+ * caller) with a single call to the reg_frame_t buffer 
+ * 'frame' instead.
+ *
  * Parameters:
  *	sid		The thread
  *	regtype		Registers to read
@@ -49,6 +209,11 @@
  *				EIP => 2
  *			REGS_X86_EFLAGS
  *				EFLAGS => 1
+ *			REGS_X86_FRAME
+ *				All registers => frame
+ *			REGS_X86_FRAME_FPU
+ *				All registers and FPU => frame
+ *	frame		Buffer (only REGS_X86_FRAME*)
  *
  * Return value:
  *	Passed directly to the registers of the calling
@@ -56,7 +221,7 @@
  *	EDX value 3 and ESI value 4.
  *
  */
-void sysc_read_regs(sid_t sid, unsigned regtype)
+void sysc_read_regs(sid_t sid, unsigned regtype, uintptr_t frame)
 {
 	uint32_t l__outreg[4] = {0, 0, 0, 0};
 	uint32_t *l__srcstack = NULL;
@@ -93,6 +258,13 @@ void sysc_read_regs(sid_t sid, unsigned regtype)
 			  - (17 * 4)
 			);
 	
+	/* Complete frame: Don't change the registers of the caller */
+	if ((regtype == REGS_X86_FRAME) || (regtype == REGS_X86_FRAME_FPU))
+	{
+		kremote_read_frame(sid, l__srcstack, regtype, frame);
+		return;
+	}
+	
 	/* Read registers from source */
 	switch(regtype)
 	{
@@ -145,6 +317,12 @@ void sysc_read_regs(sid_t sid, unsigned regtype)
  * Modifies the register contents of another thread. The calling
  * thread has to be root.
  *
+ * The types REGS_X86_FRAME and REGS_X86_FRAME_FPU change all
+ * registers (and the FPU state of a thread, that isn't the 
+ * caller) to the content of the reg_frame_t buffer 'reg_a'.
+ * The segment registers are read-only. Only the flags CF, PF,
+ * AF, ZF, SF, TF, DF and OF of EFLAGS can be changed.
+ *
  * Parameters:
  *	sid		The thread
  *	regtype		Registers to read
@@ -162,6 +340,10 @@ void sysc_read_regs(sid_t sid, unsigned regtype)
  *				reg_b => EIP
  *			REGS_X86_EFLAGS
  *				reg_a => EFLAGS
+ *			REGS_X86_FRAME
+ *				Frame buffer => reg_a
+ *			REGS_X86_FRAME_FPU
+ *				Frame buffer => reg_a
  *
  *	reg_a - reg_d:	New register values (see above)
  */
@@ -201,6 +383,13 @@ void sysc_write_regs(sid_t sid,
 	/* Read registers from source */
 	switch(regtype)
 	{
+		case (REGS_X86_FRAME):
+		case (REGS_X86_FRAME_FPU):
+		{
+			kremote_write_frame(sid, l__deststack, regtype, reg_a);
+			break;
+		}
+		
 		case (REGS_X86_GENERIC):
 		{
 			l__deststack[7] = reg_a; /* eax */
@@ -262,6 +451,24 @@ void sysc_write_regs(sid_t sid,
  *						before the beginning
  *						of the observation 
  *						using sysc_awake_thread.
+ *			RECV_TRACE_SYSCALL	System calls are 
+ *						executed after 
+ *						receiving them.
+ *			RECV_STREAM_SYSCALL	System calls don't stop
+ *						the observed thread.
+ *						They are written to the
+ *						trace ring instead 
+ *						(TRACE_SYSCALL_ENTER and
+ *						TRACE_SYSCALL_ARGS). 
+ *						Without this flag the
+ *						streaming will be
+ *						stopped.
+ *
+ * In the streaming mode the caller stays listener of the
+ * thread after receiving RECV_STREAM_DATA. Software interrupts
+ * that occur until the next call of recv_softints will be
+ * returned by that call immediately. A call with timeout 0
+ * ends the listening.
  *
  * Return Value:
  *	Number of the traced software interrupt.
@@ -270,9 +477,14 @@ void sysc_write_regs(sid_t sid,
  *	write_regs. Exception codes etc. are stored in the
  *	thread descriptor.
  *
+ *	RECV_STREAM_DATA, if new system calls of a streamed
+ *	thread have been written to the trace ring.
+ *
  */
 uint32_t sysc_recv_softints(sid_t sid, unsigned timeout, int flags)
 {
+	uint32_t l__intr;
+	
 	/* Only root is allowed to... */
 	if (current_p[PRCTAB_IS_ROOT] != 1)
 	{
@@ -289,13 +501,39 @@ uint32_t sysc_recv_softints(sid_t sid, unsigned timeout, int flags)
 		return 0xFFFFFFFF;
 	}
 	
-	/* Is always a listner active? */
-	if (THREAD(sid, THRTAB_SOFTINT_LISTENER_SID) != 0)
+	/* Is always a listner active? (We may still listen in streaming mode) */
+	if (    (THREAD(sid, THRTAB_SOFTINT_LISTENER_SID) != 0)
+	     && (THREAD(sid, THRTAB_SOFTINT_LISTENER_SID) != current_t[THRTAB_SID])
+	   )
 	{
 		SET_ERROR(ERR_RESOURCE_BUSY);
 		return 0xFFFFFFFF;
 	}
 	
+	/* Start or stop the streaming of system calls */
+	if (flags & RECV_STREAM_SYSCALL)
+	{
+		if ((ktrace_header == NULL) && (ktrace_alloc_ring()))
+		{
+			SET_ERROR(ERR_NOT_ENOUGH_MEMORY);
+			return 0xFFFFFFFF;
+		}
+		
+		THREAD(sid, THRTAB_THRSTAT_FLAGS) |= THRSTAT_TRACE_STREAM;
+	}
+	 else
+	{
+		THREAD(sid, THRTAB_THRSTAT_FLAGS) &= (~THRSTAT_TRACE_STREAM);
+	}
+	
+	/* Received something since the last call (streaming mode)? */
+	if (    (THREAD(sid, THRTAB_SOFTINT_LISTENER_SID) == current_t[THRTAB_SID])
+	     && (THREAD(sid, THRTAB_RECEIVED_SOFTINT) != 0xFFFFFFFF)
+	   )
+	{
+		goto received;
+	}
+	
 	/* Awake the other side, if wanted */
 	if (    (flags & RECV_AWAKE_OTHER)
 	     && (THREAD(sid, THRTAB_FREEZE_COUNTER) > 0)
@@ -315,9 +553,16 @@ uint32_t sysc_recv_softints(sid_t sid, unsigned timeout, int flags)
 		}
 	}
 	
-	/* No timeout, just exit */
+	/* No timeout, just exit (and stop listening) */
 	if (timeout == 0)
 	{
+		if (THREAD(sid, THRTAB_SOFTINT_LISTENER_SID) == current_t[THRTAB_SID])
+		{
+			current_t[THRTAB_RECV_LISTEN_TO] = 0;
+			THREAD(sid, THRTAB_SOFTINT_LISTENER_SID) = 0;
+			THREAD(sid, THRTAB_RECEIVED_SOFTINT) = 0xFFFFFFFF;
+		}
+		
 		SET_ERROR(ERR_TIMED_OUT);
 		return 0xFFFFFFFF;
 	}
@@ -352,19 +597,30 @@ uint32_t sysc_recv_softints(sid_t sid, unsigned timeout, int flags)
 	MSYNC();
 
 	current_t[THRTAB_THRSTAT_FLAGS] &= (~THRSTAT_RECV_SOFTINT);
-	current_t[THRTAB_RECV_LISTEN_TO] = 0;
 	
 	/* No software interrupt received */
 	if (THREAD(sid, THRTAB_RECEIVED_SOFTINT) == 0xFFFFFFFF)
 	{
+		current_t[THRTAB_RECV_LISTEN_TO] = 0;
 		THREAD(sid, THRTAB_SOFTINT_LISTENER_SID) = 0;
 		SET_ERROR(ERR_TIMED_OUT);
 		return 0xFFFFFFFF;
 	}		
 	
+received:
+	l__intr = THREAD(sid, THRTAB_RECEIVED_SOFTINT);
+	
+	/* Streamed system calls: The thread is still running, keep on listening */
+	if (l__intr == RECV_STREAM_DATA)
+	{
+		THREAD(sid, THRTAB_RECEIVED_SOFTINT) = 0xFFFFFFFF;
+		return RECV_STREAM_DATA;
+	}
+	
+	current_t[THRTAB_RECV_LISTEN_TO] = 0;
 	THREAD(sid, THRTAB_SOFTINT_LISTENER_SID) = 0;
 		
-	return THREAD(sid, THRTAB_RECEIVED_SOFTINT);
+	return l__intr;
 }
 
 /*
@@ -374,15 +630,22 @@ uint32_t sysc_recv_softints(sid_t sid, unsigned timeout, int flags)
  * should be handled by another thread, that is currently
  * receiving it.
  *
+ * System calls of a streamed thread (THRSTAT_TRACE_STREAM)
+ * are executed without stopping the thread. The receiver 
+ * will be only informed (RECV_STREAM_DATA), that new records
+ * are in the trace ring.
+ *
  * Return value:
  *
  *	0 - Handled
- *	1 - Not Handled (Trace-Only, Start Syscall)
+ *	1 - Not Handled (Trace-Only, Streamed, Start Syscall)
  *
  */
 int kremote_received(uint32_t intr)
 {
 	sid_t l__receiver = current_t[THRTAB_SOFTINT_LISTENER_SID];
+	int l__stream = 0;
+	int l__pending;
 	
 	/* Is the receiver still active? */
 	if (kinfo_isthrd(l__receiver) == 0)
@@ -391,17 +654,41 @@ int kremote_received(uint32_t intr)
 		while(1);
 	}
 	
+	/* Streamed system call? Don't overwrite a pending software interrupt */
+	if (    (current_t[THRTAB_THRSTAT_FLAGS] & THRSTAT_TRACE_STREAM)
+	     && (intr >= KFIRST_SYSCALL) 
+	     && (intr <= KLAST_SYSCALL)
+	   )
+	{
+		if (current_t[THRTAB_RECEIVED_SOFTINT] != 0xFFFFFFFF)
+			return 1;
+			
+		intr = RECV_STREAM_DATA;
+		l__stream = 1;
+	}
+	
+	/* Already woken by a streamed system call? */
+	l__pending = (current_t[THRTAB_RECEIVED_SOFTINT] != 0xFFFFFFFF);
+	
 	/* Inform the receiver */
 	current_t[THRTAB_RECEIVED_SOFTINT] = intr;
 	
-	/* Restart the receiver */
-	if (THREAD(l__receiver, THRTAB_THRSTAT_FLAGS) & THRSTAT_TIMEOUT)
+	/* Restart the receiver (if it isn't busy with the stream) */
+	if (    (!l__pending)
+	     && (THREAD(l__receiver, THRTAB_THRSTAT_FLAGS) & THRSTAT_RECV_SOFTINT)
+	   )
 	{
-		ksched_del_timeout(&THREAD(l__receiver, 0));
-		THREAD(l__receiver, THRTAB_THRSTAT_FLAGS) &= (~THRSTAT_TIMEOUT);
-	}
+		if (THREAD(l__receiver, THRTAB_THRSTAT_FLAGS) & THRSTAT_TIMEOUT)
+		{
+			ksched_del_timeout(&THREAD(l__receiver, 0));
+			THREAD(l__receiver, THRTAB_THRSTAT_FLAGS) &= (~THRSTAT_TIMEOUT);
+		}
 		
-	ksched_start_thread(&THREAD(l__receiver, 0));
+		ksched_start_thread(&THREAD(l__receiver, 0));
+	}
+	
+	/* Streamed system calls will be executed without a stop */
+	if (l__stream) return 1;
 	
 	/* Comment: Trace-Only exists only for system calls */
 	if ((current_t[THRTAB_THRSTAT_FLAGS] & THRSTAT_TRACE_ONLY) && (intr >= KFIRST_SYSCALL) && (intr <= KLAST_SYSCALL))
@@ -0,0 +1,446 @@
+/*
+ *
+ * rmap.c
+ *
+ * (C)2007 by Friedrich Grter
+ *
+ * This file is distributed under the terms of
+ * the GNU General Public License, Version 2. You
+ * should have received a copy of this license (e.g.
+ * in the file 'copying').
+ *
+ * Reverse map of shared page frames
+ *
+ */
+#include <hydrixos/types.h>
+#include <stdio.h>
+#include <setup.h>
+#include <mem.h>
+
+/*
+ * Pool of RMAP objects
+ *
+ * Both rmap_t and rmap_entry_t are allocated from the same
+ * pool of 32 byte objects. The pool grows on demand by
+ * allocating kernel page frames. It won't shrink.
+ *
+ */
+#define RMAP_OBJ_SIZE		32
+#define RMAP_OBJS_PER_PAGE	(4096 / RMAP_OBJ_SIZE)
+
+typedef struct rmap_obj_st {
+	struct rmap_obj_st	*nxt;			/* Next free object */
+	uint32_t		unused[(RMAP_OBJ_SIZE / 4) - 1];
+}rmap_obj_t;
+
+static rmap_obj_t *rmap_pool_free = NULL;	/* Free objects of the pool */
+unsigned long rmap_pool_pages = 0;		/* Page frames used by the RMAP pool */
+unsigned long rmap_pool_free_count = 0;		/* Free objects within the RMAP pool */
+
+/*
+ * RMAP_HASH(page, pid, u_adr)
+ *
+ * Returns the hash bucket of the overflow entry of the
+ * process 'pid' for the page frame 'page' at 'u_adr'.
+ *
+ */
+#define RMAP_HASH(___page, ___pid, ___u_adr) \
+	(rmap_hash[(    ((___page) >> 12) \
+		      ^ ((___pid) * 0x9E3779B1u) \
+		      ^ ((___u_adr) >> 12) \
+		    ) & (rmap_hash_count - 1) \
+		  ] \
+	)
+
+/*
+ * kmem_rmap_reserve(num)
+ *
+ * Makes sure that the RMAP pool contains at least 'num'
+ * free objects. If needed, new kernel page frames will
+ * be added to the pool.
+ *
+ * Return value:
+ *	0	Successful
+ *	1	Not enough memory
+ *
+ */
+int kmem_rmap_reserve(unsigned long num)
+{
+	while (rmap_pool_free_count < num)
+	{
+		rmap_obj_t *l__page = kmem_alloc_kernel_pageframe();
+		unsigned l__n;
+		
+		if (l__page == NULL) return 1;
+		
+		for (l__n = 0; l__n < RMAP_OBJS_PER_PAGE; l__n ++)
+		{
+			l__page[l__n].nxt = rmap_pool_free;
+			rmap_pool_free = &l__page[l__n];
+		}
+		
+		rmap_pool_free_count += RMAP_OBJS_PER_PAGE;
+		rmap_pool_pages ++;
+	}
+	
+	return 0;
+}
+
+/*
+ * kmem_rmap_get_obj()
+ *
+ * Takes an object from the RMAP pool. The caller has
+ * to reserve it using kmem_rmap_reserve first.
+ *
+ */
+static void* kmem_rmap_get_obj(void)
+{
+	rmap_obj_t *l__obj = rmap_pool_free;
+	
+	rmap_pool_free = l__obj->nxt;
+	rmap_pool_free_count --;
+	
+	return l__obj;
+}
+
+/*
+ * kmem_rmap_put_obj(obj)
+ *
+ * Returns the object 'obj' to the RMAP pool.
+ *
+ */
+static void kmem_rmap_put_obj(void *obj)
+{
+	rmap_obj_t *l__obj = obj;
+	
+	l__obj->nxt = rmap_pool_free;
+	rmap_pool_free = l__obj;
+	rmap_pool_free_count ++;
+	
+	return;
+}
+
+/*
+ * kmem_rmap_hash_remove(ent)
+ *
+ * Removes the overflow entry 'ent' from its hash bucket.
+ *
+ */
+static void kmem_rmap_hash_remove(rmap_entry_t *ent)
+{
+	rmap_entry_t **l__ptr = &RMAP_HASH(ent->page, ent->user.pid, ent->user.u_adr);
+	
+	while (*l__ptr != NULL)
+	{
+		if (*l__ptr == ent)
+		{
+			*l__ptr = ent->hash_nxt;
+			return;
+		}
+		
+		l__ptr = &((*l__ptr)->hash_nxt);
+	}
+	
+	return;
+}
+
+/*
+ * kmem_rmap_hash_find(page, pid, u_adr)
+ *
+ * Searches the overflow entry of the process 'pid' for
+ * the page frame 'page' at address 'u_adr'.
+ *
+ * Return value:
+ *	!= NULL		Pointer to the entry
+ *	NULL		Entry not found
+ *
+ */
+static rmap_entry_t* kmem_rmap_hash_find(uintptr_t page, 
+					 sid_t pid, 
+					 uintptr_t u_adr
+					)
+{
+	rmap_entry_t *l__ent = RMAP_HASH(page, pid, u_adr);
+	
+	while (l__ent != NULL)
+	{
+		if (    (l__ent->page == page)
+		     && (l__ent->user.pid == pid)
+		     && (l__ent->user.u_adr == u_adr)
+		   )
+		{
+			return l__ent;
+		}
+		
+		l__ent = l__ent->hash_nxt;
+	}
+	
+	return NULL;
+}
+
+/*
+ * kmem_rmap_add(page, pid, u_adr)
+ *
+ * Adds the process 'pid' as a further user of the page frame 
+ * 'page', which is mapped to its address space at address
+ * 'u_adr'. If the page frame has been used by a single owner
+ * until now, the function will create a reverse map for it. 
+ * The usage counter of the page frame will be incremented.
+ *
+ * The page frame has to be described by the PBT.
+ *
+ * Return value:
+ *	0	Successful
+ *	1	Not enough memory for the reverse map
+ *
+ */
+int kmem_rmap_add(uintptr_t page, sid_t pid, uintptr_t u_adr)
+{
+	rmap_t *l__rmap;
+	
+	if (kmem_rmap_reserve(2)) return 1;
+	
+	/* An unused page frame gets its first owner */
+	if (PAGE_BUF_TAB(page).usage == 0)
+	{
+		PAGE_BUF_TAB(page).owner.single.pid = pid;
+		PAGE_BUF_TAB(page).owner.single.u_adr = u_adr;
+		PAGE_BUF_TAB(page).usage = 1;
+		
+		return 0;
+	}
+	
+	/* Create a new reverse map */
+	if (PAGE_BUF_TAB(page).usage == 1)
+	{
+		l__rmap = kmem_rmap_get_obj();
+		
+		l__rmap->users[0] = PAGE_BUF_TAB(page).owner.single;
+		l__rmap->inline_count = 1;
+		l__rmap->overflow = NULL;
+		
+		PAGE_BUF_TAB(page).owner.multi = l__rmap;
+	}
+	
+	l__rmap = PAGE_BUF_TAB(page).owner.multi;
+	
+	if (l__rmap->inline_count < RMAP_INLINE_USERS)
+	{
+		/* There is still place within the inline users */
+		l__rmap->users[l__rmap->inline_count].pid = pid;
+		l__rmap->users[l__rmap->inline_count].u_adr = u_adr;
+		l__rmap->inline_count ++;
+	}
+	 else
+	{
+		/* Create an overflow entry */
+		rmap_entry_t *l__ent = kmem_rmap_get_obj();
+		rmap_entry_t **l__bucket = &RMAP_HASH(page, pid, u_adr);
+		
+		l__ent->page = page;
+		l__ent->user.pid = pid;
+		l__ent->user.u_adr = u_adr;
+		
+		l__ent->hash_nxt = *l__bucket;
+		*l__bucket = l__ent;
+		
+		l__ent->prv = NULL;
+		l__ent->nxt = l__rmap->overflow;
+		if (l__rmap->overflow != NULL) l__rmap->overflow->prv = l__ent;
+		l__rmap->overflow = l__ent;
+	}
+	
+	PAGE_BUF_TAB(page).usage ++;
+	
+	return 0;
+}
+
+/*
+ * kmem_rmap_remove(page, pid, u_adr)
+ *
+ * Removes the process 'pid' from the reverse map of the
+ * page frame 'page', which is mapped at address 'u_adr'.
+ * The usage counter of the page frame will be decremented.
+ * If the page frame is used by a single owner after that, 
+ * the reverse map will be released.
+ *
+ * The page frame has to be used by more than one owner.
+ *
+ * Return value:
+ *	0	Successful
+ *	1	Entry not found
+ *
+ */
+int kmem_rmap_remove(uintptr_t page, sid_t pid, uintptr_t u_adr)
+{
+	rmap_t *l__rmap = PAGE_BUF_TAB(page).owner.multi;
+	rmap_entry_t *l__ent = NULL;
+	unsigned l__n;
+	
+	if (PAGE_BUF_TAB(page).usage < 2) return 1;
+	
+	/* Is it an inline user? */
+	for (l__n = 0; l__n < l__rmap->inline_count; l__n ++)
+	{
+		if (    (l__rmap->users[l__n].pid == pid)
+		     && (l__rmap->users[l__n].u_adr == u_adr)
+		   )
+		{
+			break;
+		}
+	}
+	
+	if (l__n < l__rmap->inline_count)
+	{
+		/* Keep the order of the inline users */
+		for (; (l__n + 1) < l__rmap->inline_count; l__n ++)
+			l__rmap->users[l__n] = l__rmap->users[l__n + 1];
+			
+		l__rmap->inline_count --;
+		
+		/* Replace it by an overflow entry */
+		l__ent = l__rmap->overflow;
+		if (l__ent != NULL)
+		{
+			l__rmap->users[l__rmap->inline_count ++] = l__ent->user;
+		}
+	}
+	 else
+	{
+		l__ent = kmem_rmap_hash_find(page, pid, u_adr);
+		if (l__ent == NULL) return 1;
+	}
+	
+	/* Release the overflow entry */
+	if (l__ent != NULL)
+	{
+		kmem_rmap_hash_remove(l__ent);
+		
+		if (l__ent->prv != NULL) 
+			l__ent->prv->nxt = l__ent->nxt;
+		 else 
+			l__rmap->overflow = l__ent->nxt;
+			
+		if (l__ent->nxt != NULL) l__ent->nxt->prv = l__ent->prv;
+		
+		kmem_rmap_put_obj(l__ent);
+	}
+	
+	PAGE_BUF_TAB(page).usage --;
+	
+	/* Do we need still a reverse map? */
+	if (PAGE_BUF_TAB(page).usage == 1)
+	{
+		PAGE_BUF_TAB(page).owner.single = l__rmap->users[0];
+		kmem_rmap_put_obj(l__rmap);
+	}
+	
+	return 0;
+}
+
+/*
+ * kmem_rmap_release(page)
+ *
+ * Releases the complete reverse map of the page frame
+ * 'page' without changing its usage counter.
+ *
+ */
+void kmem_rmap_release(uintptr_t page)
+{
+	rmap_t *l__rmap = PAGE_BUF_TAB(page).owner.multi;
+	rmap_entry_t *l__ent;
+	
+	if (PAGE_BUF_TAB(page).usage < 2) return;
+	
+	while (l__rmap->overflow != NULL)
+	{
+		l__ent = l__rmap->overflow;
+		l__rmap->overflow = l__ent->nxt;
+		
+		kmem_rmap_hash_remove(l__ent);
+		kmem_rmap_put_obj(l__ent);
+	}
+	
+	kmem_rmap_put_obj(l__rmap);
+	
+	return;
+}
+
+/*
+ * kmem_rmap_rename(page, old_pid, new_pid, u_adr)
+ *
+ * Changes the owner entry of the process 'old_pid' for the
+ * page frame 'page' at address 'u_adr' to the process 'new_pid'.
+ * The usage counter of the page frame will not be changed.
+ *
+ * Return value:
+ *	0	Successful
+ *	1	Entry not found
+ *
+ */
+int kmem_rmap_rename(uintptr_t page, 
+		     sid_t old_pid, 
+		     sid_t new_pid, 
+		     uintptr_t u_adr
+		    )
+{
+	rmap_t *l__rmap;
+	rmap_entry_t *l__ent;
+	unsigned l__n;
+	
+	/* Single owner */
+	if (PAGE_BUF_TAB(page).usage == 1)
+	{
+		if (    (PAGE_BUF_TAB(page).owner.single.pid == old_pid)
+		     && (PAGE_BUF_TAB(page).owner.single.u_adr == u_adr)
+		   )
+		{
+			PAGE_BUF_TAB(page).owner.single.pid = new_pid;
+			return 0;
+		}
+		
+		return 1;
+	}
+	
+	if (PAGE_BUF_TAB(page).usage == 0) return 1;
+	
+	/* Inline user */
+	l__rmap = PAGE_BUF_TAB(page).owner.multi;
+	
+	for (l__n = 0; l__n < l__rmap->inline_count; l__n ++)
+	{
+		if (    (l__rmap->users[l__n].pid == old_pid)
+		     && (l__rmap->users[l__n].u_adr == u_adr)
+		   )
+		{
+			l__rmap->users[l__n].pid = new_pid;
+			return 0;
+		}
+	}
+	
+	/* Overflow entry, move it to its new hash bucket */
+	l__ent = kmem_rmap_hash_find(page, old_pid, u_adr);
+	if (l__ent == NULL) return 1;
+	
+	kmem_rmap_hash_remove(l__ent);
+	
+	l__ent->user.pid = new_pid;
+	l__ent->hash_nxt = RMAP_HASH(page, new_pid, u_adr);
+	RMAP_HASH(page, new_pid, u_adr) = l__ent;
+	
+	return 0;
+}
+
+/*
+ * kmem_rmap_first(page)
+ *
+ * Returns the oldest user of the page frame 'page'.
+ *
+ */
+sid_t kmem_rmap_first(uintptr_t page)
+{
+	if (PAGE_BUF_TAB(page).usage <= 1)
+		return PAGE_BUF_TAB(page).owner.single.pid;
+		
+	return PAGE_BUF_TAB(page).owner.multi->users[0].pid;
+}
@@ -22,6 +22,7 @@
 #include <sched.h>
 #include <current.h>
 #include <sysc.h>
+#include <trace.h>
 
 /* Count of threads that are ready for execution*/
 long ksched_active_threads = 0;
@@ -29,9 +30,201 @@ long ksched_active_threads = 0;
 /* Signalizes the need of a thread switch */
 long ksched_change_thread = 0;	
 
+/* The current thread gave up the CPU voluntarily */
+long ksched_yielded = 0;
+
 /* The "idle" kernel thread */
 uint32_t *ksched_idle_thread;
 
+/* Last real-time thread of the run queue (NULL if none) */
+static uint32_t *ksched_rt_last = NULL;
+
+/* Bandwidth reserved by deadline threads (in 1/65536) */
+uint32_t ksched_deadline_bandwidth = 0;
+
+/* Deadline threads waiting for their next period (NULL if none) */
+uint32_t *ksched_throttled = NULL;
+
+/* Absolute deadline of a deadline thread (in timer ticks) */
+#define KSCHED_DEADLINE(___thr)	\
+		(  (((uint64_t)(___thr)[THRTAB_DEADLINE_HIGH]) << 32) \
+		 | (___thr)[THRTAB_DEADLINE_LOW] \
+		)
+
+/* Bandwidth of a deadline thread (in 1/65536) */
+#define KSCHED_DEADLINE_BW(___thr)	\
+		(  ((___thr)[THRTAB_DEADLINE_RUNTIME] << 16) \
+		 / (___thr)[THRTAB_DEADLINE_PERIOD] \
+		)
+
+/*
+ * ksched_set_deadline(thrd, deadline)
+ *
+ * Sets the absolute deadline of the deadline thread 'thrd'.
+ *
+ */
+static inline void ksched_set_deadline(uint32_t *thrd, uint64_t deadline)
+{
+	thrd[THRTAB_DEADLINE_LOW] = (uint32_t)deadline;
+	thrd[THRTAB_DEADLINE_HIGH] = (uint32_t)(deadline >> 32);
+}
+
+/*
+ * ksched_rt_before(a, b)
+ *
+ * Tests if the real-time thread 'a' has to be executed
+ * before the real-time thread 'b'. Deadline threads are
+ * executed before FIFO and RR threads, ordered by their
+ * absolute deadline (EDF). FIFO and RR threads are ordered
+ * by their static priority (or their inherited priority).
+ *
+ * Return value:
+ *	!= 0	'a' has to be executed before 'b'
+ *	== 0	'b' has to be executed before 'a' or both are equal
+ *
+ */
+static int ksched_rt_before(uint32_t *a, uint32_t *b)
+{
+	if (a[THRTAB_SCHEDULING_CLASS] == THRSCHED_CLASS_DEADLINE)
+	{
+		if (b[THRTAB_SCHEDULING_CLASS] != THRSCHED_CLASS_DEADLINE)
+			return 1;
+			
+		return KSCHED_DEADLINE(a) < KSCHED_DEADLINE(b);
+	}
+	
+	if (b[THRTAB_SCHEDULING_CLASS] == THRSCHED_CLASS_DEADLINE)
+		return 0;
+		
+	return KSCHED_PRIORITY(a) > KSCHED_PRIORITY(b);
+}
+
+/*
+ * ksched_start_rt_thread(thrd)
+ *
+ * Adds the real-time thread 'thrd' to the run queue. The 
+ * real-time threads are kept sorted at the begin of the run 
+ * queue (between the idle thread and 'ksched_rt_last'). A 
+ * thread is added behind all threads that are executed 
+ * before it or that are equal to it. If it becomes the 
+ * first thread of the run queue, it will preempt the 
+ * current thread.
+ *
+ * A deadline thread gets a new deadline and a full budget,
+ * if its old deadline can't be kept with the rest of its
+ * budget (Constant Bandwidth Server).
+ *
+ */
+static void ksched_start_rt_thread(uint32_t *thrd)
+{
+	uint32_t *l__prev = ksched_idle_thread;
+	uint32_t *l__next = NULL;
+	uint32_t *l__last = (ksched_rt_last != NULL) 
+				? ksched_rt_last 
+				: ksched_idle_thread;
+	
+	if (thrd[THRTAB_SCHEDULING_CLASS] == THRSCHED_CLASS_DEADLINE)
+	{
+		uint64_t l__now = *kinfo_rtc_ctr;
+		uint64_t l__deadline = KSCHED_DEADLINE(thrd);
+		
+		/* budget / (deadline - now) > runtime / period ? */
+		if (    (l__deadline <= l__now)
+		     || (  ((uint64_t)thrd[THRTAB_DEADLINE_BUDGET]) 
+		         * thrd[THRTAB_DEADLINE_PERIOD]
+		         > (l__deadline - l__now) 
+		         * thrd[THRTAB_DEADLINE_RUNTIME]
+		        )
+		   )
+		{
+			ksched_set_deadline(thrd, l__now + thrd[THRTAB_DEADLINE_PERIOD]);
+			thrd[THRTAB_DEADLINE_BUDGET] = thrd[THRTAB_DEADLINE_RUNTIME];
+		}
+	}
+	
+	/* The time slice of RR threads */
+	if (thrd[THRTAB_EFFECTIVE_PRIORITY] == 0)
+		thrd[THRTAB_EFFECTIVE_PRIORITY] = KSCHED_PRIORITY(thrd) * 2;
+	
+	/* Search the position within the real-time threads */
+	while (    ((l__next = (void*)(uintptr_t)l__prev[THRTAB_RUNQUEUE_NEXT]) != NULL)
+		&& (KSCHED_IS_RT(l__next))
+		&& (!ksched_rt_before(thrd, l__next))
+	      )
+	{
+		l__prev = l__next;
+	}
+	
+	thrd[THRTAB_RUNQUEUE_PREV] = (uintptr_t)l__prev;
+	thrd[THRTAB_RUNQUEUE_NEXT] = l__prev[THRTAB_RUNQUEUE_NEXT];
+	
+	l__prev[THRTAB_RUNQUEUE_NEXT] = (uintptr_t)thrd;
+	if (l__next != NULL)
+		l__next[THRTAB_RUNQUEUE_PREV] = (uintptr_t)thrd;
+	
+	if (l__prev == l__last)
+		ksched_rt_last = thrd;
+	
+	/* Preempt the current thread, if we are the first thread now */
+	if (    (l__prev == ksched_idle_thread)
+	     && (thrd != current_t)
+	   )
+	{
+		ksched_change_thread = true;
+	}
+	
+	return;
+}
+
+/*
+ * ksched_requeue_thread(thrd)
+ *
+ * Removes the thread 'thrd' from the run queue and adds
+ * it again, if it is active. This is needed after changing
+ * its scheduling class or its deadline, or to move a RR 
+ * thread behind the other threads of its priority.
+ *
+ */
+void ksched_requeue_thread(uint32_t *thrd)
+{
+	if (    (thrd[THRTAB_RUNQUEUE_PREV] == NULL)
+	     && (thrd[THRTAB_RUNQUEUE_NEXT] == NULL)
+	   )
+	{
+		return;
+	}
+	
+	ksched_stop_thread(thrd);
+	ksched_start_thread(thrd);
+	
+	if (thrd == current_t) ksched_change_thread = true;
+	
+	return;
+}
+
+/*
+ * ksched_account_wakeup(thrd)
+ *
+ * Counts the insertion of 'thrd' into the run queue and
+ * starts the measurement of its wait time.
+ *
+ */
+static inline void ksched_account_wakeup(uint32_t *thrd)
+{
+	uint64_t l__now;
+	
+	thrd[THRTAB_WAKEUPS] ++;
+	KTRACE(TRACE_CAT_SCHED, TRACE_WAKEUP, thrd[THRTAB_SID], 0, 0, 0);
+	
+	if ((!i386_do_tsc) || (thrd == current_t)) return;
+	
+	RDTSC(l__now);
+	thrd[THRTAB_X86_ACCOUNT_TSC_LOW] = (uint32_t)l__now;
+	thrd[THRTAB_X86_ACCOUNT_TSC_HIGH] = (uint32_t)(l__now >> 32);
+	
+	return;
+}
+
 /*
  * ksched_start_thread(thrd)
  *
@@ -64,6 +257,22 @@ int ksched_start_thread(uint32_t *thrd)
 	if (thrd[THRTAB_FREEZE_COUNTER])
 		return 0;
 	
+	/* ... or a deadline thread before its next period */
+	if (thrd[THRTAB_THRSTAT_FLAGS] & THRSTAT_THROTTLED)
+		return 0;
+	
+	/* Real-time threads are sorted into the begin of the run queue */
+	if (KSCHED_IS_RT(thrd))
+	{
+		ksched_start_rt_thread(thrd);
+		ksched_account_wakeup(thrd);
+		
+		ksched_active_threads ++;
+		thrd[THRTAB_THRSTAT_FLAGS] &= (~THRSTAT_BUSY);
+		
+		return 0;
+	}
+	
 	/*
 	 * The effective priority consists of 
 	 * a quarter of the unused effective 
@@ -74,7 +283,7 @@ int ksched_start_thread(uint32_t *thrd)
 	thrd[THRTAB_EFFECTIVE_PRIORITY] = 
 		(
 		    (thrd[THRTAB_EFFECTIVE_PRIORITY] / 4)
-		  + thrd[THRTAB_STATIC_PRIORITY]
+		  + KSCHED_PRIORITY(thrd)
 		);
 	
 	/* Recalculate it to clock ticks */
@@ -86,14 +295,16 @@ int ksched_start_thread(uint32_t *thrd)
 	 * thread the current thread will be preempted and the new
 	 * thread will be executed.
 	 *
-	 * If the current thread is the 'idle thread' however
-	 * this operation won't be executed.
+	 * If the current thread is the 'idle thread' or a real-time
+	 * thread however this operation won't be executed.
 	 *
 	 */
 	if (    (    thrd[THRTAB_EFFECTIVE_PRIORITY] 
 		  >= l__current_t[THRTAB_EFFECTIVE_PRIORITY]
 		) 
      	     && (l__current_t != ksched_idle_thread)
+     	     && (l__current_t != thrd)
+     	     && (!KSCHED_IS_RT(l__current_t))
    	   )
 	{
 		/*
@@ -122,14 +333,18 @@ int ksched_start_thread(uint32_t *thrd)
 		 * If not, the new thread will be executed after all
 		 * other threads of the run queue were executed. So
 		 * we put it into the runqueue after the entry of the
-		 * idle thread
+		 * idle thread (resp. after the last real-time thread)
 		 *
 		 */
+		uint32_t *l__last = (ksched_rt_last != NULL) 
+					? ksched_rt_last 
+					: ksched_idle_thread;
+		
 		thrd[THRTAB_RUNQUEUE_NEXT] =
-			(uintptr_t)ksched_idle_thread[THRTAB_RUNQUEUE_NEXT];
+			(uintptr_t)l__last[THRTAB_RUNQUEUE_NEXT];
 		thrd[THRTAB_RUNQUEUE_PREV] = 
-			(uintptr_t)ksched_idle_thread;
-		ksched_idle_thread[THRTAB_RUNQUEUE_NEXT] = 
+			(uintptr_t)l__last;
+		l__last[THRTAB_RUNQUEUE_NEXT] = 
 			(uintptr_t)thrd;
 		
 		if (thrd[THRTAB_RUNQUEUE_NEXT] != (uintptr_t)NULL) 
@@ -141,6 +356,8 @@ int ksched_start_thread(uint32_t *thrd)
 	}	
 
 	ksched_active_threads ++;
+	ksched_account_wakeup(thrd);
+	
 	/*
 	 * We remove the THRSTAT_BUSY flag here. However
 	 * the flag that described the reason of the blocking
@@ -153,6 +370,76 @@ int ksched_start_thread(uint32_t *thrd)
 	return 0;
 }
 
+/*
+ * ksched_start_thread_direct(thrd)
+ *
+ * Starts the thread 'thrd' like ksched_start_thread, but
+ * lets it always preempt the current thread (even the idle 
+ * thread) without comparing the effective priorities. The
+ * thread is linked behind the current thread, so it will
+ * get the CPU at the next call of ksched_next_thread.
+ *
+ * This is the fast path for IRQ handler threads.
+ *
+ * Return value:
+ *	== 0	Successful
+ *	!= 0	Error
+ *
+ */
+int ksched_start_thread_direct(uint32_t *thrd)
+{
+	/* 
+	 * Is the thread already active or the current thread? Are 
+	 * real-time threads involved?
+	 *
+	 */
+	if (    (thrd[THRTAB_RUNQUEUE_PREV] != NULL)
+	     || (thrd[THRTAB_RUNQUEUE_NEXT] != NULL)
+	     || (thrd == current_t)
+	     || (KSCHED_IS_RT(thrd))
+	     || (KSCHED_IS_RT(current_t))
+	   )
+	{
+		return ksched_start_thread(thrd);
+	}
+	
+	/* Never start a defunced or freezed thread */
+	if (    (thrd[THRTAB_THRSTAT_FLAGS] & THRSTAT_PROC_DEFUNC)
+	     || (thrd[THRTAB_FREEZE_COUNTER])
+	   )
+	{
+		return 0;
+	}
+	
+	/* Calculate the effective priority (see ksched_start_thread) */
+	thrd[THRTAB_EFFECTIVE_PRIORITY] = 
+		(
+		    (thrd[THRTAB_EFFECTIVE_PRIORITY] / 4)
+		  + KSCHED_PRIORITY(thrd)
+		) * 2;
+	
+	/* Link it behind the current thread */
+	thrd[THRTAB_RUNQUEUE_PREV] = (uintptr_t)current_t;
+	thrd[THRTAB_RUNQUEUE_NEXT] = current_t[THRTAB_RUNQUEUE_NEXT];
+		
+	current_t[THRTAB_RUNQUEUE_NEXT] = (uintptr_t)thrd;
+	if (thrd[THRTAB_RUNQUEUE_NEXT] != (uintptr_t)NULL)
+	{
+		uint32_t *l__thrd_next = (void*)(uintptr_t)thrd[THRTAB_RUNQUEUE_NEXT];
+		
+		l__thrd_next[THRTAB_RUNQUEUE_PREV] = (uintptr_t)thrd;			
+	}
+	
+	ksched_active_threads ++;
+	ksched_account_wakeup(thrd);
+	thrd[THRTAB_THRSTAT_FLAGS] &= (~THRSTAT_BUSY);
+	
+	/* Change threads after leaving the kernel mode */
+	ksched_change_thread = true;
+	
+	return 0;
+}
+
 /*
  * ksched_stop_thread(thrd)
  *
@@ -171,6 +458,13 @@ int ksched_start_thread(uint32_t *thrd)
  */ 
 int ksched_stop_thread(uint32_t *thrd)
 {
+	/* Was it the last real-time thread? */
+	if (thrd == ksched_rt_last)
+	{
+		ksched_rt_last = (void*)(uintptr_t)thrd[THRTAB_RUNQUEUE_PREV];
+		if (ksched_rt_last == ksched_idle_thread) ksched_rt_last = NULL;
+	}
+	
 	/* Remove the thread from the run queue */
 	if (thrd[THRTAB_RUNQUEUE_PREV] != (uintptr_t)NULL) 
 	{
@@ -204,6 +498,184 @@ int ksched_stop_thread(uint32_t *thrd)
 	return 0;
 }
 
+/*
+ * ksched_rt_tick()
+ *
+ * Is called by the timer IRQ instead of the reduction of
+ * the effective priority, if the current thread is a 
+ * real-time thread:
+ *
+ *	FIFO		Runs until it blocks or yields
+ *	RR		Is moved behind the other RR threads of 
+ *			its priority after its time slice 
+ *			(static priority * 2 ticks)
+ *	DEADLINE	Is throttled until its deadline, if its
+ *			budget is consumed. It gets a new budget
+ *			and a deadline one period later afterwards
+ *			(see ksched_rt_replenish).
+ *
+ */
+void ksched_rt_tick(void)
+{
+	switch (current_t[THRTAB_SCHEDULING_CLASS])
+	{
+		case (THRSCHED_CLASS_RR):
+		{
+			if (current_t[THRTAB_EFFECTIVE_PRIORITY] > 1)
+			{
+				current_t[THRTAB_EFFECTIVE_PRIORITY] --;
+				break;
+			}
+			
+			current_t[THRTAB_EFFECTIVE_PRIORITY] = 0;
+			ksched_requeue_thread(current_t);
+			break;
+		}
+		
+		case (THRSCHED_CLASS_DEADLINE):
+		{
+			if (current_t[THRTAB_DEADLINE_BUDGET] > 1)
+			{
+				current_t[THRTAB_DEADLINE_BUDGET] --;
+				break;
+			}
+			
+			/* The period is already over, just start a new one */
+			if (KSCHED_DEADLINE(current_t) <= *kinfo_rtc_ctr)
+			{
+				ksched_set_deadline(current_t, 
+						      *kinfo_rtc_ctr 
+						    + current_t[THRTAB_DEADLINE_PERIOD]
+						   );
+				current_t[THRTAB_DEADLINE_BUDGET] = 
+					current_t[THRTAB_DEADLINE_RUNTIME];
+				
+				ksched_requeue_thread(current_t);
+				break;
+			}
+			
+			/* Throttle it until its deadline */
+			current_t[THRTAB_DEADLINE_BUDGET] = 0;
+			current_t[THRTAB_THROTTLE_COUNT] ++;
+			ksched_stop_thread(current_t);
+			
+			current_t[THRTAB_THRSTAT_FLAGS] |= THRSTAT_THROTTLED;
+			current_t[THRTAB_THROTTLE_NEXT] = (uintptr_t)ksched_throttled;
+			ksched_throttled = current_t;
+			
+			ksched_change_thread = true;
+			break;
+		}
+		
+		default:
+			break;
+	}
+	
+	return;
+}
+
+/*
+ * ksched_rt_unthrottle(thrd)
+ *
+ * Removes the deadline thread 'thrd' from the list of
+ * throttled threads, if it is part of it. The thread won't 
+ * be started. This is the object of the calling function.
+ *
+ * Return value:
+ *	1	The thread was throttled
+ *	0	The thread wasn't throttled
+ *
+ */
+static int ksched_rt_unthrottle(uint32_t *thrd)
+{
+	uint32_t **l__ptr = &ksched_throttled;
+	
+	if (!(thrd[THRTAB_THRSTAT_FLAGS] & THRSTAT_THROTTLED))
+		return 0;
+	
+	while (*l__ptr != NULL)
+	{
+		if (*l__ptr == thrd)
+		{
+			*l__ptr = (void*)(uintptr_t)thrd[THRTAB_THROTTLE_NEXT];
+			break;
+		}
+		
+		l__ptr = (void*)&((*l__ptr)[THRTAB_THROTTLE_NEXT]);
+	}
+	
+	thrd[THRTAB_THROTTLE_NEXT] = (uintptr_t)NULL;
+	thrd[THRTAB_THRSTAT_FLAGS] &= (~THRSTAT_THROTTLED);
+	
+	return 1;
+}
+
+/*
+ * ksched_rt_replenish()
+ *
+ * Is called by the timer IRQ, if there are throttled deadline
+ * threads. Every thread whose deadline has been reached gets a
+ * new budget and a deadline one period later and is put back 
+ * into the run queue (if it isn't freezed).
+ *
+ */
+void ksched_rt_replenish(void)
+{
+	uint32_t *l__thrd = ksched_throttled;
+	
+	while (l__thrd != NULL)
+	{
+		uint32_t *l__next = (void*)(uintptr_t)l__thrd[THRTAB_THROTTLE_NEXT];
+		
+		if (KSCHED_DEADLINE(l__thrd) <= *kinfo_rtc_ctr)
+		{
+			ksched_rt_unthrottle(l__thrd);
+			
+			ksched_set_deadline(l__thrd, 
+					      KSCHED_DEADLINE(l__thrd) 
+					    + l__thrd[THRTAB_DEADLINE_PERIOD]
+					   );
+			l__thrd[THRTAB_DEADLINE_BUDGET] = 
+				l__thrd[THRTAB_DEADLINE_RUNTIME];
+			
+			ksched_start_thread(l__thrd);
+		}
+		
+		l__thrd = l__next;
+	}
+	
+	return;
+}
+
+/*
+ * ksched_release_deadline(thrd)
+ *
+ * Releases the bandwidth reserved by the thread 'thrd', if
+ * it is a deadline thread, and moves it to the normal 
+ * scheduling class. The thread won't be moved within the
+ * run queue. This is the object of the calling function.
+ * The same applies to a throttled thread, which has to be
+ * started again by the caller.
+ *
+ * Return value:
+ *	1	The thread was throttled
+ *	0	The thread wasn't throttled
+ *
+ */
+int ksched_release_deadline(uint32_t *thrd)
+{
+	if (thrd[THRTAB_SCHEDULING_CLASS] != THRSCHED_CLASS_DEADLINE)
+		return 0;
+		
+	ksched_deadline_bandwidth -= KSCHED_DEADLINE_BW(thrd);
+	main_info[MAININFO_DEADLINE_BANDWIDTH] = ksched_deadline_bandwidth;
+	
+	thrd[THRTAB_SCHEDULING_CLASS] = THRSCHED_CLASS_NORMAL;
+	thrd[THRTAB_EFFECTIVE_PRIORITY] = 0;
+	
+	return ksched_rt_unthrottle(thrd);
+}
+
 /*
  * sysc_set_priority(thrd, priority, policy)
  *
@@ -212,7 +684,13 @@ int ksched_stop_thread(uint32_t *thrd)
  * Changes the priority and the scheduling policy of
  * a thread. If the thread isn't part of a root process
  * it may only reduce its priority or scheduling policy
- * value. 
+ * value. The real-time classes (RR and FIFO) may only be
+ * selected by root processes (the caller has to be root 
+ * as well as the process of the thread). THRSCHED_CLASS_DEADLINE can
+ * only be selected by set_deadline.
+ *
+ * The static priority of a real-time thread is its
+ * real-time priority.
  *
  * Parameters:
  *	thrd		SID of the affected thread
@@ -242,6 +720,7 @@ void sysc_set_priority(sid_t thrd, unsigned priority, unsigned policy)
 	{
 		if (    (THREAD(thrd, THRTAB_STATIC_PRIORITY) < priority)
 		     || (THREAD(thrd, THRTAB_SCHEDULING_CLASS) < policy)
+		     || (policy != THRSCHED_CLASS_NORMAL)
 		   )
 		{
 			SET_ERROR(ERR_ACCESS_DENIED);
@@ -249,9 +728,23 @@ void sysc_set_priority(sid_t thrd, unsigned priority, unsigned policy)
 		}
 	}   
 	
+	/* Only root processes may select a real-time class */
+	if (    (    (policy == THRSCHED_CLASS_RR)
+	          || (policy == THRSCHED_CLASS_FIFO)
+	        )
+	     && (!current_p[PRCTAB_IS_ROOT])
+	   )
+	{
+		SET_ERROR(ERR_ACCESS_DENIED);
+		return;
+	}
+	
 	/* Is the wanted priority or scheduling class valid? */		   
 	if (    (priority > SCHED_PRIORITY_MAX)
 	     || (policy > SCHED_CLASS_MAX)
+	     || (    (policy == THRSCHED_CLASS_DEADLINE)
+	          && (THREAD(thrd, THRTAB_SCHEDULING_CLASS) != THRSCHED_CLASS_DEADLINE)
+	        )
 	   )
 	{
 		SET_ERROR(ERR_INVALID_ARGUMENT);
@@ -260,7 +753,136 @@ void sysc_set_priority(sid_t thrd, unsigned priority, unsigned policy)
 	
 	/* Change the priority */
 	THREAD(thrd, THRTAB_STATIC_PRIORITY) = priority;
-	THREAD(thrd, THRTAB_SCHEDULING_CLASS) = policy;
+	
+	/* Change the scheduling class */
+	if (THREAD(thrd, THRTAB_SCHEDULING_CLASS) != policy)
+	{
+		int l__throttled = ksched_release_deadline(&THREAD(thrd, 0));
+		
+		THREAD(thrd, THRTAB_SCHEDULING_CLASS) = policy;
+		THREAD(thrd, THRTAB_EFFECTIVE_PRIORITY) = 0;
+		
+		ksched_requeue_thread(&THREAD(thrd, 0));
+		if (l__throttled) ksched_start_thread(&THREAD(thrd, 0));
+	}
+	 else if (KSCHED_IS_RT(&THREAD(thrd, 0)))
+	{
+		/* The position within the real-time threads may change */
+		ksched_requeue_thread(&THREAD(thrd, 0));
+	}
+	
+	/* Update the priority of the thread we are waiting for */
+	ksync_priority_changed(&THREAD(thrd, 0));
+	
+	KSCHED_TRY_RESCHED();
+	
+	return;
+}
+
+/*
+ * sysc_set_deadline(thrd, runtime, period)
+ *
+ * (Implementation of the "set_deadline" system call)
+ *
+ * Moves a thread to the deadline scheduling class. The
+ * thread may run 'runtime' timer ticks within each period
+ * of 'period' ticks. Deadline threads are executed before 
+ * all other threads, ordered by their deadline (EDF). If
+ * a thread consumed its runtime, it is throttled until its
+ * deadline, which is postponed by one period afterwards (CBS).
+ *
+ * The new thread is only admitted, if the bandwidth of all
+ * deadline threads stays below SCHED_DEADLINE_MAX_BANDWIDTH.
+ * The period may not be longer than SCHED_DEADLINE_MAX_PERIOD.
+ * If 'runtime' is 0, the thread returns to the normal
+ * scheduling class. Only root processes may use this system
+ * call.
+ *
+ * Parameters:
+ *	thrd		SID of the affected thread
+ *	runtime		Runtime per period (ticks)
+ *	period		Length of the period (ticks)
+ *
+ */
+void sysc_set_deadline(sid_t thrd, unsigned runtime, unsigned period)
+{
+	uint32_t *l__thrd;
+	uint32_t l__bw = 0;
+	uint32_t l__old_bw = 0;
+	
+	if (!current_p[PRCTAB_IS_ROOT])
+	{
+		SET_ERROR(ERR_ACCESS_DENIED);
+		return;
+	}
+	
+	/* Invalid or null for current thread */
+	if ((thrd == SID_PLACEHOLDER_INVALID) || (thrd == SID_PLACEHOLDER_NULL))
+	{
+		thrd = current_t[THRTAB_SID];
+	}
+	
+	if (!kinfo_isthrd(thrd))
+	{
+		SET_ERROR(ERR_INVALID_SID);
+		return;
+	}
+	
+	l__thrd = &THREAD(thrd, 0);
+	
+	/* Leave the deadline class */
+	if (runtime == 0)
+	{
+		if (l__thrd[THRTAB_SCHEDULING_CLASS] == THRSCHED_CLASS_DEADLINE)
+		{
+			if (ksched_release_deadline(l__thrd))
+				ksched_start_thread(l__thrd);
+				
+			ksched_requeue_thread(l__thrd);
+			KSCHED_TRY_RESCHED();
+		}
+		
+		return;
+	}
+	
+	if ((period == 0) || (period > SCHED_DEADLINE_MAX_PERIOD) || (runtime > period))
+	{
+		SET_ERROR(ERR_INVALID_ARGUMENT);
+		return;
+	}
+	
+	/* Admission control */
+	l__bw = (runtime << 16) / period;
+	
+	if (l__thrd[THRTAB_SCHEDULING_CLASS] == THRSCHED_CLASS_DEADLINE)
+		l__old_bw = KSCHED_DEADLINE_BW(l__thrd);
+	
+	if (    (ksched_deadline_bandwidth - l__old_bw + l__bw) 
+	      > SCHED_DEADLINE_MAX_BANDWIDTH
+	   )
+	{
+		SET_ERROR(ERR_RESOURCE_BUSY);
+		return;
+	}
+	
+	ksched_deadline_bandwidth = ksched_deadline_bandwidth - l__old_bw + l__bw;
+	main_info[MAININFO_DEADLINE_BANDWIDTH] = ksched_deadline_bandwidth;
+	
+	/* Set the parameters and a new deadline */
+	l__thrd[THRTAB_SCHEDULING_CLASS] = THRSCHED_CLASS_DEADLINE;
+	l__thrd[THRTAB_DEADLINE_RUNTIME] = runtime;
+	l__thrd[THRTAB_DEADLINE_PERIOD] = period;
+	l__thrd[THRTAB_DEADLINE_BUDGET] = runtime;
+	ksched_set_deadline(l__thrd, *kinfo_rtc_ctr + period);
+	
+	/* A throttled thread may run again with its new budget */
+	if (ksched_rt_unthrottle(l__thrd))
+		ksched_start_thread(l__thrd);
+	 else
+		ksched_requeue_thread(l__thrd);
+		
+	ksync_priority_changed(l__thrd);
+	KSCHED_TRY_RESCHED();
 	
 	return;
 }
@@ -455,6 +1077,10 @@ void sysc_yield_thread(sid_t subj)
 
 	/* The current thread loses its effective priority */	
 	current_t[THRTAB_EFFECTIVE_PRIORITY] = 0;	
+	ksched_yielded = 1;
+	
+	/* A real-time thread goes behind the threads of its priority */
+	if (KSCHED_IS_RT(current_t)) ksched_requeue_thread(current_t);
 		
 	/* Yield the current thread */
 	ksched_change_thread = true;
@@ -476,6 +1102,21 @@ void ksched_idle_loop(void)
 	{
 		/* Reduce our effective priority to 0 */
 		current_t[THRTAB_EFFECTIVE_PRIORITY] = 0;
+		
+		/* 
+		 * Reclaim the memory of defunct processes step
+		 * by step. IRQs are only handled between two steps.
+		 *
+		 */
+		if (ksubj_reclaim_pending)
+		{
+			__asm__ __volatile__("CLI\n");
+			ksubj_reclaim(MEM_RECLAIM_CHUNK);
+			__asm__ __volatile__("STI\n");
+			
+			continue;
+		}
+		
 		/* 
 		 * Activate IRQs and sleep until 
 		 * new IRQs are arriving
@@ -76,6 +76,10 @@ void sysc_chg_root(sid_t proc, int op)
 							      | IO_ALLOW_PORTS
 							  ));
 	}
+	
+	/* Reload the I/O permission bitmap */
+	if (&PROCESS(proc, 0) == current_p)
+		kio_load_iomap();
 						   
 	return;
 }
@@ -28,6 +28,11 @@
 uint32_t ksubj_next_unique_process_id = 0;
 uint32_t ksubj_next_unique_thread_id = 0;
 
+/* Defunct processes waiting for the reclamation of their page frames */
+static uint32_t *ksubj_reclaim_begin = NULL;
+static uint32_t *ksubj_reclaim_end = NULL;
+unsigned long ksubj_reclaim_pending = 0;
+
 void ksync_interrupt_other(uint32_t *other);
 void ksync_removefrom_waitqueue_error(uint32_t *other, uint32_t *me);
 
@@ -59,6 +64,7 @@ static inline sid_t ksubj_create_thread(uintptr_t eip, uintptr_t esp)
 	sid_t l__retval = 0;
 	void* l__kstack = NULL;
 	void* l__dadr = NULL;
+	unsigned l__n;
 	
 	/* Search an unused SID */
 	l__descr = thread_tab;
@@ -121,6 +127,25 @@ static inline sid_t ksubj_create_thread(uintptr_t eip, uintptr_t esp)
 	l__descr[THRTAB_STATIC_PRIORITY] = current_t[THRTAB_STATIC_PRIORITY];
 	l__descr[THRTAB_SCHEDULING_CLASS] = current_t[THRTAB_SCHEDULING_CLASS];
 	
+	/* ...but the bandwidth of a deadline thread is not inherited */
+	if (l__descr[THRTAB_SCHEDULING_CLASS] == THRSCHED_CLASS_DEADLINE)
+		l__descr[THRTAB_SCHEDULING_CLASS] = THRSCHED_CLASS_NORMAL;
+		
+	l__descr[THRTAB_DEADLINE_RUNTIME] = 0;
+	l__descr[THRTAB_DEADLINE_PERIOD] = 0;
+	l__descr[THRTAB_DEADLINE_BUDGET] = 0;
+	l__descr[THRTAB_DEADLINE_LOW] = 0;
+	l__descr[THRTAB_DEADLINE_HIGH] = 0;
+	l__descr[THRTAB_INHERITED_PRIORITY] = 0;
+	l__descr[THRTAB_INHERITED_CLASS] = THRSCHED_CLASS_NORMAL;
+	
+	/* No statistics */
+	for (l__n = THRTAB_CPU_TIME_LOW; l__n <= THRTAB_IRQ_COUNT; l__n ++)
+		l__descr[l__n] = 0;
+		
+	l__descr[THRTAB_X86_ACCOUNT_TSC_LOW] = 0;
+	l__descr[THRTAB_X86_ACCOUNT_TSC_HIGH] = 0;
+	
 	l__descr[THRTAB_CUR_SYNC_QUEUE_PREV] = (uintptr_t)NULL;
 	l__descr[THRTAB_CUR_SYNC_QUEUE_NEXT] = (uintptr_t)NULL;
 	l__descr[THRTAB_OWN_SYNC_QUEUE_BEGIN] = (uintptr_t)NULL;
@@ -132,6 +157,13 @@ static inline sid_t ksubj_create_thread(uintptr_t eip, uintptr_t esp)
 	l__descr[THRTAB_TIMEOUT_HIGH] = 0;
 	l__descr[THRTAB_TIMEOUT_QUEUE_NEXT] = (uintptr_t)NULL;
 	l__descr[THRTAB_TIMEOUT_QUEUE_PREV] = (uintptr_t)NULL;
+	
+	/* Not part of the PageD fault queue */
+	l__descr[THRTAB_PAGED_QUEUE_PREV] = (uintptr_t)NULL;
+	l__descr[THRTAB_PAGED_QUEUE_NEXT] = (uintptr_t)NULL;
+	
+	/* No interrupted memory operation */
+	l__descr[THRTAB_MEMOP_RESTART_OP] = 0;
 		
 	/* Set the address of the TLS */
 	l__descr[THRTAB_X86_TLS_PHYS_ADDRESS] = ((uintptr_t)l__dadr);
@@ -318,6 +350,14 @@ sid_t sysc_create_process(uintptr_t eip, uintptr_t esp)
 	l__descr[PRCTAB_IS_ROOT] = current_p[PRCTAB_IS_ROOT];
 	l__descr[PRCTAB_THREAD_COUNT] = 1;
 	l__descr[PRCTAB_THREAD_LIST_BEGIN] = (uintptr_t)&THREAD(l__thread, 0);
+	l__descr[PRCTAB_RECLAIM_NEXT] = (uintptr_t)NULL;
+	l__descr[PRCTAB_RECLAIM_TABLE] = 0;
+	l__descr[PRCTAB_IO_BITMAP_LOW] = (uintptr_t)NULL;
+	l__descr[PRCTAB_IO_BITMAP_HIGH] = (uintptr_t)NULL;
+	l__descr[PRCTAB_IO_BITMAP_SIZE] = 0;
+	l__descr[PRCTAB_CPU_TIME_LOW] = 0;
+	l__descr[PRCTAB_CPU_TIME_HIGH] = 0;
+	l__descr[PRCTAB_CPU_TICKS] = 0;
 	
 	/* Set the time of creation */
 	l__descr[PRCTAB_UNIQUE_ID] = ksubj_next_unique_process_id ++;		
@@ -364,42 +404,113 @@ void sysc_set_controller(sid_t sid)
 	return;
 }
 
+/*
+ * ksubj_reclaim(tables)
+ *
+ * Reclaims the page frames of up to 'tables' page tables of
+ * the defunct processes waiting within the reclamation queue.
+ * If all page tables of a process have been released, its
+ * page directory and its descriptor will be destroyed. 
+ *
+ * The function returns after each step of 'tables' page
+ * tables, so that a large address space can be reclaimed
+ * in several steps (e.g. by the idle thread, which is 
+ * interruptible between two steps).
+ *
+ * Parameters:
+ *	tables	Max. number of page tables to reclaim
+ *
+ * Return value:
+ *	1	There are still defunct processes to reclaim
+ *	0	Reclamation queue empty
+ *
+ */
+int ksubj_reclaim(unsigned long tables)
+{
+	while (ksubj_reclaim_begin != NULL)
+	{
+		uint32_t *l__proc = ksubj_reclaim_begin;
+		uint32_t *l__pdir = (void*)(uintptr_t)
+				l__proc[PRCTAB_PAGEDIR_PHYSICAL_ADDR];
+		
+		/* Free the page frames of its page tables */
+		while (l__proc[PRCTAB_RECLAIM_TABLE] < (VAS_KERNEL_START / (4096 * 1024)))
+		{
+			unsigned long l__n = l__proc[PRCTAB_RECLAIM_TABLE];
+			
+			if (l__pdir[l__n] & GENFLAG_PRESENT)
+			{
+				/* Preemption point */
+				if (tables == 0) return 1;
+				tables --;
+			
+				main_info[MAININFO_RECLAIMED_PAGES] += 
+					kmem_reclaim_table(l__pdir, 
+							   l__proc[PRCTAB_SID], 
+							   l__n
+							  );
+			}
+			
+			l__proc[PRCTAB_RECLAIM_TABLE] ++;
+		}
+		
+		/* Remove it from the queue */
+		ksubj_reclaim_begin = (void*)(uintptr_t)l__proc[PRCTAB_RECLAIM_NEXT];
+		if (ksubj_reclaim_begin == NULL) ksubj_reclaim_end = NULL;
+		
+		ksubj_reclaim_pending --;
+		main_info[MAININFO_RECLAIM_PENDING] = ksubj_reclaim_pending;
+		
+		/* Free the page directory */
+		kmem_destroy_space(l__pdir);
+	
+		/* Free its I/O permission bitmap */
+		kio_free_iomap(l__proc);
+		
+		/* Destroy the process descriptor */
+		kinfo_del_descr(l__proc[PRCTAB_SID]);
+	}
+	
+	return 0;
+}
+
 /*
  * ksubj_kill_proc(proc);
  *
  * Destroys the process 'proc', by
- *	- Freeing its page tables
+ *	- Freeing its page frames
+ *	- Freeing its page tables (or leaving shared ones)
  *	- Freeing its page directory
  *	- Destroying its descriptor
  *
+ * The process will be added to the reclamation queue and
+ * the first MEM_RECLAIM_CHUNK page tables of the queue are 
+ * reclaimed immediately. The rest will be done by the idle 
+ * thread or if the page buffer runs out of memory 
+ * (see ksubj_reclaim).
+ *
  * Parameters:
  *	proc	Pointer to the process descriptor
  *
  */
 static void ksubj_kill_proc(uint32_t *proc)
 {
-	unsigned l__i = 1024;
-	uint32_t *l__pdir = (void*)(uintptr_t)
-				proc[PRCTAB_PAGEDIR_PHYSICAL_ADDR];	
+	proc[PRCTAB_IS_DEFUNCT] = 1;
+	proc[PRCTAB_RECLAIM_NEXT] = (uintptr_t)NULL;
+	proc[PRCTAB_RECLAIM_TABLE] = 0;
 	
-	/* Search existing page tables within the page directory */
-	while (l__i --)
-	{
-		if (l__pdir[l__i] & GENFLAG_PRESENT)
-		{
-			void *l__ptab = (void*)(uintptr_t)
-					(l__pdir[l__i] & (~0xFFFu));
+	/* Append it to the reclamation queue */
+	if (ksubj_reclaim_end != NULL)
+		ksubj_reclaim_end[PRCTAB_RECLAIM_NEXT] = (uintptr_t)proc;
+	else
+		ksubj_reclaim_begin = proc;
 		
-			kmem_free_kernel_pageframe(l__ptab);
-			l__pdir[l__i] = 0;
-		}
-	}
-
-	/* Free the page directory */
-	kmem_destroy_space(l__pdir);
+	ksubj_reclaim_end = proc;
+	
+	ksubj_reclaim_pending ++;
+	main_info[MAININFO_RECLAIM_PENDING] = ksubj_reclaim_pending;
 	
-	/* Destroy the process descriptor */
-	kinfo_del_descr(proc[PRCTAB_SID]);
+	ksubj_reclaim(MEM_RECLAIM_CHUNK);
 	
 	return;
 }
@@ -430,17 +541,16 @@ static void ksubj_kill_proc(uint32_t *proc)
  * for ever by setting PRCTAB_IS_DEFUNCT to 1. The process
  * self will be only destroyed if its last thread was
  * destroyed. 
- * During the destruction of a process, only its page
- * directories and page tables would be freed. It is the
- * object of the user level to free the page frames of the
- * process first.
+ * During the destruction of a process, the kernel will
+ * free its page frames, page tables and page directory.
+ * Large address spaces are reclaimed in several steps
+ * (see ksubj_reclaim), so the SID of the process stays
+ * in use until the reclamation is finished.
  * To prevent the locking of too much memory, a process
  * could be only set into the Defunct state by a root
  * process. Even also its last thread could be only
  * killed by a root process, because a thread couldn't
- * kill itself. So a process manager e.g. can initialize
- * the freeing of a process' page frames using the paging
- * daemon.
+ * kill itself.
  *
  * Parameters:
  *	sid	SID of the affected subject
@@ -492,6 +602,7 @@ void sysc_destroy_subject(sid_t sid)
 		while (l__thread != NULL)
 		{
 			ksched_stop_thread(l__thread);
+			ksched_release_deadline(l__thread);
 			l__thread[THRTAB_THRSTAT_FLAGS] 
 			                 |= THRSTAT_PROC_DEFUNC;	
 	
@@ -541,6 +652,7 @@ void sysc_destroy_subject(sid_t sid)
 
 		/* At first, remove it from the runqueue */
 		ksched_stop_thread(l__thread);
+		ksched_release_deadline(l__thread);
 		
 		/* Then remove it from the process thread list */
 		if (l__thread[THRTAB_NEXT_THREAD_OF_PROC])
@@ -596,6 +708,12 @@ void sysc_destroy_subject(sid_t sid)
 		/* Is the killed thread part of a wait queue? */
 		if (    (l__thread[THRTAB_CUR_SYNC_QUEUE_NEXT] != 0)
 		     || (l__thread[THRTAB_CUR_SYNC_QUEUE_PREV] != 0)
+		     || (    (l__thread[THRTAB_THRSTAT_FLAGS] & THRSTAT_SYNC)
+		          && (kinfo_isthrd(l__thread[THRTAB_SYNC_SID]))
+		          && (   THREAD(l__thread[THRTAB_SYNC_SID], THRTAB_OWN_SYNC_QUEUE_BEGIN)
+		              == (uintptr_t)l__thread
+		             )
+		        )
 		   )
 		{
 			ksync_removefrom_waitqueue_error(
@@ -632,25 +750,31 @@ void sysc_destroy_subject(sid_t sid)
 			  &THREAD(l__thread[THRTAB_SOFTINT_LISTENER_SID], 0);
 
 			l__waitthr[THRTAB_RECEIVED_SOFTINT] = 0xFFFFFFFF;
-			  			
-			/* Remove the timeout */
-			if (l__waitthr[THRTAB_THRSTAT_FLAGS] & THRSTAT_TIMEOUT)
+			l__waitthr[THRTAB_RECV_LISTEN_TO] = 0;
+			
+			/* Is it waiting? (Not in streaming mode) */
+			if (l__waitthr[THRTAB_THRSTAT_FLAGS] & THRSTAT_RECV_SOFTINT)
 			{
-				ksched_del_timeout(l__waitthr);
-				l__waitthr[THRTAB_THRSTAT_FLAGS] &= (~THRSTAT_TIMEOUT);
+				/* Remove the timeout */
+				if (l__waitthr[THRTAB_THRSTAT_FLAGS] & THRSTAT_TIMEOUT)
+				{
+					ksched_del_timeout(l__waitthr);
+					l__waitthr[THRTAB_THRSTAT_FLAGS] &= (~THRSTAT_TIMEOUT);
+				}
+		
+				ksched_start_thread(l__waitthr);
 			}
-		
-			ksched_start_thread(l__waitthr);
 		}
 
 		/* Is the thread listenting to the softints of sb. else? */
 		if (kinfo_isthrd(l__thread[THRTAB_RECV_LISTEN_TO]))
 		{
 			uint32_t *l__other = (void*)(uintptr_t)
-				l__thread[THRTAB_RECV_LISTEN_TO];
+				&THREAD(l__thread[THRTAB_RECV_LISTEN_TO], 0);
 			
 			/* Clear Softint listening information */
 			l__other[THRTAB_SOFTINT_LISTENER_SID] = 0;
+			l__other[THRTAB_THRSTAT_FLAGS] &= (~THRSTAT_TRACE_STREAM);
 		}
     
 		/* Did we set any timeout? */
@@ -658,6 +782,14 @@ void sysc_destroy_subject(sid_t sid)
 		{
 			ksched_del_timeout(l__thread);
 		}
+		
+		/* Is it waiting for the PageD or for page faults? */
+		if (    l__thread[THRTAB_THRSTAT_FLAGS] 
+		     & (THRSTAT_WAIT_HYPAGED | THRSTAT_RECV_PAGEFAULTS)
+		   )
+		{
+			kpaged_remove_fault(l__thread);
+		}
 
 		/* Destroy its descriptor */
 		kinfo_del_descr(sid);
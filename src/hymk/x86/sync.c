@@ -24,6 +24,111 @@
 #include <string.h>
 
 
+/*
+ * ksync_update_inheritance(thr)
+ *
+ * Recalculates the priority that the thread 'thr' inherits
+ * from the blocked threads within its wait queue (the threads
+ * that are waiting for the SID of 'thr'). The thread inherits
+ * the highest priority of these threads. If one of them is a
+ * real-time thread, it inherits THRSCHED_CLASS_FIFO with the
+ * highest priority of the real-time threads.
+ *
+ * If 'thr' is waiting for another thread itself, the change
+ * will be passed to that thread (max. SYNC_INHERIT_DEPTH 
+ * threads).
+ *
+ */
+void ksync_update_inheritance(uint32_t *thr)
+{
+	unsigned l__depth = SYNC_INHERIT_DEPTH;
+	
+	while (l__depth --)
+	{
+		uint32_t *l__ent = (void*)(uintptr_t)
+					thr[THRTAB_OWN_SYNC_QUEUE_BEGIN];
+		uint32_t l__prior = 0;
+		uint32_t l__rt_prior = 0;
+		uint32_t l__class = THRSCHED_CLASS_NORMAL;
+		int l__was_rt = KSCHED_IS_RT(thr);
+		
+		/* Search the highest priority of the blocked threads */
+		while (l__ent != NULL)
+		{
+			if (    (l__ent[THRTAB_THRSTAT_FLAGS] & THRSTAT_SYNC)
+			     && (l__ent[THRTAB_THRSTAT_FLAGS] & THRSTAT_BUSY)
+			   )
+			{
+				uint32_t l__p = KSCHED_PRIORITY(l__ent);
+				
+				if (l__p > l__prior) l__prior = l__p;
+				
+				if (KSCHED_IS_RT(l__ent))
+				{
+					l__class = THRSCHED_CLASS_FIFO;
+					if (l__p > l__rt_prior) l__rt_prior = l__p;
+				}
+			}
+			
+			l__ent = (void*)(uintptr_t)
+					l__ent[THRTAB_CUR_SYNC_QUEUE_NEXT];
+		}
+		
+		if (l__class != THRSCHED_CLASS_NORMAL) l__prior = l__rt_prior;
+		
+		/* Nothing changed */
+		if (    (thr[THRTAB_INHERITED_PRIORITY] == l__prior)
+		     && (thr[THRTAB_INHERITED_CLASS] == l__class)
+		   )
+		{
+			return;
+		}
+		
+		thr[THRTAB_INHERITED_PRIORITY] = l__prior;
+		thr[THRTAB_INHERITED_CLASS] = l__class;
+		
+		/* Give it the time slice of the inherited priority */
+		if (thr[THRTAB_EFFECTIVE_PRIORITY] < (l__prior * 2))
+			thr[THRTAB_EFFECTIVE_PRIORITY] = l__prior * 2;
+		
+		/* Its position within the real-time threads may change */
+		if (l__was_rt || KSCHED_IS_RT(thr))
+			ksched_requeue_thread(thr);
+		
+		/* Pass it to the thread we are waiting for */
+		if (    (!(thr[THRTAB_THRSTAT_FLAGS] & THRSTAT_SYNC))
+		     || (!kinfo_isthrd(thr[THRTAB_SYNC_SID]))
+		   )
+		{
+			return;
+		}
+		
+		thr = &THREAD(thr[THRTAB_SYNC_SID], 0);
+	}
+	
+	return;
+}
+
+/*
+ * ksync_priority_changed(thr)
+ *
+ * Updates the inherited priority of the thread that 'thr' 
+ * is waiting for, after the priority of 'thr' or its state
+ * changed (e.g. by a time out).
+ *
+ */
+void ksync_priority_changed(uint32_t *thr)
+{
+	if (    (thr[THRTAB_THRSTAT_FLAGS] & THRSTAT_SYNC)
+	     && (kinfo_isthrd(thr[THRTAB_SYNC_SID]))
+	   )
+	{
+		ksync_update_inheritance(&THREAD(thr[THRTAB_SYNC_SID], 0));
+	}
+	
+	return;
+}
+
 /*
  * ksync_interrupt_other(other)
  *
@@ -93,6 +198,9 @@ void ksync_removefrom_waitqueue_error(uint32_t *other, uint32_t *me)
 	
 	me[THRTAB_CUR_SYNC_QUEUE_NEXT] = 0;
 	me[THRTAB_CUR_SYNC_QUEUE_PREV] = 0;
+	
+	/* 'other' doesn't inherit our priority anymore */
+	ksync_update_inheritance(other);
 
 	return;
 }
@@ -115,6 +223,9 @@ static inline void ksync_awake_other(sid_t other)
 	ksched_start_thread(&THREAD(other,  0));
 	
 	THREAD(other, THRTAB_SYNC_SID) = current_t[THRTAB_SID];
+	
+	/* We don't inherit the priority of 'other' anymore */
+	ksync_update_inheritance(current_t);
 
 	return;
 }
@@ -152,15 +263,6 @@ static inline sid_t ksync_is_waitqueue(sid_t other)
 		          &&  (other == SID_USER_ROOT)
 			)
 		     || (other == SID_USER_EVERYBODY)
-		        /* PageD-only */
-		     || (    (other == SID_PLACEHOLDER_KERNEL)
-		          && (   l__ent[THRTAB_THRSTAT_FLAGS] 
-			       & THRSTAT_WAIT_HYPAGED
-			     )
-			  && (    current_t[THRTAB_SID] 
-			       == paged_thr_sid
-			     )
-			)
 		   )
 		{
 			/* Yes... */
@@ -296,6 +398,11 @@ static inline sid_t ksync_wait_for(sid_t other, unsigned timeout)
 	}
 
 	ksched_stop_thread(current_t);
+	
+	/* The thread we are waiting for inherits our priority */
+	if (kinfo_isthrd(other))
+		ksync_update_inheritance(&THREAD(other, 0));
+	
 	ksched_change_thread = true;
 	ksched_next_thread();
 	i386_yield_kernel_thread();
@@ -336,7 +443,6 @@ static inline sid_t ksync_wait_for(sid_t other, unsigned timeout)
  *				- Any thread of a special process (Process-SID)
  *				- Any thread of a process in root mode (ROOT)
  *				- Any thread (EVERYBODY)
- *				- Kernel (only for Paged)
  *
  *	timeout		Timeout of the operation in ms (0 = no waiting, 
  *							0xFFFFFFFF unlimited
@@ -355,6 +461,8 @@ sid_t sysc_sync(sid_t other,
 {
 	sid_t l__retval = 0;
 	
+	current_t[THRTAB_SYNC_COUNT] ++;
+	
 	/* Ignore self-thread-syncs */
 	if (other == current_t[THRTAB_SID])
 		return other;
@@ -381,14 +489,6 @@ sid_t sysc_sync(sid_t other,
 				     && (current_p[PRCTAB_IS_ROOT] == 1)
 				    )
 				 || (l__other_want == SID_USER_EVERYBODY)
-				 /* PageD-Operations only */
-				 || (   (    l__other_want 
-				         ==  SID_PLACEHOLDER_KERNEL
-					)
-				     && (  current_t[THRTAB_THRSTAT_FLAGS]
-				         & THRSTAT_WAIT_HYPAGED
-					)
-				    )
 				)
 			     && (   THREAD(other, THRTAB_THRSTAT_FLAGS) 
 			         &  THRSTAT_SYNC
@@ -411,6 +511,10 @@ sid_t sysc_sync(sid_t other,
 				l__retval = ksync_wait_for(other, timeout);
 								
 			    	ksync_removefrom_waitqueue(other);
+			    	
+			    	/* Restore the priority of the other thread */
+			    	if (kinfo_isthrd(other))
+			    		ksync_update_inheritance(&THREAD(other, 0));
 								
 				MSYNC();
 			}
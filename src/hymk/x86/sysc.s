@@ -25,6 +25,48 @@
 .extern i386_emptyint_handler
 
 .extern current_t
+.extern ktrace_mask
+.extern ktrace_syscall_enter
+.extern ktrace_syscall_exit
+
+#
+# Tracing of the system calls
+#
+# Both macros only call the trace functions, if the
+# category TRACE_CAT_SYSCALL (2) is active or if the
+# current thread is streamed (THRSTAT_TRACE_STREAM).
+#
+.macro TRACE_SYSC_TEST
+	testl	$2, ktrace_mask
+	jnz	2f
+	pushl	%ebp
+	movl	current_t, %ebp
+	testl	$4096, 40(%ebp)		# THRTAB_THRSTAT_FLAGS
+	popl	%ebp
+	jz	1f
+2:
+.endm
+
+.macro TRACE_SYSC_ENTER M_nr
+	TRACE_SYSC_TEST
+	pushal
+	pushl	%ecx
+	pushl	%ebx
+	pushl	%eax
+	pushl	$\M_nr
+	call	ktrace_syscall_enter
+	addl	$16, %esp
+	popal
+1:
+.endm
+
+.macro TRACE_SYSC_EXIT M_nr
+	TRACE_SYSC_TEST
+	pushl	$\M_nr
+	call	ktrace_syscall_exit
+	addl	$4, %esp
+1:
+.endm
 
 #
 # System call exports
@@ -62,6 +104,28 @@
 .global i386_sysc_set_paged
 .global i386_sysc_test_page
 
+.global i386_sysc_clone
+
+.global i386_sysc_merge
+
+.global i386_sysc_recv_pagefaults
+
+.global i386_sysc_resolve_pagefaults
+
+.global i386_sysc_io_allow_range
+
+.global i386_sysc_irq_mode
+
+.global i386_sysc_set_deadline
+
+.global i386_sysc_trace_ctl
+
+.global i386_sysc_profile_ctl
+
+.global i386_sysc_trace_read
+
+.global i386_sysc_profile_read
+
 #
 # System call impotrs
 #
@@ -96,6 +160,29 @@
 .extern sysc_write_regs
 
 .extern sysc_set_paged
+.extern sysc_test_page
+
+.extern sysc_clone
+
+.extern sysc_merge
+
+.extern sysc_recv_pagefaults
+
+.extern sysc_resolve_pagefaults
+
+.extern sysc_io_allow_range
+
+.extern sysc_irq_mode
+
+.extern sysc_set_deadline
+
+.extern sysc_trace_ctl
+
+.extern sysc_profile_ctl
+
+.extern sysc_trace_read
+
+.extern sysc_profile_read
 
 .code32
 .text
@@ -181,6 +268,8 @@ i386_sysc_alloc_pages:
 i386_sysc_alloc_pages_norm:				
 	popl	%ebp
 	popl	%eax
+
+	TRACE_SYSC_ENTER 0xC0
 	
 	#
 	# Call system call handler (push and pop
@@ -191,6 +280,8 @@ i386_sysc_alloc_pages_norm:
 	call	sysc_alloc_pages
 	addl	$8, %esp
 
+	TRACE_SYSC_EXIT 0xC0
+	
 	#
 	# Write the error status to the eax register of the
 	# returning thread
@@ -277,6 +368,8 @@ i386_sysc_create_thread:
 i386_sysc_create_thread_norm:				
 	popl	%ebp
 	popl	%eax	
+
+	TRACE_SYSC_ENTER 0xC1
 	
 	#
 	# Call system call handler (push and pop
@@ -292,6 +385,8 @@ i386_sysc_create_thread_norm:
 	#
 	movl	%eax, 16(%esp)
 	
+	TRACE_SYSC_EXIT 0xC1
+	
 	#
 	# Write the error status to the eax register of the
 	# returning thread
@@ -378,6 +473,8 @@ i386_sysc_create_process:
 i386_sysc_create_process_norm:				
 	popl	%ebp
 	popl	%eax	
+
+	TRACE_SYSC_ENTER 0xC2
 	
 	#
 	# Call system call handler (push and pop
@@ -393,6 +490,8 @@ i386_sysc_create_process_norm:
 	#
 	movl	%eax, 16(%esp)
 	
+	TRACE_SYSC_EXIT 0xC2
+	
 	#
 	# Write the error status to the eax register of the
 	# returning thread
@@ -477,6 +576,8 @@ i386_sysc_set_controller:
 i386_sysc_set_controller_norm:				
 	popl	%ebp
 	popl	%eax	
+
+	TRACE_SYSC_ENTER 0xC3
 	
 	#
 	# Call system call handler (push and pop
@@ -486,6 +587,8 @@ i386_sysc_set_controller_norm:
 	call	sysc_set_controller
 	addl	$4, %esp
 	
+	TRACE_SYSC_EXIT 0xC3
+	
 	#
 	# Write the error status to the eax register of the
 	# returning thread
@@ -571,6 +674,8 @@ i386_sysc_destroy_subject:
 i386_sysc_destroy_subject_norm:				
 	popl	%ebp
 	popl	%eax	
+
+	TRACE_SYSC_ENTER 0xC4
 	
 	#
 	# Call system call handler (push and pop
@@ -580,6 +685,8 @@ i386_sysc_destroy_subject_norm:
 	call	sysc_destroy_subject
 	addl	$4, %esp
 	
+	TRACE_SYSC_EXIT 0xC4
+	
 	#
 	# Write the error status to the eax register of the
 	# returning thread
@@ -665,6 +772,8 @@ i386_sysc_chg_root:
 i386_sysc_chg_root_norm:				
 	popl	%ebp
 	popl	%eax		
+
+	TRACE_SYSC_ENTER 0xC5
 	
 	#
 	# Call system call handler (push and pop
@@ -675,6 +784,8 @@ i386_sysc_chg_root_norm:
 	call	sysc_chg_root
 	addl	$8, %esp
 	
+	TRACE_SYSC_EXIT 0xC5
+	
 	#
 	# Write the error status to the eax register of the
 	# returning thread
@@ -759,6 +870,8 @@ i386_sysc_freeze_subject:
 i386_sysc_freeze_subject_norm:				
 	popl	%ebp
 	popl	%eax	
+
+	TRACE_SYSC_ENTER 0xC6
 	
 	#
 	# Call system call handler (push and pop
@@ -768,6 +881,8 @@ i386_sysc_freeze_subject_norm:
 	call	sysc_freeze_subject
 	addl	$4, %esp
 	
+	TRACE_SYSC_EXIT 0xC6
+	
 	#
 	# Write the error status to the eax register of the
 	# returning thread
@@ -852,6 +967,8 @@ i386_sysc_awake_subject:
 i386_sysc_awake_subject_norm:				
 	popl	%ebp
 	popl	%eax	
+
+	TRACE_SYSC_ENTER 0xC7
 	
 	#
 	# Call system call handler (push and pop
@@ -861,6 +978,8 @@ i386_sysc_awake_subject_norm:
 	call	sysc_awake_subject
 	addl	$4, %esp
 	
+	TRACE_SYSC_EXIT 0xC7
+	
 	#
 	# Write the error status to the eax register of the
 	# returning thread
@@ -945,6 +1064,8 @@ i386_sysc_yield_thread:
 i386_sysc_yield_thread_norm:				
 	popl	%ebp
 	popl	%eax
+
+	TRACE_SYSC_ENTER 0xC8
 	
 	#
 	# Call system call handler (push and pop
@@ -954,6 +1075,8 @@ i386_sysc_yield_thread_norm:
 	call	sysc_yield_thread
 	addl	$4, %esp
 	
+	TRACE_SYSC_EXIT 0xC8
+	
 	#
 	# Write the error status to the eax register of the
 	# returning thread
@@ -1040,6 +1163,8 @@ i386_sysc_set_priority:
 i386_sysc_set_priority_norm:				
 	popl	%ebp
 	popl	%eax	
+
+	TRACE_SYSC_ENTER 0xC9
 	
 	#
 	# Call system call handler (push and pop
@@ -1051,6 +1176,8 @@ i386_sysc_set_priority_norm:
 	call	sysc_set_priority
 	addl	$12, %esp
 	
+	TRACE_SYSC_EXIT 0xC9
+	
 	#
 	# Write the error status to the eax register of the
 	# returning thread
@@ -1139,6 +1266,8 @@ i386_sysc_allow:
 i386_sysc_allow_norm:				
 	popl	%ebp
 	popl	%eax		
+
+	TRACE_SYSC_ENTER 0xCA
 	
 	#
 	# Call system call handler (push and pop
@@ -1152,6 +1281,8 @@ i386_sysc_allow_norm:
 	call	sysc_allow
 	addl	$20, %esp
 	
+	TRACE_SYSC_EXIT 0xCA
+	
 	#
 	# Write the error status to the eax register of the
 	# returning thread
@@ -1240,6 +1371,8 @@ i386_sysc_map:
 i386_sysc_map_norm:				
 	popl	%ebp
 	popl	%eax	
+
+	TRACE_SYSC_ENTER 0xCB
 	
 	#
 	# Call system call handler (push and pop
@@ -1253,6 +1386,8 @@ i386_sysc_map_norm:
 	call	sysc_map
 	addl	$20, %esp
 	
+	TRACE_SYSC_EXIT 0xCB
+	
 	#
 	# Write the error status to the eax register of the
 	# returning thread
@@ -1340,6 +1475,8 @@ i386_sysc_unmap:
 i386_sysc_unmap_norm:				
 	popl	%ebp
 	popl	%eax	
+
+	TRACE_SYSC_ENTER 0xCC
 	
 	#
 	# Call system call handler (push and pop
@@ -1352,6 +1489,8 @@ i386_sysc_unmap_norm:
 	call	sysc_unmap
 	addl	$16, %esp
 	
+	TRACE_SYSC_EXIT 0xCC
+	
 	#
 	# Write the error status to the eax register of the
 	# returning thread
@@ -1440,6 +1579,8 @@ i386_sysc_move:
 i386_sysc_move_norm:				
 	popl	%ebp
 	popl	%eax		
+
+	TRACE_SYSC_ENTER 0xCD
 	
 	#
 	# Call system call handler (push and pop
@@ -1453,6 +1594,8 @@ i386_sysc_move_norm:
 	call	sysc_move
 	addl	$20, %esp
 	
+	TRACE_SYSC_EXIT 0xCD
+	
 	#
 	# Write the error status to the eax register of the
 	# returning thread
@@ -1540,6 +1683,8 @@ i386_sysc_sync:
 i386_sysc_sync_norm:				
 	popl	%ebp
 	popl	%eax		
+
+	TRACE_SYSC_ENTER 0xCE
 	
 	#
 	# Call system call handler (push and pop
@@ -1556,6 +1701,8 @@ i386_sysc_sync_norm:
 	#
 	movl	%eax, 16(%esp)
 		
+	TRACE_SYSC_EXIT 0xCE
+	
 	#
 	# Write the error status to the eax register of the
 	# returning thread
@@ -1641,6 +1788,8 @@ i386_sysc_io_allow:
 i386_sysc_io_allow_norm:				
 	popl	%ebp
 	popl	%eax		
+
+	TRACE_SYSC_ENTER 0xCF
 	
 	#
 	# Call system call handler (push and pop
@@ -1651,6 +1800,8 @@ i386_sysc_io_allow_norm:
 	call	sysc_io_allow
 	addl	$8, %esp
 	
+	TRACE_SYSC_EXIT 0xCF
+	
 	#
 	# Write the error status to the eax register of the
 	# returning thread
@@ -1738,6 +1889,8 @@ i386_sysc_io_alloc:
 i386_sysc_io_alloc_norm:				
 	popl	%ebp
 	popl	%eax		
+
+	TRACE_SYSC_ENTER 0xD0
 	
 	#
 	# Call system call handler (push and pop
@@ -1750,6 +1903,8 @@ i386_sysc_io_alloc_norm:
 	call	sysc_io_alloc
 	addl	$16, %esp
 	
+	TRACE_SYSC_EXIT 0xD0
+	
 	#
 	# Write the error status to the eax register of the
 	# returning thread
@@ -1834,6 +1989,8 @@ i386_sysc_recv_irq:
 i386_sysc_recv_irq_norm:				
 	popl	%ebp
 	popl	%eax		
+
+	TRACE_SYSC_ENTER 0xD1
 	
 	#
 	# Call system call handler (push and pop
@@ -1843,6 +2000,8 @@ i386_sysc_recv_irq_norm:
 	call	sysc_recv_irq
 	addl	$4, %esp
 	
+	TRACE_SYSC_EXIT 0xD1
+	
 	#
 	# Write the error status to the eax register of the
 	# returning thread
@@ -1931,6 +2090,8 @@ i386_sysc_recv_softints:
 i386_sysc_recv_softints_norm:				
 	popl	%ebp
 	popl	%eax		
+
+	TRACE_SYSC_ENTER 0xD2
 	
 	#
 	# Call system call handler (push and pop
@@ -1947,6 +2108,8 @@ i386_sysc_recv_softints_norm:
 	#
 	movl	%eax, 16(%esp)
 		
+	TRACE_SYSC_EXIT 0xD2
+	
 	#
 	# Write the error status to the eax register of the
 	# returning thread
@@ -1969,6 +2132,7 @@ i386_sysc_recv_softints_norm:
 # In:
 #	EAX	SID of the affected thread
 #	EBX	Type of the register block
+#	ECX	Buffer (REGS_X86_FRAME, REGS_X86_FRAME_FPU)
 #
 # Out:
 #	EAX	Error code
@@ -2036,16 +2200,21 @@ i386_sysc_read_regs:
 i386_sysc_read_regs_norm:
 	popl	%ebp
 	popl	%eax		
+
+	TRACE_SYSC_ENTER 0xD3
 	
 	#
 	# Call system call handler (push and pop
 	# additional parameters and return values)
 	#
+	pushl	%ecx
 	pushl	%ebx
 	pushl	%eax
 	call	sysc_read_regs
-	addl	$8, %esp
+	addl	$12, %esp
 		
+	TRACE_SYSC_EXIT 0xD3
+	
 	#
 	# Write the error status to the eax register of the
 	# returning thread
@@ -2135,6 +2304,8 @@ i386_sysc_write_regs:
 i386_sysc_write_regs_norm:
 	popl	%ebp
 	popl	%eax		
+
+	TRACE_SYSC_ENTER 0xD4
 	
 	#
 	# Call system call handler (push and pop
@@ -2149,6 +2320,8 @@ i386_sysc_write_regs_norm:
 	call	sysc_write_regs
 	addl	$24, %esp
 		
+	TRACE_SYSC_EXIT 0xD4
+	
 	#
 	# Write the error status to the eax register of the
 	# returning thread
@@ -2233,6 +2406,8 @@ i386_sysc_set_paged:
 i386_sysc_set_paged_norm:
 	popl	%ebp
 	popl	%eax		
+
+	TRACE_SYSC_ENTER 0xD5
 	
 	#
 	# Call system call handler (push and pop
@@ -2240,6 +2415,8 @@ i386_sysc_set_paged_norm:
 	#
 	call	sysc_set_paged
 	
+	TRACE_SYSC_EXIT 0xD5
+	
 	#
 	# Write the error status to the eax register of the
 	# returning thread
@@ -2326,6 +2503,8 @@ i386_sysc_test_page:
 i386_sysc_test_page_norm:				
 	popl	%ebp
 	popl	%eax		
+
+	TRACE_SYSC_ENTER 0xD6
 	
 	#
 	# Call system call handler (push and pop
@@ -2341,6 +2520,1096 @@ i386_sysc_test_page_norm:
 	#
 	movl	%eax, 16(%esp)
 		
+	TRACE_SYSC_EXIT 0xD6
+	
+	#
+	# Write the error status to the eax register of the
+	# returning thread
+	#
+	movl	sysc_error, %eax
+	movl	%eax, 28(%esp)
+	movl	$0, %eax
+	movl	%eax, sysc_error
+		
+        #
+        # Return to the current thread
+        #
+	jmp i386_do_context_switch
+	
+
+#
+# sysc_clone
+#
+# ISR:	0xD7
+#
+# In:
+#	EAX	SID of the other side
+#	EBX	Start address
+#	ECX	Number of pages
+#
+# Out:
+#	EAX	Error code
+#
+i386_sysc_clone:
+	#
+	# Save all registers to stack
+	#
+	cli
+	pushl	%ds
+	pushl	%es
+	pushl	%fs
+	pushl	%gs
+		
+	pushal
+	
+	#
+	# Load the kernel segment descriptor
+	#
+	pushw	%ax
+	movw	$0x20, %ax
+	movw	%ax, %ds
+	movw	%ax, %es
+	movw	%ax, %fs
+	movw	$0x2b, %ax
+	movw	%ax, %gs	
+	popw	%ax
+	
+	#
+	# Redirect the system call if we are selected for
+	# recv_softints
+	#
+	pushl	%eax
+	pushl	%ebp
+	movl	current_t, %ebp
+	addl	$60, %ebp		# THRTAB_SOFTINT_LISTENER_SID
+	movl	(%ebp), %eax
+	cmpl	$0, %eax
+	je	i386_sysc_clone_norm
+	
+	# Redirect it
+	pushal
+	pushl	$0xD7
+	call	kremote_received
+	addl	$4, %esp
+	cmpl	$0, %eax
+	popal
+	jne	i386_sysc_clone_norm		# Normal execution, if Trace-Only
+	
+	# Return to user mode
+	popl	%ebp
+	popl	%eax
+	jmp	i386_do_context_switch
+
+i386_sysc_clone_norm:				
+	popl	%ebp
+	popl	%eax	
+
+	TRACE_SYSC_ENTER 0xD7
+	
+	#
+	# Call system call handler (push and pop
+	# additional parameters and return values)
+	#
+	pushl	%ecx
+	pushl	%ebx
+	pushl	%eax
+	call	sysc_clone
+	addl	$12, %esp
+	
+	TRACE_SYSC_EXIT 0xD7
+	
+	#
+	# Write the error status to the eax register of the
+	# returning thread
+	#
+	movl	sysc_error, %eax
+	movl	%eax, 28(%esp)
+	movl	$0, %eax
+	movl	%eax, sysc_error
+		
+        #
+        # Return to the current thread
+        #
+	jmp i386_do_context_switch
+
+
+#
+# sysc_merge
+#
+# ISR:	0xD8
+#
+# In:
+#	EAX	SID of the process
+#	EBX	Start address
+#	ECX	Number of pages
+#
+# Out:
+#	EAX	Error code
+#	EBX	Number of merged pages
+#
+i386_sysc_merge:
+	#
+	# Save all registers to stack
+	#
+	cli
+	pushl	%ds
+	pushl	%es
+	pushl	%fs
+	pushl	%gs
+		
+	pushal
+	
+	#
+	# Load the kernel segment descriptor
+	#
+	pushw	%ax
+	movw	$0x20, %ax
+	movw	%ax, %ds
+	movw	%ax, %es
+	movw	%ax, %fs
+	movw	$0x2b, %ax
+	movw	%ax, %gs	
+	popw	%ax
+	
+	#
+	# Redirect the system call if we are selected for
+	# recv_softints
+	#
+	pushl	%eax
+	pushl	%ebp
+	movl	current_t, %ebp
+	addl	$60, %ebp		# THRTAB_SOFTINT_LISTENER_SID
+	movl	(%ebp), %eax
+	cmpl	$0, %eax
+	je	i386_sysc_merge_norm
+	
+	# Redirect it
+	pushal
+	pushl	$0xD8
+	call	kremote_received
+	addl	$4, %esp
+	cmpl	$0, %eax
+	popal
+	jne	i386_sysc_merge_norm		# Normal execution, if Trace-Only
+	
+	# Return to user mode
+	popl	%ebp
+	popl	%eax
+	jmp	i386_do_context_switch
+
+i386_sysc_merge_norm:				
+	popl	%ebp
+	popl	%eax	
+
+	TRACE_SYSC_ENTER 0xD8
+	
+	#
+	# Call system call handler (push and pop
+	# additional parameters and return values)
+	#
+	pushl	%ecx
+	pushl	%ebx
+	pushl	%eax
+	call	sysc_merge
+	addl	$12, %esp
+	
+	#
+	# Writing the return value (EAX register) to EBX
+	#
+	movl	%eax, 16(%esp)
+	
+	TRACE_SYSC_EXIT 0xD8
+	
+	#
+	# Write the error status to the eax register of the
+	# returning thread
+	#
+	movl	sysc_error, %eax
+	movl	%eax, 28(%esp)
+	movl	$0, %eax
+	movl	%eax, sysc_error
+		
+        #
+        # Return to the current thread
+        #
+	jmp i386_do_context_switch
+
+
+#
+# sysc_recv_pagefaults
+#
+# ISR:	0xD9
+#
+# In:
+#	EAX	Buffer address
+#	EBX	Max. number of faults
+#
+#
+# Out:
+#	EAX	Error code
+#	EBX	Number of received faults
+#
+i386_sysc_recv_pagefaults:
+	#
+	# Save all registers to stack
+	#
+	cli
+	pushl	%ds
+	pushl	%es
+	pushl	%fs
+	pushl	%gs
+		
+	pushal
+	
+	#
+	# Load the kernel segment descriptor
+	#
+	pushw	%ax
+	movw	$0x20, %ax
+	movw	%ax, %ds
+	movw	%ax, %es
+	movw	%ax, %fs
+	movw	$0x2b, %ax
+	movw	%ax, %gs	
+	popw	%ax
+	
+	#
+	# Redirect the system call if we are selected for
+	# recv_softints
+	#
+	pushl	%eax
+	pushl	%ebp
+	movl	current_t, %ebp
+	addl	$60, %ebp		# THRTAB_SOFTINT_LISTENER_SID
+	movl	(%ebp), %eax
+	cmpl	$0, %eax
+	je	i386_sysc_recv_pagefaults_norm
+	
+	# Redirect it
+	pushal
+	pushl	$0xD9
+	call	kremote_received
+	addl	$4, %esp
+	cmpl	$0, %eax
+	popal
+	jne	i386_sysc_recv_pagefaults_norm		# Normal execution, if Trace-Only
+	
+	# Return to user mode
+	popl	%ebp
+	popl	%eax
+	jmp	i386_do_context_switch
+
+i386_sysc_recv_pagefaults_norm:				
+	popl	%ebp
+	popl	%eax	
+
+	TRACE_SYSC_ENTER 0xD9
+	
+	#
+	# Call system call handler (push and pop
+	# additional parameters and return values)
+	#
+	pushl	%ebx
+	pushl	%eax
+	call	sysc_recv_pagefaults
+	addl	$8, %esp
+	
+	#
+	# Writing the return value (EAX register) to EBX
+	#
+	movl	%eax, 16(%esp)
+	
+	TRACE_SYSC_EXIT 0xD9
+	
+	#
+	# Write the error status to the eax register of the
+	# returning thread
+	#
+	movl	sysc_error, %eax
+	movl	%eax, 28(%esp)
+	movl	$0, %eax
+	movl	%eax, sysc_error
+		
+        #
+        # Return to the current thread
+        #
+	jmp i386_do_context_switch
+
+
+#
+# sysc_resolve_pagefaults
+#
+# ISR:	0xDA
+#
+# In:
+#	EAX	List address
+#	EBX	Number of entries
+#
+#
+# Out:
+#	EAX	Error code
+#	EBX	Number of awaked threads
+#
+i386_sysc_resolve_pagefaults:
+	#
+	# Save all registers to stack
+	#
+	cli
+	pushl	%ds
+	pushl	%es
+	pushl	%fs
+	pushl	%gs
+		
+	pushal
+	
+	#
+	# Load the kernel segment descriptor
+	#
+	pushw	%ax
+	movw	$0x20, %ax
+	movw	%ax, %ds
+	movw	%ax, %es
+	movw	%ax, %fs
+	movw	$0x2b, %ax
+	movw	%ax, %gs	
+	popw	%ax
+	
+	#
+	# Redirect the system call if we are selected for
+	# recv_softints
+	#
+	pushl	%eax
+	pushl	%ebp
+	movl	current_t, %ebp
+	addl	$60, %ebp		# THRTAB_SOFTINT_LISTENER_SID
+	movl	(%ebp), %eax
+	cmpl	$0, %eax
+	je	i386_sysc_resolve_pagefaults_norm
+	
+	# Redirect it
+	pushal
+	pushl	$0xDA
+	call	kremote_received
+	addl	$4, %esp
+	cmpl	$0, %eax
+	popal
+	jne	i386_sysc_resolve_pagefaults_norm		# Normal execution, if Trace-Only
+	
+	# Return to user mode
+	popl	%ebp
+	popl	%eax
+	jmp	i386_do_context_switch
+
+i386_sysc_resolve_pagefaults_norm:				
+	popl	%ebp
+	popl	%eax	
+
+	TRACE_SYSC_ENTER 0xDA
+	
+	#
+	# Call system call handler (push and pop
+	# additional parameters and return values)
+	#
+	pushl	%ebx
+	pushl	%eax
+	call	sysc_resolve_pagefaults
+	addl	$8, %esp
+	
+	#
+	# Writing the return value (EAX register) to EBX
+	#
+	movl	%eax, 16(%esp)
+	
+	TRACE_SYSC_EXIT 0xDA
+	
+	#
+	# Write the error status to the eax register of the
+	# returning thread
+	#
+	movl	sysc_error, %eax
+	movl	%eax, 28(%esp)
+	movl	$0, %eax
+	movl	%eax, sysc_error
+		
+        #
+        # Return to the current thread
+        #
+	jmp i386_do_context_switch
+
+
+#
+# sysc_io_allow_range
+#
+# ISR:	0xDB
+#
+# In:
+#	EAX	Destination process
+#	EBX	First port
+#	ECX	Number of ports
+#	EDX	Operation
+#
+# Out:
+#	EAX	Error code
+#
+i386_sysc_io_allow_range:
+	#
+	# Save all registers to stack
+	#
+	cli
+	pushl	%ds
+	pushl	%es
+	pushl	%fs
+	pushl	%gs
+		
+	pushal
+	
+	#
+	# Load the kernel segment descriptor
+	#
+	pushw	%ax
+	movw	$0x20, %ax
+	movw	%ax, %ds
+	movw	%ax, %es
+	movw	%ax, %fs
+	movw	$0x2b, %ax
+	movw	%ax, %gs	
+	popw	%ax
+	
+	#
+	# Redirect the system call if we are selected for
+	# recv_softints
+	#
+	pushl	%eax
+	pushl	%ebp
+	movl	current_t, %ebp
+	addl	$60, %ebp		# THRTAB_SOFTINT_LISTENER_SID
+	movl	(%ebp), %eax
+	cmpl	$0, %eax
+	je	i386_sysc_io_allow_range_norm
+	
+	# Redirect it
+	pushal
+	pushl	$0xDB
+	call	kremote_received
+	addl	$4, %esp
+	cmpl	$0, %eax
+	popal
+	jne	i386_sysc_io_allow_range_norm		# Normal execution, if Trace-Only
+	
+	# Return to user mode
+	popl	%ebp
+	popl	%eax
+	jmp	i386_do_context_switch
+
+i386_sysc_io_allow_range_norm:				
+	popl	%ebp
+	popl	%eax	
+
+	TRACE_SYSC_ENTER 0xDB
+	
+	#
+	# Call system call handler (push and pop
+	# additional parameters and return values)
+	#
+	pushl	%edx
+	pushl	%ecx
+	pushl	%ebx
+	pushl	%eax
+	call	sysc_io_allow_range
+	addl	$16, %esp
+	
+	TRACE_SYSC_EXIT 0xDB
+	
+	#
+	# Write the error status to the eax register of the
+	# returning thread
+	#
+	movl	sysc_error, %eax
+	movl	%eax, 28(%esp)
+	movl	$0, %eax
+	movl	%eax, sysc_error
+		
+        #
+        # Return to the current thread
+        #
+	jmp i386_do_context_switch
+
+
+#
+# sysc_irq_mode
+#
+# ISR:	0xDC
+#
+# In:
+#	EAX	IRQ number
+#	EBX	Mode
+#
+# Out:
+#	EAX	Error code
+#
+i386_sysc_irq_mode:
+	#
+	# Save all registers to stack
+	#
+	cli
+	pushl	%ds
+	pushl	%es
+	pushl	%fs
+	pushl	%gs
+		
+	pushal
+	
+	#
+	# Load the kernel segment descriptor
+	#
+	pushw	%ax
+	movw	$0x20, %ax
+	movw	%ax, %ds
+	movw	%ax, %es
+	movw	%ax, %fs
+	movw	$0x2b, %ax
+	movw	%ax, %gs	
+	popw	%ax
+	
+	#
+	# Redirect the system call if we are selected for
+	# recv_softints
+	#
+	pushl	%eax
+	pushl	%ebp
+	movl	current_t, %ebp
+	addl	$60, %ebp		# THRTAB_SOFTINT_LISTENER_SID
+	movl	(%ebp), %eax
+	cmpl	$0, %eax
+	je	i386_sysc_irq_mode_norm
+	
+	# Redirect it
+	pushal
+	pushl	$0xDC
+	call	kremote_received
+	addl	$4, %esp
+	cmpl	$0, %eax
+	popal
+	jne	i386_sysc_irq_mode_norm		# Normal execution, if Trace-Only
+	
+	# Return to user mode
+	popl	%ebp
+	popl	%eax
+	jmp	i386_do_context_switch
+
+i386_sysc_irq_mode_norm:				
+	popl	%ebp
+	popl	%eax	
+
+	TRACE_SYSC_ENTER 0xDC
+	
+	#
+	# Call system call handler (push and pop
+	# additional parameters and return values)
+	#
+	pushl	%ebx
+	pushl	%eax
+	call	sysc_irq_mode
+	addl	$8, %esp
+	
+	TRACE_SYSC_EXIT 0xDC
+	
+	#
+	# Write the error status to the eax register of the
+	# returning thread
+	#
+	movl	sysc_error, %eax
+	movl	%eax, 28(%esp)
+	movl	$0, %eax
+	movl	%eax, sysc_error
+		
+        #
+        # Return to the current thread
+        #
+	jmp i386_do_context_switch
+
+
+#
+# sysc_set_deadline
+#
+# ISR:	0xDD
+#
+# In:
+#	EAX	SID of the thread
+#	EBX	Runtime per period (ticks)
+#	ECX	Period (ticks)
+#
+# Out:
+#	EAX	Error code
+#
+i386_sysc_set_deadline:
+	#
+	# Save all registers to stack
+	#
+	cli
+	pushl	%ds
+	pushl	%es
+	pushl	%fs
+	pushl	%gs
+		
+	pushal
+	
+	#
+	# Load the kernel segment descriptor
+	#
+	pushw	%ax
+	movw	$0x20, %ax
+	movw	%ax, %ds
+	movw	%ax, %es
+	movw	%ax, %fs
+	movw	$0x2b, %ax
+	movw	%ax, %gs	
+	popw	%ax
+	
+	#
+	# Redirect the system call if we are selected for
+	# recv_softints
+	#
+	pushl	%eax
+	pushl	%ebp
+	movl	current_t, %ebp
+	addl	$60, %ebp		# THRTAB_SOFTINT_LISTENER_SID
+	movl	(%ebp), %eax
+	cmpl	$0, %eax
+	je	i386_sysc_set_deadline_norm
+	
+	# Redirect it
+	pushal
+	pushl	$0xDD
+	call	kremote_received
+	addl	$4, %esp
+	cmpl	$0, %eax
+	popal
+	jne	i386_sysc_set_deadline_norm		# Normal execution, if Trace-Only
+	
+	# Return to user mode
+	popl	%ebp
+	popl	%eax
+	jmp	i386_do_context_switch
+
+i386_sysc_set_deadline_norm:				
+	popl	%ebp
+	popl	%eax	
+
+	TRACE_SYSC_ENTER 0xDD
+	
+	#
+	# Call system call handler (push and pop
+	# additional parameters and return values)
+	#
+	pushl	%ecx
+	pushl	%ebx
+	pushl	%eax
+	call	sysc_set_deadline
+	addl	$12, %esp
+	
+	TRACE_SYSC_EXIT 0xDD
+	
+	#
+	# Write the error status to the eax register of the
+	# returning thread
+	#
+	movl	sysc_error, %eax
+	movl	%eax, 28(%esp)
+	movl	$0, %eax
+	movl	%eax, sysc_error
+		
+        #
+        # Return to the current thread
+        #
+	jmp i386_do_context_switch
+
+
+#
+# sysc_trace_ctl
+#
+# ISR:	0xDE
+#
+# In:
+#	EAX	Categories to record (TRACE_CAT_*, TRACE_RESET)
+#
+#
+# Out:
+#	EAX	Error code
+#	EBX	Previous categories
+#
+i386_sysc_trace_ctl:
+	#
+	# Save all registers to stack
+	#
+	cli
+	pushl	%ds
+	pushl	%es
+	pushl	%fs
+	pushl	%gs
+		
+	pushal
+	
+	#
+	# Load the kernel segment descriptor
+	#
+	pushw	%ax
+	movw	$0x20, %ax
+	movw	%ax, %ds
+	movw	%ax, %es
+	movw	%ax, %fs
+	movw	$0x2b, %ax
+	movw	%ax, %gs	
+	popw	%ax
+	
+	#
+	# Redirect the system call if we are selected for
+	# recv_softints
+	#
+	pushl	%eax
+	pushl	%ebp
+	movl	current_t, %ebp
+	addl	$60, %ebp		# THRTAB_SOFTINT_LISTENER_SID
+	movl	(%ebp), %eax
+	cmpl	$0, %eax
+	je	i386_sysc_trace_ctl_norm
+	
+	# Redirect it
+	pushal
+	pushl	$0xDE
+	call	kremote_received
+	addl	$4, %esp
+	cmpl	$0, %eax
+	popal
+	jne	i386_sysc_trace_ctl_norm		# Normal execution, if Trace-Only
+	
+	# Return to user mode
+	popl	%ebp
+	popl	%eax
+	jmp	i386_do_context_switch
+
+i386_sysc_trace_ctl_norm:				
+	popl	%ebp
+	popl	%eax	
+
+	TRACE_SYSC_ENTER 0xDE
+	
+	#
+	# Call system call handler (push and pop
+	# additional parameters and return values)
+	#
+	pushl	%eax
+	call	sysc_trace_ctl
+	addl	$4, %esp
+	
+	#
+	# Writing the return value (EAX register) to EBX
+	#
+	movl	%eax, 16(%esp)
+	
+	TRACE_SYSC_EXIT 0xDE
+	
+	#
+	# Write the error status to the eax register of the
+	# returning thread
+	#
+	movl	sysc_error, %eax
+	movl	%eax, 28(%esp)
+	movl	$0, %eax
+	movl	%eax, sysc_error
+		
+        #
+        # Return to the current thread
+        #
+	jmp i386_do_context_switch
+
+
+#
+# sysc_profile_ctl
+#
+# ISR:	0xDF
+#
+# In:
+#	EAX	Process to sample (or SID_NULL)
+#	EBX	Number of return addresses
+#
+#
+# Out:
+#	EAX	Error code
+#
+i386_sysc_profile_ctl:
+	#
+	# Save all registers to stack
+	#
+	cli
+	pushl	%ds
+	pushl	%es
+	pushl	%fs
+	pushl	%gs
+		
+	pushal
+	
+	#
+	# Load the kernel segment descriptor
+	#
+	pushw	%ax
+	movw	$0x20, %ax
+	movw	%ax, %ds
+	movw	%ax, %es
+	movw	%ax, %fs
+	movw	$0x2b, %ax
+	movw	%ax, %gs	
+	popw	%ax
+	
+	#
+	# Redirect the system call if we are selected for
+	# recv_softints
+	#
+	pushl	%eax
+	pushl	%ebp
+	movl	current_t, %ebp
+	addl	$60, %ebp		# THRTAB_SOFTINT_LISTENER_SID
+	movl	(%ebp), %eax
+	cmpl	$0, %eax
+	je	i386_sysc_profile_ctl_norm
+	
+	# Redirect it
+	pushal
+	pushl	$0xDF
+	call	kremote_received
+	addl	$4, %esp
+	cmpl	$0, %eax
+	popal
+	jne	i386_sysc_profile_ctl_norm		# Normal execution, if Trace-Only
+	
+	# Return to user mode
+	popl	%ebp
+	popl	%eax
+	jmp	i386_do_context_switch
+
+i386_sysc_profile_ctl_norm:				
+	popl	%ebp
+	popl	%eax	
+
+	TRACE_SYSC_ENTER 0xDF
+	
+	#
+	# Call system call handler (push and pop
+	# additional parameters and return values)
+	#
+	pushl	%ebx
+	pushl	%eax
+	call	sysc_profile_ctl
+	addl	$8, %esp
+	
+	TRACE_SYSC_EXIT 0xDF
+	
+	#
+	# Write the error status to the eax register of the
+	# returning thread
+	#
+	movl	sysc_error, %eax
+	movl	%eax, 28(%esp)
+	movl	$0, %eax
+	movl	%eax, sysc_error
+		
+        #
+        # Return to the current thread
+        #
+	jmp i386_do_context_switch
+
+
+#
+# sysc_trace_read
+#
+# ISR:	0xE0
+#
+# In:
+#	EAX	Buffer address
+#	EBX	Number of the first record
+#	ECX	Number of records
+#
+#
+# Out:
+#	EAX	Error code
+#	EBX	Number of copied records
+#
+i386_sysc_trace_read:
+	#
+	# Save all registers to stack
+	#
+	cli
+	pushl	%ds
+	pushl	%es
+	pushl	%fs
+	pushl	%gs
+		
+	pushal
+	
+	#
+	# Load the kernel segment descriptor
+	#
+	pushw	%ax
+	movw	$0x20, %ax
+	movw	%ax, %ds
+	movw	%ax, %es
+	movw	%ax, %fs
+	movw	$0x2b, %ax
+	movw	%ax, %gs	
+	popw	%ax
+	
+	#
+	# Redirect the system call if we are selected for
+	# recv_softints
+	#
+	pushl	%eax
+	pushl	%ebp
+	movl	current_t, %ebp
+	addl	$60, %ebp		# THRTAB_SOFTINT_LISTENER_SID
+	movl	(%ebp), %eax
+	cmpl	$0, %eax
+	je	i386_sysc_trace_read_norm
+	
+	# Redirect it
+	pushal
+	pushl	$0xE0
+	call	kremote_received
+	addl	$4, %esp
+	cmpl	$0, %eax
+	popal
+	jne	i386_sysc_trace_read_norm		# Normal execution, if Trace-Only
+	
+	# Return to user mode
+	popl	%ebp
+	popl	%eax
+	jmp	i386_do_context_switch
+
+i386_sysc_trace_read_norm:				
+	popl	%ebp
+	popl	%eax	
+
+	TRACE_SYSC_ENTER 0xE0
+	
+	#
+	# Call system call handler (push and pop
+	# additional parameters and return values)
+	#
+	pushl	%ecx
+	pushl	%ebx
+	pushl	%eax
+	call	sysc_trace_read
+	addl	$12, %esp
+	
+	#
+	# Writing the return value (EAX register) to EBX
+	#
+	movl	%eax, 16(%esp)
+	
+	TRACE_SYSC_EXIT 0xE0
+	
+	#
+	# Write the error status to the eax register of the
+	# returning thread
+	#
+	movl	sysc_error, %eax
+	movl	%eax, 28(%esp)
+	movl	$0, %eax
+	movl	%eax, sysc_error
+		
+        #
+        # Return to the current thread
+        #
+	jmp i386_do_context_switch
+
+
+#
+# sysc_profile_read
+#
+# ISR:	0xE1
+#
+# In:
+#	EAX	Buffer address
+#	EBX	Number of the first sample
+#	ECX	Number of samples
+#
+#
+# Out:
+#	EAX	Error code
+#	EBX	Number of copied samples
+#
+i386_sysc_profile_read:
+	#
+	# Save all registers to stack
+	#
+	cli
+	pushl	%ds
+	pushl	%es
+	pushl	%fs
+	pushl	%gs
+		
+	pushal
+	
+	#
+	# Load the kernel segment descriptor
+	#
+	pushw	%ax
+	movw	$0x20, %ax
+	movw	%ax, %ds
+	movw	%ax, %es
+	movw	%ax, %fs
+	movw	$0x2b, %ax
+	movw	%ax, %gs	
+	popw	%ax
+	
+	#
+	# Redirect the system call if we are selected for
+	# recv_softints
+	#
+	pushl	%eax
+	pushl	%ebp
+	movl	current_t, %ebp
+	addl	$60, %ebp		# THRTAB_SOFTINT_LISTENER_SID
+	movl	(%ebp), %eax
+	cmpl	$0, %eax
+	je	i386_sysc_profile_read_norm
+	
+	# Redirect it
+	pushal
+	pushl	$0xE1
+	call	kremote_received
+	addl	$4, %esp
+	cmpl	$0, %eax
+	popal
+	jne	i386_sysc_profile_read_norm		# Normal execution, if Trace-Only
+	
+	# Return to user mode
+	popl	%ebp
+	popl	%eax
+	jmp	i386_do_context_switch
+
+i386_sysc_profile_read_norm:				
+	popl	%ebp
+	popl	%eax	
+
+	TRACE_SYSC_ENTER 0xE1
+	
+	#
+	# Call system call handler (push and pop
+	# additional parameters and return values)
+	#
+	pushl	%ecx
+	pushl	%ebx
+	pushl	%eax
+	call	sysc_profile_read
+	addl	$12, %esp
+	
+	#
+	# Writing the return value (EAX register) to EBX
+	#
+	movl	%eax, 16(%esp)
+	
+	TRACE_SYSC_EXIT 0xE1
+	
 	#
 	# Write the error status to the eax register of the
 	# returning thread
@@ -2354,4 +3623,3 @@ i386_sysc_test_page_norm:
         # Return to the current thread
         #
 	jmp i386_do_context_switch
-	
\ No newline at end of file
@@ -0,0 +1,592 @@
+/*
+ *
+ * trace.c
+ *
+ * (C)2007 by Friedrich Grter
+ *
+ * This file is distributed under the terms of
+ * the GNU General Public License, Version 2. You
+ * should have received a copy of this license (e.g.
+ * in the file 'copying').
+ *
+ * Kernel trace ring
+ *
+ */
+#include <hydrixos/types.h>
+#include <hydrixos/sid.h>
+#include <stdio.h>
+#include <mem.h>
+#include <page.h>
+#include <info.h>
+#include <error.h>
+#include <setup.h>
+#include <sched.h>
+#include <current.h>
+#include <sysc.h>
+#include <trace.h>
+
+/* Active trace categories */
+uint32_t ktrace_mask = 0;
+
+/* Header page and records of the trace ring (NULL if not allocated) */
+trace_header_t *ktrace_header = NULL;
+trace_record_t *ktrace_ring = NULL;
+
+/* Entry time of the current system call */
+static uint64_t ktrace_sysc_start = 0;
+
+/* Sampling profiler */
+sid_t kprof_process = SID_NULL;
+static unsigned kprof_depth = 0;
+
+/* Sample buffer of the profiler and its owner (NULL if not allocated) */
+static trace_record_t *kprof_buffer = NULL;
+static sid_t kprof_owner = SID_NULL;
+
+/*
+ * ktrace_map_area(vas, pages)
+ *
+ * Allocates 'pages' page frames and maps them to the 
+ * info area at 'vas'. The pages are only accessible in 
+ * kernel mode.
+ *
+ * Return value:
+ *	0	Successful
+ *	1	Not enough memory
+ *
+ */
+static int ktrace_map_area(uintptr_t vas, unsigned pages)
+{
+	uint32_t *l__ptab = ikp_start + 1024;
+	unsigned l__n;
+	
+	for (l__n = 0; l__n < pages; l__n ++)
+	{
+		uintptr_t l__frame = (uintptr_t)kmem_alloc_kernel_pageframe();
+		
+		if (l__frame == (uintptr_t)NULL)
+		{
+			/* Free the pages allocated so far */
+			while (l__n --)
+			{
+				uintptr_t l__page = (vas / 4096) - 0xC0000 + l__n;
+				
+				kmem_free_kernel_pageframe((void*)(uintptr_t)
+							   (l__ptab[l__page] & (~0xFFFU))
+							  );
+				l__ptab[l__page] = 0;
+				INVLPG(vas + (l__n * 4096));
+			}
+			
+			return 1;
+		}
+		
+		l__ptab[(vas / 4096) - 0xC0000 + l__n] =   l__frame
+							  | PFLAG_PRESENT
+							  | PFLAG_GLOBAL
+							 ;
+		INVLPG(vas + (l__n * 4096));
+	}
+	
+	return 0;
+}
+
+/*
+ * ktrace_alloc_ring()
+ *
+ * Allocates the trace ring and maps it into the info area
+ * (VAS_TRACE_RING). The ring is only accessible in kernel
+ * mode, because the records contain the system call 
+ * parameters of every process. Root processes read it
+ * by the trace_read system call.
+ *
+ * Return value:
+ *	0	Successful
+ *	1	Not enough memory
+ *
+ */
+int ktrace_alloc_ring(void)
+{
+	/* Header page + records */
+	if (ktrace_map_area(VAS_TRACE_RING, KTRACE_RING_PAGES + 1))
+		return 1;
+	
+	/* Kernel internal addresses */
+	ktrace_header = (void*)(uintptr_t)(VAS_TRACE_RING - 0xC0000000);
+	ktrace_ring = (void*)(uintptr_t)(VAS_TRACE_RING + 4096 - 0xC0000000);
+	
+	ktrace_header->head = 0;
+	ktrace_header->mask = 0;
+	ktrace_header->size = KTRACE_RING_SIZE;
+	ktrace_header->record_size = sizeof(trace_record_t);
+	
+	main_info[MAININFO_TRACE_RECORDS] = KTRACE_RING_SIZE;
+	
+	return 0;
+}
+
+/*
+ * ktrace_syscall_enter(nr, eax, ebx, ecx)
+ *
+ * Records the entry of the system call 'nr' with its
+ * first parameters (called by the system call handlers
+ * of sysc.s if TRACE_CAT_SYSCALL is active or the current
+ * thread is streamed by a debugger).
+ *
+ * The system calls of a streamed thread (THRSTAT_TRACE_STREAM)
+ * will be followed by a TRACE_SYSCALL_ARGS record with the 
+ * remaining registers.
+ *
+ */
+void ktrace_syscall_enter(uint32_t nr, uint32_t eax, uint32_t ebx, uint32_t ecx)
+{
+	if (i386_do_tsc) {RDTSC(ktrace_sysc_start);}
+	
+	ktrace_write(TRACE_SYSCALL_ENTER, nr, eax, ebx, ecx);
+	
+	if (current_t[THRTAB_THRSTAT_FLAGS] & THRSTAT_TRACE_STREAM)
+	{
+		/* The user mode registers saved by the pushal of sysc.s */
+		uint32_t *l__frame = (void*)(uintptr_t)
+				(
+				    current_t[THRTAB_KERNEL_STACK_ADDRESS]
+				  + KERNEL_STACK_SIZE
+				  - (17 * 4)
+				);
+				
+		ktrace_write(TRACE_SYSCALL_ARGS, 
+			     l__frame[5],	/* EDX */
+			     l__frame[1],	/* ESI */
+			     l__frame[0],	/* EDI */
+			     l__frame[2]	/* EBP */
+			    );
+	}
+	
+	return;
+}
+
+/*
+ * ktrace_syscall_exit(nr)
+ *
+ * Records the end of the system call 'nr' with its
+ * duration and error code.
+ *
+ */
+void ktrace_syscall_exit(uint32_t nr)
+{
+	uint64_t l__now = 0;
+	
+	if (i386_do_tsc) {RDTSC(l__now);}
+	
+	/* Tracing may have been activated by this system call */
+	if (ktrace_sysc_start == 0) l__now = 0;
+	
+	ktrace_write(TRACE_SYSCALL_EXIT, 
+		     nr, 
+		     (uint32_t)(l__now - ktrace_sysc_start), 
+		     sysc_error, 
+		     0
+		    );
+	
+	ktrace_sysc_start = 0;
+	
+	return;
+}
+
+/*
+ * sysc_trace_ctl(mask)
+ *
+ * (Implementation of the "trace_ctl" system call)
+ *
+ * Selects the categories of events that will be written
+ * to the trace ring. The ring will be allocated by the 
+ * first call. This system call may be only called by root 
+ * processes.
+ *
+ * Parameters:
+ *	mask	TRACE_CAT_* flags of the events to record. If
+ *		TRACE_RESET is set, all records will be 
+ *		discarded.
+ *
+ * Return value:
+ *	The previous mask
+ *
+ */
+uint32_t sysc_trace_ctl(uint32_t mask)
+{
+	uint32_t l__old = ktrace_mask;
+	
+	/* Is it a root process */
+	if (!current_p[PRCTAB_IS_ROOT])
+	{
+		SET_ERROR(ERR_NOT_ROOT);
+		return 0;
+	}
+	
+	if (mask & (~(TRACE_CAT_ALL | TRACE_RESET)))
+	{
+		SET_ERROR(ERR_INVALID_ARGUMENT);
+		return 0;
+	}
+	
+	/* Allocate the ring */
+	if (ktrace_header == NULL)
+	{
+		if (ktrace_alloc_ring())
+		{
+			SET_ERROR(ERR_NOT_ENOUGH_MEMORY);
+			return 0;
+		}
+	}
+	
+	if (mask & TRACE_RESET) 
+	{
+		ktrace_header->head = 0;
+		main_info[MAININFO_TRACE_HEAD] = 0;
+	}
+	
+	ktrace_mask = mask & TRACE_CAT_ALL;
+	ktrace_header->mask = ktrace_mask;
+	main_info[MAININFO_TRACE_MASK] = ktrace_mask;
+	
+	return l__old;
+}
+
+/*
+ * sysc_trace_read(buf, first, num)
+ *
+ * (Implementation of the "trace_read" system call)
+ *
+ * Copies up to 'num' records of the trace ring, beginning 
+ * with the record 'first', to the buffer 'buf'. The number
+ * of written records is MAININFO_TRACE_HEAD. Records that
+ * have been overwritten already (older than HEAD - RECORDS)
+ * or that are not written yet can't be read. This system 
+ * call may be only called by root processes.
+ *
+ * Parameters:
+ *	buf	Buffer for 'num' trace_record_t entries
+ *	first	Number of the first record
+ *	num	Max. number of records (max. KTRACE_READ_MAX)
+ *
+ * Return value:
+ *	Number of copied records (0 if the record 'first'
+ *	can't be read)
+ *
+ */
+unsigned sysc_trace_read(uintptr_t buf, uint32_t first, unsigned num)
+{
+	trace_record_t *l__buf;
+	uint32_t l__head;
+	unsigned l__i;
+	
+	/* Is it a root process */
+	if (!current_p[PRCTAB_IS_ROOT])
+	{
+		SET_ERROR(ERR_NOT_ROOT);
+		return 0;
+	}
+	
+	if (num > KTRACE_READ_MAX)
+	{
+		SET_ERROR(ERR_SYSCALL_RESTRICTED);
+		return 0;
+	}
+	
+	if (ktrace_header == NULL) return 0;
+	
+	/* Still (or already) within the ring? */
+	l__head = ktrace_header->head;
+	
+	if (    ((first - l__head) < 0x80000000u)
+	     || ((l__head - first) > KTRACE_RING_SIZE)
+	   )
+	{
+		return 0;
+	}
+	
+	if (num > (l__head - first)) num = l__head - first;
+	if (num == 0) return 0;
+	
+	l__buf = kpaged_get_user_buffer(buf, num * sizeof(trace_record_t), true);
+	if (l__buf == NULL)
+	{
+		SET_ERROR(ERR_INVALID_ADDRESS);
+		return 0;
+	}
+	
+	for (l__i = 0; l__i < num; l__i ++)
+		l__buf[l__i] = ktrace_ring[(first + l__i) & (KTRACE_RING_SIZE - 1)];
+	
+	return num;
+}
+
+/*
+ * ktrace_user_frame(adr)
+ *
+ * Tests if the stack frame (saved EBP and return address)
+ * at the user address 'adr' of the current address space
+ * is readable.
+ *
+ * Return value:
+ *	!= NULL		Kernel pointer to the frame
+ *	NULL		Frame not readable
+ *
+ */
+static uint32_t* ktrace_user_frame(uintptr_t adr)
+{
+	uint32_t *l__pdir = (void*)(uintptr_t)current_p[PRCTAB_PAGEDIR_PHYSICAL_ADDR];
+	uint32_t *l__ptab;
+	uint32_t l__entry;
+	
+	/* Aligned and within a single user page? */
+	if (    (adr & 3)
+	     || (adr < VAS_USER_START)
+	     || (adr >= (VAS_USER_END - 8))
+	     || ((adr & 0xFFFu) > (4096 - 8))
+	   )
+	{
+		return NULL;
+	}
+	
+	l__ptab = kmem_get_table(l__pdir, adr, false);
+	if (l__ptab == NULL) return NULL;
+	
+	l__entry = l__ptab[(adr / 4096) & 0x3FF];
+	
+	if (    (!(l__entry & GENFLAG_PRESENT))
+	     || (!(l__entry & GENFLAG_USER_MODE))
+	     || (l__entry & GENFLAG_PAGED_PROTECTED)
+	   )
+	{
+		return NULL;
+	}
+	
+	return (void*)(adr - VAS_KERNEL_START);
+}
+
+/*
+ * ktrace_sample()
+ *
+ * Writes a profiler sample of the current thread (EIP
+ * and the return addresses of the frame pointer chain)
+ * to the sample buffer. Called by every timer tick if the 
+ * profiler is active. If the buffer is full, the sample 
+ * will be only counted as dropped.
+ *
+ */
+void ktrace_sample(void)
+{
+	uint32_t *l__frame = (void*)(uintptr_t)
+				(
+				    current_t[THRTAB_KERNEL_STACK_ADDRESS]
+				  + KERNEL_STACK_SIZE
+				  - (17 * 4)
+				);
+	uint32_t l__ret[TRACE_SAMPLE_DEPTH] = {0, 0, 0};
+	uint32_t l__num = main_info[MAININFO_PROFILE_SAMPLES];
+	trace_record_t *l__rec;
+	uintptr_t l__ebp;
+	unsigned l__n;
+	
+	/* Only user mode threads of the selected process */
+	if (current_t == ksched_idle_thread) return;
+	if ((l__frame[13] & 3) != 3) return;
+	
+	if (    (kprof_process != SID_USER_EVERYBODY)
+	     && (kprof_process != current_p[PRCTAB_SID])
+	   )
+	{
+		return;
+	}
+	
+	if (l__num >= KPROF_BUFFER_SIZE)
+	{
+		main_info[MAININFO_PROFILE_DROPPED] ++;
+		return;
+	}
+	
+	/* Follow the frame pointers (the stack grows downwards) */
+	l__ebp = l__frame[2];
+	
+	for (l__n = 0; l__n < kprof_depth; l__n ++)
+	{
+		uint32_t *l__stack = ktrace_user_frame(l__ebp);
+		
+		if (l__stack == NULL) break;
+		
+		l__ret[l__n] = l__stack[1];
+		
+		if (l__stack[0] <= l__ebp) break;
+		l__ebp = l__stack[0];
+	}
+	
+	l__rec = &kprof_buffer[l__num];
+	
+	if (i386_do_tsc)
+	{
+		__asm__ __volatile__("rdtsc\n"
+				     :"=a" (l__rec->tsc_low), "=d" (l__rec->tsc_high)
+				    );
+	}
+	 else
+	{
+		l__rec->tsc_low = main_info[MAININFO_RTC_COUNTER_LOW];
+		l__rec->tsc_high = main_info[MAININFO_RTC_COUNTER_HIGH];
+	}
+	
+	l__rec->type = TRACE_SAMPLE;
+	l__rec->cpu = 0;
+	l__rec->thread = current_t[THRTAB_SID];
+	l__rec->arg[0] = l__frame[12];
+	l__rec->arg[1] = l__ret[0];
+	l__rec->arg[2] = l__ret[1];
+	l__rec->arg[3] = l__ret[2];
+	
+	main_info[MAININFO_PROFILE_SAMPLES] = l__num + 1;
+	
+	return;
+}
+
+/*
+ * sysc_profile_ctl(proc, depth)
+ *
+ * (Implementation of the "profile_ctl" system call)
+ *
+ * Starts or stops the sampling profiler. With every timer
+ * tick that interrupts a thread of the process 'proc' in
+ * user mode, a TRACE_SAMPLE record will be written to the 
+ * sample buffer of the profiler. Starting the profiler
+ * discards the previous samples and makes the calling
+ * process the owner of the buffer, that is the only one
+ * that can read it (see profile_read) or stop the 
+ * profiler. This system call may be only called by root 
+ * processes.
+ *
+ * Parameters:
+ *	proc	Process to sample, SID_USER_EVERYBODY for all
+ *		processes or SID_NULL to stop the profiler
+ *	depth	Number of return addresses to record 
+ *		(0 - TRACE_SAMPLE_DEPTH). The return addresses
+ *		will be found by following the EBP chain.
+ *
+ */
+void sysc_profile_ctl(sid_t proc, unsigned depth)
+{
+	/* Is it a root process */
+	if (!current_p[PRCTAB_IS_ROOT])
+	{
+		SET_ERROR(ERR_NOT_ROOT);
+		return;
+	}
+	
+	if (depth > TRACE_SAMPLE_DEPTH)
+	{
+		SET_ERROR(ERR_INVALID_ARGUMENT);
+		return;
+	}
+	
+	if (    (proc != SID_NULL)
+	     && (proc != SID_USER_EVERYBODY)
+	     && (!kinfo_isproc(proc))
+	   )
+	{
+		SET_ERROR(ERR_INVALID_SID);
+		return;
+	}
+	
+	/* Used by another (living) process? */
+	if (    (kprof_process != SID_NULL)
+	     && (kprof_owner != current_p[PRCTAB_SID])
+	     && (kinfo_isproc(kprof_owner))
+	   )
+	{
+		SET_ERROR(ERR_RESOURCE_BUSY);
+		return;
+	}
+	
+	if (proc == SID_NULL)
+	{
+		kprof_process = SID_NULL;
+		return;
+	}
+	
+	/* Allocate the sample buffer */
+	if (kprof_buffer == NULL)
+	{
+		if (ktrace_map_area(VAS_PROFILE_BUFFER, KPROF_BUFFER_PAGES))
+		{
+			SET_ERROR(ERR_NOT_ENOUGH_MEMORY);
+			return;
+		}
+		
+		kprof_buffer = (void*)(uintptr_t)(VAS_PROFILE_BUFFER - 0xC0000000);
+	}
+	
+	main_info[MAININFO_PROFILE_SAMPLES] = 0;
+	main_info[MAININFO_PROFILE_DROPPED] = 0;
+	
+	kprof_owner = current_p[PRCTAB_SID];
+	kprof_depth = depth;
+	kprof_process = proc;
+	
+	return;
+}
+
+/*
+ * sysc_profile_read(buf, first, num)
+ *
+ * (Implementation of the "profile_read" system call)
+ *
+ * Copies up to 'num' samples of the profiler, beginning 
+ * with the sample 'first', to the buffer 'buf'. The number
+ * of written samples is MAININFO_PROFILE_SAMPLES. This system
+ * call may be only called by the process that has started
+ * the profiler.
+ *
+ * Parameters:
+ *	buf	Buffer for 'num' trace_record_t entries
+ *	first	Number of the first sample
+ *	num	Max. number of samples (max. KTRACE_READ_MAX)
+ *
+ * Return value:
+ *	Number of copied samples
+ *
+ */
+unsigned sysc_profile_read(uintptr_t buf, uint32_t first, unsigned num)
+{
+	trace_record_t *l__buf;
+	uint32_t l__samples = main_info[MAININFO_PROFILE_SAMPLES];
+	unsigned l__i;
+	
+	if (    (kprof_buffer == NULL)
+	     || (kprof_owner != current_p[PRCTAB_SID])
+	   )
+	{
+		SET_ERROR(ERR_ACCESS_DENIED);
+		return 0;
+	}
+	
+	if (num > KTRACE_READ_MAX)
+	{
+		SET_ERROR(ERR_SYSCALL_RESTRICTED);
+		return 0;
+	}
+	
+	if (first >= l__samples) return 0;
+	
+	if (num > (l__samples - first)) num = l__samples - first;
+	if (num == 0) return 0;
+	
+	l__buf = kpaged_get_user_buffer(buf, num * sizeof(trace_record_t), true);
+	if (l__buf == NULL)
+	{
+		SET_ERROR(ERR_INVALID_ADDRESS);
+		return 0;
+	}
+	
+	for (l__i = 0; l__i < num; l__i ++)
+		l__buf[l__i] = kprof_buffer[first + l__i];
+	
+	return num;
+}
@@ -23,6 +23,10 @@
 /* Kernel TSS */
 struct i386_tss_ps *i386_tss_struct;
 
+/* Memory of the TSS and its I/O permission bitmaps */
+static uint8_t i386_tss_area[I386_TSS_AREA_SIZE] 
+			__attribute__ ((aligned (4096)));
+
 /* The address of the ESP0 stack pointer */
 uint32_t i386_esp0_ret;
 
@@ -34,20 +38,38 @@ uint32_t i386_esp0_ret;
  * that is part of the system TSS and is needed for 
  * entering the kernel mode.
  *
+ * The I/O permission bitmaps behind the TSS will be
+ * initialized, too. The "allow all" map permits every
+ * port, the process map denies every port until the
+ * map of a process is loaded (see kio_load_iomap).
+ *
  */
 int ksched_init_tss()
 {
+	int l__i;
+	
 	#ifdef DEBUG_MODE
 		kprintf("Loading system TSS...");
 	#endif
 	
-	i386_tss_struct = (void*)(uintptr_t)kmem_alloc_kernel_pageframe();
-	if (i386_tss_struct == NULL)
+	i386_tss_struct = (void*)i386_tss_area;
+	
+	/* Initialize the I/O permission bitmaps */
+	for (l__i = 0; l__i < I386_TSS_AREA_SIZE; l__i ++)
 	{
-		return -1;
+		if (    (l__i >= I386_IOMAP_ALLOW_ALL)
+		     && (l__i < (I386_IOMAP_ALLOW_ALL + I386_IOMAP_SIZE))
+		   )
+		{
+			i386_tss_area[l__i] = 0x00;
+		}
+		 else
+		{
+			i386_tss_area[l__i] = 0xFF;
+		}
 	}
 
-	/* We don't want an I/O-Map */
+	/* No I/O-Map until the first process is loaded */
 	i386_tss_struct->backl = 0x8000;		
 	i386_tss_struct->esp0 = 0;
 	i386_tss_struct->ss0 = DS_KERNEL;
@@ -74,10 +96,11 @@ int ksched_init_tss()
 	i386_tss_struct->gs = DS_USER;
 	i386_tss_struct->ldt = 0;
 	i386_tss_struct->t = 0;
-	i386_tss_struct->io_base = 5000;
+	i386_tss_struct->io_base = I386_IOMAP_NONE;
 	
 	i386_esp0_ret = (uintptr_t)&(i386_tss_struct->esp0);
 	
+	i386_gdt_s[7].limit_l = I386_TSS_LIMIT;
 	i386_gdt_s[7].base_l = (uintptr_t)i386_tss_struct + 0xC0000000;
 	i386_gdt_s[7].base_lh = 
 		(((uintptr_t)i386_tss_struct + 0xC0000000) >> 16) & 0xFF;	
@@ -73,6 +73,8 @@ enum dbg_client_commands
 	DBG_COM_PUTS = 0x1041,
 	DBG_COM_GETC = 0x1042,
 	DBG_COM_GETS = 0x1043,
+	DBG_COM_CONNECT_RING = 0x1044,
+	DBG_COM_FLUSH = 0x1045,
 
 	DBG_COM_SET_TERMINAL = 0x1050,
 	DBG_COM_GET_TERMFLAGS = 0x1051,
@@ -101,6 +103,7 @@ void dc_interactive_mode(void);
 
 void dc_putc(uint32_t c);
 size_t dc_puts(const utf8_t *str, size_t len);
+void dc_flush(void);
 uint32_t dc_getc(void);
 size_t dc_gets(size_t num, utf8_t *buf);
 
@@ -111,6 +114,31 @@ void dc_set_termcolor(unsigned color);
 
 
 
+/*
+ * Console ring
+ *
+ * Every connected thread shares a page with the debugger. The
+ * output is written to "out" directly and drained by the debugger
+ * on the next debugger call (or if a line is complete or 
+ * DC_RING_WATERMARK is reached). Remaining output is drained when
+ * the client is destroyed.
+ * Input lines of dc_gets are returned in "in".
+ *
+ */
+#define DC_RING_OUT_SIZE		2048
+#define DC_RING_IN_SIZE			1024
+#define DC_RING_WATERMARK		(DC_RING_OUT_SIZE / 2)
+
+typedef struct
+{
+	volatile uint32_t	out_head;	/* Written bytes (client) */
+	volatile uint32_t	out_tail;	/* Drained bytes (debugger) */
+	uint32_t		reserved[2];
+	
+	utf8_t			out[DC_RING_OUT_SIZE];
+	utf8_t			in[DC_RING_IN_SIZE];
+}dc_ring_t;
+
 /*
  * Console functions
  *
@@ -30,6 +30,8 @@ typedef struct spxml_node_st
 	
 	struct spxml_node_st	*children;	/* List of children elements */
 	list_t			ls;		/* List of elements of the same parent */
+	
+	struct spxml_arena_st	*arena;		/* Memory of the tree (owned by the root node) */
 }spxml_node_t;
 
 /* Structure of a SPXML event (event = something found within the text during parsing) */
@@ -63,6 +65,58 @@ typedef struct
 #define SPXMLEVENT_EOF			7
 	/* Invalid Element */
 #define SPXMLEVENT_INVALID		8
+	/* The input is used up, feed the next part (spxml_reader_*) */
+#define SPXMLEVENT_NEED_DATA		9
+
+/* 
+ * State of a streaming SPXML reader. The input is fed in parts
+ * of any size by spxml_reader_feed. Events which cross the end 
+ * of a part are collected in the "carry" buffer of the caller.
+ *
+ */
+typedef struct
+{
+	const utf8_t*	data;		/* Unread input of the current part */
+	size_t		len;		/* Size of the unread input */
+	int		final;		/* No more input will follow */
+	
+	utf8_t*		carry;		/* Buffer for incomplete events */
+	size_t		carry_size;	/* Size of the buffer */
+	size_t		carry_len;	/* Used bytes of the buffer */
+	int		carry_done;	/* The last event was returned from the buffer */
+	
+	unsigned	depth;		/* Depth of the current element */
+	unsigned	match;		/* Matched path elements (spxml_reader_filter) */
+	
+	unsigned	skip;		/* Open elements of the skipped subtree */
+	int		skip_state;	/* Scanner state within the skipped subtree */
+	unsigned	skip_prev;	/* Last two bytes within the skipped subtree */
+}spxml_reader_t;
+
+/* Element of a compiled path */
+typedef struct
+{
+	const utf8_t*	name;		/* Name of the element (within the path text) */
+	size_t		len;		/* Size of the name */
+	uint32_t	hash;		/* Hash of the name */
+}spxml_path_element_t;
+
+/* Compiled simplified XPath (spxml_compile_path) */
+typedef struct
+{
+	utf8_t*		text;		/* Copy of the path */
+	size_t		len;		/* Size of the path */
+	uint32_t	hash;		/* Hash of the path */
+	
+	unsigned		count;		/* Number of path elements */
+	spxml_path_element_t	elements[];	/* Path elements */
+}spxml_path_t;
+
+/* Index of a SPXML tree for the path resolution */
+typedef struct spxml_index_st spxml_index_t;
+
+/* Callback of spxml_reader_filter (return != 0 to stop) */
+typedef int (*spxml_callback_t)(spxml_reader_t *reader, const spxml_event_t *evt, void *ctx);
 	
 /* Functions */
 utf8_t* spxml_replace_stdentities(const utf8_t *text, size_t len);
@@ -72,4 +126,17 @@ void spxml_destroy_tree(spxml_node_t *node);
 
 spxml_node_t* spxml_resolve_path(const utf8_t *path, spxml_node_t *node);
 
+void spxml_reader_init(spxml_reader_t *reader, utf8_t *carry, size_t carry_size);
+int spxml_reader_feed(spxml_reader_t *reader, const utf8_t *data, size_t len);
+int spxml_reader_next(spxml_reader_t *reader, spxml_event_t *evt);
+int spxml_reader_skip(spxml_reader_t *reader);
+int spxml_reader_filter(spxml_reader_t *reader, const utf8_t *path, spxml_callback_t func, void *ctx);
+
+spxml_index_t* spxml_create_index(spxml_node_t *node);
+void spxml_destroy_index(spxml_index_t *index);
+spxml_path_t* spxml_compile_path(const utf8_t *path);
+void spxml_destroy_path(spxml_path_t *path);
+spxml_node_t* spxml_index_lookup(spxml_index_t *index, const spxml_path_t *path);
+spxml_node_t* spxml_index_resolve(spxml_index_t *index, const utf8_t *path);
+
 #endif
@@ -31,6 +31,13 @@
 /* Memory synchronization */
 #define HYSYS_MSYNC()                  asm volatile("add $0, (%%esp)":::"memory")
 
+/*
+ * Clock access (see MAININFO_CLOCK_SEQUENCE)
+ *
+ */
+uint64_t hysys_rtc_read(void);
+uint64_t hysys_time_ns(void);
+
 
 /*
  * Info page access functions
@@ -16,6 +16,7 @@
 #define _SYSCALL_H
 
 #include <hydrixos/types.h>
+#include <hymk/trace.h>
 
 /* Memory managment system calls */
 void hymk_alloc_pages(void* start, unsigned pages);
@@ -40,6 +41,13 @@ void hymk_awake_subject(sid_t subj);
 
 void hymk_yield_thread(sid_t dest);
 void hymk_set_priority(sid_t thrd, unsigned priority, unsigned policy);
+void hymk_set_deadline(sid_t thrd, unsigned runtime, unsigned period);
+
+/* Tracing */
+uint32_t hymk_trace_ctl(uint32_t mask);
+void hymk_profile_ctl(sid_t proc, unsigned depth);
+unsigned hymk_trace_read(trace_record_t *buf, uint32_t first, unsigned num);
+unsigned hymk_profile_read(trace_record_t *buf, uint32_t first, unsigned num);
 
 /* Memory sharing */
 void hymk_allow(sid_t dest_sid, 
@@ -83,6 +91,16 @@ void hymk_move(sid_t dest_sid,
 	       uintptr_t dest_offset
 	      );
 
+void hymk_clone(sid_t dest_sid,
+		void* src_adr,
+		unsigned pages
+	       );
+
+unsigned hymk_merge(sid_t sid,
+		    void* adr,
+		    unsigned pages
+		   );
+
 /* Synchronization */
 sid_t hymk_sync(sid_t other, unsigned timeout, unsigned resyncs);
     
@@ -91,6 +109,14 @@ void hymk_io_allow(sid_t dest, unsigned flags);
 #define IO_ALLOW_IRQ		1u
 #define IO_ALLOW_PORTS		2u
 
+void hymk_io_allow_range(sid_t dest, 
+			 unsigned port, 
+			 unsigned num, 
+			 unsigned op
+			);
+#define IORANGE_DENY		0u
+#define IORANGE_ALLOW		1u
+
 void hymk_io_alloc(uintptr_t src, 
 		  void* dest, 
 		  unsigned pages, 
@@ -104,10 +130,19 @@ void hymk_io_alloc(uintptr_t src,
 void hymk_recv_irq(irq_t irq);
 #define RECV_IRQ_NONE		0xFFFFFFFFu		 
 
+void hymk_irq_mode(irq_t irq, unsigned mode);
+#define IRQMODE_EDGE		0u
+#define IRQMODE_LEVEL		1u
+#define IRQMODE_ACTIVE_LOW	2u
+
 /* Remote control of threads */
 unsigned hymk_recv_softints(sid_t sid, unsigned timeout, unsigned flags);
 #define RECV_AWAKE_OTHER	1u
 #define RECV_TRACE_SYSCALL	2u
+#define RECV_STREAM_SYSCALL	4u
+
+/* Return value of recv_softints: New records in the trace ring */
+#define RECV_STREAM_DATA	0xFFFFFFFEu
 
 /* x86: Count of registers readable with the read_regs system call */
 #define SYSTEM_REGREAD_COUNT	4u
@@ -126,6 +161,32 @@ void hymk_write_regs(sid_t subj, unsigned tp, reg_t rv);
 #define REGS_X86_EFLAGS		3u
 #define REGS_X86_BREAKPOINTS	4u
 #define REGS_X86_DEBUG_SETUP	5u
+#define REGS_X86_FRAME		6u
+#define REGS_X86_FRAME_FPU	7u
+
+/* x86: Complete register frame (REGS_X86_FRAME, REGS_X86_FRAME_FPU) */
+typedef struct
+{
+	uint32_t	eax, ebx, ecx, edx;
+	uint32_t	esi, edi, ebp, esp;
+	uint32_t	eip, eflags;
+	uint32_t	cs, ss, ds, es, fs, gs;	/* Read-only */
+	
+	/* Only used by REGS_X86_FRAME_FPU */
+	uint32_t	fpu_format;		/* REG_FPU_* */
+	uint32_t	reserved[3];
+	uint8_t		fpu[512];		/* FSAVE or FXSAVE image */
+}reg_frame_t;
+
+/* Size of the register frame without the FPU state */
+#define REG_FRAME_SIZE		(16 * 4)
+
+#define REG_FPU_NONE		0u
+#define REG_FPU_FSAVE		1u
+#define REG_FPU_FXSAVE		2u
+
+void hymk_read_frame(sid_t subj, unsigned tp, reg_frame_t *frame);
+void hymk_write_frame(sid_t subj, unsigned tp, const reg_frame_t *frame);
 
 /* Paging Daemon */
 void hymk_set_paged(void);
@@ -135,4 +196,23 @@ unsigned hymk_test_page(uintptr_t adr, sid_t sid);
 #define PGA_WRITE		2u
 #define PGA_EXECUTE		4u
 
+/* Batched page fault handling */
+typedef struct
+{
+	sid_t		thread;		/* Faulting thread */
+	uint32_t	number;		/* Platform exception number */
+	uintptr_t	adr;		/* Fault address (or IP of other exceptions) */
+	uint32_t	descr;		/* Page table entry of the fault address */
+}paged_fault_t;
+
+typedef struct
+{
+	sid_t		thread;		/* Thread to awake */
+	uintptr_t	src_adr;	/* Page to map to the fault address (or null) */
+	unsigned	flags;		/* MAP_WRITE, MAP_EXECUTABLE, MAP_PAGED */
+}paged_resolve_t;
+
+unsigned hymk_recv_pagefaults(paged_fault_t *buf, unsigned max);
+unsigned hymk_resolve_pagefaults(paged_resolve_t *list, unsigned num);
+
 #endif
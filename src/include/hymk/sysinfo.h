@@ -31,6 +31,40 @@
 #define MAININFO_CPU_ID_CODE		9
 #define MAININFO_PAGE_SIZE		10
 #define MAININFO_MAX_PAGE_OPERATION	11
+#define MAININFO_RECLAIMED_PAGES	12
+#define MAININFO_RECLAIM_PENDING	13
+#define MAININFO_IRQ_LINES		14
+#define MAININFO_DEADLINE_BANDWIDTH	15
+#define MAININFO_CLOCK_SEQUENCE		16
+#define MAININFO_CLOCK_TSC_LOW		17
+#define MAININFO_CLOCK_TSC_HIGH		18
+#define MAININFO_CLOCK_NS_LOW		19
+#define MAININFO_CLOCK_NS_HIGH		20
+#define MAININFO_CLOCK_MULT		21
+#define MAININFO_CLOCK_TICK_NS		22
+#define MAININFO_CLOCK_TSC_KHZ		23
+#define MAININFO_TRACE_RECORDS		24
+#define MAININFO_TRACE_HEAD		25
+#define MAININFO_TRACE_MASK		26
+#define MAININFO_PROFILE_SAMPLES	27
+#define MAININFO_PROFILE_DROPPED	28
+
+/*
+ * High resolution clock
+ *
+ * The entries MAININFO_RTC_COUNTER_* and MAININFO_CLOCK_*
+ * are guarded by MAININFO_CLOCK_SEQUENCE, which is odd while
+ * the kernel changes them. A reader has to retry if the
+ * sequence was odd or changed during its read.
+ *
+ * If MAININFO_CLOCK_MULT is not 0, the time in nanoseconds is
+ *
+ *	CLOCK_NS + (((TSC - CLOCK_TSC) * CLOCK_MULT) >> MAININFO_CLOCK_SHIFT)
+ *
+ * Otherwise it is RTC_COUNTER * CLOCK_TICK_NS.
+ *
+ */
+#define MAININFO_CLOCK_SHIFT		24
 
 #define MAININFO_X86_CPU_NAME_PART_1	100
 #define MAININFO_X86_CPU_NAME_PART_2	101
@@ -40,6 +74,24 @@
 #define MAININFO_X86_CPU_MODEL		105
 #define MAININFO_X86_CPU_STEPPING	106
 #define MAININFO_X86_RAM_SIZE		107
+#define MAININFO_X86_APIC_ACTIVE	108
+
+/*
+ * Latency histograms of the IRQ handler threads
+ *
+ * Bucket 'n' of IRQ 'irq' counts the IRQs that were passed 
+ * to their handler thread after less than 2^(n + 8) TSC 
+ * cycles (but at least 2^(n + 7) cycles). The last bucket
+ * also counts all slower IRQs.
+ *
+ */
+#define MAININFO_IRQ_LATENCY_START	512
+#define MAININFO_IRQ_LATENCY_BUCKETS	16
+#define MAININFO_IRQ_LATENCY(___irq, ___n)	\
+		(  MAININFO_IRQ_LATENCY_START \
+		 + ((___irq) * MAININFO_IRQ_LATENCY_BUCKETS) \
+		 + (___n) \
+		)
 
 /*
  * The process table entries
@@ -58,6 +110,16 @@
 #define PRCTAB_THREAD_COUNT		10
 #define PRCTAB_THREAD_LIST_BEGIN	11
 #define PRCTAB_UNIQUE_ID		12
+#define PRCTAB_RECLAIM_NEXT		13
+#define PRCTAB_RECLAIM_TABLE		14
+#define PRCTAB_IO_BITMAP_LOW		15
+#define PRCTAB_IO_BITMAP_HIGH		16
+#define PRCTAB_IO_BITMAP_SIZE		17
+
+/* CPU time of all threads of the process (TSC cycles and timer ticks) */
+#define PRCTAB_CPU_TIME_LOW		18
+#define PRCTAB_CPU_TIME_HIGH		19
+#define PRCTAB_CPU_TICKS		20
 
 #define PRCTAB_X86_MMTABLE		1024
 
@@ -103,12 +165,51 @@
 
 #define THRTAB_UNIQUE_ID		31
 
+/* Parameters of THRSCHED_CLASS_DEADLINE (in timer ticks) */
+#define THRTAB_DEADLINE_RUNTIME		32
+#define THRTAB_DEADLINE_PERIOD		33
+#define THRTAB_DEADLINE_BUDGET		34
+#define THRTAB_DEADLINE_LOW		35
+#define THRTAB_DEADLINE_HIGH		36
+
+/* Priority and class inherited from waiting threads (see sync) */
+#define THRTAB_INHERITED_PRIORITY	37
+#define THRTAB_INHERITED_CLASS		38
+
+/* Scheduler statistics */
+#define THRTAB_CPU_TIME_LOW		39	/* Run time (TSC cycles) */
+#define THRTAB_CPU_TIME_HIGH		40
+#define THRTAB_CPU_TICKS		41	/* Timer ticks while running */
+#define THRTAB_VOLUNTARY_SWITCHES	42	/* Blocked or yielded */
+#define THRTAB_INVOLUNTARY_SWITCHES	43	/* Preempted */
+#define THRTAB_WAIT_TIME_LOW		44	/* Time in the run queue (TSC cycles) */
+#define THRTAB_WAIT_TIME_HIGH		45
+#define THRTAB_WAKEUPS			46	/* Insertions into the run queue */
+#define THRTAB_SYNC_COUNT		47	/* Calls of sync */
+#define THRTAB_PAGEFAULT_COUNT		48	/* Page faults */
+#define THRTAB_IRQ_COUNT		49	/* IRQs handled */
+
 /* x86-Implementation defined elements */
 #define THRTAB_CUR_SYNC_QUEUE_PREV	50
 #define THRTAB_CUR_SYNC_QUEUE_NEXT	51
 #define THRTAB_OWN_SYNC_QUEUE_BEGIN	52
 #define THRTAB_TIMEOUT_QUEUE_PREV	53
 #define THRTAB_TIMEOUT_QUEUE_NEXT	54
+#define THRTAB_PAGED_QUEUE_PREV		55
+#define THRTAB_PAGED_QUEUE_NEXT		56
+#define THRTAB_MEMOP_RESTART_OP		57
+#define THRTAB_MEMOP_RESTART_ADR	58
+#define THRTAB_MEMOP_RESTART_PAGES	59
+#define THRTAB_MEMOP_RESTART_DONE	60
+#define THRTAB_MEMOP_RESTART_RESULT	63	/* Partial result (merge) */
+#define THRTAB_THROTTLE_NEXT		64	/* List of throttled deadline threads */
+#define THRTAB_THROTTLE_COUNT		65	/* Budget overruns of a deadline thread */
+#define THRTAB_MEMOP_RESTART_SID	66
+#define THRTAB_MEMOP_RESTART_FLAGS	67
+#define THRTAB_MEMOP_RESTART_OFFSET	68
+/* TSC value of the last switch to or from the thread or of its wakeup */
+#define THRTAB_X86_ACCOUNT_TSC_LOW	61
+#define THRTAB_X86_ACCOUNT_TSC_HIGH	62
 
 /* Kernel stack pointer */
 #define THRTAB_X86_KERNEL_POINTER	100
@@ -131,8 +232,11 @@
 #define THRSTAT_WAIT_HYPAGED		256
 #define THRSTAT_PROC_DEFUNC		512
 #define THRSTAT_TRACE_ONLY		1024
+#define THRSTAT_RECV_PAGEFAULTS		2048
+#define THRSTAT_TRACE_STREAM		4096
+#define THRSTAT_THROTTLED		8192
 
-#define THRSTAT_OTHER_FREEZE		(THRSTAT_IRQ|THRSTAT_SYNC|THRSTAT_RECV_SOFTINT|THRSTAT_WAIT_HYPAGED|THRSTAT_PROC_DEFUNC)
+#define THRSTAT_OTHER_FREEZE		(THRSTAT_IRQ|THRSTAT_SYNC|THRSTAT_RECV_SOFTINT|THRSTAT_WAIT_HYPAGED|THRSTAT_PROC_DEFUNC|THRSTAT_RECV_PAGEFAULTS|THRSTAT_THROTTLED)
 
 /* Priority constants */
 #define THRPRIOR_MIN		0
@@ -146,8 +250,11 @@
 
 /* Scheduling class constants */
 #define THRSCHED_CLASS_MIN	0
-#define THRSCHED_CLASS_MAX	0
+#define THRSCHED_CLASS_MAX	3
 
 #define THRSCHED_CLASS_NORMAL	0 
+#define THRSCHED_CLASS_RR	1
+#define THRSCHED_CLASS_FIFO	2
+#define THRSCHED_CLASS_DEADLINE	3
 
 #endif
@@ -0,0 +1,87 @@
+/*
+ *
+ * hymk/trace.h
+ *
+ * (C)2007 by Friedrich Grter
+ *
+ * This file is distributed under the terms of
+ * the GNU Lesser General Public License, Version 2. You
+ * should have received a copy of this license (e.g. in 
+ * the file 'copying.library'). 
+ *
+ * Kernel trace ring
+ *
+ */
+#ifndef _TRACE_H
+#define _TRACE_H
+
+#include <hydrixos/types.h>
+#include <hydrixos/sid.h>
+
+/*
+ * Categories of trace events (for trace_ctl)
+ *
+ */
+#define TRACE_CAT_SCHED		0x00000001u	/* Thread switches and wakeups */
+#define TRACE_CAT_SYSCALL	0x00000002u	/* System call entry and exit */
+#define TRACE_CAT_FAULT		0x00000004u	/* User mode page faults */
+#define TRACE_CAT_IRQ		0x00000008u	/* IRQs passed to handler threads */
+#define TRACE_CAT_TIMEOUT	0x00000010u	/* Expired timeouts */
+#define TRACE_CAT_ALL		0x0000001Fu
+
+#define TRACE_RESET		0x80000000u	/* Discard all records */
+
+/*
+ * Types of trace records
+ *
+ *				arg[0]		arg[1]		arg[2]		arg[3]
+ */
+#define TRACE_SWITCH		1	/* Next thread	Voluntary	-		- */
+#define TRACE_WAKEUP		2	/* Woken thread	-		-		- */
+#define TRACE_SYSCALL_ENTER	3	/* Number	EAX		EBX		ECX */
+#define TRACE_SYSCALL_EXIT	4	/* Number	Cycles		Error		- */
+#define TRACE_PAGEFAULT		5	/* Address	Error code	EIP		- */
+#define TRACE_IRQ		6	/* IRQ number	Handler thread	-		- */
+#define TRACE_TIMEOUT		7	/* Woken thread	-		-		- */
+#define TRACE_SAMPLE		8	/* EIP		Return adr. 1	Return adr. 2	Return adr. 3 (profile_read only) */
+#define TRACE_SYSCALL_ARGS	9	/* EDX		ESI		EDI		EBP */
+
+#define TRACE_TYPE_MAX		9
+
+/* Maximal number of return addresses of a profiler sample */
+#define TRACE_SAMPLE_DEPTH	3
+
+/*
+ * Trace record (32 bytes)
+ *
+ */
+typedef struct
+{
+	uint32_t	tsc_low;	/* Time stamp counter */
+	uint32_t	tsc_high;
+	uint16_t	type;		/* TRACE_* */
+	uint16_t	cpu;		/* Number of the CPU */
+	sid_t		thread;		/* Current thread */
+	uint32_t	arg[4];		/* Type specific arguments */
+}trace_record_t;
+
+/*
+ * Header of the trace ring (kernel internal)
+ *
+ * The records follow the header page. The kernel writes
+ * record (head % size) and increments "head" afterwards.
+ * All records older than (head - size) are overwritten.
+ * User mode reads "head", "mask" and "size" from the main 
+ * info page (MAININFO_TRACE_HEAD, _MASK and _RECORDS) and 
+ * copies the records by the trace_read system call.
+ *
+ */
+typedef struct
+{
+	volatile uint32_t	head;		/* Count of written records */
+	volatile uint32_t	mask;		/* Active categories */
+	uint32_t		size;		/* Capacity in records (power of 2) */
+	uint32_t		record_size;	/* sizeof(trace_record_t) */
+}trace_header_t;
+
+#endif
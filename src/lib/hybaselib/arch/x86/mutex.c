@@ -24,7 +24,8 @@
 /*
  * mtx_trylock (mutex)
  *
- * Tries to lock the lock "mutex" atomically.
+ * Tries to lock the lock "mutex" atomically. The
+ * SID of the locking thread is stored into the mutex.
  * 
  * Return value:
  *	0	If the mutex couldn't be locked.
@@ -45,7 +46,7 @@ int mtx_trylock(mtx_t *mutex)
 	 * Compare the value of the mutex with
 	 * the value 0 (stored in EAX). If it
 	 * is equal "cmpxchgl" will set 'mutex'
-	 * to the value 1 atomically.
+	 * to the SID of the current thread atomically.
 	 * Otherwise "cmpxchgl" will store
 	 * the content of 'mutex' to the register EAX
 	 * which will be stored to 'l__a'
@@ -57,11 +58,13 @@ int mtx_trylock(mtx_t *mutex)
 	 */
 	__asm__ __volatile__ ("lock cmpxchgl %%edx, (%%ebx)\n\t"
 	     	      	      : "=a" (l__a)
-	     	      	      : "d" (1), "a" (0), "b" ((uintptr_t)&(mutex->mutex)) 
+	     	      	      : "d" (hysys_info_read(MAININFO_CURRENT_THREAD)), 
+	     	      	        "a" (0), 
+	     	      	        "b" ((uintptr_t)&(mutex->mutex)) 
 	     	      	      : "memory"
 	     	      	     );
 
-	/* l__a will be set to 1, if the mutex was already locked.
+	/* l__a will be set to the owner, if the mutex was already locked.
 	 * l__a will stay at 0, if the mutex have been locked now.
 	 */
 	if (l__a)
@@ -115,7 +118,9 @@ void mtx_unlock(mtx_t *mutex)
  * is currently locked, the function tries to
  * wait for the unlocking of the mutex using the
  * thread_yield-Operation until "timeout" tries
- * where failed. If "timeout" is -1 the function
+ * where failed. The rest of the time slice is
+ * given to the owner of the mutex, so it can 
+ * unlock the mutex earlier. If "timeout" is -1 the function
  * will make unlimited tries for locking the mutex.
  *
  * Return value:
@@ -145,10 +150,15 @@ int mtx_lock(mtx_t *mutex, long timeout)
 	{
 		if (!mtx_trylock(mutex))
 		{
+			sid_t l__owner = mutex->mutex;
+			errno_t l__errno = *tls_errno;
+			
 			/* Set up the latency flag */
 			mutex->latency = 1;			
 			
-			blthr_yield(0);
+			/* Give our time to the owner (errors are ignored) */
+			blthr_yield(l__owner);
+			*tls_errno = l__errno;
 		}
 		 else
 		{
@@ -270,6 +270,28 @@ void hymk_write_regs(sid_t subj, unsigned tp, reg_t rv)
 	                    );
 }
 
+void hymk_read_frame(sid_t subj, unsigned tp, reg_frame_t *frame)
+{
+	__asm__ __volatile__("int $0xD3\n"
+	                     : "=a" (*tls_errno)
+	                     : "a" (subj),
+	                       "b" (tp),
+	                       "c" (frame)
+	                     : "memory"
+	                    );
+}
+
+void hymk_write_frame(sid_t subj, unsigned tp, const reg_frame_t *frame)
+{
+	__asm__ __volatile__("int $0xD4\n"
+	                     : "=a" (*tls_errno)
+	                     : "a" (subj),
+	                       "b" (tp),
+	                       "c" (frame)
+	                     : "memory"
+	                    );
+}
+
 void hymk_set_paged(void)
 {
 	__asm__ __volatile__("int $0xD5\n"
@@ -294,3 +316,148 @@ unsigned hymk_test_page(uintptr_t adr, sid_t sid)
 	return l__retval;
 }
 
+void hymk_clone(sid_t subj, void* adr, unsigned pages)
+{
+	__asm__ __volatile__("int $0xD7\n"
+	                     : "=a" (*tls_errno)
+	                     : "a" (subj),
+	                       "b" ((uintptr_t)adr),
+	                       "c" (pages)
+	                     : "memory"
+	                    );
+}
+
+unsigned hymk_merge(sid_t sid, void* adr, unsigned pages)
+{
+	unsigned l__retval = 0;
+	
+	__asm__ __volatile__("int $0xD8\n"
+	                     : "=a" (*tls_errno),
+	                       "=b" (l__retval)
+	                     : "a" (sid),
+	                       "b" ((uintptr_t)adr),
+	                       "c" (pages)
+	                     : "memory"
+	                    );
+	   
+	return l__retval;
+}
+
+unsigned hymk_recv_pagefaults(paged_fault_t *buf, unsigned max)
+{
+	unsigned l__retval = 0;
+	
+	__asm__ __volatile__("int $0xD9\n"
+	                     : "=a" (*tls_errno),
+	                       "=b" (l__retval)
+	                     : "a" ((uintptr_t)buf),
+	                       "b" (max)
+	                     : "memory"
+	                    );
+	   
+	return l__retval;
+}
+
+unsigned hymk_resolve_pagefaults(paged_resolve_t *list, unsigned num)
+{
+	unsigned l__retval = 0;
+	
+	__asm__ __volatile__("int $0xDA\n"
+	                     : "=a" (*tls_errno),
+	                       "=b" (l__retval)
+	                     : "a" ((uintptr_t)list),
+	                       "b" (num)
+	                     : "memory"
+	                    );
+	   
+	return l__retval;
+}
+
+void hymk_io_allow_range(sid_t subj, unsigned port, unsigned num, unsigned op)
+{
+	__asm__ __volatile__("int $0xDB\n"
+	                     : "=a" (*tls_errno)
+	                     : "a" (subj),
+	                       "b" (port),
+	                       "c" (num),
+	                       "d" (op)
+	                     : "memory"
+	                    );
+}
+
+void hymk_irq_mode(irq_t irq, unsigned mode)
+{
+	__asm__ __volatile__("int $0xDC\n"
+	                     : "=a" (*tls_errno)
+	                     : "a" (irq),
+	                       "b" (mode)
+	                     : "memory"
+	                    );
+}
+
+void hymk_set_deadline(sid_t thrd, unsigned runtime, unsigned period)
+{
+	__asm__ __volatile__("int $0xDD\n"
+	                     : "=a" (*tls_errno)
+	                     : "a" (thrd),
+	                       "b" (runtime),
+	                       "c" (period)
+	                     : "memory"
+	                    );
+}
+
+uint32_t hymk_trace_ctl(uint32_t mask)
+{
+	uint32_t l__retval = 0;
+	
+	__asm__ __volatile__("int $0xDE\n"
+	                     : "=a" (*tls_errno),
+	                       "=b" (l__retval)
+	                     : "a" (mask)
+	                     : "memory"
+	                    );
+	
+	return l__retval;
+}
+
+void hymk_profile_ctl(sid_t proc, unsigned depth)
+{
+	__asm__ __volatile__("int $0xDF\n"
+	                     : "=a" (*tls_errno)
+	                     : "a" (proc),
+	                       "b" (depth)
+	                     : "memory"
+	                    );
+}
+
+unsigned hymk_trace_read(trace_record_t *buf, uint32_t first, unsigned num)
+{
+	unsigned l__retval = 0;
+	
+	__asm__ __volatile__("int $0xE0\n"
+	                     : "=a" (*tls_errno),
+	                       "=b" (l__retval)
+	                     : "a" ((uintptr_t)buf),
+	                       "b" (first),
+	                       "c" (num)
+	                     : "memory"
+	                    );
+	   
+	return l__retval;
+}
+
+unsigned hymk_profile_read(trace_record_t *buf, uint32_t first, unsigned num)
+{
+	unsigned l__retval = 0;
+	
+	__asm__ __volatile__("int $0xE1\n"
+	                     : "=a" (*tls_errno),
+	                       "=b" (l__retval)
+	                     : "a" ((uintptr_t)buf),
+	                       "b" (first),
+	                       "c" (num)
+	                     : "memory"
+	                    );
+	   
+	return l__retval;
+}
@@ -0,0 +1,102 @@
+/*
+ *
+ * time.c
+ *
+ * (C)2007 by Friedrich Grter
+ *
+ * This file is distributed under the terms of
+ * the GNU Lesser General Public License, Version 2. You
+ * should have received a copy of this license (e.g. in 
+ * the file 'copying.library').   
+ *
+ * Clock access without system calls
+ *
+ */
+#include <hydrixos/types.h>
+#include <hydrixos/system.h>
+#include "../../hybaselib.h"
+
+/* Compiler barrier */
+#define TIME_BARRIER()		__asm__ __volatile__("":::"memory")
+
+/*
+ * hysys_rtc_read()
+ *
+ * Reads the 64-bit timer tick counter of the kernel
+ * consistently.
+ *
+ * Return value:
+ *	Timer ticks since the system start
+ *
+ */
+uint64_t hysys_rtc_read(void)
+{
+	volatile uint32_t *l__info = (void*)(uintptr_t)ARCH_MAIN_INFO_PAGE;
+	uint32_t l__seq;
+	uint64_t l__rtc;
+	
+	do
+	{
+		l__seq = l__info[MAININFO_CLOCK_SEQUENCE];
+		TIME_BARRIER();
+		
+		l__rtc =   (((uint64_t)l__info[MAININFO_RTC_COUNTER_HIGH]) << 32)
+			 | l__info[MAININFO_RTC_COUNTER_LOW];
+		
+		TIME_BARRIER();
+	}while ((l__seq & 1) || (l__seq != l__info[MAININFO_CLOCK_SEQUENCE]));
+	
+	return l__rtc;
+}
+
+/*
+ * hysys_time_ns()
+ *
+ * Reads the time in nanoseconds since the system start. The
+ * time is calculated from the TSC if the kernel calibrated
+ * it. Otherwise it has the resolution of a timer tick.
+ *
+ * Return value:
+ *	Time in nanoseconds
+ *
+ */
+uint64_t hysys_time_ns(void)
+{
+	volatile uint32_t *l__info = (void*)(uintptr_t)ARCH_MAIN_INFO_PAGE;
+	uint32_t l__seq;
+	uint32_t l__mult;
+	uint32_t l__tick_ns;
+	uint64_t l__rtc;
+	uint64_t l__base_tsc;
+	uint64_t l__base_ns;
+	uint64_t l__delta;
+	
+	/* Read a consistent copy of the clock */
+	do
+	{
+		l__seq = l__info[MAININFO_CLOCK_SEQUENCE];
+		TIME_BARRIER();
+		
+		l__rtc =   (((uint64_t)l__info[MAININFO_RTC_COUNTER_HIGH]) << 32)
+			 | l__info[MAININFO_RTC_COUNTER_LOW];
+		l__base_tsc =   (((uint64_t)l__info[MAININFO_CLOCK_TSC_HIGH]) << 32)
+			      | l__info[MAININFO_CLOCK_TSC_LOW];
+		l__base_ns =   (((uint64_t)l__info[MAININFO_CLOCK_NS_HIGH]) << 32)
+			     | l__info[MAININFO_CLOCK_NS_LOW];
+		l__mult = l__info[MAININFO_CLOCK_MULT];
+		l__tick_ns = l__info[MAININFO_CLOCK_TICK_NS];
+		
+		TIME_BARRIER();
+	}while ((l__seq & 1) || (l__seq != l__info[MAININFO_CLOCK_SEQUENCE]));
+	
+	/* No TSC available */
+	if (l__mult == 0) return l__rtc * l__tick_ns;
+	
+	__asm__ __volatile__("rdtsc\n" : "=A" (l__delta));
+	l__delta -= l__base_tsc;
+	
+	/* 96-bit product of the delta and the scale factor */
+	return   l__base_ns
+	       + ((((uint64_t)(uint32_t)l__delta) * l__mult) >> MAININFO_CLOCK_SHIFT)
+	       + (((l__delta >> 32) * l__mult) << (32 - MAININFO_CLOCK_SHIFT));
+}
@@ -21,6 +21,22 @@
 	
 /* From which SPXMLEVENT_-number we can ignore events? */
 #define SPXML_IGNORABLE_EVENTS		1
+
+/* Size of a chunk of the node arena */
+#define SPXML_ARENA_CHUNK		4096
+
+/* 
+ * Header of a chunk of the node arena. The nodes of a tree are
+ * allocated from these chunks and released together with the
+ * tree. The first chunk is the arena of the tree.
+ *
+ */
+typedef struct spxml_arena_st
+{
+	struct spxml_arena_st	*next;		/* Next chunk */
+	spxml_node_t		*root;		/* Root node (owner) of the arena */
+	size_t			used;		/* Used bytes of the chunk */
+}spxml_arena_t;
 	
 /* Table of possible SPXML evenets */
 static struct
@@ -120,192 +136,435 @@ utf8_t* spxml_replace_stdentities(const utf8_t *text, size_t len)
 }
 
 /*
- * spxml_end_of_event(&val, str, len)
+ * Structural scanner
  *
- * Searches the end of the event "val" which is marked
- * by "str". In returns the end position in to the structure
- * val. The string "str" has a maximum length of "len"
+ * The tokenizer classifies its input in blocks of 16 bytes. For
+ * every block it gets bitmasks of the positions of "<", ">", the
+ * whitespace characters and the 0 character (bit n = byte n of
+ * the block). Character data and the contents of tags are skipped
+ * by searching these masks instead of testing every byte. The kind
+ * of an element is decided by the byte after "<" and the end of
+ * an element by the bytes before ">".
  *
- *	1	End of event found
- *	0	End of event not found
+ * Four bytes are compared at once within a 32-bit word (SWAR),
+ * so the scanner needs no vector unit of the CPU.
  *
  */
-static inline int spxml_end_of_event(spxml_event_t *val, const utf8_t *str, size_t len)
+#define SPXML_BLOCK			16
+
+typedef struct
 {
-	utf8_t *l__end = str_find(val->position, val->len, str, len + 1);
-	if (l__end == NULL) return 0;
-	
-	val->len = l__end - val->position;
-	val->total_len = (l__end - val->position) + spxml_event_types[val->type].elen;
+	uint32_t	lt;		/* "<" */
+	uint32_t	gt;		/* ">" */
+	uint32_t	ws;		/* CR, LF, TAB and SPACE */
+	uint32_t	nul;		/* 0 character */
+}spxml_masks_t;
+
+/* Classes of characters to classify (spxml_classify) */
+#define SPXML_CLASS_GT			1	/* ">" */
+#define SPXML_CLASS_STOP		2	/* "<" (0 is always classified) */
+#define SPXML_CLASS_WS			4	/* Whitespace */
+
+typedef uint32_t spxml_word_t __attribute__((aligned(1)));
+
+/*
+ * spxml_match(word, c)
+ *
+ * Returns the mask of the bytes of "word" that are equal to "c"
+ * (bits 0 - 3).
+ *
+ */
+static inline uint32_t spxml_match(uint32_t word, uint32_t c)
+{
+	/* Set bit 7 of every byte which is 0 after the XOR */
+	word ^= c * 0x01010101u;
+	word = ~(((word & 0x7F7F7F7Fu) + 0x7F7F7F7Fu) | word) & 0x80808080u;
 	
-	return 1;
+	/* Gather these bits to the bits 21 - 24 */
+	return (((word >> 7) * 0x00204081u) >> 21) & 0xF;
 }
 
 /*
- * spxml_probe_element(&val, type)
+ * spxml_classify_block(xml, masks, classes)
  *
- * Test if the event "val" is a SPXML element of type "type",
- * which normally begins with "begin" and ends with "end".
- * "begin" has a length of "blen" bytes and "end" a length
- * of "elen" bytes.
- * The length element of "val" (val->len) has to be specified
- * to run this function.
- *
- * Return Value:
- * 	1 	Element found, the datas will be passed to "val"
- *	0	Element not found
+ * Classifies the 16 bytes at "xml" to "masks". Only the
+ * character classes "classes" (SPXML_CLASS_*) and the 0
+ * character are set. The words behind the first 0 character
+ * are not read.
  *
  */
-static inline int spxml_probe_element(spxml_event_t *val, int type)
+static inline void spxml_classify_block(const utf8_t *xml, spxml_masks_t *masks, unsigned classes)
 {
-	utf8_t *l__buf = mem_alloc(5);
-	str_copy(l__buf, val->position, 4);
-	l__buf[4] = 0;	
-	mem_free(l__buf);
-		
-	if (!str_compare(val->position, spxml_event_types[type].begin, spxml_event_types[type].blen))
+	unsigned l__i;
+	
+	masks->lt = 0;
+	masks->gt = 0;
+	masks->ws = 0;
+	masks->nul = 0;
+	
+	for (l__i = 0; l__i < (SPXML_BLOCK / 4); l__i ++)
 	{
-		val->type = type;
-		if (!spxml_end_of_event(val, spxml_event_types[type].end, spxml_event_types[type].elen)) return 0;
+		uint32_t l__word = ((const spxml_word_t*)xml)[l__i];
+		
+		if (classes & SPXML_CLASS_GT)
+			masks->gt |= spxml_match(l__word, '>') << (l__i * 4);
+		
+		if (classes & SPXML_CLASS_STOP)
+			masks->lt |= spxml_match(l__word, '<') << (l__i * 4);
+		
+		if (classes & SPXML_CLASS_WS)
+		{
+			masks->ws |= (  spxml_match(l__word, ' ') | spxml_match(l__word, '\t')
+				      | spxml_match(l__word, 10) | spxml_match(l__word, 13)
+				     ) << (l__i * 4);
+		}
 		
-		val->content = val->position + spxml_event_types[type].blen;
-		val->len -= spxml_event_types[type].blen;
+		/* End of the input */
+		masks->nul |= spxml_match(l__word, 0) << (l__i * 4);
+		if (masks->nul) break;
+	}
+}
 
-		return 1;
+/*
+ * spxml_classify(xml, len, masks, classes)
+ *
+ * Classifies the character classes "classes" of the next block
+ * of "xml" to "masks". The input has "len" remaining bytes, a
+ * shorter block than SPXML_BLOCK is copied to a buffer before.
+ * Like the input, the block ends at the first 0 character.
+ *
+ * Return value:
+ *	Mask of the valid bytes of the block (up to and
+ *	including the first 0 character)
+ *
+ */
+static inline uint32_t spxml_classify(const utf8_t *xml, size_t len, spxml_masks_t *masks, unsigned classes)
+{
+	uint32_t l__valid = (1u << SPXML_BLOCK) - 1;
+	
+	if (len >= SPXML_BLOCK)
+	{
+		spxml_classify_block(xml, masks, classes);
 	}
 	 else
 	{
-		return 0;
+		utf8_t l__buf[SPXML_BLOCK] = {0};
+		
+		l__valid = (1u << len) - 1;
+		
+		buf_copy(l__buf, xml, len);
+		spxml_classify_block(l__buf, masks, classes);
+		
+		masks->nul &= l__valid;
 	}
+	
+	/* Nothing behind the 0 character belongs to the input */
+	if (masks->nul)
+		l__valid &= (masks->nul ^ (masks->nul - 1));
+	
+	masks->lt &= l__valid;
+	masks->gt &= l__valid;
+	masks->ws &= l__valid;
+	masks->nul &= l__valid;
+	
+	return l__valid;
 }
 
 /*
- * spxml_is_whitespace(str, len)
+ * spxml_scan_text(xml, len, &ws)
  *
- * Test if the string "str" contains only 
- * whitespace up to "len".
+ * Searches the end of the character data at "xml" ("len"
+ * bytes). "ws" is set to 1, if the data contains only
+ * whitespace, otherwise it is set to 0.
  *
  * Return value:
- *	2	If it contains the 0 charracter
- *	1	If it contains only whitespaces
- *	0	Other charracters found
+ *	Pointer to the next "<" or 0 character, or to the
+ *	end of the input
+ *
  */
-static inline int spxml_is_whitespace(const utf8_t *str, size_t len)
+static inline const utf8_t* spxml_scan_text(const utf8_t *xml, size_t len, int *ws)
 {
-	while (len --)
+	const utf8_t *l__end = xml + len;
+	
+	*ws = 1;
+	
+	while (xml < l__end)
 	{
-		if ((*str != 13) && (*str != 10) && (*str != '\t') && (*str != ' ') && (*str != 0))
+		spxml_masks_t l__masks;
+		uint32_t l__text;
+		uint32_t l__stop;
+		
+		/* Whitespace is only of interest until other data is found */
+		if (*ws)
 		{
-			return 0;
+			l__text = spxml_classify(xml, l__end - xml, &l__masks, SPXML_CLASS_STOP | SPXML_CLASS_WS);
+			l__text &= ~l__masks.ws;
+		}
+		 else
+		{
+			l__text = 0;
+			spxml_classify(xml, l__end - xml, &l__masks, SPXML_CLASS_STOP);
+		}
+		
+		l__stop = l__masks.lt | l__masks.nul;
+		
+		if (l__stop)
+		{
+			unsigned l__pos = __builtin_ctz(l__stop);
+			
+			if (l__text & ((1u << l__pos) - 1)) *ws = 0;
+			return xml + l__pos;
 		}
 		
-		if (*str == 0)
-			return 2;
+		if (l__text) *ws = 0;
 		
-		str ++;
+		if ((size_t)(l__end - xml) <= SPXML_BLOCK) break;
+		xml += SPXML_BLOCK;
 	}
 	
-	return (*str == 0) ? 2 : 1;
+	return l__end;
 }
 
 /*
- * spxml_next_event(xml, len, &evt)
+ * spxml_scan_close(xml, len, type)
  *
- * Searches the string "xml" for the next SPXML event and
- * returns informations about it. The string has a maximum
- * length of "len" bytes. The return value will be passed to
- * "evt".
+ * Searches the end sequence of an element of the type "type"
+ * within the first "len" bytes of "xml". All end sequences
+ * end with ">". 
+ *
+ * Return value:
+ *	Pointer to the end sequence
+ *	NULL, if not found
  *
  */
- 
-static inline void spxml_next_event(const utf8_t *xml, size_t len, spxml_event_t *evt)
+static inline const utf8_t* spxml_scan_close(const utf8_t *xml, size_t len, int type)
 {
-	evt->position = xml;
+	const utf8_t *l__start = xml;
+	const utf8_t *l__end = xml + len;
+	size_t l__prefix = spxml_event_types[type].elen - 1;
 	
-	/* Test parameters */
-	if (evt == NULL) return;
-	if ((xml == NULL) || (len == 0)) {evt->type = SPXMLEVENT_INVALID; return;}	
+	while (xml < l__end)
+	{
+		spxml_masks_t l__masks;
+		
+		spxml_classify(xml, l__end - xml, &l__masks, SPXML_CLASS_GT);
+		
+		while (l__masks.gt)
+		{
+			const utf8_t *l__pos = xml + __builtin_ctz(l__masks.gt);
+			
+			/* Test the bytes before ">" */
+			if (    (l__prefix == 0)
+			     || (    ((size_t)(l__pos - l__start) >= l__prefix)
+			          && (!buf_compare(l__pos - l__prefix, spxml_event_types[type].end, l__prefix))
+			        )
+			   )
+			{
+				return l__pos - l__prefix;
+			}
+			
+			l__masks.gt &= l__masks.gt - 1;
+		}
+		
+		/* Not behind the end of the input */
+		if (l__masks.nul) break;
+		
+		if ((size_t)(l__end - xml) <= SPXML_BLOCK) break;
+		xml += SPXML_BLOCK;
+	}
+	
+	return NULL;
+}
+
+/*
+ * spxml_scan_event(xml, len, final, evt)
+ *
+ * Reads the SPXML event at the begin of "xml" ("len" bytes)
+ * to "evt". If "final" is 0, more input may follow after
+ * "xml".
+ *
+ * Return value:
+ *	 1	Event found
+ *	 0	The event is incomplete
+ *	-1	Invalid event
+ *
+ */
+static int spxml_scan_event(const utf8_t *xml, size_t len, int final, spxml_event_t *evt)
+{
+	int l__type = SPXMLEVENT_BEGIN_TAG;
+	
+	evt->position = xml;
 	
 	/* End of file? */
 	if (*xml == 0)
 	{
-		evt->len = 1;
 		evt->type = SPXMLEVENT_EOF;
-		evt->total_len = evt->len;
-		evt->content = evt->position;		
+		evt->content = xml;
+		evt->len = 1;
+		evt->total_len = 1;
 		
-		return;
+		return 1;
 	}
 	
-	/* No SPXML element? */
+	/* Character data (until "<" or the end of the input) */
 	if (*xml != '<')
 	{
-		/* Search for next element */
-		const utf8_t *l__end = str_char(evt->position, '<', len);
+		int l__ws;
+		const utf8_t *l__end = spxml_scan_text(xml, len, &l__ws);
 		
-		if (l__end == NULL)
-		{
-			evt->type = SPXMLEVENT_INVALID;
-		}
-		 else
-		{
-			evt->len = l__end - evt->position;
-			evt->total_len = evt->len;
-			evt->content = evt->position;
-		}
+		evt->content = xml;
+		evt->len = l__end - xml;
+		evt->total_len = evt->len;
+		evt->type = l__ws ? SPXMLEVENT_WHITESPACE : SPXMLEVENT_DATA;
 		
-		/* Is it a whitespace or EOF content? */
-		int l__is_ws = spxml_is_whitespace(evt->position, evt->total_len);
-
-		switch (l__is_ws)
+		return 1;
+	}
+	
+	/* Too short to decide */
+	if (len < 2) return final ? -1 : 0;
+	
+	/* Element type */
+	switch (xml[1])
+	{
+		case ('?'):
+			l__type = SPXMLEVENT_PROCESSING;
+			break;
+			
+		case ('/'):
+			l__type = SPXMLEVENT_END_TAG;
+			break;
+			
+		case ('!'):
 		{
-			case 1:
-				evt->type = SPXMLEVENT_WHITESPACE;
-				break;
-			case 2:
-				evt->type = SPXMLEVENT_EOF;
+			/* "<!--" is a comment, everything else a tag */
+			size_t l__blen = spxml_event_types[SPXMLEVENT_COMMENT].blen;
+			
+			if (buf_compare(xml, spxml_event_types[SPXMLEVENT_COMMENT].begin, (len < l__blen) ? len : l__blen))
 				break;
-			default:
-				evt->type =  SPXMLEVENT_DATA;
-		}
 			
+			if (len < l__blen) return final ? -1 : 0;
+			
+			l__type = SPXMLEVENT_COMMENT;
+			break;
+		}
+	}
+	
+	/* Search its end */
+	size_t l__blen = spxml_event_types[l__type].blen;
+	const utf8_t *l__end = spxml_scan_close(xml + l__blen, len - l__blen, l__type);
+	
+	if (l__end == NULL)
+		return final ? -1 : 0;
+	
+	evt->type = l__type;
+	evt->content = xml + l__blen;
+	evt->len = l__end - evt->content;
+	evt->total_len = (l__end - xml) + spxml_event_types[l__type].elen;
+	
+	/* Begin tag or empty tag? */
+	if ((l__type == SPXMLEVENT_BEGIN_TAG) && (evt->len > 0) && (evt->content[evt->len - 1] == '/'))
+	{
+		evt->len -= 1;
+		evt->type = SPXMLEVENT_EMPTY_TAG;
+	}
+	
+	return 1;
+}
+
+/*
+ * spxml_next_event(xml, len, &evt)
+ *
+ * Searches the string "xml" for the next SPXML event and
+ * returns informations about it. The string has a maximum
+ * length of "len" bytes. The return value will be passed to
+ * "evt".
+ *
+ */
+ 
+static inline void spxml_next_event(const utf8_t *xml, size_t len, spxml_event_t *evt)
+{
+	/* Test parameters */
+	if (evt == NULL) return;
+	
+	evt->position = xml;
+	
+	if ((xml == NULL) || (len == 0)) {evt->type = SPXMLEVENT_INVALID; return;}	
+	
+	if (spxml_scan_event(xml, len, 1, evt) != 1)
+	{
+		evt->type = SPXMLEVENT_INVALID;
 		return;
 	}
 	
-	evt->len = len;
+	/* Whitespace up to the 0 character is the end of the file */
+	if ((evt->type == SPXMLEVENT_WHITESPACE) && (evt->len < len) && (xml[evt->len] == 0))
+	{
+		evt->type = SPXMLEVENT_EOF;
+	}
+	
+	return;
+}
+
+/*
+ * spxml_arena_alloc(arena)
+ *
+ * Allocates a node from the arena "arena". A new chunk
+ * will be added to the arena, if the current one is full.
+ *
+ * Return value:
+ *	Pointer to the new node
+ *	NULL, if failed
+ *
+ */
+static spxml_node_t* spxml_arena_alloc(spxml_arena_t *arena)
+{
+	/* New chunks are inserted after the first one */
+	spxml_arena_t *l__chunk = (arena->next != NULL) ? arena->next : arena;
 	
-	/* What kind of element do we have? */
-	if (spxml_probe_element(evt, SPXMLEVENT_COMMENT)) return;
-	if (spxml_probe_element(evt, SPXMLEVENT_PROCESSING)) return;
-	if (spxml_probe_element(evt, SPXMLEVENT_END_TAG)) return;
-	if (spxml_probe_element(evt, SPXMLEVENT_BEGIN_TAG)) 
+	if ((l__chunk->used + sizeof(spxml_node_t)) > SPXML_ARENA_CHUNK)
 	{
-		/* Begin tag or empty tag? */
+		l__chunk = mem_alloc(SPXML_ARENA_CHUNK);
+		if (l__chunk == NULL) return NULL;
 		
-		if (evt->content[evt->len - 1] == '/')
-		{
-			evt->len -= 1;
-			evt->type = SPXMLEVENT_EMPTY_TAG;
-		}
-				
-		return;
+		l__chunk->next = arena->next;
+		l__chunk->root = arena->root;
+		l__chunk->used = sizeof(spxml_arena_t);
+		
+		arena->next = l__chunk;
 	}
 	
-	evt->type = SPXMLEVENT_INVALID;
+	spxml_node_t *l__node = (void*)((uintptr_t)l__chunk + l__chunk->used);
+	l__chunk->used += sizeof(spxml_node_t);
+	
+	return l__node;
+}
+
+/*
+ * spxml_arena_free(arena)
+ *
+ * Frees all chunks of the arena "arena".
+ *
+ */
+static void spxml_arena_free(spxml_arena_t *arena)
+{
+	while (arena != NULL)
+	{
+		spxml_arena_t *l__next = arena->next;
+		
+		mem_free(arena);
+		arena = l__next;
+	}
 	
 	return;
 }
 
 /*
- * spxml_create_tree(xml, len, node)
+ * spxml_parse_node(xml, len, node, arena)
  *
  * Analyses the SPXML content "xml" which has the
- * length of "len" bytes. It creates a new
- * element "node" according to the first SPXML element
- * found in "xml". All sub-elements of the first
- * node will be add to the children list of "node".
- * If there is no sub-element, the function will
- * just configure "node" and exit.
+ * length of "len" bytes and configures "node" according
+ * to the first SPXML element found in "xml". Its 
+ * sub-elements are allocated from the arena "arena".
  *
  * Return value:
  *	Pointer to the end of the SPXML element
@@ -314,14 +573,8 @@ static inline void spxml_next_event(const utf8_t *xml, size_t len, spxml_event_t
  *	NULL		error
  *
  */
-const utf8_t* spxml_create_tree(const utf8_t *xml, size_t len, spxml_node_t *node)
+static const utf8_t* spxml_parse_node(const utf8_t *xml, size_t len, spxml_node_t *node, spxml_arena_t *arena)
 {
-	if ((xml == NULL) || (len == 0) || (node == NULL))
-	{
-		*tls_errno = ERR_INVALID_ADDRESS;
-		return NULL;
-	}
-		
 	/*
 	 * What kind of event do we have at first level?
 	 *
@@ -358,6 +611,7 @@ const utf8_t* spxml_create_tree(const utf8_t *xml, size_t len, spxml_node_t *nod
 	node->tag = l__event.content;
 	node->tag_len = l__event.len;
 	node->children = NULL;		
+	node->arena = arena;
 	
 	xml = l__event.position;
 	
@@ -402,10 +656,15 @@ const utf8_t* spxml_create_tree(const utf8_t *xml, size_t len, spxml_node_t *nod
 				{
 					const utf8_t *l__oldxml = xml;
 					
-					spxml_node_t *l__subnode = mem_alloc(sizeof(spxml_node_t));
+					spxml_node_t *l__subnode = spxml_arena_alloc(arena);
+					if (l__subnode == NULL)
+					{
+						*tls_errno = ERR_NOT_ENOUGH_MEMORY;
+						return NULL;
+					}
 					
 					/* Create a children node */
-					xml = spxml_create_tree(xml, len, l__subnode);
+					xml = spxml_parse_node(xml, len, l__subnode, arena);
 					
 					if (xml != NULL)
 					{
@@ -417,7 +676,7 @@ const utf8_t* spxml_create_tree(const utf8_t *xml, size_t len, spxml_node_t *nod
 						return NULL;					
 					}
 
-					len = len - ((uintptr_t)l__oldxml - (uintptr_t)xml);
+					len -= xml - l__oldxml;
 				}
 				 else
 				{
@@ -433,12 +692,78 @@ const utf8_t* spxml_create_tree(const utf8_t *xml, size_t len, spxml_node_t *nod
 	return NULL;	
 }
 
+/*
+ * spxml_create_tree(xml, len, node)
+ *
+ * Analyses the SPXML content "xml" which has the
+ * length of "len" bytes. It creates a new
+ * element "node" according to the first SPXML element
+ * found in "xml". All sub-elements of the first
+ * node will be add to the children list of "node".
+ * If there is no sub-element, the function will
+ * just configure "node" and exit.
+ *
+ * The sub-elements are allocated from an arena, which
+ * is owned by "node" and released by spxml_destroy_tree.
+ *
+ * Return value:
+ *	Pointer to the end of the SPXML element
+ *	within "xml".
+ *
+ *	NULL		error
+ *
+ */
+const utf8_t* spxml_create_tree(const utf8_t *xml, size_t len, spxml_node_t *node)
+{
+	if ((xml == NULL) || (len == 0) || (node == NULL))
+	{
+		*tls_errno = ERR_INVALID_ADDRESS;
+		return NULL;
+	}
+	
+	/* Create the arena of the tree */
+	spxml_arena_t *l__arena = mem_alloc(SPXML_ARENA_CHUNK);
+	if (l__arena == NULL)
+	{
+		*tls_errno = ERR_NOT_ENOUGH_MEMORY;
+		return NULL;
+	}
+	
+	l__arena->next = NULL;
+	l__arena->root = node;
+	l__arena->used = sizeof(spxml_arena_t);
+	
+	node->children = NULL;
+	node->arena = l__arena;
+	lst_init(node);
+	
+	/* Parse it */
+	const utf8_t *l__retval = spxml_parse_node(xml, len, node, l__arena);
+	if (l__retval == NULL)
+	{
+		errno_t l__err = *tls_errno;
+		
+		spxml_arena_free(l__arena);
+		
+		node->children = NULL;
+		node->arena = NULL;
+		
+		*tls_errno = l__err;
+	}
+	
+	return l__retval;
+}
+
 /*
  * spxml_destroy_tree(node)
  *
  * Frees the tree datastructures below the node "node".
  * The node "node" itself wouldn't be freed.
  *
+ * If "node" is the root of a tree, all nodes are released
+ * together with its arena. The nodes below other nodes of 
+ * the tree are just removed until the root is destroyed.
+ *
  */
 void spxml_destroy_tree(spxml_node_t *node)
 {
@@ -448,14 +773,30 @@ void spxml_destroy_tree(spxml_node_t *node)
 		return;
 	}
 	
+	/* Arena of the tree */
+	if (node->arena != NULL)
+	{
+		if (node->arena->root == node)
+		{
+			spxml_arena_free(node->arena);
+			node->arena = NULL;
+		}
+		
+		node->children = NULL;
+		return;
+	}
+	
+	/* Single allocated nodes */
 	spxml_node_t *l__node = node->children;
 	
 	while(l__node != NULL)
 	{
+		spxml_node_t *l__next = l__node->ls.n;
+		
 		spxml_destroy_tree(l__node);
 		mem_free(l__node);
 		
-		l__node = l__node->ls.n;
+		l__node = l__next;
 	};
 	
 	node->children = NULL;
@@ -497,20 +838,13 @@ spxml_node_t* spxml_resolve_path(const utf8_t *path, spxml_node_t *node)
 	do
 	{
 		l__pos = path;
-		l__plen = 0;
 		
 		/* Get the length of the current path element */
-		do
-		{
-			l__plen ++;
-			if (*l__pos == '/') break;
-			
-		}while(*l__pos++);
+		while ((*l__pos != '/') && (*l__pos != 0)) l__pos ++;
 		
-		if (*l__pos == 0) continue;
-		l__plen --;
+		l__plen = l__pos - path;
 		
-		if ((!str_compare(node->tag, path, l__plen)) && (l__plen  == node->tag_len))
+		if ((l__plen > 0) && (l__plen == node->tag_len) && (!str_compare(node->tag, path, l__plen)))
 		{
 			path += l__plen;
 			
@@ -543,3 +877,976 @@ spxml_node_t* spxml_resolve_path(const utf8_t *path, spxml_node_t *node)
 	*tls_errno = ERR_INVALID_ARGUMENT;
 	return NULL;
 }
+
+/*
+ * Streaming reader
+ *
+ * The reader returns the SPXML events of a document, which is
+ * fed in parts of any size (e.g. pages read from a file). It 
+ * doesn't build a tree and needs only the carry buffer of the
+ * caller for events, which cross the end of a part. Character
+ * data may be returned in more than one SPXMLEVENT_DATA or
+ * SPXMLEVENT_WHITESPACE event.
+ *
+ * The event pointers are valid until the next call of the 
+ * reader. The fed parts have to be valid until they are
+ * used up (SPXMLEVENT_NEED_DATA).
+ *
+ */
+
+/* Scanner states of spxml_reader_skip */
+#define SPXML_SKIP_TEXT			0	/* Character data */
+#define SPXML_SKIP_LT			1	/* After "<" */
+#define SPXML_SKIP_OPEN			2	/* Within a begin tag */
+#define SPXML_SKIP_CLOSE		3	/* Within an end tag */
+#define SPXML_SKIP_COMMENT		4	/* Within "<!" ... "-->" */
+#define SPXML_SKIP_PROCESSING		5	/* Within "<?" ... "?>" */
+
+/*
+ * spxml_reader_init(reader, carry, carry_size)
+ *
+ * Initializes the streaming reader "reader". The buffer "carry"
+ * of "carry_size" bytes is used for events, which cross the end of
+ * a part of the input. It limits the size of a single tag.
+ *
+ */
+void spxml_reader_init(spxml_reader_t *reader, utf8_t *carry, size_t carry_size)
+{
+	reader->data = NULL;
+	reader->len = 0;
+	reader->final = 0;
+	
+	reader->carry = carry;
+	reader->carry_size = carry_size;
+	reader->carry_len = 0;
+	reader->carry_done = 0;
+	
+	reader->depth = 0;
+	reader->match = 0;
+	
+	reader->skip = 0;
+	reader->skip_state = SPXML_SKIP_TEXT;
+	reader->skip_prev = 0;
+	
+	return;
+}
+
+/*
+ * spxml_reader_feed(reader, data, len)
+ *
+ * Passes the next part "data" ("len" bytes) of the input to the
+ * reader "reader". A part of 0 bytes marks the end of the input.
+ *
+ * Return value:
+ *	0	Successful
+ *	1	The last part isn't used up yet
+ *
+ */
+int spxml_reader_feed(spxml_reader_t *reader, const utf8_t *data, size_t len)
+{
+	if ((reader->len > 0) || ((data == NULL) && (len > 0)))
+	{
+		*tls_errno = ERR_INVALID_ARGUMENT;
+		return 1;
+	}
+	
+	reader->data = data;
+	reader->len = len;
+	
+	if (len == 0) reader->final = 1;
+	
+	return 0;
+}
+
+/*
+ * spxml_reader_next(reader, evt)
+ *
+ * Reads the next SPXML event of the reader "reader" to "evt".
+ *
+ * Return value:
+ *	Type of the event (SPXMLEVENT_*)
+ *	SPXMLEVENT_NEED_DATA, if the next part of the input is needed
+ *
+ */
+int spxml_reader_next(spxml_reader_t *reader, spxml_event_t *evt)
+{
+	int l__r;
+	
+	/* The last event was in the carry buffer */
+	if (reader->carry_done)
+	{
+		reader->carry_len = 0;
+		reader->carry_done = 0;
+	}
+	
+	if (reader->carry_len > 0)
+	{
+		/* Complete the incomplete event */
+		size_t l__n = reader->carry_size - reader->carry_len;
+		if (l__n > reader->len) l__n = reader->len;
+		
+		buf_copy(&reader->carry[reader->carry_len], reader->data, l__n);
+		
+		l__r = spxml_scan_event(reader->carry, 
+					reader->carry_len + l__n, 
+					reader->final && (l__n == reader->len), 
+					evt
+				       );
+				       
+		if (l__r > 0)
+		{
+			/* Use up its part of the input */
+			size_t l__used = evt->total_len - reader->carry_len;
+			
+			reader->data += l__used;
+			reader->len -= l__used;
+			reader->carry_done = 1;
+		}
+		 else if ((l__r == 0) && (l__n == reader->len) && ((reader->carry_len + l__n) < reader->carry_size))
+		{
+			reader->carry_len += l__n;
+			reader->data += l__n;
+			reader->len = 0;
+			
+			return SPXMLEVENT_NEED_DATA;
+		}
+		 else
+		{
+			/* Invalid or larger than the carry buffer */
+			evt->type = SPXMLEVENT_INVALID;
+			*tls_errno = ERR_INVALID_ARGUMENT;
+			return SPXMLEVENT_INVALID;
+		}
+	}
+	 else
+	{
+		if (reader->len == 0)
+		{
+			if (!reader->final) return SPXMLEVENT_NEED_DATA;
+			
+			evt->type = SPXMLEVENT_EOF;
+			evt->position = NULL;
+			evt->content = NULL;
+			evt->len = 0;
+			evt->total_len = 0;
+			
+			return SPXMLEVENT_EOF;
+		}
+		
+		l__r = spxml_scan_event(reader->data, reader->len, reader->final, evt);
+		
+		if (l__r > 0)
+		{
+			reader->data += evt->total_len;
+			reader->len -= evt->total_len;
+		}
+		 else if ((l__r == 0) && (reader->len < reader->carry_size))
+		{
+			/* Keep the begin of the event */
+			buf_copy(reader->carry, reader->data, reader->len);
+			
+			reader->carry_len = reader->len;
+			reader->data += reader->len;
+			reader->len = 0;
+			
+			return SPXMLEVENT_NEED_DATA;
+		}
+		 else
+		{
+			evt->type = SPXMLEVENT_INVALID;
+			*tls_errno = ERR_INVALID_ARGUMENT;
+			return SPXMLEVENT_INVALID;
+		}
+	}
+	
+	/* Track the depth */
+	if (evt->type == SPXMLEVENT_BEGIN_TAG) 
+	{
+		reader->depth ++;
+	}
+	 else if ((evt->type == SPXMLEVENT_END_TAG) && (reader->depth > 0))
+	{
+		reader->depth --;
+	}
+	
+	return evt->type;
+}
+
+/*
+ * spxml_reader_skip(reader)
+ *
+ * Skips the content of the element, whose begin tag was the
+ * last event of the reader "reader", including its end tag.
+ * The content is only scanned for tag boundaries.
+ *
+ * Return value:
+ *	SPXMLEVENT_END_TAG	The element is skipped
+ *	SPXMLEVENT_NEED_DATA	Feed the next part and call again
+ *	SPXMLEVENT_EOF		End of input within the element
+ *
+ */
+int spxml_reader_skip(spxml_reader_t *reader)
+{
+	/* Start skipping */
+	if (reader->skip == 0)
+	{
+		reader->skip = 1;
+		reader->skip_state = SPXML_SKIP_TEXT;
+		reader->skip_prev = 0;
+	}
+	
+	if (reader->carry_done)
+	{
+		reader->carry_len = 0;
+		reader->carry_done = 0;
+	}
+	
+	/* An incomplete event in the carry buffer belongs to the element */
+	if (reader->carry_len > 0)
+	{
+		const utf8_t *l__data = reader->data;
+		size_t l__len = reader->len;
+		
+		reader->data = reader->carry;
+		reader->len = reader->carry_len;
+		reader->carry_len = 0;
+		
+		int l__r = spxml_reader_skip(reader);
+		
+		reader->data = l__data;
+		reader->len = l__len;
+		
+		if (l__r != SPXMLEVENT_NEED_DATA) 
+		{
+			/* The carry buffer ends within the end tag */
+			*tls_errno = ERR_INVALID_ARGUMENT;
+			return SPXMLEVENT_INVALID;
+		}
+	}
+	
+	while (reader->len > 0)
+	{
+		utf8_t l__c = *reader->data;
+		
+		switch (reader->skip_state)
+		{
+			case (SPXML_SKIP_TEXT):
+			{
+				/* Jump to the next tag */
+				const utf8_t *l__lt = reader->data;
+				const utf8_t *l__end = reader->data + reader->len;
+				
+				while ((l__lt < l__end) && (*l__lt != '<')) l__lt ++;
+				
+				reader->len -= l__lt - reader->data;
+				reader->data = l__lt;
+				
+				if (reader->len == 0) continue;
+				
+				reader->skip_state = SPXML_SKIP_LT;
+				break;
+			}
+			
+			case (SPXML_SKIP_LT):
+			{
+				if (l__c == '/') 
+					reader->skip_state = SPXML_SKIP_CLOSE;
+				else if (l__c == '!')
+					reader->skip_state = SPXML_SKIP_COMMENT;
+				else if (l__c == '?')
+					reader->skip_state = SPXML_SKIP_PROCESSING;
+				else
+					reader->skip_state = SPXML_SKIP_OPEN;
+					
+				reader->skip_prev = 0;
+				break;
+			}
+			
+			case (SPXML_SKIP_OPEN):
+			{
+				if (l__c == '>')
+				{
+					/* Not an empty tag */
+					if ((reader->skip_prev & 0xFF) != '/') reader->skip ++;
+					reader->skip_state = SPXML_SKIP_TEXT;
+				}
+				break;
+			}
+			
+			case (SPXML_SKIP_CLOSE):
+			{
+				if (l__c == '>')
+				{
+					reader->skip --;
+					reader->skip_state = SPXML_SKIP_TEXT;
+					
+					/* End of the skipped element */
+					if (reader->skip == 0)
+					{
+						reader->data ++;
+						reader->len --;
+						
+						if (reader->depth > 0) reader->depth --;
+						
+						return SPXMLEVENT_END_TAG;
+					}
+				}
+				break;
+			}
+			
+			case (SPXML_SKIP_COMMENT):
+			{
+				if ((l__c == '>') && ((reader->skip_prev & 0xFFFF) == (('-' << 8) | '-')))
+					reader->skip_state = SPXML_SKIP_TEXT;
+				break;
+			}
+			
+			case (SPXML_SKIP_PROCESSING):
+			{
+				if ((l__c == '>') && ((reader->skip_prev & 0xFF) == '?'))
+					reader->skip_state = SPXML_SKIP_TEXT;
+				break;
+			}
+		}
+		
+		if (reader->skip_state == SPXML_SKIP_TEXT) 
+		{
+			/* The "<" was already used up in SPXML_SKIP_TEXT */
+			if (l__c != '<')
+			{
+				reader->data ++;
+				reader->len --;
+			}
+			continue;
+		}
+		
+		reader->skip_prev = (reader->skip_prev << 8) | l__c;
+		reader->data ++;
+		reader->len --;
+	}
+	
+	return reader->final ? SPXMLEVENT_EOF : SPXMLEVENT_NEED_DATA;
+}
+
+/*
+ * spxml_path_element(path, num, &len)
+ *
+ * Returns the element "num" of the simplified XPath "path"
+ * and its length. 
+ *
+ * Return value:
+ *	Pointer to the element
+ *	NULL, if there is no such element
+ *
+ */
+static const utf8_t* spxml_path_element(const utf8_t *path, unsigned num, size_t *len)
+{
+	while (1)
+	{
+		while (*path == '/') path ++;
+		if (*path == 0) return NULL;
+		
+		const utf8_t *l__end = path;
+		while ((*l__end != '/') && (*l__end != 0)) l__end ++;
+		
+		if (num == 0) 
+		{
+			*len = l__end - path;
+			return path;
+		}
+		
+		num --;
+		path = l__end;
+	}
+}
+
+/*
+ * spxml_tag_name_len(evt)
+ *
+ * Returns the length of the name of the tag "evt"
+ * (without its attributes).
+ *
+ */
+static inline size_t spxml_tag_name_len(const spxml_event_t *evt)
+{
+	size_t l__len = 0;
+	
+	while (    (l__len < evt->len) 
+		&& (evt->content[l__len] != ' ')
+		&& (evt->content[l__len] != '\t')
+		&& (evt->content[l__len] != 13)
+		&& (evt->content[l__len] != 10)
+	      )
+	{
+		l__len ++;
+	}
+	
+	return l__len;
+}
+
+/*
+ * spxml_reader_filter(reader, path, func, ctx)
+ *
+ * Reads the events of the reader "reader" and passes all events
+ * of the elements selected by the simplified XPath "path" (e.g. 
+ * "/config/drivers/driver") to the callback "func" (with the 
+ * parameter "ctx"). Elements outside of "path" are skipped by 
+ * spxml_reader_skip.
+ *
+ * The function returns if the input is used up. Call it again
+ * with the same parameters after feeding the next part.
+ *
+ * Return value:
+ *	SPXMLEVENT_NEED_DATA	Feed the next part and call again
+ *	SPXMLEVENT_EOF		End of the document
+ *	SPXMLEVENT_INVALID	Invalid document
+ *	-1			Stopped by the callback
+ *
+ */
+int spxml_reader_filter(spxml_reader_t *reader, const utf8_t *path, spxml_callback_t func, void *ctx)
+{
+	spxml_event_t l__evt;
+	unsigned l__elements = 0;
+	size_t l__len = 0;
+	
+	if ((path == NULL) || (func == NULL))
+	{
+		*tls_errno = ERR_INVALID_ARGUMENT;
+		return SPXMLEVENT_INVALID;
+	}
+	
+	while (spxml_path_element(path, l__elements, &l__len) != NULL) l__elements ++;
+	
+	while (1)
+	{
+		int l__type;
+		
+		/* Skip an element outside of the path */
+		if (reader->skip > 0)
+		{
+			l__type = spxml_reader_skip(reader);
+			if (l__type != SPXMLEVENT_END_TAG) return l__type;
+			
+			continue;
+		}
+		
+		l__type = spxml_reader_next(reader, &l__evt);
+		
+		if (    (l__type == SPXMLEVENT_NEED_DATA) 
+		     || (l__type == SPXMLEVENT_EOF)
+		     || (l__type == SPXMLEVENT_INVALID)
+		   )
+		{
+			return l__type;
+		}
+		
+		/* Within a selected element */
+		if (reader->match >= l__elements)
+		{
+			if ((l__type == SPXMLEVENT_END_TAG) && (reader->depth < l__elements))
+				reader->match = reader->depth;
+			
+			if (func(reader, &l__evt, ctx)) return -1;
+			continue;
+		}
+		
+		/* End of a parent element of the path */
+		if (l__type == SPXMLEVENT_END_TAG)
+		{
+			reader->match = reader->depth;
+			continue;
+		}
+		
+		if ((l__type != SPXMLEVENT_BEGIN_TAG) && (l__type != SPXMLEVENT_EMPTY_TAG))
+			continue;
+			
+		/* Is the tag the next element of the path? */
+		const utf8_t *l__name = spxml_path_element(path, reader->match, &l__len);
+		
+		if (    (l__len == spxml_tag_name_len(&l__evt))
+		     && (!buf_compare(l__evt.content, l__name, l__len))
+		   )
+		{
+			if (l__type == SPXMLEVENT_BEGIN_TAG)
+			{
+				reader->match ++;
+				
+				if (reader->match < l__elements) continue;
+			}
+			 else if ((reader->match + 1) < l__elements)
+			{
+				continue;
+			}
+			
+			if (func(reader, &l__evt, ctx)) return -1;
+		}
+		 else if (l__type == SPXMLEVENT_BEGIN_TAG)
+		{
+			/* Skip it */
+			reader->skip = 0;
+			
+			l__type = spxml_reader_skip(reader);
+			if (l__type != SPXMLEVENT_END_TAG) return l__type;
+		}
+	}
+}
+
+/*
+ * Index of a SPXML tree
+ *
+ * The index maps the pair (parent node, tag) to the first child
+ * of the parent with this tag, so a path is resolved by one probe
+ * of a hash table per path element. The results of the last
+ * resolved path strings are kept in a cache together with their
+ * compiled paths. The tree must not be changed while it has an
+ * index.
+ *
+ */
+
+/* Number of entries of the path cache of an index (power of two) */
+#define SPXML_INDEX_CACHE		64
+
+/* Entry of the hash table of an index */
+typedef struct spxml_index_entry_st
+{
+	struct spxml_index_entry_st	*next;		/* Next entry of the bucket */
+	const spxml_node_t		*parent;	/* Parent node (NULL for the root) */
+	spxml_node_t			*node;		/* Child node */
+	uint32_t			hash;		/* Hash of the tag */
+}spxml_index_entry_t;
+
+struct spxml_index_st
+{
+	spxml_index_entry_t	**buckets;	/* Buckets of the hash table */
+	uint32_t		mask;		/* Count of buckets - 1 */
+	spxml_index_entry_t	*entries;	/* Entries of the hash table */
+	size_t			used;		/* Used entries */
+	
+	mtx_t			cache_mtx;	/* Lock of the path cache */
+	struct
+	{
+		spxml_path_t	*path;		/* Compiled path */
+		spxml_node_t	*node;		/* Its result */
+	}cache[SPXML_INDEX_CACHE];
+};
+
+/*
+ * spxml_hash(str, len)
+ *
+ * Returns the hash (FNV-1a) of the first "len" bytes of "str".
+ *
+ */
+static inline uint32_t spxml_hash(const utf8_t *str, size_t len)
+{
+	uint32_t l__hash = 2166136261u;
+	
+	while (len --)
+	{
+		l__hash ^= (uint8_t)*str ++;
+		l__hash *= 16777619u;
+	}
+	
+	return l__hash;
+}
+
+/*
+ * spxml_index_bucket(index, parent, hash)
+ *
+ * Returns the bucket of the tag hash "hash" below "parent".
+ *
+ */
+static inline spxml_index_entry_t** spxml_index_bucket(spxml_index_t *index, const spxml_node_t *parent, uint32_t hash)
+{
+	return &index->buckets[(hash ^ ((uint32_t)(uintptr_t)parent * 2654435761u)) & index->mask];
+}
+
+/*
+ * spxml_index_find(index, parent, tag, len, hash)
+ *
+ * Searches the first child of "parent" with the tag "tag"
+ * ("len" bytes, hash "hash") within "index".
+ *
+ * Return value:
+ *	Pointer to the child
+ *	NULL, if not found
+ *
+ */
+static inline spxml_node_t* spxml_index_find(spxml_index_t *index, const spxml_node_t *parent, const utf8_t *tag, size_t len, uint32_t hash)
+{
+	spxml_index_entry_t *l__entry = *spxml_index_bucket(index, parent, hash);
+	
+	while (l__entry != NULL)
+	{
+		if (    (l__entry->hash == hash)
+		     && (l__entry->parent == parent)
+		     && (l__entry->node->tag_len == len)
+		     && (!buf_compare(l__entry->node->tag, tag, len))
+		   )
+		{
+			return l__entry->node;
+		}
+		
+		l__entry = l__entry->next;
+	}
+	
+	return NULL;
+}
+
+/*
+ * spxml_index_count(node)
+ *
+ * Returns the number of nodes of the tree "node".
+ *
+ */
+static size_t spxml_index_count(const spxml_node_t *node)
+{
+	const spxml_node_t *l__child = node->children;
+	size_t l__count = 1;
+	
+	while (l__child != NULL)
+	{
+		l__count += spxml_index_count(l__child);
+		l__child = l__child->ls.n;
+	}
+	
+	return l__count;
+}
+
+/*
+ * spxml_index_insert(index, parent, node)
+ *
+ * Adds the node "node" with the parent "parent" and all of
+ * its children to the index "index". If the parent has already
+ * a child with the same tag, only the first one is added.
+ *
+ */
+static void spxml_index_insert(spxml_index_t *index, const spxml_node_t *parent, spxml_node_t *node)
+{
+	uint32_t l__hash = spxml_hash(node->tag, node->tag_len);
+	spxml_node_t *l__child = node->children;
+	
+	if (    (node->tag_len > 0)
+	     && (spxml_index_find(index, parent, node->tag, node->tag_len, l__hash) == NULL)
+	   )
+	{
+		spxml_index_entry_t **l__bucket = spxml_index_bucket(index, parent, l__hash);
+		spxml_index_entry_t *l__entry = &index->entries[index->used ++];
+		
+		l__entry->parent = parent;
+		l__entry->node = node;
+		l__entry->hash = l__hash;
+		l__entry->next = *l__bucket;
+		*l__bucket = l__entry;
+	}
+	
+	while (l__child != NULL)
+	{
+		spxml_index_insert(index, node, l__child);
+		l__child = l__child->ls.n;
+	}
+	
+	return;
+}
+
+/*
+ * spxml_create_index(node)
+ *
+ * Creates an index of the SPXML tree "node" for the path
+ * resolution with spxml_index_lookup and spxml_index_resolve.
+ * The tree must not be changed or destroyed while the index
+ * exists.
+ *
+ * Return value:
+ *	Pointer to the index
+ *	NULL		error
+ *
+ */
+spxml_index_t* spxml_create_index(spxml_node_t *node)
+{
+	spxml_index_t *l__index;
+	size_t l__count;
+	uint32_t l__buckets = 1;
+	unsigned l__i;
+	
+	if (node == NULL)
+	{
+		*tls_errno = ERR_INVALID_ADDRESS;
+		return NULL;
+	}
+	
+	/* One bucket per node at least */
+	l__count = spxml_index_count(node);
+	while (l__buckets < l__count) l__buckets *= 2;
+	
+	/* Index, buckets and entries are allocated together */
+	l__index = mem_alloc(  sizeof(spxml_index_t) 
+			     + l__buckets * sizeof(spxml_index_entry_t*) 
+			     + l__count * sizeof(spxml_index_entry_t)
+			    );
+	if (l__index == NULL)
+	{
+		*tls_errno = ERR_NOT_ENOUGH_MEMORY;
+		return NULL;
+	}
+	
+	l__index->buckets = (void*)((uintptr_t)l__index + sizeof(spxml_index_t));
+	l__index->mask = l__buckets - 1;
+	l__index->entries = (void*)((uintptr_t)l__index->buckets + l__buckets * sizeof(spxml_index_entry_t*));
+	l__index->used = 0;
+	l__index->cache_mtx = MTX_NEW();
+	
+	for (l__i = 0; l__i < l__buckets; l__i ++)
+		l__index->buckets[l__i] = NULL;
+	
+	for (l__i = 0; l__i < SPXML_INDEX_CACHE; l__i ++)
+	{
+		l__index->cache[l__i].path = NULL;
+		l__index->cache[l__i].node = NULL;
+	}
+	
+	spxml_index_insert(l__index, NULL, node);
+	
+	return l__index;
+}
+
+/*
+ * spxml_destroy_index(index)
+ *
+ * Destroys the index "index" and its path cache.
+ *
+ */
+void spxml_destroy_index(spxml_index_t *index)
+{
+	unsigned l__i;
+	
+	if (index == NULL)
+	{
+		*tls_errno = ERR_INVALID_ADDRESS;
+		return;
+	}
+	
+	for (l__i = 0; l__i < SPXML_INDEX_CACHE; l__i ++)
+	{
+		if (index->cache[l__i].path != NULL)
+			mem_free(index->cache[l__i].path);
+	}
+	
+	mem_free(index);
+	
+	return;
+}
+
+/*
+ * spxml_compile_path(path)
+ *
+ * Compiles the simplified XPath "path" (e.g. "/config/net/ip")
+ * for spxml_index_lookup. Empty path elements (repeated "/")
+ * are invalid, a single "/" at the end is ignored like by
+ * spxml_resolve_path. The compiled path contains a copy of
+ * "path", so "path" can be released afterwards.
+ *
+ * Return value:
+ *	Pointer to the compiled path (release it with
+ *	spxml_destroy_path)
+ *	NULL		error
+ *
+ */
+spxml_path_t* spxml_compile_path(const utf8_t *path)
+{
+	spxml_path_t *l__path;
+	const utf8_t *l__elem;
+	size_t l__len = 0;
+	size_t l__elen = 0;
+	unsigned l__count = 0;
+	
+	if (path == NULL)
+	{
+		*tls_errno = ERR_INVALID_ADDRESS;
+		return NULL;
+	}
+	
+	if (*path != '/')
+	{
+		*tls_errno = ERR_INVALID_ARGUMENT;
+		return NULL;
+	}
+	
+	/* Every "/" has to be followed by a path element or the end */
+	while (path[l__len] != 0)
+	{
+		if ((path[l__len] == '/') && (path[l__len + 1] == '/'))
+		{
+			*tls_errno = ERR_INVALID_ARGUMENT;
+			return NULL;
+		}
+		
+		l__len ++;
+	}
+	
+	while (spxml_path_element(path, l__count, &l__elen) != NULL) l__count ++;
+	
+	if (l__count == 0)
+	{
+		*tls_errno = ERR_INVALID_ARGUMENT;
+		return NULL;
+	}
+	
+	/* Path, its elements and the copy of the text are allocated together */
+	l__path = mem_alloc(  sizeof(spxml_path_t) 
+			    + l__count * sizeof(spxml_path_element_t) 
+			    + l__len + 1
+			   );
+	if (l__path == NULL)
+	{
+		*tls_errno = ERR_NOT_ENOUGH_MEMORY;
+		return NULL;
+	}
+	
+	l__path->text = (utf8_t*)&l__path->elements[l__count];
+	l__path->len = l__len;
+	l__path->hash = spxml_hash(path, l__len);
+	l__path->count = l__count;
+	
+	buf_copy(l__path->text, path, l__len + 1);
+	
+	for (l__count = 0; l__count < l__path->count; l__count ++)
+	{
+		l__elem = spxml_path_element(l__path->text, l__count, &l__elen);
+		
+		l__path->elements[l__count].name = l__elem;
+		l__path->elements[l__count].len = l__elen;
+		l__path->elements[l__count].hash = spxml_hash(l__elem, l__elen);
+	}
+	
+	return l__path;
+}
+
+/*
+ * spxml_destroy_path(path)
+ *
+ * Releases the compiled path "path".
+ *
+ */
+void spxml_destroy_path(spxml_path_t *path)
+{
+	if (path == NULL)
+	{
+		*tls_errno = ERR_INVALID_ADDRESS;
+		return;
+	}
+	
+	mem_free(path);
+	
+	return;
+}
+
+/*
+ * spxml_index_lookup(index, path)
+ *
+ * Resolves the compiled path "path" within the tree of 
+ * the index "index". The path is matched like by
+ * spxml_resolve_path.
+ *
+ * Return value:
+ *	Pointer to the element found
+ *	NULL		error or not found
+ *
+ */
+spxml_node_t* spxml_index_lookup(spxml_index_t *index, const spxml_path_t *path)
+{
+	spxml_node_t *l__node = NULL;
+	unsigned l__i;
+	
+	if ((index == NULL) || (path == NULL))
+	{
+		*tls_errno = ERR_INVALID_ADDRESS;
+		return NULL;
+	}
+	
+	for (l__i = 0; l__i < path->count; l__i ++)
+	{
+		l__node = spxml_index_find(index, 
+					   l__node, 
+					   path->elements[l__i].name, 
+					   path->elements[l__i].len, 
+					   path->elements[l__i].hash
+					  );
+		
+		if (l__node == NULL)
+		{
+			*tls_errno = ERR_INVALID_ARGUMENT;
+			return NULL;
+		}
+	}
+	
+	return l__node;
+}
+
+/*
+ * spxml_index_resolve(index, path)
+ *
+ * Resolves the simplified XPath "path" within the tree of
+ * the index "index". The compiled path and its result are
+ * kept in the path cache of the index, so resolving the same
+ * path again needs only a comparison with the cached one.
+ *
+ * Return value:
+ *	Pointer to the element found
+ *	NULL		error or not found
+ *
+ */
+spxml_node_t* spxml_index_resolve(spxml_index_t *index, const utf8_t *path)
+{
+	spxml_node_t *l__node;
+	size_t l__len = 0;
+	uint32_t l__hash = 2166136261u;
+	unsigned l__slot;
+	
+	if ((index == NULL) || (path == NULL))
+	{
+		*tls_errno = ERR_INVALID_ADDRESS;
+		return NULL;
+	}
+	
+	/* Length and hash (like spxml_hash) of the path */
+	while (path[l__len] != 0)
+	{
+		l__hash ^= (uint8_t)path[l__len ++];
+		l__hash *= 16777619u;
+	}
+	
+	l__slot = l__hash & (SPXML_INDEX_CACHE - 1);
+	
+	mtx_lock(&index->cache_mtx, MTX_UNLIMITED);
+	
+	spxml_path_t *l__path = index->cache[l__slot].path;
+	
+	/* Not cached yet? */
+	if (    (l__path == NULL)
+	     || (l__path->hash != l__hash)
+	     || (l__path->len != l__len)
+	     || ((l__len > 0) && buf_compare(l__path->text, path, l__len))
+	   )
+	{
+		l__path = spxml_compile_path(path);
+		if (l__path == NULL)
+		{
+			mtx_unlock(&index->cache_mtx);
+			return NULL;
+		}
+		
+		if (index->cache[l__slot].path != NULL)
+			mem_free(index->cache[l__slot].path);
+		
+		index->cache[l__slot].path = l__path;
+		index->cache[l__slot].node = spxml_index_lookup(index, l__path);
+	}
+	
+	l__node = index->cache[l__slot].node;
+	
+	mtx_unlock(&index->cache_mtx);
+	
+	if (l__node == NULL) *tls_errno = ERR_INVALID_ARGUMENT;
+	
+	return l__node;
+}
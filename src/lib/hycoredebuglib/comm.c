@@ -19,6 +19,8 @@
 #include <hydrixos/hymk.h>
 #include <hydrixos/system.h>
 #include <hydrixos/blthr.h>
+#include <hydrixos/mutex.h>
+#include <hydrixos/pmap.h>
 #include <coredbg/cdebug.h>
 
 /*
@@ -34,7 +36,157 @@
  * with their servers. It could be a solution for emulation foreign
  * operating systems using an external thread.
  *
+ * The console output doesn't need a debugger call for every
+ * string. It is written to a ring buffer (dc_ring_t), which
+ * is shared with the debugger. The debugger drains it on
+ * every debugger call of this thread. Complete lines are
+ * flushed at once.
+ *
+ */
+
+/* Console ring of the current thread */
+static dc_ring_t **dc_tls_ring = NULL;
+static mtx_t dc_ring_mtx = MTX_DEFINE();
+
+/*
+ * dc_connect_ring
+ *
+ * Allocates the console ring of the current thread and
+ * shares it with the debugger.
+ *
+ * Return value:
+ *	0	Success
+ *	!= 0	Error (the debugger calls will be used for I/O)
+ *
+ */
+int dc_connect_ring(void)
+{
+	int l__retval = -1;
+	
+	/* Allocate the TLS entry once */
+	if (dc_tls_ring == NULL)
+	{
+		mtx_lock(&dc_ring_mtx, -1);
+		
+		if (dc_tls_ring == NULL)
+			dc_tls_ring = (dc_ring_t**)tls_global_alloc();
+		
+		mtx_unlock(&dc_ring_mtx);
+		
+		if (dc_tls_ring == NULL) return -1;
+	}
+	
+	*dc_tls_ring = NULL;
+	
+	/* Allocate the ring */
+	dc_ring_t *l__ring = pmap_mapalloc(sizeof(dc_ring_t));
+	if (l__ring == NULL) return -1;
+	
+	l__ring->out_head = 0;
+	l__ring->out_tail = 0;
+	
+	/* Pass it to the debugger */
+	__asm__ __volatile__("int $0xB0\n"
+		     	     "addl $0, %%esp\n"
+		     	     : "=a" (*tls_errno),
+		     	       "=b" (l__retval)
+		     	     : "a" (DBG_COM_CONNECT_RING),
+		     	       "b" (l__ring)
+		     	     : "memory"
+		     	    );	
+	
+	if ((*tls_errno) || (l__retval != 0))
+	{
+		pmap_free(l__ring);
+		return -1;
+	}
+	
+	*dc_tls_ring = l__ring;
+	
+	return 0;
+}
+
+/*
+ * dc_get_ring
+ *
+ * Returns the console ring of the current thread or
+ * NULL, if there is none.
+ *
+ */
+static inline dc_ring_t* dc_get_ring(void)
+{
+	if (dc_tls_ring == NULL) return NULL;
+	
+	return *dc_tls_ring;
+}
+
+/*
+ * dc_flush
+ *
+ * Lets the debugger output the content of the
+ * console ring of the current thread.
+ *
  */
+void dc_flush(void)
+{
+	if (dc_get_ring() == NULL) return;
+	
+	__asm__ __volatile__("int $0xB0\n"
+		     	     "addl $0, %%esp\n"
+		     	     : "=a" (*tls_errno)
+		     	     : "a" (DBG_COM_FLUSH)
+		     	     : "memory"
+		     	    );	
+	
+	return;
+}
+
+/*
+ * dc_ring_write(ring, str, len)
+ *
+ * Writes "len" bytes from "str" to the console ring "ring".
+ * The debugger will be called if the ring is full, the
+ * watermark is reached or a line has been completed.
+ *
+ */
+static void dc_ring_write(dc_ring_t *ring, const utf8_t *str, size_t len)
+{
+	int l__newline = 0;
+	
+	while (len > 0)
+	{
+		uint32_t l__head = ring->out_head;
+		uint32_t l__free = DC_RING_OUT_SIZE - (l__head - ring->out_tail);
+		
+		/* Full. Let the debugger drain it. */
+		if (l__free == 0)
+		{
+			dc_flush();
+			if (*tls_errno) return;
+			continue;
+		}
+		
+		while ((l__free --) && (len > 0))
+		{
+			if (*str == '\n') l__newline = 1;
+			
+			ring->out[l__head & (DC_RING_OUT_SIZE - 1)] = *str ++;
+			l__head ++;
+			len --;
+		}
+		
+		ring->out_head = l__head;
+	}
+	
+	if (    (l__newline)
+	     || ((ring->out_head - ring->out_tail) >= DC_RING_WATERMARK)
+	   )
+	{
+		dc_flush();
+	}
+	
+	return;
+}
 
 /*
  * dc_disconnect
@@ -340,6 +492,17 @@ void dc_interactive_mode(void)
  */
 void dc_putc(uint32_t c)
 {
+	dc_ring_t *l__ring = dc_get_ring();
+	
+	/* ASCII charracters are written to the ring */
+	if ((l__ring != NULL) && (c > 0) && (c < 0x80))
+	{
+		utf8_t l__c = c;
+		
+		dc_ring_write(l__ring, &l__c, 1);
+		return;
+	}
+	
 	__asm__ __volatile__("int $0xB0\n"
 		     	     "addl $0, %%esp\n"
 		     	     : "=a" (*tls_errno)
@@ -356,12 +519,24 @@ void dc_putc(uint32_t c)
  *
  * Writes an string "str" to the terminal of
  * this thread. The string has the length of
- * "len" bytes.
+ * "len" bytes (including the terminating zero).
  *
  */
 size_t dc_puts(const utf8_t *str, size_t len)
 {
 	size_t l__retval = 0;
+	dc_ring_t *l__ring = dc_get_ring();
+	
+	/* Write it to the ring */
+	if (l__ring != NULL)
+	{
+		while ((l__retval < len) && (str[l__retval] != 0))
+			l__retval ++;
+		
+		dc_ring_write(l__ring, str, l__retval);
+		
+		return len;
+	}
 	
 	__asm__ __volatile__("int $0xB0\n"
 		     	     "addl $0, %%esp\n"
@@ -409,17 +584,30 @@ uint32_t dc_getc(void)
 size_t dc_gets(size_t num, utf8_t *buf)
 {
 	size_t l__retval;
+	dc_ring_t *l__ring = dc_get_ring();
 	
+	/* The line will be returned in the ring, if it fits */
+	if ((l__ring == NULL) || (num > DC_RING_IN_SIZE))
+		l__ring = NULL;
+		
 	__asm__ __volatile__("int $0xB0\n"
 		     	     "addl $0, %%esp\n"
 		     	     : "=a" (*tls_errno),
 		     	       "=b" (l__retval)
 		     	     : "a" (DBG_COM_GETS),
 		     	       "b" (num),
-		     	       "c" (buf)
+		     	       "c" ((l__ring != NULL) ? NULL : buf)
 		     	     : "memory"
 		     	    );	
 	
+	if ((l__ring != NULL) && (*tls_errno == 0))
+	{
+		size_t l__i;
+		
+		for (l__i = 0; l__i < num; l__i ++)
+			buf[l__i] = l__ring->in[l__i];
+	}
+	
 	return l__retval;
 }
 
@@ -17,6 +17,7 @@
 
 #include <coredbg/cdebug.h>
 
+int dc_connect_ring(void);
 
 
 #endif
@@ -54,6 +54,10 @@ sid_t cdbg_connect(void)
 			
 	if (*tls_errno != 0)
 		return 0;
-	else
-		return l__worker;
+		
+	/* Share a console ring with the debugger (or use debugger calls) */
+	dc_connect_ring();
+	*tls_errno = 0;
+	
+	return l__worker;
 }